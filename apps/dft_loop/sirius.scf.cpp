@@ -96,6 +96,11 @@ double ground_state(Simulation_context& ctx,
         }
         density.load();
         potential.load();
+        if (!ctx.full_potential()) {
+            /* wave-functions of the previous run (if stored) are used as the initial guess */
+            ks.load();
+            dft.band().initialize_subspace(ks, potential);
+        }
     } else {
         density.initial_density();
         potential.generate(density);
@@ -171,7 +176,8 @@ double ground_state(Simulation_context& ctx,
     ctx.comm().barrier();
 
     if (ctx.control().print_timers_)  {
-        sddk::timer::print();
+        sddk::timer::print_reduced(ctx.comm());
+        sddk::timer::write_json_tree(std::string("timers_") + ctx.start_time_tag() + std::string(".json"), ctx.comm());
     }
 
     return dft.total_energy();
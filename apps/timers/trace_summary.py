@@ -0,0 +1,57 @@
+# Summary of the timeline recorded with SDDK_TRACE=<number of events per thread>.
+#
+# For each MPI rank prints the time spent in MPI calls and the number of bytes sent; for each
+# timer prints the minimum and maximum over ranks of the total time, which shows the load imbalance.
+import json
+import sys
+
+def main():
+
+    if len(sys.argv) < 2:
+        print("Usage: %s sirius_trace.json [number of timers]"%sys.argv[0])
+        sys.exit(1)
+
+    ntimers = int(sys.argv[2]) if len(sys.argv) > 2 else 20
+
+    events = json.load(open(sys.argv[1], 'r'))["traceEvents"]
+
+    # time in MPI calls and number of bytes per rank and call
+    mpi = {}
+    # total time of each timer per rank
+    timers = {}
+    for e in events:
+        if e["ph"] != "X":
+            continue
+        rank = e["pid"]
+        t = e["dur"] * 1e-6
+        if e.get("cat") == "mpi":
+            d = mpi.setdefault(rank, {}).setdefault(e["name"], [0, 0.0, 0])
+            d[0] += 1
+            d[1] += t
+            d[2] += e["args"]["bytes"]
+        else:
+            # only the master thread is counted to avoid summation over threads
+            if e["tid"] == 0:
+                timers.setdefault(e["name"], {})
+                timers[e["name"]][rank] = timers[e["name"]].get(rank, 0.0) + t
+
+    print("%-6s %-16s %10s %12s %16s"%("rank", "MPI call", "count", "time (s)", "bytes"))
+    for rank in sorted(mpi):
+        for name in sorted(mpi[rank]):
+            d = mpi[rank][name]
+            print("%-6i %-16s %10i %12.4f %16i"%(rank, name, d[0], d[1], d[2]))
+
+    nranks = len(set(e["pid"] for e in events))
+    tmp = []
+    for name in timers:
+        v = [timers[name].get(r, 0.0) for r in range(nranks)]
+        tmp.append((max(v), min(v), name))
+    tmp.sort(reverse=True)
+
+    print("")
+    print("%-65s %12s %12s %12s"%("timer", "min (s)", "max (s)", "max/min"))
+    for tmax, tmin, name in tmp[:ntimers]:
+        print("%-65s %12.4f %12.4f %12.2f"%(name, tmin, tmax, tmax / tmin if tmin > 0 else 0))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,223 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* write a synthetic ultrasoft pseudopotential with s- and p-projectors and Gaussian augmentation functions */
+void write_synthetic_uspp(std::string fname__)
+{
+    int nr = 1500;
+    double r0{1e-6};
+    double rmax{8};
+    std::vector<double> r(nr);
+    for (int i = 0; i < nr; i++) {
+        r[i] = r0 * std::exp(i * std::log(rmax / r0) / (nr - 1));
+    }
+    auto f = [&](std::function<double(double)> g)
+    {
+        std::vector<double> v(nr);
+        for (int i = 0; i < nr; i++) {
+            v[i] = g(r[i]);
+        }
+        return v;
+    };
+
+    json pp;
+    pp["header"]["element"]        = "X";
+    pp["header"]["z_valence"]      = 2.0;
+    pp["header"]["mesh_size"]      = nr;
+    pp["header"]["number_of_proj"] = 2;
+    pp["radial_grid"]              = r;
+    pp["local_potential"]          = f([](double x){return -2 * std::erf(x) / x;});
+    pp["total_charge_density"]     = f([](double x){return 2 * x * x * std::exp(-x * x);});
+    for (int l: {0, 1}) {
+        json beta;
+        beta["angular_momentum"] = l;
+        beta["radial_function"]  = f([l](double x){return std::pow(x, l + 1) * std::exp(-x * x);});
+        pp["beta_projectors"].push_back(beta);
+    }
+    pp["D_ion"] = std::vector<double>(4, 0);
+    /* Q_{ij}^{l}(r) r^2 for all allowed combinations of the orbital quantum numbers of the s- and p-projectors */
+    std::vector<std::array<int, 3>> ijl = {{0, 0, 0}, {0, 1, 1}, {1, 1, 0}, {1, 1, 2}};
+    for (auto& e: ijl) {
+        json q;
+        q["i"] = e[0];
+        q["j"] = e[1];
+        q["angular_momentum"] = e[2];
+        double c = 1 + 0.3 * e[0] + 0.2 * e[1] + 0.1 * e[2];
+        q["radial_function"] = f([&](double x){return c * std::pow(x, e[2] + 2) * std::exp(-x * x);});
+        pp["augmentation"].push_back(q);
+    }
+    json dict;
+    dict["pseudo_potential"] = pp;
+
+    std::ofstream(fname__) << dict.dump(4);
+}
+
+/// Quantities computed with the plane-wave coefficients of the augmentation operator.
+struct aug_result
+{
+    /// Number of G-vectors in a block of Q(G).
+    int block_size;
+    /// Number of local G-vectors.
+    int num_gvec_loc;
+    std::vector<double_complex> rho_aug;
+    std::vector<double_complex> d_mtrx;
+    std::vector<double> forces;
+};
+
+/* compute rho_aug, D-operator matrix and ultrasoft forces for a fixed density matrix and potential */
+aug_result compute(std::string fname__, double pw_cutoff__, int aug_block_size__, int aug_cache_blocks__)
+{
+    Simulation_context ctx(mpi_comm_world());
+    ctx.set_esm_type("pseudopotential");
+    ctx.set_processing_unit("cpu");
+    ctx.set_pw_cutoff(pw_cutoff__);
+    ctx.set_gk_cutoff(pw_cutoff__ / 2);
+    ctx.set_verbosity(0);
+    ctx.set_aug_block_size(aug_block_size__);
+    /* memory of aug_cache_blocks__ blocks of Q(G) of the atom type with 4 beta-projectors; slightly more memory is
+     * given to avoid rounding down */
+    ctx.set_aug_cache_memory((aug_cache_blocks__ + 0.5) * 16.0 * 10 * aug_block_size__ / (1 << 20));
+    /* triclinic cell; the second atom is close to the cell boundary */
+    ctx.unit_cell().set_lattice_vectors({7.1, 0.3, 0.0}, {0.8, 6.7, 0.2}, {-0.4, 0.5, 7.4});
+    ctx.unit_cell().add_atom_type("X", fname__);
+    ctx.unit_cell().add_atom("X", {0.11, 0.23, 0.37});
+    ctx.unit_cell().add_atom("X", {0.67, 0.02, 0.95});
+    ctx.initialize();
+
+    Potential potential(ctx);
+    potential.allocate();
+
+    Density density(ctx);
+    density.allocate();
+
+    aug_result res;
+    res.block_size   = ctx.augmentation_op(0).block_size();
+    res.num_gvec_loc = ctx.gvec().count();
+
+    /* augmentation charge */
+    int nv = ctx.num_mag_dims() + 1;
+    auto& dm = density.density_matrix();
+    for (size_t i = 0; i < dm.size(); i++) {
+        dm[i] = double_complex(std::sin(0.37 * i + 0.1), std::cos(1.3 * i));
+    }
+    /* make the density matrix of each atom Hermitian */
+    for (int ia = 0; ia < ctx.unit_cell().num_atoms(); ia++) {
+        int nbf = ctx.unit_cell().atom(ia).mt_basis_size();
+        for (int xi1 = 0; xi1 < nbf; xi1++) {
+            dm(xi1, xi1, 0, ia) = dm(xi1, xi1, 0, ia).real();
+            for (int xi2 = 0; xi2 < xi1; xi2++) {
+                dm(xi2, xi1, 0, ia) = std::conj(dm(xi1, xi2, 0, ia));
+            }
+        }
+    }
+    mdarray<double_complex, 2> rho_aug(ctx.gvec().count(), nv);
+    density.generate_rho_aug<CPU>(rho_aug);
+    for (size_t i = 0; i < rho_aug.size(); i++) {
+        res.rho_aug.push_back(rho_aug[i]);
+    }
+
+    /* D-operator matrix for a smooth real potential: V(-G) = V^{*}(G) */
+    auto veff = potential.effective_potential();
+    vector3d<double> r1({0.3, -1.2, 0.7});
+    vector3d<double> r2({1.5, 0.4, -0.9});
+    for (int igloc = 0; igloc < ctx.gvec().count(); igloc++) {
+        int ig = ctx.gvec().offset() + igloc;
+        auto gc = ctx.gvec().gvec_cart(ig);
+        veff->f_pw_local(igloc) = double_complex(std::cos(gc * r1), std::sin(gc * r2)) * std::exp(-0.5 * gc.length());
+    }
+    veff->fft_transform(1);
+    potential.generate_D_operator_matrix();
+    for (int ia = 0; ia < ctx.unit_cell().num_atoms(); ia++) {
+        auto& d_mtrx = ctx.unit_cell().atom(ia).d_mtrx();
+        for (size_t i = 0; i < d_mtrx.size(); i++) {
+            res.d_mtrx.push_back(d_mtrx[i]);
+        }
+    }
+
+    /* ultrasoft contribution to the forces; the k-point set is empty */
+    K_point_set kset(ctx);
+    kset.initialize();
+    Forces_PS forces(ctx, density, potential, kset);
+    auto& f = forces.ultrasoft_forces();
+    for (size_t i = 0; i < f.size(); i++) {
+        res.forces.push_back(f[i]);
+    }
+
+    return res;
+}
+
+/* maximum difference relative to the maximum absolute value of the reference */
+template <typename T>
+double rel_diff(std::vector<T> const& ref__, std::vector<T> const& x__)
+{
+    double diff{0};
+    double norm{0};
+    for (size_t i = 0; i < ref__.size(); i++) {
+        diff = std::max(diff, std::abs(ref__[i] - x__[i]));
+        norm = std::max(norm, std::abs(ref__[i]));
+    }
+    double v[] = {diff, norm};
+    mpi_comm_world().allreduce<double, mpi_op_t::max>(v, 2);
+    /* a vanishing reference means that the test doesn't check anything */
+    return (v[1] > 0) ? v[0] / v[1] : 1.0;
+}
+
+/* compare the streaming mode of the augmentation operator with the full table of Q(G) */
+int test_aug_block(double pw_cutoff__, int aug_block_size__)
+{
+    std::string fname = "test_aug_block.pp.json";
+    if (mpi_comm_world().rank() == 0) {
+        write_synthetic_uspp(fname);
+    }
+    mpi_comm_world().barrier();
+
+    auto ref = compute(fname, pw_cutoff__, 0, 0);
+
+    int ierr{0};
+    /* no cache: every block except the first one is generated on the fly; partial cache: three blocks are stored */
+    for (int num_blocks: {0, 3}) {
+        auto res = compute(fname, pw_cutoff__, aug_block_size__, num_blocks);
+
+        double d_rho = rel_diff(ref.rho_aug, res.rho_aug);
+        double d_d   = rel_diff(ref.d_mtrx, res.d_mtrx);
+        double d_f   = rel_diff(ref.forces, res.forces);
+        if (mpi_comm_world().rank() == 0) {
+            printf("aug_block_size: %i, cached blocks: %i, number of local G-vectors: %i\n", res.block_size,
+                   num_blocks, res.num_gvec_loc);
+            printf("  relative difference of rho_aug: %12.6e, D-operator: %12.6e, ultrasoft forces: %12.6e\n",
+                   d_rho, d_d, d_f);
+        }
+        if (res.num_gvec_loc <= (num_blocks + 1) * aug_block_size__ || d_rho > 1e-12 || d_d > 1e-12 || d_f > 1e-12) {
+            ierr++;
+        }
+    }
+    return ierr;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--pw_cutoff=", "{double} plane-wave cutoff (a.u.^-1)");
+    args.register_key("--aug_block_size=", "{int} number of G-vectors in a block of Q(G)");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto pw_cutoff      = args.value<double>("pw_cutoff", 12);
+    auto aug_block_size = args.value<int>("aug_block_size", 100);
+
+    sirius::initialize(1);
+
+    int ierr = test_aug_block(pw_cutoff, aug_block_size);
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("%s\n", ierr ? "Fail" : "OK");
+    }
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,180 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* write a synthetic ultrasoft pseudopotential with s- and p-projectors and Gaussian augmentation functions */
+void write_synthetic_uspp(std::string fname__, double alpha__)
+{
+    int nr = 1500;
+    double r0{1e-6};
+    double rmax{8};
+    std::vector<double> r(nr);
+    for (int i = 0; i < nr; i++) {
+        r[i] = r0 * std::exp(i * std::log(rmax / r0) / (nr - 1));
+    }
+    auto f = [&](std::function<double(double)> g)
+    {
+        std::vector<double> v(nr);
+        for (int i = 0; i < nr; i++) {
+            v[i] = g(r[i]);
+        }
+        return v;
+    };
+
+    json pp;
+    pp["header"]["element"]        = "X";
+    pp["header"]["z_valence"]      = 2.0;
+    pp["header"]["mesh_size"]      = nr;
+    pp["header"]["number_of_proj"] = 2;
+    pp["radial_grid"]              = r;
+    pp["local_potential"]          = f([](double x){return -2 * std::erf(x) / x;});
+    pp["total_charge_density"]     = f([](double x){return 2 * x * x * std::exp(-x * x);});
+    for (int l: {0, 1}) {
+        json beta;
+        beta["angular_momentum"] = l;
+        beta["radial_function"]  = f([l](double x){return std::pow(x, l + 1) * std::exp(-x * x);});
+        pp["beta_projectors"].push_back(beta);
+    }
+    /* D_ion is zero, so only the integrals of the augmentation functions with the potential enter D */
+    pp["D_ion"] = std::vector<double>(4, 0);
+    /* Q_{ij}^{l}(r) r^2 for all allowed combinations of the orbital quantum numbers of the s- and p-projectors */
+    std::vector<std::array<int, 3>> ijl = {{0, 0, 0}, {0, 1, 1}, {1, 1, 0}, {1, 1, 2}};
+    for (auto& e: ijl) {
+        json q;
+        q["i"] = e[0];
+        q["j"] = e[1];
+        q["angular_momentum"] = e[2];
+        double c = 1 + 0.3 * e[0] + 0.2 * e[1] + 0.1 * e[2];
+        q["radial_function"] = f([&](double x){return c * std::pow(x, e[2] + 2) * std::exp(-alpha__ * x * x);});
+        pp["augmentation"].push_back(q);
+    }
+    json dict;
+    dict["pseudo_potential"] = pp;
+
+    std::ofstream(fname__) << dict.dump(4);
+}
+
+/* compare the real-space augmentation charge and D-operator with the G-space implementation */
+int test_aug_rg(double pw_cutoff__, double alpha__)
+{
+    std::string fname = "test_aug_rg.pp.json";
+    if (mpi_comm_world().rank() == 0) {
+        write_synthetic_uspp(fname, alpha__);
+    }
+    mpi_comm_world().barrier();
+
+    Simulation_context ctx(mpi_comm_world());
+    ctx.set_esm_type("pseudopotential");
+    ctx.set_processing_unit("cpu");
+    ctx.set_pw_cutoff(pw_cutoff__);
+    ctx.set_gk_cutoff(pw_cutoff__ / 2);
+    ctx.set_verbosity(0);
+    ctx.set_augment_real_space(true);
+    /* triclinic cell; the second atom is close to the cell boundary */
+    ctx.unit_cell().set_lattice_vectors({7.1, 0.3, 0.0}, {0.8, 6.7, 0.2}, {-0.4, 0.5, 7.4});
+    ctx.unit_cell().add_atom_type("X", fname);
+    ctx.unit_cell().add_atom("X", {0.11, 0.23, 0.37});
+    ctx.unit_cell().add_atom("X", {0.67, 0.02, 0.95});
+    ctx.initialize();
+
+    Potential potential(ctx);
+    potential.allocate();
+
+    Density density(ctx);
+    density.allocate();
+
+    int nv = ctx.num_mag_dims() + 1;
+
+    /* augmentation charge */
+    auto& dm = density.density_matrix();
+    for (size_t i = 0; i < dm.size(); i++) {
+        dm[i] = double_complex(std::sin(0.37 * i + 0.1), std::cos(1.3 * i));
+    }
+    mdarray<double_complex, 2> rho_aug(ctx.gvec().count(), nv);
+    mdarray<double_complex, 2> rho_aug_rg(ctx.gvec().count(), nv);
+    density.generate_rho_aug<CPU>(rho_aug);
+    density.generate_rho_aug_rg(rho_aug_rg);
+
+    double diff_rho{0};
+    double norm_rho{0};
+    for (int iv = 0; iv < nv; iv++) {
+        for (int igloc = 0; igloc < ctx.gvec().count(); igloc++) {
+            diff_rho = std::max(diff_rho, std::abs(rho_aug(igloc, iv) - rho_aug_rg(igloc, iv)));
+            norm_rho = std::max(norm_rho, std::abs(rho_aug(igloc, iv)));
+        }
+    }
+    mpi_comm_world().allreduce<double, mpi_op_t::max>(&diff_rho, 1);
+    mpi_comm_world().allreduce<double, mpi_op_t::max>(&norm_rho, 1);
+
+    /* D-operator matrix for a smooth real potential: V(-G) = V^{*}(G) */
+    auto veff = potential.effective_potential();
+    vector3d<double> r1({0.3, -1.2, 0.7});
+    vector3d<double> r2({1.5, 0.4, -0.9});
+    for (int igloc = 0; igloc < ctx.gvec().count(); igloc++) {
+        int ig = ctx.gvec().offset() + igloc;
+        auto gc = ctx.gvec().gvec_cart(ig);
+        veff->f_pw_local(igloc) = double_complex(std::cos(gc * r1), std::sin(gc * r2)) * std::exp(-0.5 * gc.length());
+    }
+    veff->fft_transform(1);
+
+    auto collect_d = [&]()
+    {
+        std::vector<double_complex> d;
+        for (int ia = 0; ia < ctx.unit_cell().num_atoms(); ia++) {
+            auto& d_mtrx = ctx.unit_cell().atom(ia).d_mtrx();
+            for (size_t i = 0; i < d_mtrx.size(); i++) {
+                d.push_back(d_mtrx[i]);
+            }
+        }
+        return d;
+    };
+
+    ctx.set_augment_real_space(false);
+    potential.generate_D_operator_matrix();
+    auto d_ref = collect_d();
+
+    ctx.set_augment_real_space(true);
+    potential.generate_D_operator_matrix();
+    auto d_rg = collect_d();
+
+    double diff_d{0};
+    double norm_d{0};
+    for (size_t i = 0; i < d_ref.size(); i++) {
+        diff_d = std::max(diff_d, std::abs(d_ref[i] - d_rg[i]));
+        norm_d = std::max(norm_d, std::abs(d_ref[i]));
+    }
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("pw_cutoff: %f, alpha: %f\n", pw_cutoff__, alpha__);
+        printf("rho_aug: max. value: %12.6e, max. difference: %12.6e\n", norm_rho, diff_rho);
+        printf("D-operator: max. value: %12.6e, max. difference: %12.6e\n", norm_d, diff_d);
+    }
+    return (diff_rho > 1e-6 * norm_rho || diff_d > 1e-6 * norm_d) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--pw_cutoff=", "{double} plane-wave cutoff (a.u.^-1)");
+    args.register_key("--alpha=", "{double} exponent of the Gaussian augmentation functions");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto pw_cutoff = args.value<double>("pw_cutoff", 12);
+    auto alpha     = args.value<double>("alpha", 1.0);
+
+    sirius::initialize(1);
+
+    int ierr = test_aug_rg(pw_cutoff, alpha);
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("%s\n", ierr ? "Fail" : "OK");
+    }
+
+    sirius::finalize();
+    return ierr;
+}
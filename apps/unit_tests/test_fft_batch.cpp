@@ -0,0 +1,162 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* compare the batched transformation with the transformation of individual functions and both of them with
+ * the direct summation over G-vectors, which does not depend on the pruning of the xy-transformation */
+int test_fft_batch(double cutoff__, int num_fft__, bool reduce__, bool sp_a2a__)
+{
+    matrix3d<double> M = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    /* FFT box is set for the doubled cutoff as in case of the wave-functions transformation */
+    FFT3D fft(find_translations(2 * cutoff__, M), mpi_comm_world(), CPU);
+
+    Gvec gvec(M, cutoff__, mpi_comm_world(), mpi_comm_world(), reduce__);
+
+    fft.prepare(gvec.partition());
+    /* in case of single precision exchange of z-sticks the result is accurate only to the float precision */
+    fft.a2a_single_precision(sp_a2a__);
+    double tol = sp_a2a__ ? 1e-6 : 1e-10;
+
+    int ngv = gvec.partition().gvec_count_fft();
+
+    mdarray<double_complex, 2> f(ngv, num_fft__);
+    for (int i = 0; i < num_fft__; i++) {
+        for (int ig = 0; ig < ngv; ig++) {
+            f(ig, i) = type_wrapper<double_complex>::random();
+        }
+        if (reduce__ && gvec.partition().gvec_offset_fft() == 0) {
+            f(0, i) = 1.0;
+        }
+    }
+
+    /* number of real-space functions */
+    int nrg = reduce__ ? num_fft__ / 2 : num_fft__;
+
+    /* reference real-space functions */
+    mdarray<double_complex, 2> f_rg(fft.local_size(), nrg);
+    for (int i = 0; i < nrg; i++) {
+        if (reduce__) {
+            fft.transform<1>(&f(0, 2 * i), &f(0, 2 * i + 1));
+        } else {
+            fft.transform<1>(&f(0, i));
+        }
+        fft.output(&f_rg(0, i));
+    }
+
+    /* reference real-space functions from the direct summation over G-vectors on the full grid */
+    mdarray<double_complex, 2> f_ref(fft.size(), nrg);
+    f_ref.zero();
+    for (int igloc = 0; igloc < ngv; igloc++) {
+        auto v = gvec.gvec(gvec.partition().gvec_offset_fft() + igloc);
+        bool g0 = (v[0] == 0 && v[1] == 0 && v[2] == 0);
+        for (int j2 = 0; j2 < fft.grid().size(2); j2++) {
+            for (int j1 = 0; j1 < fft.grid().size(1); j1++) {
+                for (int j0 = 0; j0 < fft.grid().size(0); j0++) {
+                    auto rl = vector3d<double>(double(j0) / fft.grid().size(0), 
+                                               double(j1) / fft.grid().size(1), 
+                                               double(j2) / fft.grid().size(2));
+                    auto e = std::exp(double_complex(0.0, twopi * (rl * v)));
+                    int idx = j0 + fft.grid().size(0) * (j1 + fft.grid().size(1) * j2);
+                    for (int i = 0; i < nrg; i++) {
+                        if (reduce__) {
+                            /* two real functions; coefficients of -G are the complex conjugates */
+                            double w = g0 ? 1 : 2;
+                            f_ref(idx, i) += double_complex(w * std::real(f(igloc, 2 * i) * e),
+                                                            w * std::real(f(igloc, 2 * i + 1) * e));
+                        } else {
+                            f_ref(idx, i) += f(igloc, i) * e;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    mpi_comm_world().allreduce(f_ref.at<CPU>(), static_cast<int>(f_ref.size()));
+
+    double diff_ref{0};
+    double norm_ref{0};
+    for (int i = 0; i < nrg; i++) {
+        for (int j2 = 0; j2 < fft.local_size_z(); j2++) {
+            for (int j1 = 0; j1 < fft.grid().size(1); j1++) {
+                for (int j0 = 0; j0 < fft.grid().size(0); j0++) {
+                    int idx = j0 + fft.grid().size(0) * (j1 + fft.grid().size(1) * (fft.offset_z() + j2));
+                    diff_ref += std::pow(std::abs(f_rg(fft.grid().index_by_coord(j0, j1, j2), i) - f_ref(idx, i)), 2);
+                    norm_ref += std::pow(std::abs(f_ref(idx, i)), 2);
+                }
+            }
+        }
+    }
+
+    fft.transform_batch<1>(num_fft__, f.at<CPU>(), f.ld());
+
+    double diff_rg{0};
+    for (int i = 0; i < nrg; i++) {
+        for (int ir = 0; ir < fft.local_size(); ir++) {
+            diff_rg += std::pow(std::abs(f_rg(ir, i) - fft.buffer_batch()(ir, i)), 2);
+        }
+    }
+
+    mdarray<double_complex, 2> g(ngv, num_fft__);
+    fft.transform_batch<-1>(num_fft__, g.at<CPU>(), g.ld());
+
+    double diff_pw{0};
+    for (int i = 0; i < num_fft__; i++) {
+        for (int ig = 0; ig < ngv; ig++) {
+            diff_pw += std::pow(std::abs(f(ig, i) - g(ig, i)), 2);
+        }
+    }
+    mpi_comm_world().allreduce(&diff_rg, 1);
+    mpi_comm_world().allreduce(&diff_pw, 1);
+    mpi_comm_world().allreduce(&diff_ref, 1);
+    mpi_comm_world().allreduce(&norm_ref, 1);
+    diff_rg = std::sqrt(diff_rg / fft.size() / nrg);
+    /* relative error with respect to the direct summation */
+    diff_ref = std::sqrt(diff_ref / norm_ref);
+    diff_pw = std::sqrt(diff_pw / gvec.num_gvec() / num_fft__);
+
+    fft.dismiss();
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("num_fft: %i, reduced: %i, sp_a2a: %i, rel. error (ref): %18.10e, error (r): %18.10e, error (G): %18.10e",
+               num_fft__, reduce__, sp_a2a__, diff_ref, diff_rg, diff_pw);
+    }
+    if (diff_ref > tol || diff_rg > tol || diff_pw > tol) {
+        if (mpi_comm_world().rank() == 0) {
+            printf("  Fail\n");
+        }
+        return 1;
+    }
+    if (mpi_comm_world().rank() == 0) {
+        printf("  OK\n");
+    }
+    return 0;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} cutoff radius in G-space");
+    args.register_key("--num_fft=", "{int} number of functions in a batch");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    double cutoff = args.value<double>("cutoff", 10);
+    int num_fft = args.value<int>("num_fft", 4);
+
+    sirius::initialize(1);
+
+    int ierr{0};
+    for (bool sp_a2a: {false, true}) {
+        ierr += test_fft_batch(cutoff, num_fft, false, sp_a2a);
+        ierr += test_fft_batch(cutoff, 2 * ((num_fft + 1) / 2), true, sp_a2a);
+    }
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,88 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* compare the compressed-row storage and the contraction kernels with the direct evaluation of Gaunt coefficients */
+template <typename T>
+int test_gaunt(int lmax1__, int lmax3__, int lmax2__, std::function<T(int, int, int, int, int, int)> get__)
+{
+    Gaunt_coefficients<T> gc(lmax1__, lmax3__, lmax2__, get__);
+
+    int lmmax1 = Utils::lmmax(lmax1__);
+    int lmmax2 = Utils::lmmax(lmax2__);
+    int lmmax3 = Utils::lmmax(lmax3__);
+
+    std::vector<double> v(lmmax3);
+    std::vector<double_complex> zv(lmmax3);
+    for (int lm3 = 0; lm3 < lmmax3; lm3++) {
+        v[lm3]  = std::sin(0.3 * lm3 + 0.1);
+        zv[lm3] = double_complex(std::cos(0.7 * lm3), std::sin(0.2 * lm3 - 0.5));
+    }
+
+    double diff{0};
+    std::vector<int> lm1_list;
+    std::vector<int> lm2_list;
+    std::vector<T> ref;
+    for (int l1 = 0, lm1 = 0; l1 <= lmax1__; l1++) {
+        for (int m1 = -l1; m1 <= l1; m1++, lm1++) {
+            for (int l2 = 0, lm2 = 0; l2 <= lmax2__; l2++) {
+                for (int m2 = -l2; m2 <= l2; m2++, lm2++) {
+                    T sum = 0;
+                    double_complex zsum = 0;
+                    int n{0};
+                    for (int l3 = 0, lm3 = 0; l3 <= lmax3__; l3++) {
+                        for (int m3 = -l3; m3 <= l3; m3++, lm3++) {
+                            T c = get__(l1, l3, l2, m1, m3, m2);
+                            if (std::abs(c) > 1e-12) {
+                                sum += c * v[lm3];
+                                zsum += c * zv[lm3];
+                                n++;
+                            }
+                        }
+                    }
+                    if (n != gc.num_gaunt(lm1, lm2) || n != static_cast<int>(gc.gaunt_vector(lm1, lm2).size())) {
+                        printf("wrong number of coefficients for lm1=%i lm2=%i\n", lm1, lm2);
+                        return 1;
+                    }
+                    for (auto& g: gc.gaunt_vector(lm1, lm2)) {
+                        int l3 = Utils::l_by_lm(lmax3__)[g.lm3];
+                        int m3 = g.lm3 - l3 * l3 - l3;
+                        diff = std::max(diff, std::abs(g.coef - get__(l1, l3, l2, m1, m3, m2)));
+                    }
+                    diff = std::max(diff, std::abs(gc.sum_L3_gaunt(lm1, lm2, &v[0]) - sum));
+                    diff = std::max(diff, std::abs(gc.sum_L3_gaunt(lm1, lm2, &zv[0]) - zsum));
+                    lm1_list.push_back(lm1);
+                    lm2_list.push_back(lm2);
+                    ref.push_back(sum);
+                }
+            }
+        }
+    }
+
+    /* batched contraction; all pairs use the same vector */
+    std::vector<int> offs(ref.size(), 0);
+    std::vector<T> result(ref.size());
+    gc.sum_L3_gaunt(static_cast<int>(ref.size()), lm1_list.data(), lm2_list.data(), v.data(), offs.data(),
+                    result.data());
+    for (size_t i = 0; i < ref.size(); i++) {
+        diff = std::max(diff, std::abs(result[i] - ref[i]));
+    }
+
+    printf("lmax: %i %i %i, number of pairs: %i, diff: %18.12e\n", lmax1__, lmax3__, lmax2__, lmmax1 * lmmax2, diff);
+    return (diff > 1e-12) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(1);
+
+    int ierr{0};
+    ierr += test_gaunt<double>(3, 6, 3, SHT::gaunt_rlm);
+    ierr += test_gaunt<double>(2, 8, 4, SHT::gaunt_rlm);
+    ierr += test_gaunt<double_complex>(4, 6, 4, SHT::gaunt_hybrid);
+
+    printf("%s\n", ierr ? "Fail" : "OK");
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,196 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* local arrays of the spinor wave-functions and of the first-variational eigen-vectors of a k-point */
+std::vector<mdarray<double_complex, 2>*> kpoint_arrays(Simulation_context& ctx__, K_point& kp__)
+{
+    std::vector<mdarray<double_complex, 2>*> result;
+    auto add = [&result](wave_functions& wf)
+    {
+        result.push_back(&wf.pw_coeffs().prime());
+        if (wf.has_mt() && wf.mt_coeffs().num_rows_loc()) {
+            result.push_back(&wf.mt_coeffs().prime());
+        }
+    };
+    for (int ispn = 0; ispn < ctx__.num_spins(); ispn++) {
+        add(kp__.spinor_wave_functions(ispn));
+    }
+    if (ctx__.full_potential()) {
+        add(kp__.fv_eigen_vectors_slab());
+    }
+    return result;
+}
+
+/* make the k-points of the first (or the second) half of the list expensive, re-distribute the k-points and
+ * check that every moved k-point has the same wave-functions on the new rank */
+int rebalance(Simulation_context& ctx__, K_point_set& kset__, bool first_half__)
+{
+    int nk   = kset__.num_kpoints();
+    int rank = kset__.comm().rank();
+
+    for (int ik = 0; ik < nk; ik++) {
+        kset__.solve_time(ik) = ((ik < nk / 2) == first_half__) ? 10 : 1;
+    }
+
+    /* copy of the local arrays before the k-points are moved */
+    auto spl_old = kset__.spl_num_kpoints();
+    std::map<int, std::vector<std::vector<double_complex>>> saved;
+    for (int ikloc = 0; ikloc < spl_old.local_size(); ikloc++) {
+        int ik = spl_old[ikloc];
+        for (auto a: kpoint_arrays(ctx__, *kset__[ik])) {
+            saved[ik].push_back(std::vector<double_complex>(a->at<CPU>(), a->at<CPU>() + a->size()));
+        }
+    }
+
+    kset__.rebalance();
+
+    auto& spl_new = kset__.spl_num_kpoints();
+
+    /* all ranks must have the same distribution of k-points */
+    std::vector<int> owner_min(nk);
+    std::vector<int> owner_max(nk);
+    for (int ik = 0; ik < nk; ik++) {
+        owner_min[ik] = owner_max[ik] = spl_new.local_rank(ik);
+    }
+    kset__.comm().allreduce<int, mpi_op_t::min>(owner_min.data(), nk);
+    kset__.comm().allreduce<int, mpi_op_t::max>(owner_max.data(), nk);
+    int nk_loc = spl_new.local_size();
+    kset__.comm().allreduce(&nk_loc, 1);
+
+    int err{0};
+    if (owner_min != owner_max || nk_loc != nk) {
+        err++;
+    }
+    for (int ikloc = 0; ikloc < spl_new.local_size(); ikloc++) {
+        if (spl_new.local_rank(spl_new[ikloc]) != rank) {
+            err++;
+        }
+    }
+
+    /* the old owner sends its copy of the arrays to the new owner which compares them bit by bit */
+    int num_moved{0};
+    std::vector<MPI_Request> req;
+    for (int ik = 0; ik < nk; ik++) {
+        int src = spl_old.local_rank(ik);
+        int dst = spl_new.local_rank(ik);
+        if (src == dst) {
+            continue;
+        }
+        num_moved++;
+        if (rank == src) {
+            for (auto& a: saved[ik]) {
+                req.push_back(MPI_Request());
+                kset__.comm().isend(a.data(), static_cast<int>(a.size()), dst, ik, &req.back());
+            }
+        }
+        if (rank == dst) {
+            auto arrays = kpoint_arrays(ctx__, *kset__[ik]);
+            for (auto a: arrays) {
+                std::vector<double_complex> buf(a->size());
+                kset__.comm().recv(buf.data(), static_cast<int>(buf.size()), src, ik);
+                if (std::memcmp(buf.data(), a->at<CPU>(), a->size() * sizeof(double_complex))) {
+                    err++;
+                }
+            }
+        }
+    }
+    MPI_Waitall(static_cast<int>(req.size()), req.data(), MPI_STATUSES_IGNORE);
+    kset__.comm().allreduce(&err, 1);
+
+    if (rank == 0) {
+        printf("number of k-points: %i, moved: %i, new distribution:", nk, num_moved);
+        for (int r = 0; r < kset__.comm().size(); r++) {
+            printf(" %i", spl_new.local_size(r));
+        }
+        printf(", errors: %i\n", err);
+    }
+    /* the skewed cost must move some k-points */
+    return (err || !num_moved) ? 1 : 0;
+}
+
+int test_rebalance(Simulation_context& ctx__)
+{
+    ctx__.set_processing_unit("cpu");
+    ctx__.set_std_evp_solver_name("lapack");
+    ctx__.set_gen_evp_solver_name("lapack");
+    ctx__.set_use_symmetry(false);
+    ctx__.set_verbosity(0);
+    ctx__.initialize();
+
+    K_point_set kset(ctx__, {2, 2, 2}, {0, 0, 0}, ctx__.use_symmetry());
+    kset.initialize();
+
+    for (int ikloc = 0; ikloc < kset.spl_num_kpoints().local_size(); ikloc++) {
+        int ik = kset.spl_num_kpoints(ikloc);
+        for (auto a: kpoint_arrays(ctx__, *kset[ik])) {
+            *a = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
+        }
+    }
+
+    /* k-points move from the first rank to the last one and back */
+    return rebalance(ctx__, kset, true) + rebalance(ctx__, kset, false);
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--upf=", "{string} Si pseudopotential file in the JSON format");
+    args.register_key("--species=", "{string} He species file for the full-potential test");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto upf     = args.value<std::string>("upf", "../../verification/test8/si_lda_v1.uspp.F.UPF.json");
+    auto species = args.value<std::string>("species", "../../verification/test2/He.json");
+
+    sirius::initialize(1);
+
+    if (mpi_comm_world().size() < 2) {
+        printf("test_rebalance must run on at least two MPI ranks\n");
+        sirius::finalize();
+        return 1;
+    }
+
+    int ierr{0};
+    {
+        /* pseudopotential with two spinor components */
+        Simulation_context ctx(mpi_comm_world());
+        ctx.set_esm_type("pseudopotential");
+        ctx.set_gk_cutoff(5);
+        ctx.set_pw_cutoff(10);
+        ctx.set_num_fv_states(8);
+        ctx.set_num_mag_dims(1);
+        ctx.unit_cell().set_lattice_vectors({0, 5.13, 5.13}, {5.13, 0, 5.13}, {5.13, 5.13, 0});
+        ctx.unit_cell().add_atom_type("Si", upf);
+        ctx.unit_cell().add_atom("Si", {0, 0, 0}, {0, 0, 1});
+        ctx.unit_cell().add_atom("Si", {0.25, 0.25, 0.25}, {0, 0, 1});
+        ierr += test_rebalance(ctx);
+    }
+    {
+        /* full-potential with the first-variational eigen-vectors */
+        Simulation_context ctx(mpi_comm_world());
+        ctx.set_esm_type("full_potential_lapwlo");
+        ctx.set_aw_cutoff(5);
+        ctx.set_pw_cutoff(12);
+        ctx.set_lmax_apw(6);
+        ctx.set_lmax_rho(6);
+        ctx.set_lmax_pot(6);
+        ctx.set_auto_rmt(0);
+        ctx.set_num_fv_states(4);
+        ctx.unit_cell().set_lattice_vectors({6, 0, 0}, {0, 6, 0}, {0, 0, 6});
+        ctx.unit_cell().add_atom_type("He", species);
+        ctx.unit_cell().add_atom("He", {0, 0, 0});
+        ierr += test_rebalance(ctx);
+    }
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("%s\n", ierr ? "Fail" : "OK");
+    }
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,93 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* compare the pipelined remap of matrix_storage with the blocking one */
+int test_remap(int num_rows__, int num_cols__, int idx0__, int batch_size__)
+{
+    auto& comm = mpi_comm_world();
+
+    /* distribution of rows between ranks */
+    block_data_descriptor row_distr(comm.size());
+    for (int i = 0; i < comm.size(); i++) {
+        row_distr.counts[i] = num_rows__ / comm.size() + std::min(1, std::max(0, num_rows__ % comm.size() - i));
+    }
+    row_distr.calc_offsets();
+    int nrow_loc = row_distr.counts[comm.rank()];
+
+    matrix_storage<double_complex, matrix_storage_t::slab> ref(nrow_loc, idx0__ + num_cols__, comm);
+    matrix_storage<double_complex, matrix_storage_t::slab> pipe(nrow_loc, idx0__ + num_cols__, comm);
+    for (int j = 0; j < idx0__ + num_cols__; j++) {
+        for (int i = 0; i < nrow_loc; i++) {
+            ref.prime(i, j) = pipe.prime(i, j) = type_wrapper<double_complex>::random();
+        }
+    }
+
+    ref.remap_forward(CPU, row_distr, num_cols__, idx0__);
+
+    int nb = pipe.remap_forward_begin(CPU, row_distr, num_cols__, idx0__, batch_size__);
+    int n_loc = pipe.spl_num_col().local_size();
+
+    double diff{0};
+    for (int ib = 0; ib < nb; ib++) {
+        pipe.remap_forward_wait(ib);
+        /* modify the sub-batch and send it back */
+        for (int i = std::min(n_loc, ib * batch_size__); i < std::min(n_loc, (ib + 1) * batch_size__); i++) {
+            for (int ig = 0; ig < row_distr.counts.back() + row_distr.offsets.back(); ig++) {
+                diff += std::abs(pipe.extra()(ig, i) - ref.extra()(ig, i));
+                pipe.extra()(ig, i) *= 2.0;
+            }
+        }
+        if (ib == 0) {
+            pipe.remap_backward_begin(CPU, row_distr, num_cols__, idx0__, batch_size__);
+        }
+        pipe.remap_backward_post(ib);
+    }
+    pipe.remap_backward_wait();
+
+    for (int j = 0; j < idx0__ + num_cols__; j++) {
+        double f = (j < idx0__) ? 1.0 : 2.0;
+        for (int i = 0; i < nrow_loc; i++) {
+            diff += std::abs(pipe.prime(i, j) - f * ref.prime(i, j));
+        }
+    }
+    comm.allreduce(&diff, 1);
+
+    if (comm.rank() == 0) {
+        printf("num_rows: %i, num_cols: %i, idx0: %i, batch_size: %i, number of sub-batches: %i, diff: %18.10e",
+               num_rows__, num_cols__, idx0__, batch_size__, nb, diff);
+    }
+    if (diff > 1e-14) {
+        if (comm.rank() == 0) {
+            printf("  Fail\n");
+        }
+        return 1;
+    }
+    if (comm.rank() == 0) {
+        printf("  OK\n");
+    }
+    return 0;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    sirius::initialize(1);
+
+    int ierr{0};
+    for (int num_cols: {1, 7, 20}) {
+        for (int batch_size: {1, 2, 3, 100}) {
+            ierr += test_remap(37, num_cols, 3, batch_size);
+        }
+    }
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,128 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/// Maximum number of calls of the band solver in converge().
+const int max_num_calls = 50;
+
+/* solve for the fixed potential until the band energies stop changing */
+int converge(K_point_set& kset__, Band& band__, Potential& potential__, int num_bands__)
+{
+    int num_calls{0};
+    double diff{1};
+    while (diff > 1e-10 && num_calls < max_num_calls) {
+        std::vector<double> e0;
+        for (int ik = 0; ik < kset__.num_kpoints(); ik++) {
+            for (int j = 0; j < num_bands__; j++) {
+                e0.push_back(kset__[ik]->band_energy(j));
+            }
+        }
+        band__.solve_for_kset(kset__, potential__, true);
+        diff = 0;
+        for (int ik = 0, i = 0; ik < kset__.num_kpoints(); ik++) {
+            for (int j = 0; j < num_bands__; j++, i++) {
+                diff = std::max(diff, std::abs(kset__[ik]->band_energy(j) - e0[i]));
+            }
+        }
+        num_calls++;
+    }
+    return num_calls;
+}
+
+/* compare the band energies of RMM-DIIS with the band energies of Davidson solver for the same Hamiltonian */
+int test_rmm_diis(std::string upf__, double gk_cutoff__, int num_bands__)
+{
+    Simulation_context ctx(mpi_comm_world());
+    ctx.set_esm_type("pseudopotential");
+    ctx.set_processing_unit("cpu");
+    ctx.set_std_evp_solver_name("lapack");
+    ctx.set_gen_evp_solver_name("lapack");
+    ctx.set_gk_cutoff(gk_cutoff__);
+    ctx.set_pw_cutoff(2 * gk_cutoff__);
+    ctx.set_num_fv_states(num_bands__);
+    ctx.set_verbosity(0);
+    /* no XC functionals: the Hamiltonian is built from the Hartree and the pseudopotential parts */
+    ctx.unit_cell().set_lattice_vectors({0, 5.13, 5.13}, {5.13, 0, 5.13}, {5.13, 5.13, 0});
+    ctx.unit_cell().add_atom_type("Si", upf__);
+    ctx.unit_cell().add_atom("Si", {0, 0, 0});
+    ctx.unit_cell().add_atom("Si", {0.25, 0.25, 0.25});
+    ctx.initialize();
+
+    Potential potential(ctx);
+    potential.allocate();
+
+    Density density(ctx);
+    density.allocate();
+    density.initial_density();
+    potential.generate(density);
+
+    K_point_set kset(ctx, {2, 2, 2}, {0, 0, 0}, ctx.use_symmetry());
+    kset.initialize();
+
+    Band band(ctx);
+
+    /* reference band energies */
+    ctx.set_iterative_solver_type("davidson");
+    ctx.set_iterative_solver_tolerance(1e-10);
+    band.initialize_subspace(kset, potential);
+    int n1 = converge(kset, band, potential, ctx.num_bands());
+
+    std::vector<double> e_ref;
+    for (int ik = 0; ik < kset.num_kpoints(); ik++) {
+        for (int j = 0; j < ctx.num_bands(); j++) {
+            e_ref.push_back(kset[ik]->band_energy(j));
+        }
+    }
+
+    /* start from the same subspace as in the beginning of the SCF cycle: RMM-DIIS falls back to Davidson solver
+       while the tolerance is above iterative_solver.rmm_diis_tolerance */
+    ctx.set_iterative_solver_type("rmm-diis");
+    ctx.set_iterative_solver_tolerance(1e-2);
+    band.initialize_subspace(kset, potential);
+    band.solve_for_kset(kset, potential, true);
+
+    ctx.set_iterative_solver_tolerance(1e-10);
+    int n2 = converge(kset, band, potential, ctx.num_bands());
+
+    double diff{0};
+    for (int ik = 0, i = 0; ik < kset.num_kpoints(); ik++) {
+        for (int j = 0; j < ctx.num_bands(); j++, i++) {
+            diff = std::max(diff, std::abs(kset[ik]->band_energy(j) - e_ref[i]));
+        }
+    }
+    if (mpi_comm_world().rank() == 0) {
+        printf("number of k-points: %i, number of bands: %i, calls of Davidson: %i, calls of RMM-DIIS: %i, "
+               "max. difference of band energies: %18.12e\n", kset.num_kpoints(), ctx.num_bands(), n1, n2, diff);
+    }
+    /* both solvers must converge before the limit on the number of calls is reached */
+    return (diff > 1e-9 || n1 >= max_num_calls || n2 >= max_num_calls) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--upf=", "{string} Si pseudopotential file in the JSON format");
+    args.register_key("--gk_cutoff=", "{double} cutoff for the G+k vectors (a.u.^-1)");
+    args.register_key("--num_bands=", "{int} number of bands");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto upf       = args.value<std::string>("upf", "../../verification/test8/si_lda_v1.uspp.F.UPF.json");
+    auto gk_cutoff = args.value<double>("gk_cutoff", 5.0);
+    auto num_bands = args.value<int>("num_bands", 8);
+
+    sirius::initialize(1);
+
+    int ierr = test_rmm_diis(upf, gk_cutoff, num_bands);
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("%s\n", ierr ? "Fail" : "OK");
+    }
+
+    sirius::finalize();
+    return ierr;
+}
@@ -0,0 +1,76 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* check that timers, started inside a parallel region, are accumulated and attached to the right node of the tree */
+int test_timer(int num_iter__)
+{
+    for (int iter = 0; iter < num_iter__; iter++) {
+        PROFILE("test_timer|outer");
+        #pragma omp parallel
+        {
+            sddk::timer t1("test_timer|inner");
+            #pragma omp for
+            for (int i = 0; i < 1000; i++) {
+                sddk::timer t2("test_timer|innermost");
+            }
+        }
+    }
+
+    int ierr{0};
+
+    auto stats = sddk::timer::collect_timer_stats();
+    int nt = omp_get_max_threads();
+    if (stats["test_timer|outer"].count != num_iter__) {
+        ierr++;
+    }
+    if (stats["test_timer|inner"].count != num_iter__ * nt) {
+        ierr++;
+    }
+    if (stats["test_timer|innermost"].count != num_iter__ * 1000) {
+        ierr++;
+    }
+
+    auto tree = sddk::timer::collect_tree_stats();
+    std::string path = main_timer_label + "\ttest_timer|outer\ttest_timer|inner";
+    if (tree[path].count != num_iter__ * nt || tree[path + "\ttest_timer|innermost"].count != num_iter__ * 1000) {
+        ierr++;
+    }
+    for (auto& e: tree) {
+        if (e.first.find("test_timer") == 0) {
+            /* worker threads must not create the separate root nodes */
+            ierr++;
+        }
+    }
+    if (mpi_comm_world().rank() == 0) {
+        printf("number of threads: %i, number of iterations: %i", nt, num_iter__);
+        if (ierr) {
+            printf("  Fail\n");
+        } else {
+            printf("  OK\n");
+        }
+    }
+    return ierr;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.register_key("--num_iter=", "{int} number of iterations");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    int num_iter = args.value<int>("num_iter", 10);
+
+    sirius::initialize(1);
+    int ierr = test_timer(num_iter);
+    sddk::timer::print();
+    sddk::timer::write_json_tree("test_timer.json");
+    sirius::finalize();
+    return ierr;
+}
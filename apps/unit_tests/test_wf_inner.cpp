@@ -0,0 +1,108 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* compare the pipelined inner product with the product of the full matrices */
+template <typename T>
+int test_wf_inner(std::vector<int> mpi_grid_dims__, double cutoff__, int m__, int n__, int bs__, double beta__)
+{
+    bool reduce = std::is_same<T, double>::value;
+
+    BLACS_grid blacs_grid(mpi_comm_world(), mpi_grid_dims__[0], mpi_grid_dims__[1]);
+
+    /* hexagonal cell with a = 12 and c = 14 a.u. */
+    matrix3d<double> L = {{12, -6, 0}, {0, 6 * std::sqrt(3.0), 0}, {0, 0, 14}};
+    matrix3d<double> M = transpose(inverse(L)) * twopi;
+
+    Gvec gvec(M, cutoff__, mpi_comm_world(), mpi_comm_world(), reduce);
+
+    wave_functions phi(CPU, gvec, m__);
+    wave_functions psi(CPU, gvec, n__);
+
+    phi.pw_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
+    psi.pw_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
+
+    int ngv = phi.pw_coeffs().num_rows_loc();
+
+    /* reference overlap of the local G-vectors is computed with a single gemm */
+    matrix<double_complex> z(m__, n__);
+    linalg<CPU>::gemm(2, 0, m__, n__, ngv, phi.pw_coeffs().prime().at<CPU>(), phi.pw_coeffs().prime().ld(),
+                      psi.pw_coeffs().prime().at<CPU>(), psi.pw_coeffs().prime().ld(), z.at<CPU>(), z.ld());
+
+    mdarray<T, 2> ref(m__, n__);
+    for (int j = 0; j < n__; j++) {
+        for (int i = 0; i < m__; i++) {
+            if (reduce) {
+                z(i, j) = 2.0 * z(i, j).real();
+                if (mpi_comm_world().rank() == 0) {
+                    z(i, j) -= phi.pw_coeffs().prime(0, i).real() * psi.pw_coeffs().prime(0, j).real();
+                }
+            }
+            ref(i, j) = type_wrapper<T>::bypass(z(i, j));
+        }
+    }
+    mpi_comm_world().allreduce(ref.template at<CPU>(), m__ * n__);
+
+    dmatrix<T> ovlp(m__, n__, blacs_grid, bs__, bs__);
+    for (int j = 0; j < ovlp.num_cols_local(); j++) {
+        for (int i = 0; i < ovlp.num_rows_local(); i++) {
+            ovlp(i, j) = 1;
+            ref(ovlp.irow(i), ovlp.icol(j)) += beta__;
+        }
+    }
+
+    inner(phi, 0, m__, psi, 0, n__, beta__, ovlp, 0, 0);
+
+    double diff{0};
+    for (int j = 0; j < ovlp.num_cols_local(); j++) {
+        for (int i = 0; i < ovlp.num_rows_local(); i++) {
+            diff = std::max(diff, std::abs(ovlp(i, j) - ref(ovlp.irow(i), ovlp.icol(j))));
+        }
+    }
+    mpi_comm_world().allreduce<double, mpi_op_t::max>(&diff, 1);
+
+    if (diff > 1e-10) {
+        if (mpi_comm_world().rank() == 0) {
+            printf("m: %i, n: %i, real: %i, beta: %f, error: %18.10e  Fail\n", m__, n__, reduce, beta__, diff);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+    args.register_key("--mpi_grid_dims=", "{int int} dimensions of MPI grid");
+    args.register_key("--cutoff=", "{double} wave-functions cutoff (a.u.^-1)");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+    auto mpi_grid_dims = args.value< std::vector<int> >("mpi_grid_dims", {1, 1});
+    auto cutoff = args.value<double>("cutoff", 4.0);
+
+    sirius::initialize(1);
+
+    int ierr{0};
+    /* small matrices are not split into panels */
+    for (int n: {1, 7, 33}) {
+        ierr += test_wf_inner<double_complex>(mpi_grid_dims, cutoff, n + 3, n, 16, 0.0);
+        ierr += test_wf_inner<double>(mpi_grid_dims, cutoff, n, n + 5, 16, 1.0);
+    }
+    /* large matrices go through the calibration of the block size and then use the selected one */
+    for (int i = 0; i < 10; i++) {
+        ierr += test_wf_inner<double_complex>(mpi_grid_dims, cutoff, 1100 + i, 1030, 32, (i % 2) ? 1.0 : 0.0);
+    }
+    ierr += test_wf_inner<double>(mpi_grid_dims, cutoff, 700, 900, 32, 0.0);
+
+    if (mpi_comm_world().rank() == 0) {
+        printf("%s\n", ierr ? "Fail" : "OK");
+    }
+
+    sirius::finalize();
+    return ierr;
+}
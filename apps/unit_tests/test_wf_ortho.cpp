@@ -31,31 +31,54 @@ void test_wf_ortho(std::vector<int> mpi_grid_dims__,
         return 20;
     };
 
-    wave_functions phi(pu, gvec, num_atoms, nmt, 2 * num_bands__);
-    wave_functions hphi(pu, gvec, num_atoms, nmt, 2 * num_bands__);
-    wave_functions tmp(pu, gvec, num_atoms, nmt, 2 * num_bands__);
+    wave_functions phi(pu, gvec, num_atoms, nmt, 3 * num_bands__);
+    wave_functions hphi(pu, gvec, num_atoms, nmt, 3 * num_bands__);
+    wave_functions tmp(pu, gvec, num_atoms, nmt, 3 * num_bands__);
     
     phi.pw_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
     phi.mt_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
     hphi.pw_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
     hphi.mt_coeffs().prime() = [](int64_t i0, int64_t i1){return type_wrapper<double_complex>::random();};
 
-    dmatrix<double_complex> ovlp(2 * num_bands__, 2 * num_bands__, blacs_grid, bs__, bs__);
+    dmatrix<double_complex> ovlp(3 * num_bands__, 3 * num_bands__, blacs_grid, bs__, bs__);
     
+    /* check the overlap of the first n functions */
+    auto check_ovlp = [&](int n__, double tol__)
+    {
+        inner(phi, 0, n__, phi, 0, n__, 0.0, ovlp, 0, 0);
+
+        for (int j = 0; j < ovlp.num_cols_local(); j++) {
+            for (int i = 0; i < ovlp.num_rows_local(); i++) {
+                if (ovlp.irow(i) >= n__ || ovlp.icol(j) >= n__) {
+                    continue;
+                }
+                double_complex z = (ovlp.irow(i) == ovlp.icol(j)) ? ovlp(i, j) - 1.0 : ovlp(i, j);
+                if (std::abs(z) > tol__) {
+                    printf("test_wf_ortho: wrong overlap");
+                    exit(1);
+                }
+            }
+        }
+    };
+
     orthogonalize<double_complex>(0, num_bands__, phi, hphi, ovlp, tmp);
     orthogonalize<double_complex>(num_bands__, num_bands__, phi, hphi, ovlp, tmp);
 
-    inner(phi, 0, 2 * num_bands__, phi, 0, 2 * num_bands__, 0.0, ovlp, 0, 0);
+    check_ovlp(2 * num_bands__, 1e-12);
 
-    for (int j = 0; j < ovlp.num_cols_local(); j++) {
-        for (int i = 0; i < ovlp.num_rows_local(); i++) {
-            double_complex z = (ovlp.irow(i) == ovlp.icol(j)) ? ovlp(i, j) - 1.0 : ovlp(i, j);
-            if (std::abs(z) > 1e-12) {
-                printf("test_wf_ortho: wrong overlap");
-                exit(1);
-            }
+    /* new functions which are almost linearly dependent on the old ones */
+    for (int i = 0; i < num_bands__; i++) {
+        for (int ig = 0; ig < phi.pw_coeffs().num_rows_loc(); ig++) {
+            phi.pw_coeffs().prime(ig, 2 * num_bands__ + i) = phi.pw_coeffs().prime(ig, i) +
+                                                              1e-5 * type_wrapper<double_complex>::random();
+        }
+        for (int j = 0; j < phi.mt_coeffs().num_rows_loc(); j++) {
+            phi.mt_coeffs().prime(j, 2 * num_bands__ + i) = phi.mt_coeffs().prime(j, i);
         }
     }
+    orthogonalize<double_complex>(2 * num_bands__, num_bands__, phi, hphi, ovlp, tmp);
+
+    check_ovlp(3 * num_bands__, 1e-10);
 }
 
 int main(int argn, char** argv)
@@ -0,0 +1,112 @@
+#include <sirius.h>
+
+using namespace sirius;
+
+/* compare built-in implementation of XC functionals with libxc */
+int test_xc_native(std::string name__, int num_spins__)
+{
+    XC_functional f_ref(name__, num_spins__, "libxc");
+    XC_functional f_nat(name__, num_spins__, "native");
+
+    /* random points */
+    int np_rnd{1000};
+    /* fixed points: low densities close to the threshold, fully polarized densities and zero gradients */
+    std::vector<std::array<double, 3>> fixed;
+    for (double rho: {1e-14, 1e-10, 1.0}) {
+        for (double z: {-1.0, 0.0, 0.3, 1.0}) {
+            for (double s: {0.0, 0.5}) {
+                fixed.push_back({rho, z, s});
+            }
+        }
+    }
+    int np = np_rnd + static_cast<int>(fixed.size());
+
+    /* density of spin up and down and sigma_uu, sigma_ud, sigma_dd */
+    mdarray<double, 2> in(np, 5);
+    for (int i = 0; i < np_rnd; i++) {
+        double rho = std::pow(10, -4 + 6 * type_wrapper<double>::random());
+        double z   = 2 * type_wrapper<double>::random() - 1;
+        in(i, 0) = 0.5 * rho * (1 + z);
+        in(i, 1) = 0.5 * rho * (1 - z);
+        for (int j = 2; j < 5; j++) {
+            in(i, j) = std::pow(rho, 8.0 / 3) * std::pow(10, -2 + 3 * type_wrapper<double>::random());
+        }
+        /* make sure that sigma_ud^2 <= sigma_uu * sigma_dd */
+        in(i, 3) = (2 * type_wrapper<double>::random() - 1) * std::sqrt(in(i, 2) * in(i, 4));
+    }
+    for (int i = np_rnd; i < np; i++) {
+        auto& p = fixed[i - np_rnd];
+        in(i, 0) = 0.5 * p[0] * (1 + p[1]);
+        in(i, 1) = 0.5 * p[0] * (1 - p[1]);
+        in(i, 2) = p[2] * std::pow(in(i, 0), 8.0 / 3);
+        in(i, 4) = p[2] * std::pow(in(i, 1), 8.0 / 3);
+        in(i, 3) = 0.3 * std::sqrt(in(i, 2) * in(i, 4));
+    }
+    std::vector<double> rho(np);
+    std::vector<double> sigma(np);
+    for (int i = 0; i < np; i++) {
+        rho[i]   = in(i, 0) + in(i, 1);
+        sigma[i] = in(i, 2) + 2 * in(i, 3) + in(i, 4);
+    }
+
+    mdarray<double, 2> out_ref(np, 6);
+    mdarray<double, 2> out_nat(np, 6);
+    out_ref.zero();
+    out_nat.zero();
+
+    for (auto f: {&f_ref, &f_nat}) {
+        auto& out = (f == &f_ref) ? out_ref : out_nat;
+        if (f->is_lda() && num_spins__ == 1) {
+            f->get_lda(np, rho.data(), &out(0, 1), &out(0, 0));
+        }
+        if (f->is_lda() && num_spins__ == 2) {
+            f->get_lda(np, &in(0, 0), &in(0, 1), &out(0, 1), &out(0, 2), &out(0, 0));
+        }
+        if (f->is_gga() && num_spins__ == 1) {
+            f->get_gga(np, rho.data(), sigma.data(), &out(0, 1), &out(0, 2), &out(0, 0));
+        }
+        if (f->is_gga() && num_spins__ == 2) {
+            f->get_gga(np, &in(0, 0), &in(0, 1), &in(0, 2), &in(0, 3), &in(0, 4), &out(0, 1), &out(0, 2),
+                       &out(0, 3), &out(0, 4), &out(0, 5), &out(0, 0));
+        }
+    }
+
+    double diff{0};
+    for (int j = 0; j < 6; j++) {
+        for (int i = 0; i < np_rnd; i++) {
+            diff = std::max(diff, std::abs(out_ref(i, j) - out_nat(i, j)) / (1 + std::abs(out_ref(i, j))));
+        }
+    }
+    /* the values at the fixed points can be small, so the difference is relative to the value itself */
+    double diff_fixed{0};
+    for (int j = 0; j < 6; j++) {
+        for (int i = np_rnd; i < np; i++) {
+            double d = std::abs(out_ref(i, j) - out_nat(i, j));
+            diff_fixed = std::max(diff_fixed, (out_ref(i, j) == 0) ? d : d / std::abs(out_ref(i, j)));
+        }
+    }
+    printf("%-20s num_spins: %i, max. relative difference: %18.10e, at the fixed points: %18.10e", name__.c_str(),
+           num_spins__, diff, diff_fixed);
+    if (diff > 1e-8 || diff_fixed > 1e-8) {
+        printf("  Fail\n");
+        return 1;
+    }
+    printf("  OK\n");
+    return 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(1);
+
+    int ierr{0};
+    for (auto name: {"XC_LDA_X", "XC_LDA_C_PZ", "XC_LDA_C_PW", "XC_LDA_C_PW_MOD", "XC_GGA_X_PBE", "XC_GGA_X_PBE_SOL",
+                     "XC_GGA_C_PBE", "XC_GGA_C_PBE_SOL"}) {
+        for (int num_spins: {1, 2}) {
+            ierr += test_xc_native(name, num_spins);
+        }
+    }
+
+    sirius::finalize();
+    return ierr;
+}
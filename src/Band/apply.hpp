@@ -556,7 +556,7 @@ inline void Band::apply_fv_h_o(K_point* kp__,
             for (int xi = 0; xi < naw; xi++) {
                 int lm_aw    = type.indexb(xi).lm;
                 int idxrf_aw = type.indexb(xi).idxrf;
-                auto& gc     = gaunt_coefs_->gaunt_vector(lm_aw, lm_lo);
+                auto gc      = gaunt_coefs_->gaunt_vector(lm_aw, lm_lo);
                 hmt(xi, ilo) = atom.radial_integrals_sum_L3<spin_block_t::nm>(idxrf_aw, idxrf_lo, gc);
             }
         }
@@ -611,7 +611,7 @@ inline void Band::apply_fv_h_o(K_point* kp__,
                         int lm1    = type.indexb(xi_lo1).lm;
                         int order1 = type.indexb(xi_lo1).order;
                         int idxrf1 = type.indexb(xi_lo1).idxrf;
-                        auto& gc   = gaunt_coefs_->gaunt_vector(lm_lo, lm1);
+                        auto gc    = gaunt_coefs_->gaunt_vector(lm_lo, lm1);
                         if (lm_lo == lm1) {
                             ophi__.mt_coeffs().prime(ophi__.offset_mt_coeffs(ia_location.local_index) + ilo, N__ + i) +=
                                 phi_lo_ia(jlo, i) * atom.symmetry_class().o_radial_integral(l_lo, order_lo, order1);
@@ -631,7 +631,7 @@ inline void Band::apply_fv_h_o(K_point* kp__,
                     for (int xi = 0; xi < naw; xi++) {
                         int lm_aw    = type.indexb(xi).lm;
                         int idxrf_aw = type.indexb(xi).idxrf;
-                        auto& gc     = gaunt_coefs_->gaunt_vector(lm_lo, lm_aw);
+                        auto gc      = gaunt_coefs_->gaunt_vector(lm_lo, lm_aw);
                         z += atom.radial_integrals_sum_L3<spin_block_t::nm>(idxrf_lo, idxrf_aw, gc) * alm_phi(xi, i);
                     }
                     /* lo-APW contribution */
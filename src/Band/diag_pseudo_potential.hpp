@@ -691,382 +691,379 @@ inner_local<double_complex>(K_point* kp__,
     return result;
 }
 
+/// RMM-DIIS diagonalization of the pseudopotential Hamiltonian.
+/** The residual minimization with direct inversion in the iterative subspace refines each band independently:
+ *  a first preconditioned steepest descent step with a line search defines the trial step \f$ \lambda_i \f$ of
+ *  the band and the following steps minimize the norm of the residual in the history of the trial vectors:
+ *  \f[
+ *      \tilde \phi_i^{(j)} = \sum_{k < j} c_k \phi_i^{(k)}, \quad
+ *      \tilde R_i^{(j)} = \sum_{k < j} c_k R_i^{(k)}, \quad \sum_{k < j} c_k = 1, \quad
+ *      \phi_i^{(j)} = \tilde \phi_i^{(j)} + \lambda_i K \tilde R_i^{(j)}
+ *  \f]
+ *  The bands are not orthogonalized during the iterations and no subspace matrices are diagonalized; the
+ *  H and O operators are applied to the block of unconverged bands at once and the per-band scalar products of a
+ *  step are reduced in a single call. A single Rayleigh-Ritz rotation of the refined bands is done at the end.
+ *  The length of the DIIS history of each band is set by the iterative_solver.subspace_size parameter. */
 template <typename T>
-inline void Band::diag_pseudo_potential_rmm_diis(K_point* kp__,
-                                                 int ispn__,
-                                                 D_operator<T>& d_op__,
-                                                 Q_operator<T>& q_op__) const
+inline int Band::diag_pseudo_potential_rmm_diis(K_point* kp__,
+                                                int ispn__,
+                                                D_operator<T>& d_op__,
+                                                Q_operator<T>& q_op__) const
 
 {
-    //auto& itso = ctx_.iterative_solver_input();
-    double tol = ctx_.iterative_solver_tolerance();
+    PROFILE("sirius::Band::diag_pseudo_potential_rmm_diis");
 
-    if (tol > 1e-4) {
-        diag_pseudo_potential_davidson(kp__, d_op__, q_op__);
-        return;
-    }
+    auto& itso = ctx_.iterative_solver_input();
 
-    PROFILE("sirius::Band::diag_pseudo_potential_rmm_diis");
+    /* short notation for number of target wave-functions */
+    int num_bands = ctx_.num_fv_states();
+
+    /* length of the DIIS history of each band */
+    int num_hist = std::max(itso.subspace_size_, 2);
+
+    /* short notation for target wave-functions */
+    auto& psi = kp__->spinor_wave_functions(ispn__);
+
+    int ngk = kp__->num_gkvec_loc();
+
+    sddk::timer t1("sirius::Band::diag_pseudo_potential_rmm_diis|wf");
+    /* total memory size of all wave-functions */
+    size_t size = sizeof(double_complex) * ngk * (4 * num_hist * num_bands + 3 * num_bands);
+    /* get preallocatd memory buffer */
+    double_complex* mem_buf_ptr = static_cast<double_complex*>(ctx_.memory_buffer(size));
+
+    /* history of trial wave-functions, their residuals and H, O applied to them;
+     * j-th step of the i-th band is stored in the column j * num_bands + i */
+    Wave_functions phi(mem_buf_ptr, CPU, kp__->gkvec(), num_hist * num_bands, 1);
+    mem_buf_ptr += ngk * num_hist * num_bands;
+
+    Wave_functions hphi(mem_buf_ptr, CPU, kp__->gkvec(), num_hist * num_bands, 1);
+    mem_buf_ptr += ngk * num_hist * num_bands;
+
+    Wave_functions ophi(mem_buf_ptr, CPU, kp__->gkvec(), num_hist * num_bands, 1);
+    mem_buf_ptr += ngk * num_hist * num_bands;
+
+    Wave_functions res(mem_buf_ptr, CPU, kp__->gkvec(), num_hist * num_bands, 1);
+    mem_buf_ptr += ngk * num_hist * num_bands;
+
+    /* temporary arrays for a block of bands */
+    Wave_functions phi_tmp(mem_buf_ptr, CPU, kp__->gkvec(), num_bands, 1);
+    mem_buf_ptr += ngk * num_bands;
+
+    Wave_functions hphi_tmp(mem_buf_ptr, CPU, kp__->gkvec(), num_bands, 1);
+    mem_buf_ptr += ngk * num_bands;
+
+    Wave_functions ophi_tmp(mem_buf_ptr, CPU, kp__->gkvec(), num_bands, 1);
+    t1.stop();
+
+    kp__->beta_projectors().prepare();
 
     /* get diagonal elements for preconditioning */
-    //auto h_diag = get_h_diag(kp__, ispn__, local_op_->v0(ispn__), d_op__);
-    //auto o_diag = get_o_diag(kp__, q_op__);
-    STOP();
-
-//    /* short notation for number of target wave-functions */
-//    int num_bands = ctx_.num_fv_states();
-//
-//    //auto pu = ctx_.processing_unit();
-//
-//    /* short notation for target wave-functions */
-//    auto& psi = kp__->spinor_wave_functions(ispn__);
-//
-//    int niter = itso.num_steps_;
-//
-//    Eigenproblem_lapack evp_solver(2 * linalg_base::dlamch('S'));
-//
-//    std::vector<wave_functions*> phi(niter);
-//    std::vector<wave_functions*> res(niter);
-//    std::vector<wave_functions*> ophi(niter);
-//    std::vector<wave_functions*> hphi(niter);
-//
-//    for (int i = 0; i < niter; i++) {
-//        phi[i]  = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//        res[i]  = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//        hphi[i] = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//        ophi[i] = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//    }
-//
-//    wave_functions  phi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//    wave_functions hphi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//    wave_functions ophi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-//
-//    auto mem_type = (gen_evp_solver_->type() == ev_magma) ? memory_t::host_pinned : memory_t::host;
-//
-//    int bs = ctx_.cyclic_block_size();
-//
-//    dmatrix<T> hmlt(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-//    dmatrix<T> ovlp(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-//    dmatrix<T> evec(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-//    dmatrix<T> hmlt_old;
-//    dmatrix<T> ovlp_old;
-//
-//    std::vector<double> eval(num_bands);
-//    for (int i = 0; i < num_bands; i++) {
-//        eval[i] = kp__->band_energy(i);
-//    }
-//    std::vector<double> eval_old(num_bands);
-//
-//    /* trial basis functions */
-//    phi[0]->copy_from(psi, 0, num_bands);
-//
-//    std::vector<int> last(num_bands, 0);
-//    std::vector<bool> conv_band(num_bands, false);
-//    std::vector<double> res_norm(num_bands);
-//    std::vector<double> res_norm_start(num_bands);
-//    std::vector<double> lambda(num_bands, 0);
-//    
-//    auto update_res = [kp__, num_bands, &phi, &res, &hphi, &ophi, &last, &conv_band]
-//                      (std::vector<double>& res_norm__, std::vector<double>& eval__) -> void
-//    {
-//        sddk::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|res");
-//        std::vector<double> e_tmp(num_bands, 0), d_tmp(num_bands, 0);
-//
-//        #pragma omp parallel for
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                e_tmp[i] = std::real(inner_local<T>(kp__, *phi[last[i]], i, *hphi[last[i]], i));
-//                d_tmp[i] = std::real(inner_local<T>(kp__, *phi[last[i]], i, *ophi[last[i]], i));
-//            }
-//        }
-//        kp__->comm().allreduce(e_tmp);
-//        kp__->comm().allreduce(d_tmp);
-//        
-//        res_norm__ = std::vector<double>(num_bands, 0);
-//        #pragma omp parallel for
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                eval__[i] = e_tmp[i] / d_tmp[i];
-//
-//                /* compute residual r_{i} = H\Psi_{i} - E_{i}O\Psi_{i} */
-//                for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-//                    (*res[last[i]]).pw_coeffs().prime(igk, i) = (*hphi[last[i]]).pw_coeffs().prime(igk, i) - eval__[i] * (*ophi[last[i]]).pw_coeffs().prime(igk, i);
-//                }
-//                res_norm__[i] = std::real(inner_local<T>(kp__, *res[last[i]], i, *res[last[i]], i));
-//            }
-//        }
-//        kp__->comm().allreduce(res_norm__);
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                res_norm__[i] = std::sqrt(res_norm__[i]);
-//            }
-//        }
-//    };
-//
-//    auto apply_h_o = [this, kp__, num_bands, &phi, &phi_tmp, &hphi, &hphi_tmp, &ophi, &ophi_tmp, &conv_band, &last,
-//                      &d_op__, &q_op__, ispn__]() -> int
-//    {
-//        sddk::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|h_o");
-//        int n{0};
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                std::memcpy(&phi_tmp.pw_coeffs().prime(0, n), &(*phi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-//                n++;
-//            }
-//        }
-//
-//        if (n == 0) {
-//            return 0;
-//        }
-//        
-//        /* apply Hamiltonian and overlap operators to the initial basis functions */
-//        this->apply_h_o<T>(kp__, ispn__, 0, n, phi_tmp, hphi_tmp, ophi_tmp, d_op__, q_op__);
-//
-//        n = 0;
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                std::memcpy(&(*hphi[last[i]]).pw_coeffs().prime(0, i), &hphi_tmp.pw_coeffs().prime(0, n), kp__->num_gkvec_loc() * sizeof(double_complex));
-//                std::memcpy(&(*ophi[last[i]]).pw_coeffs().prime(0, i), &ophi_tmp.pw_coeffs().prime(0, n), kp__->num_gkvec_loc() * sizeof(double_complex));
-//                n++;
-//            }
-//        }
-//        return n;
-//    };
-//
-//    STOP();
-//
-//    //auto apply_preconditioner = [kp__, num_bands, &h_diag, &o_diag, &eval, &conv_band]
-//    //                            (std::vector<double> lambda,
-//    //                             wave_functions& res__,
-//    //                             double alpha,
-//    //                             wave_functions& kres__) -> void
-//    //{
-//    //    sddk::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|pre");
-//    //    #pragma omp parallel for
-//    //    for (int i = 0; i < num_bands; i++) {
-//    //        if (!conv_band[i]) {
-//    //            for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-//    //                double p = h_diag[igk] - eval[i] * o_diag[igk];
-//
-//    //                p *= 2; // QE formula is in Ry; here we convert to Ha
-//    //                p = 0.25 * (1 + p + std::sqrt(1 + (p - 1) * (p - 1)));
-//    //                kres__.pw_coeffs().prime(igk, i) = alpha * kres__.pw_coeffs().prime(igk, i) + lambda[i] * res__.pw_coeffs().prime(igk, i) / p;
-//    //            }
-//    //        }
-//
-//    //        //== double Ekin = 0;
-//    //        //== double norm = 0;
-//    //        //== for (int igk = 0; igk < kp__->num_gkvec(); igk++)
-//    //        //== {
-//    //        //==     Ekin += 0.5 * std::pow(std::abs(res__(igk, i)), 2) * std::pow(kp__->gkvec_cart(igk).length(), 2);
-//    //        //==     norm += std::pow(std::abs(res__(igk, i)), 2);
-//    //        //== }
-//    //        //== Ekin /= norm;
-//    //        //== for (int igk = 0; igk < kp__->num_gkvec(); igk++)
-//    //        //== {
-//    //        //==     double x = std::pow(kp__->gkvec_cart(igk).length(), 2) / 3 / Ekin;
-//    //        //==     kres__(igk, i) = alpha * kres__(igk, i) + lambda[i] * res__(igk, i) * 
-//    //        //==         (4.0 / 3 / Ekin) * (27 + 18 * x + 12 * x * x + 8 * x * x * x) / (27 + 18 * x + 12 * x * x + 8 * x * x * x + 16 * x * x * x * x);
-//    //        //== }
-//    //    }
-//    //};
-//
-//    /* apply Hamiltonian and overlap operators to the initial basis functions */
-//    this->apply_h_o<T>(kp__, ispn__, 0, num_bands, *phi[0], *hphi[0], *ophi[0], d_op__, q_op__);
-//    
-//    /* compute initial residuals */
-//    update_res(res_norm_start, eval);
-//
-//    bool conv{true};
-//    for (int i = 0; i < num_bands; i++) {
-//        if (res_norm_start[i] > itso.residual_tolerance_) {
-//            conv = false;
-//        }
-//    }
-//    if (conv) {
-//        DUMP("all bands are converged at stage#0");
-//        return;
-//    }
-//
-//    last = std::vector<int>(num_bands, 1);
-//    
-//    phi[1]->pw_coeffs().prime().zero();
-//    /* apply preconditioner to the initial residuals */
-//    //apply_preconditioner(std::vector<double>(num_bands, 1), *res[0], 0.0, *phi[1]);
-//    STOP();
-//    
-//    /* apply H and O to the preconditioned residuals */
-//    apply_h_o();
-//
-//    /* estimate lambda */
-//    std::vector<double> f1(num_bands, 0);
-//    std::vector<double> f2(num_bands, 0);
-//    std::vector<double> f3(num_bands, 0);
-//    std::vector<double> f4(num_bands, 0);
-//
-//    #pragma omp parallel for
-//    for (int i = 0; i < num_bands; i++) {
-//        if (!conv_band[i]) {
-//            f1[i] = std::real(inner_local<T>(kp__, *phi[1], i, *ophi[1], i));     //  <KR_i | OKR_i>
-//            f2[i] = std::real(inner_local<T>(kp__, *phi[0], i, *ophi[1], i)) * 2; // <phi_i | OKR_i>
-//            f3[i] = std::real(inner_local<T>(kp__, *phi[1], i, *hphi[1], i));     //  <KR_i | HKR_i>
-//            f4[i] = std::real(inner_local<T>(kp__, *phi[0], i, *hphi[1], i)) * 2; // <phi_i | HKR_i>
-//        }
-//    }
-//    kp__->comm().allreduce(f1);
-//    kp__->comm().allreduce(f2);
-//    kp__->comm().allreduce(f3);
-//    kp__->comm().allreduce(f4);
-//
-//    #pragma omp parallel for
-//    for (int i = 0; i < num_bands; i++) {
-//        if (!conv_band[i]) {
-//            double a = f1[i] * f4[i] - f2[i] * f3[i];
-//            double b = f3[i] - eval[i] * f1[i];
-//            double c = eval[i] * f2[i] - f4[i];
-//
-//            lambda[i] = (b - std::sqrt(b * b - 4.0 * a * c)) / 2.0 / a;
-//            if (std::abs(lambda[i]) > 2.0) {
-//                lambda[i] = 2.0 * Utils::sign(lambda[i]);
-//            }
-//            if (std::abs(lambda[i]) < 0.5) {
-//                lambda[i] = 0.5 * Utils::sign(lambda[i]);
-//            }
-//            
-//            /* construct new basis functions */
-//            for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-//                 (*phi[1]).pw_coeffs().prime(igk, i) =  (*phi[0]).pw_coeffs().prime(igk, i) + lambda[i] *  (*phi[1]).pw_coeffs().prime(igk, i);
-//                (*hphi[1]).pw_coeffs().prime(igk, i) = (*hphi[0]).pw_coeffs().prime(igk, i) + lambda[i] * (*hphi[1]).pw_coeffs().prime(igk, i);
-//                (*ophi[1]).pw_coeffs().prime(igk, i) = (*ophi[0]).pw_coeffs().prime(igk, i) + lambda[i] * (*ophi[1]).pw_coeffs().prime(igk, i);
-//            }
-//        }
-//    }
-//    /* compute new residuals */
-//    update_res(res_norm, eval);
-//    /* check which bands have converged */
-//    for (int i = 0; i < num_bands; i++) {
-//        if (res_norm[i] < itso.residual_tolerance_) {
-//            conv_band[i] = true;
-//        }
-//    }
-//
-//    mdarray<T, 3> A(niter, niter, num_bands);
-//    mdarray<T, 3> B(niter, niter, num_bands);
-//    mdarray<T, 2> V(niter, num_bands);
-//    std::vector<double> ev(niter);
-//    
-//    /* start adjusting residuals */
-//    for (int iter = 2; iter < niter; iter++) {
-//        sddk::timer t1("sirius::Band::diag_pseudo_potential_rmm_diis|AB");
-//        A.zero();
-//        B.zero();
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                for (int i1 = 0; i1 < iter; i1++) {
-//                    for (int i2 = 0; i2 < iter; i2++) {
-//                        A(i1, i2, i) = inner_local<T>(kp__, *res[i1], i, *res[i2], i);
-//                        B(i1, i2, i) = inner_local<T>(kp__, *phi[i1], i, *ophi[i2], i);
-//                    }
-//                }
-//            }
-//        }
-//        kp__->comm().allreduce(A.template at<CPU>(), (int)A.size());
-//        kp__->comm().allreduce(B.template at<CPU>(), (int)B.size());
-//        t1.stop();
-//
-//        sddk::timer t2("sirius::Band::diag_pseudo_potential_rmm_diis|phi");
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                if (evp_solver.solve(iter, 1, &A(0, 0, i), A.ld(), &B(0, 0, i), B.ld(), &ev[0], &V(0, i), V.ld()) == 0) {
-//                    /* zero phi */
-//                    std::memset(&(*phi[iter]).pw_coeffs().prime(0, i), 0, kp__->num_gkvec_loc() * sizeof(double_complex));
-//                    /* zero residual */
-//                    std::memset(&(*res[iter]).pw_coeffs().prime(0, i), 0, kp__->num_gkvec_loc() * sizeof(double_complex));
-//                    /* make linear combinations */
-//                    for (int i1 = 0; i1 < iter; i1++) {
-//                        for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-//                            (*phi[iter]).pw_coeffs().prime(igk, i) += (*phi[i1]).pw_coeffs().prime(igk, i) * V(i1, i);
-//                            (*res[iter]).pw_coeffs().prime(igk, i) += (*res[i1]).pw_coeffs().prime(igk, i) * V(i1, i);
-//                        }
-//                    }
-//                    last[i] = iter;
-//                } else {
-//                    conv_band[i] = true;
-//                }
-//            }
-//        }
-//        t2.stop();
-//        
-//        //apply_preconditioner(lambda, *res[iter], 1.0, *phi[iter]);
-//        STOP();
-//
-//        apply_h_o();
-//
-//        eval_old = eval;
-//
-//        update_res(res_norm, eval);
-//        
-//        for (int i = 0; i < num_bands; i++) {
-//            if (!conv_band[i]) {
-//                if (res_norm[i] < itso.residual_tolerance_) {
-//                    conv_band[i] = true;
-//                }
-//                //if (kp__->band_occupancy(i) <= 1e-2) {
-//                //    conv_band[i] = true;
-//                //}
-//                //if (kp__->band_occupancy(i) > 1e-2 && std::abs(eval[i] - eval_old[i]) < tol) {
-//                //    conv_band[i] = true;
-//                //}
-//                //if (kp__->band_occupancy(i) > 1e-2 && res_norm[i] < itso.residual_tolerance_) {
-//                //    conv_band[i] = true;
-//                //}
-//                //if (kp__->band_occupancy(i) <= 1e-2 ||
-//                //    res_norm[i] / res_norm_start[i] < 0.7 ||
-//                //    (kp__->band_occupancy(i) > 1e-2 && std::abs(eval[i] - eval_old[i]) < tol)) {
-//                //    conv_band[i] = true;
-//                //}
-//            }
-//        }
-//        if (std::all_of(conv_band.begin(), conv_band.end(), [](bool e){return e;})) {
-//            std::cout << "early exit from the diis loop" << std::endl;
-//            break;
-//        }
-//    }
-//
-//    #pragma omp parallel for
-//    for (int i = 0; i < num_bands; i++) {
-//        std::memcpy(&phi_tmp.pw_coeffs().prime(0, i),  &(*phi[last[i]]).pw_coeffs().prime(0, i),  kp__->num_gkvec_loc() * sizeof(double_complex));
-//        std::memcpy(&hphi_tmp.pw_coeffs().prime(0, i), &(*hphi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-//        std::memcpy(&ophi_tmp.pw_coeffs().prime(0, i), &(*ophi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-//    }
-//    orthogonalize<T>(0, num_bands, phi_tmp, hphi_tmp, ophi_tmp, ovlp, *res[0]);
-//
-//    /* setup eigen-value problem
-//     * N is the number of previous basis functions
-//     * n is the number of new basis functions */
-//    set_subspace_mtrx(0, num_bands, phi_tmp, hphi_tmp, hmlt, hmlt_old);
-//
-//    if (std_evp_solver().solve(num_bands, num_bands, hmlt.template at<CPU>(), hmlt.ld(),
-//                               eval.data(), evec.template at<CPU>(), evec.ld(),
-//                               hmlt.num_rows_local(), hmlt.num_cols_local())) {
-//        std::stringstream s;
-//        s << "error in diagonalziation";
-//        TERMINATE(s);
-//    }
-//
-//    /* recompute wave-functions */
-//    /* \Psi_{i} = \sum_{mu} \phi_{mu} * Z_{mu, i} */
-//    transform<T>(phi_tmp, 0, num_bands, evec, 0, 0, psi, 0, num_bands);
-//
-//    for (int j = 0; j < ctx_.num_fv_states(); j++) {
-//        kp__->band_energy(j + ispn__ * ctx_.num_fv_states()) = eval[j];
-//    }
-//
-//    for (int i = 0; i < niter; i++) {
-//        delete phi[i];
-//        delete res[i];
-//        delete hphi[i];
-//        delete ophi[i];
-//    }
+    auto h_diag = get_h_diag(kp__, *local_op_, d_op__);
+    auto o_diag = get_o_diag(kp__, q_op__);
+
+    auto& phi0  = phi.component(0);
+    auto& hphi0 = hphi.component(0);
+    auto& ophi0 = ophi.component(0);
+    auto& res0  = res.component(0);
+
+    auto col = [num_bands](int j__, int i__)
+    {
+        return j__ * num_bands + i__;
+    };
+
+    /* index of the last step of each band */
+    std::vector<int> last(num_bands, 0);
+    std::vector<bool> conv_band(num_bands, false);
+    std::vector<double> eval(num_bands);
+    std::vector<double> res_norm(num_bands);
+    std::vector<double> lambda(num_bands);
+
+    /* apply H and O to the last trial vectors of the given bands */
+    auto apply_h_o_last = [&](std::vector<int> const& idx__)
+    {
+        int n = static_cast<int>(idx__.size());
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx__[k];
+            std::memcpy(&phi_tmp.component(0).pw_coeffs().prime(0, k), &phi0.pw_coeffs().prime(0, col(last[i], i)),
+                        ngk * sizeof(double_complex));
+        }
+        apply_h_o<T>(kp__, ispn__, 0, n, phi_tmp, hphi_tmp, ophi_tmp, d_op__, q_op__);
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx__[k];
+            std::memcpy(&hphi0.pw_coeffs().prime(0, col(last[i], i)), &hphi_tmp.component(0).pw_coeffs().prime(0, k),
+                        ngk * sizeof(double_complex));
+            std::memcpy(&ophi0.pw_coeffs().prime(0, col(last[i], i)), &ophi_tmp.component(0).pw_coeffs().prime(0, k),
+                        ngk * sizeof(double_complex));
+        }
+    };
+
+    /* compute Rayleigh quotients and residuals of the last trial vectors of the given bands */
+    auto update_res = [&](std::vector<int> const& idx__)
+    {
+        sddk::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|res");
+        int n = static_cast<int>(idx__.size());
+        std::vector<double> ed(2 * n);
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int c = col(last[idx__[k]], idx__[k]);
+            ed[2 * k]     = std::real(inner_local<T>(kp__, phi0, c, hphi0, c));
+            ed[2 * k + 1] = std::real(inner_local<T>(kp__, phi0, c, ophi0, c));
+        }
+        kp__->comm().allreduce(ed);
+
+        std::vector<double> r(n);
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx__[k];
+            int c = col(last[i], i);
+            eval[i] = ed[2 * k] / ed[2 * k + 1];
+            /* compute residual r_{i} = H\Psi_{i} - E_{i}O\Psi_{i} */
+            for (int igk = 0; igk < ngk; igk++) {
+                res0.pw_coeffs().prime(igk, c) = hphi0.pw_coeffs().prime(igk, c) - eval[i] * ophi0.pw_coeffs().prime(igk, c);
+            }
+            r[k] = std::real(inner_local<T>(kp__, res0, c, res0, c));
+        }
+        kp__->comm().allreduce(r);
+        for (int k = 0; k < n; k++) {
+            res_norm[idx__[k]] = std::sqrt(r[k] / ed[2 * k + 1]);
+        }
+    };
+
+    /* mark converged bands and return the list of unconverged */
+    auto unconverged = [&]()
+    {
+        std::vector<int> idx;
+        for (int i = 0; i < num_bands; i++) {
+            if (!conv_band[i]) {
+                double tol = itso.residual_tolerance_ + 1e-3 * std::abs(kp__->band_occupancy(i + ispn__ * num_bands) / ctx_.max_occupancy() - 1);
+                if (res_norm[i] < tol) {
+                    conv_band[i] = true;
+                } else {
+                    idx.push_back(i);
+                }
+            }
+        }
+        return std::move(idx);
+    };
+
+    /* apply preconditioner to the residuals stored in the first columns of phi_tmp */
+    auto precondition = [&](std::vector<int> const& idx__)
+    {
+        int n = static_cast<int>(idx__.size());
+        mdarray<double, 1> eval_tmp(n);
+        for (int k = 0; k < n; k++) {
+            eval_tmp[k] = eval[idx__[k]];
+        }
+        apply_p(CPU, n, ispn__, phi_tmp.component(0), h_diag, o_diag, eval_tmp);
+    };
+
+    /* starting vectors */
+    std::vector<int> idx(num_bands);
+    std::iota(idx.begin(), idx.end(), 0);
+    phi0.copy_from(psi, 0, num_bands, 0, CPU);
+    apply_h_o_last(idx);
+    update_res(idx);
+
+    int niter{0};
+
+    sddk::timer t2("sirius::Band::diag_pseudo_potential_rmm_diis|iter");
+    /* first step: preconditioned steepest descent with the line search */
+    idx = unconverged();
+    if (idx.size()) {
+        int n = static_cast<int>(idx.size());
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx[k];
+            std::memcpy(&phi_tmp.component(0).pw_coeffs().prime(0, k), &res0.pw_coeffs().prime(0, col(0, i)),
+                        ngk * sizeof(double_complex));
+        }
+        precondition(idx);
+        /* apply H and O to the preconditioned residuals K R_i */
+        apply_h_o<T>(kp__, ispn__, 0, n, phi_tmp, hphi_tmp, ophi_tmp, d_op__, q_op__);
+
+        std::vector<double> f(5 * n);
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int c = col(0, idx[k]);
+            auto& kr = phi_tmp.component(0);
+            f[5 * k]     = std::real(inner_local<T>(kp__, kr, k, ophi_tmp.component(0), k));     // <KR_i|O|KR_i>
+            f[5 * k + 1] = std::real(inner_local<T>(kp__, phi0, c, ophi_tmp.component(0), k)) * 2; // <phi_i|O|KR_i> + c.c.
+            f[5 * k + 2] = std::real(inner_local<T>(kp__, kr, k, hphi_tmp.component(0), k));     // <KR_i|H|KR_i>
+            f[5 * k + 3] = std::real(inner_local<T>(kp__, phi0, c, hphi_tmp.component(0), k)) * 2; // <phi_i|H|KR_i> + c.c.
+            f[5 * k + 4] = std::real(inner_local<T>(kp__, phi0, c, ophi0, c));                   // <phi_i|O|phi_i>
+        }
+        kp__->comm().allreduce(f);
+
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx[k];
+            double o2 = f[5 * k];
+            double o1 = f[5 * k + 1];
+            double h2 = f[5 * k + 2];
+            double h1 = f[5 * k + 3];
+            double o0 = f[5 * k + 4];
+            double h0 = eval[i] * o0;
+            /* Rayleigh quotient along the search direction */
+            auto rq = [&](double l)
+            {
+                return (h0 + l * h1 + l * l * h2) / (o0 + l * o1 + l * l * o2);
+            };
+            /* stationary points of the Rayleigh quotient: a * l^2 + b * l + c = 0 */
+            double a = h2 * o1 - h1 * o2;
+            double b = 2 * (h2 * o0 - h0 * o2);
+            double c = h1 * o0 - h0 * o1;
+            double d = b * b - 4 * a * c;
+            double l{1};
+            if (std::abs(a) > 1e-14 && d >= 0) {
+                double l1 = (-b + std::sqrt(d)) / 2 / a;
+                double l2 = (-b - std::sqrt(d)) / 2 / a;
+                l = (rq(l1) < rq(l2)) ? l1 : l2;
+            } else if (std::abs(b) > 1e-14) {
+                l = -c / b;
+            }
+            /* the step is reused in all subsequent DIIS steps; keep it within reasonable bounds */
+            l = std::copysign(std::min(std::max(std::abs(l), 0.5), 2.0), l);
+            lambda[i] = l;
+
+            /* \phi^{(1)} = \phi^{(0)} + \lambda K R^{(0)}; H and O are linear, so no extra application is needed */
+            int c0 = col(0, i);
+            int c1 = col(1, i);
+            for (int igk = 0; igk < ngk; igk++) {
+                phi0.pw_coeffs().prime(igk, c1)  = phi0.pw_coeffs().prime(igk, c0)  + l * phi_tmp.component(0).pw_coeffs().prime(igk, k);
+                hphi0.pw_coeffs().prime(igk, c1) = hphi0.pw_coeffs().prime(igk, c0) + l * hphi_tmp.component(0).pw_coeffs().prime(igk, k);
+                ophi0.pw_coeffs().prime(igk, c1) = ophi0.pw_coeffs().prime(igk, c0) + l * ophi_tmp.component(0).pw_coeffs().prime(igk, k);
+            }
+            last[i] = 1;
+        }
+        update_res(idx);
+        niter++;
+    }
+
+    /* DIIS steps */
+    for (int j = 2; j < num_hist; j++) {
+        idx = unconverged();
+        if (ctx_.control().verbosity_ >= 2 && kp__->comm().rank() == 0) {
+            DUMP("step: %i, number of unconverged bands: %i", j, static_cast<int>(idx.size()));
+        }
+        if (idx.empty()) {
+            break;
+        }
+        int n = static_cast<int>(idx.size());
+
+        sddk::timer t1("sirius::Band::diag_pseudo_potential_rmm_diis|diis");
+        /* overlap of residuals for all unconverged bands */
+        mdarray<T, 3> A(j, j, n);
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx[k];
+            for (int k2 = 0; k2 < j; k2++) {
+                for (int k1 = 0; k1 <= k2; k1++) {
+                    A(k1, k2, k) = inner_local<T>(kp__, res0, col(k1, i), res0, col(k2, i));
+                    A(k2, k1, k) = type_wrapper<T>::bypass(std::conj(A(k1, k2, k)));
+                }
+            }
+        }
+        kp__->comm().allreduce(A.template at<CPU>(), static_cast<int>(A.size()));
+
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx[k];
+            /* minimize the norm of residual under the constraint \sum_k c_k = 1 */
+            mdarray<T, 2> m(j + 1, j + 1);
+            std::vector<T> v(j + 1, 0);
+            double s = std::abs(A(j - 1, j - 1, k));
+            for (int k2 = 0; k2 < j; k2++) {
+                for (int k1 = 0; k1 < j; k1++) {
+                    m(k1, k2) = A(k1, k2, k) / s;
+                }
+                m(j, k2) = m(k2, j) = 1;
+            }
+            m(j, j) = 0;
+            v[j] = 1;
+            if (linalg<CPU>::gesv<T>(j + 1, 1, m.template at<CPU>(), j + 1, &v[0], j + 1)) {
+                /* singular system: take the last vector as is */
+                std::fill(v.begin(), v.end(), 0);
+                v[j - 1] = 1;
+            }
+            /* optimal vector and its residual */
+            int cj = col(j, i);
+            for (int igk = 0; igk < ngk; igk++) {
+                double_complex z1(0, 0);
+                double_complex z2(0, 0);
+                for (int k1 = 0; k1 < j; k1++) {
+                    z1 += phi0.pw_coeffs().prime(igk, col(k1, i)) * v[k1];
+                    z2 += res0.pw_coeffs().prime(igk, col(k1, i)) * v[k1];
+                }
+                phi0.pw_coeffs().prime(igk, cj) = z1;
+                phi_tmp.component(0).pw_coeffs().prime(igk, k) = z2;
+            }
+        }
+        t1.stop();
+
+        precondition(idx);
+
+        /* \phi^{(j)} = \tilde \phi^{(j)} + \lambda K \tilde R^{(j)} */
+        #pragma omp parallel for
+        for (int k = 0; k < n; k++) {
+            int i = idx[k];
+            int cj = col(j, i);
+            for (int igk = 0; igk < ngk; igk++) {
+                phi0.pw_coeffs().prime(igk, cj) += lambda[i] * phi_tmp.component(0).pw_coeffs().prime(igk, k);
+            }
+            last[i] = j;
+        }
+        apply_h_o_last(idx);
+        update_res(idx);
+        niter++;
+    }
+    t2.stop();
+
+    /* final subspace rotation */
+    sddk::timer t3("sirius::Band::diag_pseudo_potential_rmm_diis|evp");
+    #pragma omp parallel for
+    for (int i = 0; i < num_bands; i++) {
+        int c = col(last[i], i);
+        std::memcpy(&phi_tmp.component(0).pw_coeffs().prime(0, i), &phi0.pw_coeffs().prime(0, c), ngk * sizeof(double_complex));
+        std::memcpy(&hphi_tmp.component(0).pw_coeffs().prime(0, i), &hphi0.pw_coeffs().prime(0, c), ngk * sizeof(double_complex));
+        std::memcpy(&ophi_tmp.component(0).pw_coeffs().prime(0, i), &ophi0.pw_coeffs().prime(0, c), ngk * sizeof(double_complex));
+    }
+
+    auto mem_type = (gen_evp_solver().type() == ev_magma) ? memory_t::host_pinned : memory_t::host;
+
+    int bs = ctx_.cyclic_block_size();
+
+    dmatrix<T> hmlt(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> ovlp(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> evec(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
+    dmatrix<T> mtrx_old;
+
+    set_subspace_mtrx(1, 0, num_bands, phi_tmp, hphi_tmp, hmlt, mtrx_old);
+    set_subspace_mtrx(1, 0, num_bands, phi_tmp, ophi_tmp, ovlp, mtrx_old);
+
+    if (gen_evp_solver().solve(num_bands, num_bands,
+                               hmlt.template at<CPU>(), hmlt.ld(),
+                               ovlp.template at<CPU>(), ovlp.ld(),
+                               eval.data(), evec.template at<CPU>(), evec.ld(),
+                               hmlt.num_rows_local(), hmlt.num_cols_local())) {
+        std::stringstream s;
+        s << "error in diagonalziation";
+        TERMINATE(s);
+    }
+
+    /* recompute wave-functions */
+    /* \Psi_{i} = \sum_{mu} \phi_{mu} * Z_{mu, i} */
+    transform<T>(CPU, phi_tmp.component(0), 0, num_bands, evec, 0, 0, psi, 0, num_bands);
+
+    for (int j = 0; j < num_bands; j++) {
+        kp__->band_energy(j + ispn__ * num_bands) = eval[j];
+    }
+    t3.stop();
+
+    kp__->beta_projectors().dismiss();
+
+    return niter;
 }
 
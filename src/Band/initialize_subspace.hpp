@@ -68,10 +68,13 @@ inline void Band::initialize_subspace(K_point_set& kset__, Potential& potential_
         int ik  = kset__.spl_num_kpoints(ikloc);
         auto kp = kset__[ik];
 
+        /* atomic orbitals are not needed if wave-functions of the previous run are available */
+        int num_ao = kp->wave_functions_restored() ? 0 : N;
+
         if (ctx_.gamma_point() && (ctx_.so_correction() == false)) {
-            initialize_subspace<double>(kp, N, rad_int);
+            initialize_subspace<double>(kp, num_ao, rad_int);
         } else {
-            initialize_subspace<double_complex>(kp, N, rad_int);
+            initialize_subspace<double_complex>(kp, num_ao, rad_int);
         }
     }
     local_op_->dismiss();
@@ -307,6 +310,19 @@ Band::initialize_subspace(K_point* kp__, int num_ao__, std::vector<std::vector<S
     }
 
     for (int ispn_step = 0; ispn_step < num_spin_steps; ispn_step++) {
+        /* wave-functions loaded from the storage file are the basis functions */
+        if (kp__->wave_functions_restored()) {
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                int s = (num_sc == 2) ? ispn : ispn_step;
+                phi.component(ispn).copy_from(kp__->spinor_wave_functions(s), 0, num_phi_tot, 0, CPU);
+#ifdef __GPU
+                if (ctx_.processing_unit() == GPU) {
+                    phi.component(ispn).copy_to_device(0, num_phi_tot);
+                }
+#endif
+            }
+        }
+
         /* apply Hamiltonian and overlap operators to the new basis functions */
         apply_h_o<T>(kp__, ispn_step, 0, num_phi_tot, phi, hphi, ophi, d_op, q_op);
 
@@ -379,30 +379,85 @@ inline void Band::set_fv_h_o_it(K_point* kp,
     //#endif
     
     double sq_alpha_half = 0.5 * std::pow(speed_of_light, -2);
-    
-    #pragma omp parallel for default(shared)
-    for (int igk_col = 0; igk_col < kp->num_gkvec_col(); igk_col++) {
-        int ig_col          = kp->igk_col(igk_col);
-        auto gvec_col       = kp->gkvec().gvec(ig_col);
-        auto gkvec_col_cart = kp->gkvec().gkvec_cart(ig_col);
-        for (int igk_row = 0; igk_row < kp->num_gkvec_row(); igk_row++) {
-            int ig_row          = kp->igk_row(igk_row);
-            auto gvec_row       = kp->gkvec().gvec(ig_row);
-            auto gkvec_row_cart = kp->gkvec().gkvec_cart(ig_row);
-            int ig12 = ctx_.gvec().index_g12(gvec_row, gvec_col);
-            /* pw kinetic energy */
-            double t1 = 0.5 * (gkvec_row_cart * gkvec_col_cart);
 
-            h(igk_row, igk_col) += potential__.veff_pw(ig12);
-            o(igk_row, igk_col) += ctx_.step_function().theta_pw(ig12);
+    int nrow = kp->num_gkvec_row();
+    int ncol = kp->num_gkvec_col();
 
-            if (ctx_.valence_relativity() == relativity_t::none) {
-                h(igk_row, igk_col) += t1 * ctx_.step_function().theta_pw(ig12);
-            } else {
-                h(igk_row, igk_col) += t1 * potential__.rm_inv_pw(ig12);
+    /* G-vectors and G+k vectors of the local rows and columns */
+    std::vector<vector3d<int>> gvec_row(nrow);
+    std::vector<vector3d<double>> gkvec_row(nrow);
+    for (int igk_row = 0; igk_row < nrow; igk_row++) {
+        int ig_row         = kp->igk_row(igk_row);
+        gvec_row[igk_row]  = kp->gkvec().gvec(ig_row);
+        gkvec_row[igk_row] = kp->gkvec().gkvec_cart(ig_row);
+    }
+    std::vector<vector3d<int>> gvec_col(ncol);
+    std::vector<vector3d<double>> gkvec_col(ncol);
+    for (int igk_col = 0; igk_col < ncol; igk_col++) {
+        int ig_col         = kp->igk_col(igk_col);
+        gvec_col[igk_col]  = kp->gkvec().gvec(ig_col);
+        gkvec_col[igk_col] = kp->gkvec().gkvec_cart(ig_col);
+    }
+
+    /* both halves of the matrix are local */
+    bool herm = (kp->num_ranks_row() == 1 && kp->num_ranks_col() == 1);
+
+    /* size of the tile */
+    int const bs{64};
+    int nbr = (nrow + bs - 1) / bs;
+    int nbc = (ncol + bs - 1) / bs;
+
+    #pragma omp parallel
+    {
+        std::vector<int> ig12(bs * bs);
+
+        #pragma omp for schedule(dynamic)
+        for (int ib = 0; ib < nbr * nbc; ib++) {
+            int jr = ib % nbr;
+            int jc = ib / nbr;
+            /* tiles of the lower half are restored from the upper half */
+            if (herm && jr > jc) {
+                continue;
             }
-            if (ctx_.valence_relativity() == relativity_t::iora) {
-                o(igk_row, igk_col) += t1 * sq_alpha_half * potential__.rm2_inv_pw(ig12);
+            bool mirror = (herm && jr < jc);
+
+            int r0 = jr * bs;
+            int nr = std::min(nrow, r0 + bs) - r0;
+            int c0 = jc * bs;
+            int nc = std::min(ncol, c0 + bs) - c0;
+
+            for (int ic = 0; ic < nc; ic++) {
+                for (int ir = 0; ir < nr; ir++) {
+                    ig12[ir + ic * bs] = ctx_.gvec().index_g12(gvec_row[r0 + ir], gvec_col[c0 + ic]);
+                }
+            }
+
+            for (int ic = 0; ic < nc; ic++) {
+                int igk_col = c0 + ic;
+                for (int ir = 0; ir < nr; ir++) {
+                    int igk_row = r0 + ir;
+                    int ig = ig12[ir + ic * bs];
+                    /* pw kinetic energy */
+                    double t1 = 0.5 * (gkvec_row[igk_row] * gkvec_col[igk_col]);
+
+                    double_complex zh = potential__.veff_pw(ig);
+                    double_complex zo = ctx_.step_function().theta_pw(ig);
+
+                    if (ctx_.valence_relativity() == relativity_t::none) {
+                        zh += t1 * ctx_.step_function().theta_pw(ig);
+                    } else {
+                        zh += t1 * potential__.rm_inv_pw(ig);
+                    }
+                    if (ctx_.valence_relativity() == relativity_t::iora) {
+                        zo += t1 * sq_alpha_half * potential__.rm2_inv_pw(ig);
+                    }
+                    h(igk_row, igk_col) += zh;
+                    o(igk_row, igk_col) += zo;
+                    if (mirror) {
+                        h(igk_col, igk_row) += std::conj(zh);
+                        o(igk_col, igk_row) += std::conj(zo);
+                    }
+                }
             }
         }
     }
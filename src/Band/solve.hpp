@@ -136,11 +136,14 @@ inline void Band::solve_for_kset(K_point_set& kset__, Potential& potential__, bo
         int ik  = kset__.spl_num_kpoints(ikloc);
         auto kp = kset__[ik];
 
+        sddk::timer t1("sirius::Band::solve_for_kset|kp");
         if (ctx_.full_potential() && use_second_variation) {
             solve_with_second_variation(*kp, potential__);
         } else {
             num_dav_iter += solve_with_single_variation(*kp, potential__);
         }
+        /* keep the time for the load balancing of k-points */
+        kset__.solve_time(ik) = t1.stop();
     }
     kset__.comm().allreduce(&num_dav_iter, 1);
     if (ctx_.comm().rank() == 0) {
@@ -33,22 +33,50 @@ class Beta_projector_chunks
     /// Total number of beta-projectors among atom types.
     int num_beta_t_;
     
+    /// Estimated local number of G+k vectors.
+    int num_gkvec_loc_;
+
+    /// Maximum number of beta-projectors in a chunk.
+    int max_num_beta_limit_;
+
     /// Split beta-projectors into chunks.
+    /** The number of beta-projectors in a chunk is limited by the memory budget for the plane-wave coefficients
+     *  of the chunk. Atoms are split between the chunks such that the chunks have similar number of
+     *  beta-projectors. */
     void split_in_chunks()
-    {   
-        /* initial chunk size */
-        int chunk_size = std::min(unit_cell_.num_atoms(), 256);
-        /* maximum number of chunks */
-        int num_chunks = unit_cell_.num_atoms() / chunk_size + std::min(1, unit_cell_.num_atoms() % chunk_size);
-        /* final maximum chunk size */
-        chunk_size = unit_cell_.num_atoms() / num_chunks + std::min(1, unit_cell_.num_atoms() % num_chunks);
+    {
+        int num_atoms = unit_cell_.num_atoms();
+
+        int num_beta_tot{0};
+        for (int ia = 0; ia < num_atoms; ia++) {
+            num_beta_tot += unit_cell_.atom(ia).mt_basis_size();
+        }
+        /* number of chunks for the given limit */
+        int num_chunks = std::max(1, num_beta_tot / max_num_beta_limit_ + std::min(1, num_beta_tot % max_num_beta_limit_));
+        /* target number of beta-projectors in a chunk */
+        int target = num_beta_tot / num_chunks + std::min(1, num_beta_tot % num_chunks);
+
+        /* global index of the first atom of each chunk */
+        std::vector<int> ia0({0});
+        int num_beta{0};
+        for (int ia = 0; ia < num_atoms; ia++) {
+            int nbf = unit_cell_.atom(ia).mt_basis_size();
+            /* start a new chunk if the atom doesn't fit into the current one */
+            if (ia != ia0.back() && (num_beta + nbf > max_num_beta_limit_ || num_beta + nbf / 2 > target)) {
+                ia0.push_back(ia);
+                num_beta = 0;
+            }
+            num_beta += nbf;
+        }
+        ia0.push_back(num_atoms);
+        num_chunks = static_cast<int>(ia0.size()) - 1;
 
         int offset_in_beta_gk{0};
         beta_chunks_ = std::vector<beta_chunk_t>(num_chunks);
 
         for (int ib = 0; ib < num_chunks; ib++) {
             /* number of atoms in this chunk */
-            int na = std::min(unit_cell_.num_atoms(), (ib + 1) * chunk_size) - ib * chunk_size;
+            int na = ia0[ib + 1] - ia0[ib];
             beta_chunks_[ib].num_atoms_ = na;
             beta_chunks_[ib].desc_      = mdarray<int, 2>(4, na);
             beta_chunks_[ib].atom_pos_  = mdarray<double, 2>(3, na);
@@ -56,7 +84,7 @@ class Beta_projector_chunks
             int num_beta{0};
             for (int i = 0; i < na; i++) {
                 /* global index of atom by local index and chunk */
-                int ia     = ib * chunk_size + i;
+                int ia     = ia0[ib] + i;
                 auto pos   = unit_cell_.atom(ia).position();
                 auto& type = unit_cell_.atom(ia).type();
                 /* atom fractional coordinates */
@@ -106,9 +134,16 @@ class Beta_projector_chunks
 
   public:
 
-    Beta_projector_chunks(Unit_cell const& unit_cell__)
+    /// Constructor.
+    /** \param [in] unit_cell     Unit cell.
+     *  \param [in] num_gkvec_loc Estimated local number of G+k vectors.
+     *  \param [in] mem_budget    Memory (in Mb) for the plane-wave coefficients of a chunk of beta-projectors. */
+    Beta_projector_chunks(Unit_cell const& unit_cell__, int num_gkvec_loc__, double mem_budget__)
         : unit_cell_(unit_cell__)
+        , num_gkvec_loc_(std::max(num_gkvec_loc__, 1))
     {
+        double n = mem_budget__ * (1 << 20) / sizeof(double_complex) / num_gkvec_loc_;
+        max_num_beta_limit_ = std::max(1, static_cast<int>(std::min(n, 1e9)));
         split_in_chunks();
     }
 
@@ -132,11 +167,18 @@ class Beta_projector_chunks
         return max_num_beta_;
     }
 
-    void print_info()
+    void print_info(int verbosity__)
     {
-        printf("num_beta_chunks: %i\n", num_chunks());
-        for (int i = 0; i < num_chunks(); i++) {
-            printf("  chunk: %i, num_atoms: %i, num_beta: %i\n", i, beta_chunks_[i].num_atoms_, beta_chunks_[i].num_beta_);
+        printf("\n");
+        printf("number of beta-projector chunks   : %i\n", num_chunks());
+        printf("maximum number of beta-projectors : %i\n", max_num_beta());
+        printf("estimated local number of G+k     : %i\n", num_gkvec_loc_);
+        printf("memory of the largest chunk (Mb)  : %.2f\n",
+               static_cast<double>(sizeof(double_complex)) * num_gkvec_loc_ * max_num_beta() / (1 << 20));
+        if (verbosity__ > 1) {
+            for (int i = 0; i < num_chunks(); i++) {
+                printf("  chunk: %i, num_atoms: %i, num_beta: %i\n", i, beta_chunks_[i].num_atoms_, beta_chunks_[i].num_beta_);
+            }
         }
     }
 };
@@ -25,6 +25,8 @@
 #ifndef __BETA_PROJECTORS_BASE_H__
 #define __BETA_PROJECTORS_BASE_H__
 
+#include <list>
+
 namespace sirius {
 
 #ifdef __GPU
@@ -37,6 +39,13 @@ extern "C" void create_beta_gk_gpu(int                   num_atoms,
                                    double_complex*       beta_gk);
 #endif
 
+/// Total size (in bytes) of the cached plane-wave coefficients of beta-projectors on this MPI rank.
+inline size_t& beta_projectors_cache_size()
+{
+    static size_t size{0};
+    return size;
+}
+
 /// Base class for beta-projectors, gradient of beta-projectors and strain derivatives of beta-projectors.
 template <int N>
 class Beta_projectors_base
@@ -48,6 +57,9 @@ class Beta_projectors_base
     Gvec const& gkvec_;
 
     mdarray<double, 2> gkvec_coord_;
+
+    /// Integer coordinates of the local G-vectors of the G+k set.
+    mdarray<int, 2> gvec_loc_;
     
     int num_gkvec_loc_;
 
@@ -77,6 +89,94 @@ class Beta_projectors_base
         return a;
     }
 
+    /// Cached plane-wave coefficients of beta-projectors for a chunk of atoms.
+    struct pw_coeffs_cache_t
+    {
+        /// Plane-wave coefficients of the chunk.
+        matrix<double_complex> pw_coeffs_;
+        /// Positions of atoms for which the coefficients were generated.
+        std::vector<double> atom_pos_;
+    };
+
+    /// Cache of the generated chunks; the key is the chunk index times N plus the component index.
+    std::map<int, pw_coeffs_cache_t> pw_coeffs_cache_;
+
+    /// Keys of the cached chunks ordered from the most to the least recently used.
+    std::list<int> pw_coeffs_cache_lru_;
+
+    /// Current positions of atoms in a chunk.
+    std::vector<double> chunk_atom_pos(int ichunk__) const
+    {
+        auto& bchunk = ctx_.beta_projector_chunks();
+
+        std::vector<double> pos;
+        for (int i = 0; i < bchunk(ichunk__).num_atoms_; i++) {
+            int ia = bchunk(ichunk__).desc_(beta_desc_idx::ia, i);
+            for (int x: {0, 1, 2}) {
+                pos.push_back(ctx_.unit_cell().atom(ia).position()[x]);
+            }
+        }
+        return std::move(pos);
+    }
+
+    /// Remove chunk from the cache.
+    void cache_erase(int key__)
+    {
+        auto it = pw_coeffs_cache_.find(key__);
+        if (it != pw_coeffs_cache_.end()) {
+            beta_projectors_cache_size() -= it->second.pw_coeffs_.size() * sizeof(double_complex);
+            pw_coeffs_cache_.erase(it);
+            pw_coeffs_cache_lru_.remove(key__);
+        }
+    }
+
+    /// Copy the cached coefficients of a chunk to the output array.
+    /** Return false if the chunk is not cached or if the atoms of the chunk have moved since it was generated. */
+    bool cache_fetch(int key__, int ichunk__, matrix<double_complex>& pw_coeffs__)
+    {
+        auto it = pw_coeffs_cache_.find(key__);
+        if (it == pw_coeffs_cache_.end()) {
+            return false;
+        }
+        if (it->second.atom_pos_ != chunk_atom_pos(ichunk__)) {
+            cache_erase(key__);
+            return false;
+        }
+        auto& c = it->second.pw_coeffs_;
+        std::memcpy(pw_coeffs__.template at<CPU>(), c.template at<CPU>(), c.size() * sizeof(double_complex));
+
+        /* mark as the most recently used */
+        pw_coeffs_cache_lru_.remove(key__);
+        pw_coeffs_cache_lru_.push_front(key__);
+        return true;
+    }
+
+    /// Store coefficients of a chunk in the cache.
+    /** The least recently used chunks of this object are evicted if the memory limit is exceeded. */
+    void cache_store(int key__, int ichunk__, matrix<double_complex>& pw_coeffs__)
+    {
+        auto& bchunk = ctx_.beta_projector_chunks();
+
+        size_t limit = static_cast<size_t>(ctx_.control().beta_cache_memory_ * (1 << 20));
+        size_t sz    = sizeof(double_complex) * num_gkvec_loc() * bchunk(ichunk__).num_beta_;
+
+        while (beta_projectors_cache_size() + sz > limit && pw_coeffs_cache_lru_.size()) {
+            cache_erase(pw_coeffs_cache_lru_.back());
+        }
+        if (beta_projectors_cache_size() + sz > limit) {
+            return;
+        }
+        pw_coeffs_cache_t c;
+        c.pw_coeffs_ = matrix<double_complex>(num_gkvec_loc(), bchunk(ichunk__).num_beta_, memory_t::host,
+                                              "pw_coeffs_cache_");
+        std::memcpy(c.pw_coeffs_.template at<CPU>(), pw_coeffs__.template at<CPU>(), sz);
+        c.atom_pos_ = chunk_atom_pos(ichunk__);
+
+        pw_coeffs_cache_[key__] = std::move(c);
+        pw_coeffs_cache_lru_.push_front(key__);
+        beta_projectors_cache_size() += sz;
+    }
+
   public:
     Beta_projectors_base(Simulation_context& ctx__,
                          Gvec         const& gkvec__)
@@ -99,6 +199,14 @@ class Beta_projectors_base
 
         auto& comm = gkvec_.comm();
 
+        gvec_loc_ = mdarray<int, 2>(3, num_gkvec_loc());
+        for (int igk_loc = 0; igk_loc < num_gkvec_loc_; igk_loc++) {
+            auto G = gkvec_.gvec(gkvec_.offset() + igk_loc);
+            for (int x: {0, 1, 2}) {
+                gvec_loc_(x, igk_loc) = G[x];
+            }
+        }
+
         if (ctx_.processing_unit() == GPU) {
             gkvec_coord_ = mdarray<double, 2>(3, num_gkvec_loc(), ctx__.dual_memory_t());
             /* copy G+k vectors */
@@ -114,6 +222,9 @@ class Beta_projectors_base
     }
     ~Beta_projectors_base()
     {
+        while (pw_coeffs_cache_lru_.size()) {
+            cache_erase(pw_coeffs_cache_lru_.back());
+        }
         //#ifdef __GPU
         pw_coeffs_a_shared(0, memory_t::none) = mdarray<double_complex, 1>(); //.deallocate_on_device();
         beta_phi_shared(0, memory_t::none) = mdarray<double, 1>(); //.deallocate_on_device();
@@ -283,27 +394,37 @@ class Beta_projectors_base
 
         switch (ctx_.processing_unit()) {
             case CPU: {
-                #pragma omp for
+                /* coefficients of the chunk don't change as long as the atoms stay in place */
+                bool use_cache = ctx_.control().beta_cache_memory_ > 0;
+                if (use_cache && cache_fetch(ichunk__ * N + j__, ichunk__, pw_coeffs)) {
+                    break;
+                }
+                #pragma omp parallel for
                 for (int i = 0; i < bchunk(ichunk__).num_atoms_; i++) {
                     int ia = bchunk(ichunk__).desc_(beta_desc_idx::ia, i);
 
                     double phase = twopi * (gkvec_.vk() * ctx_.unit_cell().atom(ia).position());
                     double_complex phase_k = std::exp(double_complex(0.0, phase));
 
+                    /* total phase e^{i(G+k)r_{\alpha}} is a product of the phase factors along the three directions */
                     std::vector<double_complex> phase_gk(num_gkvec_loc());
                     for (int igk_loc = 0; igk_loc < num_gkvec_loc_; igk_loc++) {
-                        int igk = gkvec_.offset() + igk_loc;
-                        auto G = gkvec_.gvec(igk);
-                        /* total phase e^{i(G+k)r_{\alpha}} */
+                        vector3d<int> G(&gvec_loc_(0, igk_loc));
                         phase_gk[igk_loc] = std::conj(ctx_.gvec_phase_factor(G, ia) * phase_k);
                     }
+                    int offset_t = bchunk(ichunk__).desc_(beta_desc_idx::offset_t, i);
+                    int offset   = bchunk(ichunk__).desc_(beta_desc_idx::offset, i);
                     for (int xi = 0; xi < bchunk(ichunk__).desc_(beta_desc_idx::nbf, i); xi++) {
-                        for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
-                            pw_coeffs(igk_loc, bchunk(ichunk__).desc_(beta_desc_idx::offset, i) + xi) = 
-                                pw_coeffs_t_[j__](igk_loc, bchunk(ichunk__).desc_(beta_desc_idx::offset_t, i) + xi) * phase_gk[igk_loc];
+                        auto c_t = pw_coeffs_t_[j__].template at<CPU>(0, offset_t + xi);
+                        auto c   = pw_coeffs.template at<CPU>(0, offset + xi);
+                        for (int igk_loc = 0; igk_loc < num_gkvec_loc_; igk_loc++) {
+                            c[igk_loc] = c_t[igk_loc] * phase_gk[igk_loc];
                         }
                     }
                 }
+                if (use_cache) {
+                    cache_store(ichunk__ * N + j__, ichunk__, pw_coeffs);
+                }
                 break;
             }
             case GPU: {
@@ -22,31 +22,103 @@ inline void Density::add_k_point_contribution_rg(K_point* kp__)
 
     /* non-magnetic or collinear case */
     if (ctx_.num_mag_dims() != 3) {
+        /* in case of reduced G-vectors the wave-functions are real and two of them are transformed at once */
+        bool reduced = kp__->gkvec().reduced();
+
+        /* number of wave-functions in a batch of FFTs; batched transformation is implemented only for CPU */
+        int nb = ctx_.control().fft_batch_size_;
+        if (fft.pu() != CPU || nb <= 1) {
+            nb = 1;
+        }
+        if (reduced && nb > 1) {
+            nb += nb % 2;
+        }
+        std::vector<double> w_batch(nb);
+
         /* loop over pure spinor components */
         for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            auto& wf = kp__->spinor_wave_functions(ispn).pw_coeffs();
             /* trivial case */
-            if (!kp__->spinor_wave_functions(ispn).pw_coeffs().spl_num_col().global_index_size()) {
+            if (!wf.spl_num_col().global_index_size()) {
                 continue;
             }
 
-            for (int i = 0; i < kp__->spinor_wave_functions(ispn).pw_coeffs().spl_num_col().local_size(); i++) {
-                int j = kp__->spinor_wave_functions(ispn).pw_coeffs().spl_num_col()[i];
-                double w = kp__->band_occupancy(j + ispn * nfv) * kp__->weight() / omega;
-
-                ///* transform to real space; in case of GPU wave-function stays in GPU memory */
-                fft.transform<1>(kp__->spinor_wave_functions(ispn).pw_coeffs().extra().template at<CPU>(0, i));
-                //switch (fft.pu()) {
-                //    case CPU: {
-                //        fft.transform<1>(kp__->gkvec().partition(),
-                //                         kp__->spinor_wave_functions(ispn).pw_coeffs().extra().template at<CPU>(0, i));
-                //        break;
-                //    }
-                //    case GPU: {
-                //        fft.transform<1, GPU>(kp__->gkvec().partition(),
-                //                              kp__->spinor_wave_functions(ispn).pw_coeffs().extra().template at<GPU>(0, i));
-                //        break;
-                //    }
-                //}
+            /* weight of the local wave-function */
+            auto weight = [&](int i)
+            {
+                int j = wf.spl_num_col()[i];
+                return kp__->band_occupancy(j + ispn * nfv) * kp__->weight() / omega;
+            };
+
+            int nwf = wf.spl_num_col().local_size();
+            int i{0};
+
+            /* batched transformation with the accumulation of all functions of a batch in one pass */
+            if (nb > 1) {
+                auto& fft_buf = fft.buffer_batch();
+                int nwf_batch = reduced ? nwf - nwf % 2 : nwf;
+                for (; i < nwf_batch; i += nb) {
+                    int n = std::min(nb, nwf_batch - i);
+                    for (int j = 0; j < n; j++) {
+                        w_batch[j] = weight(i + j);
+                    }
+                    fft.transform_batch<1>(n, wf.extra().template at<CPU>(0, i), wf.extra().ld());
+
+                    #pragma omp parallel for schedule(static)
+                    for (int ir = 0; ir < fft.local_size(); ir++) {
+                        double d{0};
+                        if (reduced) {
+                            for (int j = 0; j < n / 2; j++) {
+                                auto z = fft_buf(ir, j);
+                                d += w_batch[2 * j] * std::pow(z.real(), 2) + w_batch[2 * j + 1] * std::pow(z.imag(), 2);
+                            }
+                        } else {
+                            for (int j = 0; j < n; j++) {
+                                auto z = fft_buf(ir, j);
+                                d += w_batch[j] * (std::pow(z.real(), 2) + std::pow(z.imag(), 2));
+                            }
+                        }
+                        density_rg(ir, ispn) += d;
+                    }
+                }
+                i = nwf_batch;
+            }
+
+            /* two real wave-functions are packed into the real and imaginary parts of one complex function */
+            if (reduced) {
+                for (; i + 1 < nwf; i += 2) {
+                    double w1 = weight(i);
+                    double w2 = weight(i + 1);
+
+                    fft.transform<1>(wf.extra().template at<CPU>(0, i), wf.extra().template at<CPU>(0, i + 1));
+
+                    switch (fft.pu()) {
+                        case CPU: {
+                            #pragma omp parallel for schedule(static)
+                            for (int ir = 0; ir < fft.local_size(); ir++) {
+                                auto z = fft.buffer(ir);
+                                density_rg(ir, ispn) += w1 * std::pow(z.real(), 2) + w2 * std::pow(z.imag(), 2);
+                            }
+                            break;
+                        }
+                        case GPU: {
+                            #ifdef __GPU
+                            update_density_rg_1_pair_gpu(fft.local_size(), fft.buffer().at<GPU>(), w1, w2,
+                                                         density_rg.at<GPU>(0, ispn));
+                            #else
+                            TERMINATE_NO_GPU
+                            #endif
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for (; i < nwf; i++) {
+                double w = weight(i);
+
+                /* transform to real space; in case of GPU wave-function stays in GPU memory */
+                fft.transform<1>(wf.extra().template at<CPU>(0, i));
                 
                 /* add to density */
                 switch (fft.pu()) {
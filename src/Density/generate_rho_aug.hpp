@@ -29,54 +29,64 @@ inline void Density::generate_rho_aug(mdarray<double_complex, 2>& rho_aug__)
         auto dm = density_matrix_aux(iat);
         
         if (pu == CPU) {
-            sddk::timer t2("sirius::Density::generate_rho_aug|phase_fac");
-            /* treat phase factors as real array with x2 size */
-            mdarray<double, 2> phase_factors(atom_type.num_atoms(), ctx_.gvec().count() * 2);
-
-            #pragma omp parallel for schedule(static)
-            for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
-                int ig = ctx_.gvec().offset() + igloc;
-                for (int i = 0; i < atom_type.num_atoms(); i++) {
-                    int ia = atom_type.atom_id(i);
-                    double_complex z = std::conj(ctx_.gvec_phase_factor(ig, ia));
-                    phase_factors(i, 2 * igloc)     = z.real();
-                    phase_factors(i, 2 * igloc + 1) = z.imag();
+            auto& aug_op = ctx_.augmentation_op(iat);
+            int nq = nbf * (nbf + 1) / 2;
+            int na = atom_type.num_atoms();
+            int nv = ctx_.num_mag_dims() + 1;
+            /* G-vectors are processed in blocks; Q(G) of a block is either stored or generated on the fly */
+            int bs = std::min(aug_op.block_size(), ctx_.gvec().count());
+
+            /* density matrices of all components stacked along the rows */
+            matrix<double> dm_v(nq * nv, na);
+            for (int iv = 0; iv < nv; iv++) {
+                for (int i = 0; i < na; i++) {
+                    std::memcpy(&dm_v(nq * iv, i), &dm(0, i, iv), nq * sizeof(double));
                 }
             }
-            t2.stop();
-            
+
+            mdarray<double_complex, 2> pf(bs, na);
+            /* treat phase factors as real array with x2 size */
+            mdarray<double, 2> phase_factors(na, bs * 2);
             /* treat auxiliary array as double with x2 size */
-            mdarray<double, 2> dm_pw(nbf * (nbf + 1) / 2, ctx_.gvec().count() * 2);
+            mdarray<double, 2> dm_pw(nq * nv, bs * 2);
+            mdarray<double, 2> q_buf;
+
+            for (int ig0 = 0; ig0 < ctx_.gvec().count(); ig0 += bs) {
+                int ng = std::min(bs, ctx_.gvec().count() - ig0);
+
+                sddk::timer t2("sirius::Density::generate_rho_aug|phase_fac");
+                ctx_.generate_phase_factors(iat, ig0, ng, pf);
+                for (int j = 0; j < ng; j++) {
+                    for (int i = 0; i < na; i++) {
+                        phase_factors(i, 2 * j)     =  pf(j, i).real();
+                        phase_factors(i, 2 * j + 1) = -pf(j, i).imag();
+                    }
+                }
+                t2.stop();
 
-            for (int iv = 0; iv < ctx_.num_mag_dims() + 1; iv++) {
                 sddk::timer t3("sirius::Density::generate_rho_aug|gemm");
-                linalg<CPU>::gemm(0, 0, nbf * (nbf + 1) / 2, 2 * ctx_.gvec().count(), atom_type.num_atoms(), 
-                                  &dm(0, 0, iv), dm.ld(),
+                linalg<CPU>::gemm(0, 0, nq * nv, 2 * ng, na, 
+                                  &dm_v(0, 0), dm_v.ld(),
                                   &phase_factors(0, 0), phase_factors.ld(), 
                                   &dm_pw(0, 0), dm_pw.ld());
                 t3.stop();
 
-                #ifdef __PRINT_OBJECT_CHECKSUM
-                {
-                    auto cs = dm_pw.checksum();
-                    ctx_.comm().allreduce(&cs, 1);
-                    DUMP("checksum(dm_pw) : %18.10f", cs);
-                }
-                #endif
+                mdarray<double, 2> q_pw(const_cast<double*>(aug_op.q_pw_block(ig0, ng, q_buf)), nq, 2 * ng);
 
                 sddk::timer t4("sirius::Density::generate_rho_aug|sum");
                 #pragma omp parallel for
-                for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
-                    double_complex zsum(0, 0);
-                    /* get contribution from non-diagonal terms */
-                    for (int i = 0; i < nbf * (nbf + 1) / 2; i++) {
-                        double_complex z1 = double_complex(ctx_.augmentation_op(iat).q_pw(i, 2 * igloc),
-                                                           ctx_.augmentation_op(iat).q_pw(i, 2 * igloc + 1));
-                        double_complex z2(dm_pw(i, 2 * igloc), dm_pw(i, 2 * igloc + 1));
-
-                        zsum += z1 * z2 * ctx_.augmentation_op(iat).sym_weight(i);
+                for (int j = 0; j < ng; j++) {
+                    for (int iv = 0; iv < nv; iv++) {
+                        double_complex zsum(0, 0);
+                        /* get contribution from non-diagonal terms */
+                        for (int k = 0; k < nq; k++) {
+                            double_complex z1(q_pw(k, 2 * j), q_pw(k, 2 * j + 1));
+                            double_complex z2(dm_pw(nq * iv + k, 2 * j), dm_pw(nq * iv + k, 2 * j + 1));
+
+                            zsum += z1 * z2 * aug_op.sym_weight(k);
+                        }
+                        rho_aug__(ig0 + j, iv) += zsum;
                     }
-                    rho_aug__(igloc, iv) += zsum;
                 }
                 t4.stop();
             }
@@ -138,3 +148,42 @@ inline void Density::generate_rho_aug(mdarray<double_complex, 2>& rho_aug__)
     }
 }
 
+
+inline void Density::generate_rho_aug_rg(mdarray<double_complex, 2>& rho_aug__)
+{
+    PROFILE("sirius::Density::generate_rho_aug_rg");
+
+    int nv = ctx_.num_mag_dims() + 1;
+
+    std::vector<std::unique_ptr<Smooth_periodic_function<double>>> rho_rg(nv);
+    std::vector<double*> f_rg(nv);
+    for (int iv = 0; iv < nv; iv++) {
+        rho_rg[iv] = std::unique_ptr<Smooth_periodic_function<double>>(
+            new Smooth_periodic_function<double>(ctx_.fft(), ctx_.gvec()));
+        rho_rg[iv]->zero();
+        f_rg[iv] = &rho_rg[iv]->f_rg(0);
+    }
+
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        if (!unit_cell_.atom_type(iat).pp_desc().augment) {
+            continue;
+        }
+        ctx_.augmentation_op_rg().add_charge(iat, density_matrix_aux(iat), f_rg);
+    }
+
+    for (int iv = 0; iv < nv; iv++) {
+        rho_rg[iv]->fft_transform(-1);
+        #pragma omp parallel for schedule(static)
+        for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
+            rho_aug__(igloc, iv) = rho_rg[iv]->f_pw_local(igloc);
+        }
+    }
+
+    if (ctx_.control().print_checksum_) {
+         auto cs = rho_aug__.checksum();
+         ctx_.comm().allreduce(&cs, 1);
+         if (ctx_.comm().rank() == 0) {
+            print_checksum("rho_aug", cs);
+         }
+    }
+}
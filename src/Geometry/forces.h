@@ -217,39 +217,55 @@ class Forces_PS
             /* get auxiliary density matrix */
             auto dm = density_.density_matrix_aux(iat);
 
-            //mdarray<double, 2> q_tmp(nbf * (nbf + 1) / 2, ctx_.gvec().count() * 2);
-            mdarray<double, 2> v_tmp(atom_type.num_atoms(), ctx_.gvec().count() * 2);
-            mdarray<double, 2> tmp(nbf * (nbf + 1) / 2, atom_type.num_atoms());
-
-            /* over spin components, can be from 1 to 4*/
-            for (int ispin = 0; ispin < ctx_.num_mag_dims() + 1; ispin++ ){
-                /* over 3 components of the force/G - vectors */
-                for (int ivec = 0; ivec < 3; ivec++ ){
-                    /* over local rank G vectors */
-                    #pragma omp parallel for schedule(static)
-                    for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
-                        int ig = ctx_.gvec().offset() + igloc;
-                        auto gvc = ctx_.gvec().gvec_cart(ig);
-                        for (int ia = 0; ia < atom_type.num_atoms(); ia++) {
-                            /* here we write in v_tmp  -i * G * exp[ iGRn] Veff(G)
-                             * but in formula we have   i * G * exp[-iGRn] Veff*(G)
-                             * the differences because we unfold complex array in the real one
-                             * and need negative imagine part due to a multiplication law of complex numbers */
-                            auto z = double_complex(0,-gvc[ivec]) * ctx_.gvec_phase_factor(ig, atom_type.atom_id(ia)) * vfield_eff[ispin]->f_pw_local(igloc);
-                            v_tmp(ia, 2 * igloc)     = z.real();
-                            v_tmp(ia, 2 * igloc + 1) = z.imag();
+            int nq = nbf * (nbf + 1) / 2;
+            /* G-vectors are processed in blocks; Q(G) of a block is either stored or generated on the fly */
+            int bs = std::min(aug_op.block_size(), ctx_.gvec().count());
+
+            mdarray<double, 2> v_tmp(atom_type.num_atoms(), bs * 2);
+            mdarray<double, 4> tmp(nq, atom_type.num_atoms(), 3, ctx_.num_mag_dims() + 1);
+            tmp.zero();
+            mdarray<double, 2> q_buf;
+
+            for (int ig0 = 0; ig0 < ctx_.gvec().count(); ig0 += bs) {
+                int ng = std::min(bs, ctx_.gvec().count() - ig0);
+
+                auto q_pw = aug_op.q_pw_block(ig0, ng, q_buf);
+
+                /* over spin components, can be from 1 to 4*/
+                for (int ispin = 0; ispin < ctx_.num_mag_dims() + 1; ispin++ ){
+                    /* over 3 components of the force/G - vectors */
+                    for (int ivec = 0; ivec < 3; ivec++ ){
+                        /* over local rank G vectors */
+                        #pragma omp parallel for schedule(static)
+                        for (int i = 0; i < ng; i++) {
+                            int igloc = ig0 + i;
+                            int ig = ctx_.gvec().offset() + igloc;
+                            auto gvc = ctx_.gvec().gvec_cart(ig);
+                            for (int ia = 0; ia < atom_type.num_atoms(); ia++) {
+                                /* here we write in v_tmp  -i * G * exp[ iGRn] Veff(G)
+                                 * but in formula we have   i * G * exp[-iGRn] Veff*(G)
+                                 * the differences because we unfold complex array in the real one
+                                 * and need negative imagine part due to a multiplication law of complex numbers */
+                                auto z = double_complex(0,-gvc[ivec]) * ctx_.gvec_phase_factor(ig, atom_type.atom_id(ia)) * vfield_eff[ispin]->f_pw_local(igloc);
+                                v_tmp(ia, 2 * i)     = z.real();
+                                v_tmp(ia, 2 * i + 1) = z.imag();
+                            }
                         }
-                    }
-
-                    /* multiply tmp matrices, or sum over G*/
-                    linalg<CPU>::gemm(0, 1, nbf * (nbf + 1) / 2, atom_type.num_atoms(), 2 * ctx_.gvec().count(),
-                                      aug_op.q_pw(), v_tmp, tmp);
 
+                        /* multiply tmp matrices, or sum over G*/
+                        linalg<CPU>::gemm(0, 1, nq, atom_type.num_atoms(), 2 * ng, 1.0,
+                                          q_pw, nq, v_tmp.at<CPU>(), v_tmp.ld(), 1.0,
+                                          tmp.at<CPU>(0, 0, ivec, ispin), nq);
+                    }
+                }
+            }
 
+            for (int ispin = 0; ispin < ctx_.num_mag_dims() + 1; ispin++ ){
+                for (int ivec = 0; ivec < 3; ivec++ ){
                     #pragma omp parallel for
                     for (int ia = 0; ia < atom_type.num_atoms(); ia++) {
-                        for (int i = 0; i < nbf * (nbf + 1) / 2; i++) {
-                            forces(ivec, atom_type.atom_id(ia)) += ctx_.unit_cell().omega() * reduce_g_fact * dm(i, ia, ispin) *  aug_op.sym_weight(i) * tmp(i, ia);
+                        for (int i = 0; i < nq; i++) {
+                            forces(ivec, atom_type.atom_id(ia)) += ctx_.unit_cell().omega() * reduce_g_fact * dm(i, ia, ispin) *  aug_op.sym_weight(i) * tmp(i, ia, ivec, ispin);
                         }
                     }
                 }
@@ -342,56 +342,123 @@ inline void K_point::test_spinor_wave_functions(int use_fft)
 //==     std :: cout << "maximum error = " << maxerr << std::endl;
 }
 
-inline void K_point::save(int id)
+inline void K_point::save(std::string const& name__, int id__)
 {
-    if (num_ranks() > 1) TERMINATE("writing of distributed eigen-vectors is not implemented");
+    PROFILE("sirius::K_point::save");
 
-    STOP();
+    int nwf = spinor_wave_functions(0).num_wf();
 
-    //if (ctx_.mpi_grid().root(1 << _dim_col_))
-    //{
-    //    HDF5_tree fout(storage_file_name, false);
+    if (comm_.rank() == 0) {
+        HDF5_tree fout(name__, false);
+        auto node = fout["K_point_set"].create_node(id__);
+        node.write("vk", &vk_[0], 3);
+        node.write("num_gkvec", num_gkvec());
+        node.write("band_energies", band_energies_);
+        node.write("band_occupancies", band_occupancies_);
+        node.create_dataset<int>("gvec", {3, num_gkvec()});
+        node.create_node("spinor_wave_functions");
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            auto wf_node = node["spinor_wave_functions"].create_node(ispn);
+            wf_node.create_dataset<double>("pw", {2, num_gkvec(), nwf});
+            if (spinor_wave_functions(ispn).has_mt()) {
+                wf_node.create_dataset<double>("mt", {2, spinor_wave_functions(ispn).num_mt_coeffs(), nwf});
+            }
+        }
+    }
+    comm_.barrier();
 
-    //    fout["K_set"].create_node(id);
-    //    fout["K_set"][id].create_node("spinor_wave_functions");
-    //    fout["K_set"][id].write("coordinates", &vk_[0], 3);
-    //    fout["K_set"][id].write("band_energies", band_energies_);
-    //    fout["K_set"][id].write("band_occupancies", band_occupancies_);
-    //    if (num_ranks() == 1)
-    //    {
-    //        fout["K_set"][id].write("fv_eigen_vectors", fv_eigen_vectors_panel_.data());
-    //        fout["K_set"][id].write("sv_eigen_vectors", sv_eigen_vectors_[0].data());
-    //    }
-    //}
-    //
-    //comm_col_.barrier();
-    //
-    //mdarray<double_complex, 2> wfj(NULL, wf_size(), ctx_.num_spins()); 
-    //for (int j = 0; j < ctx_.num_bands(); j++)
-    //{
-    //    int rank = ctx_.spl_spinor_wf().local_rank(j);
-    //    int offs = (int)ctx_.spl_spinor_wf().local_index(j);
-    //    if (ctx_.mpi_grid().coordinate(_dim_col_) == rank)
-    //    {
-    //        HDF5_tree fout(storage_file_name, false);
-    //        wfj.set_ptr(&spinor_wave_functions_(0, 0, offs));
-    //        fout["K_set"][id]["spinor_wave_functions"].write(j, wfj);
-    //    }
-    //    comm_col_.barrier();
-    //}
+#ifdef __GPU
+    if (ctx_.processing_unit() == GPU && keep_wf_on_gpu) {
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            spinor_wave_functions(ispn).pw_coeffs().copy_to_host(0, nwf);
+        }
+    }
+#endif
+
+    /* integer coordinates of the local G+k vectors */
+    mdarray<int, 2> gv(3, num_gkvec_loc());
+    for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+        auto G = gkvec_.gvec(idxgk(igk_loc));
+        for (int x: {0, 1, 2}) {
+            gv(x, igk_loc) = G[x];
+        }
+    }
+
+    hdf5_distributed_access(name__, comm_, [&](HDF5_tree& fout)
+    {
+        auto node = fout["K_point_set"][id__];
+        node.write_slab("gvec", gv.at<CPU>(), {0, gkvec_offset_}, {3, num_gkvec_loc()});
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            auto& wf = spinor_wave_functions(ispn);
+            node["spinor_wave_functions"][ispn].write_slab("pw",
+                reinterpret_cast<double const*>(wf.pw_coeffs().prime().at<CPU>()),
+                {0, gkvec_offset_, 0}, {2, num_gkvec_loc(), nwf});
+            if (wf.has_mt()) {
+                auto& d = wf.mt_coeffs_distr();
+                node["spinor_wave_functions"][ispn].write_slab("mt",
+                    reinterpret_cast<double const*>(wf.mt_coeffs().prime().at<CPU>()),
+                    {0, d.offsets[comm_.rank()], 0}, {2, d.counts[comm_.rank()], nwf});
+            }
+        }
+    });
 }
 
-inline void K_point::load(HDF5_tree h5in, int id)
+inline bool K_point::load(std::string const& name__, int id__)
 {
-    STOP();
-    //== band_energies_.resize(ctx_.num_bands());
-    //== h5in[id].read("band_energies", band_energies_);
+    PROFILE("sirius::K_point::load");
+
+    int nwf = spinor_wave_functions(0).num_wf();
+
+    /* stored G+k vectors and plane-wave coefficients with the same offset and size as the local slab */
+    mdarray<int, 2> gv(3, num_gkvec_loc());
+    std::vector<mdarray<double_complex, 2>> pw(ctx_.num_spins());
+    for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+        pw[ispn] = mdarray<double_complex, 2>(num_gkvec_loc(), nwf);
+    }
+
+    int ngk{-1};
+    hdf5_distributed_access(name__, comm_, [&](HDF5_tree& fin)
+    {
+        auto node = fin["K_point_set"][id__];
+        node.read("num_gkvec", &ngk, 1);
+        if (ngk != num_gkvec()) {
+            return;
+        }
+        node.read("band_energies", band_energies_);
+        node.read("band_occupancies", band_occupancies_);
+        node.read_slab("gvec", gv.at<CPU>(), {0, gkvec_offset_}, {3, num_gkvec_loc()});
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            auto& wf = spinor_wave_functions(ispn);
+            node["spinor_wave_functions"][ispn].read_slab("pw", reinterpret_cast<double*>(pw[ispn].at<CPU>()),
+                                                          {0, gkvec_offset_, 0}, {2, num_gkvec_loc(), nwf});
+            /* global order of muffin-tin coefficients doesn't depend on the number of ranks */
+            if (wf.has_mt()) {
+                auto& d = wf.mt_coeffs_distr();
+                node["spinor_wave_functions"][ispn].read_slab("mt",
+                    reinterpret_cast<double*>(wf.mt_coeffs().prime().at<CPU>()),
+                    {0, d.offsets[comm_.rank()], 0}, {2, d.counts[comm_.rank()], nwf});
+            }
+        }
+    });
+    if (ngk != num_gkvec()) {
+        return false;
+    }
+
+    for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+        redistribute_by_gvec(gkvec_, gv, pw[ispn], spinor_wave_functions(ispn).pw_coeffs().prime());
+    }
+
+#ifdef __GPU
+    if (ctx_.processing_unit() == GPU && keep_wf_on_gpu) {
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            spinor_wave_functions(ispn).pw_coeffs().copy_to_device(0, nwf);
+        }
+    }
+#endif
+
+    wave_functions_restored_ = true;
 
-    //== band_occupancies_.resize(ctx_.num_bands());
-    //== h5in[id].read("band_occupancies", band_occupancies_);
-    //== 
-    //== h5in[id].read_mdarray("fv_eigen_vectors", fv_eigen_vectors_panel_);
-    //== h5in[id].read_mdarray("sv_eigen_vectors", sv_eigen_vectors_);
+    return true;
 }
 
 //== void K_point::save_wave_functions(int id)
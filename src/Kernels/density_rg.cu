@@ -32,6 +32,40 @@ extern "C" void update_density_rg_1_gpu(int size__,
     );
 }
 
+__global__ void update_density_rg_1_pair_gpu_kernel(int size__,
+                                                    cuDoubleComplex const* psi_rg__,
+                                                    double wt1__,
+                                                    double wt2__,
+                                                    double* density_rg__)
+{
+    int ir = blockIdx.x * blockDim.x + threadIdx.x;
+    if (ir < size__)
+    {
+        cuDoubleComplex z = psi_rg__[ir];
+        density_rg__[ir] += z.x * z.x * wt1__ + z.y * z.y * wt2__;
+    }
+}
+
+/* real and imaginary parts of psi_rg are two real wave-functions with weights wt1 and wt2 */
+extern "C" void update_density_rg_1_pair_gpu(int size__,
+                                             cuDoubleComplex const* psi_rg__,
+                                             double wt1__,
+                                             double wt2__,
+                                             double* density_rg__)
+{
+    dim3 grid_t(64);
+    dim3 grid_b(num_blocks(size__, grid_t.x));
+
+    update_density_rg_1_pair_gpu_kernel <<<grid_b, grid_t>>>
+    (
+        size__,
+        psi_rg__,
+        wt1__,
+        wt2__,
+        density_rg__
+    );
+}
+
 __global__ void update_density_rg_2_gpu_kernel(int size__,
                                                cuDoubleComplex const* psi_up_rg__,
                                                cuDoubleComplex const* psi_dn_rg__,
@@ -96,48 +96,75 @@ inline void Potential::generate_D_operator_matrix()
             }
             continue;
         }
-        matrix<double> d_tmp(nbf * (nbf + 1) / 2, atom_type.num_atoms());
-        for (int iv = 0; iv < ctx_.num_mag_dims() + 1; iv++) {
+        int nq = nbf * (nbf + 1) / 2;
+        int na = atom_type.num_atoms();
+        int nv = ctx_.num_mag_dims() + 1;
+        /* integrals of Q with all components of the effective potential; column i + na * iv for atom i */
+        matrix<double> d_tmp_v(nq, na * nv);
+
+        if (ctx_.control().augment_real_space_) {
+            for (int iv = 0; iv < nv; iv++) {
+                matrix<double> d_tmp(&d_tmp_v(0, na * iv), nq, na);
+                /* integrate V(r) with Q(r) on the real-space grid around each atom */
+                ctx_.augmentation_op_rg().integrate(iat, &veff_vec[iv]->f_rg(0), d_tmp);
+            }
+        } else {
             switch (ctx_.processing_unit()) {
                 case CPU: {
-                    matrix<double> veff_a(2 * ctx_.gvec().count(), atom_type.num_atoms());
-
-                    #pragma omp parallel for schedule(static)
-                    for (int i = 0; i < atom_type.num_atoms(); i++) {
-                        int ia = atom_type.atom_id(i);
-
-                        for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
-                            int ig = ctx_.gvec().offset() + igloc;
-                            /* V(G) * exp(i * G * r_{alpha}) */
-                            auto z = veff_vec[iv]->f_pw_local(igloc) * ctx_.gvec_phase_factor(ig, ia);
-                            veff_a(2 * igloc, i)     = z.real();
-                            veff_a(2 * igloc + 1, i) = z.imag();
+                    auto& aug_op = ctx_.augmentation_op(iat);
+                    /* G-vectors are processed in blocks; Q(G) of a block is either stored or generated on the fly */
+                    int bs = std::min(aug_op.block_size(), ctx_.gvec().count());
+
+                    mdarray<double_complex, 2> phase_factors(bs, na);
+                    matrix<double> veff_a(2 * bs, na * nv);
+                    mdarray<double, 2> q_buf;
+
+                    d_tmp_v.zero();
+                    for (int ig0 = 0; ig0 < ctx_.gvec().count(); ig0 += bs) {
+                        int ng = std::min(bs, ctx_.gvec().count() - ig0);
+
+                        ctx_.generate_phase_factors(iat, ig0, ng, phase_factors);
+
+                        /* V(G) * exp(i * G * r_{alpha}) for all components of the potential */
+                        #pragma omp parallel for schedule(static)
+                        for (int i = 0; i < na; i++) {
+                            for (int iv = 0; iv < nv; iv++) {
+                                for (int j = 0; j < ng; j++) {
+                                    auto z = veff_vec[iv]->f_pw_local(ig0 + j) * phase_factors(j, i);
+                                    veff_a(2 * j, i + na * iv)     = z.real();
+                                    veff_a(2 * j + 1, i + na * iv) = z.imag();
+                                }
+                            }
                         }
-                    }
 
-                    linalg<CPU>::gemm(0, 0, nbf * (nbf + 1) / 2, atom_type.num_atoms(), 2 * ctx_.gvec().count(),
-                                      ctx_.augmentation_op(iat).q_pw(), veff_a, d_tmp);
+                        linalg<CPU>::gemm(0, 0, nq, na * nv, 2 * ng, 1.0, aug_op.q_pw_block(ig0, ng, q_buf), nq,
+                                          veff_a.at<CPU>(), veff_a.ld(), 1.0, d_tmp_v.at<CPU>(), d_tmp_v.ld());
+                    }
                     break;
                 }
                 case GPU: {
 #ifdef __GPU
-                    /* copy plane wave coefficients of effective potential to GPU */
-                    mdarray<double_complex, 1> veff(&veff_vec[iv]->f_pw_local(0), veff_tmp.at<GPU>(),
-                                                    ctx_.gvec().count());
-                    veff.copy<memory_t::host, memory_t::device>();
+                    for (int iv = 0; iv < nv; iv++) {
+                        matrix<double> d_tmp(&d_tmp_v(0, na * iv), nq, na);
 
-                    matrix<double> veff_a(2 * ctx_.gvec().count(), atom_type.num_atoms(), memory_t::device);
+                        /* copy plane wave coefficients of effective potential to GPU */
+                        mdarray<double_complex, 1> veff(&veff_vec[iv]->f_pw_local(0), veff_tmp.at<GPU>(),
+                                                        ctx_.gvec().count());
+                        veff.copy<memory_t::host, memory_t::device>();
 
-                    d_tmp.allocate(memory_t::device);
+                        matrix<double> veff_a(2 * ctx_.gvec().count(), na, memory_t::device);
 
-                    mul_veff_with_phase_factors_gpu(atom_type.num_atoms(), ctx_.gvec().count(), veff.at<GPU>(),
-                                                    ctx_.gvec_coord().at<GPU>(), ctx_.atom_coord(iat).at<GPU>(),
-                                                    veff_a.at<GPU>(), 1);
+                        d_tmp.allocate(memory_t::device);
 
-                    linalg<GPU>::gemm(0, 0, nbf * (nbf + 1) / 2, atom_type.num_atoms(), 2 * ctx_.gvec().count(),
-                                      ctx_.augmentation_op(iat).q_pw(), veff_a, d_tmp, 1);
+                        mul_veff_with_phase_factors_gpu(na, ctx_.gvec().count(), veff.at<GPU>(),
+                                                        ctx_.gvec_coord().at<GPU>(), ctx_.atom_coord(iat).at<GPU>(),
+                                                        veff_a.at<GPU>(), 1);
 
-                    d_tmp.copy<memory_t::device, memory_t::host>();
+                        linalg<GPU>::gemm(0, 0, nq, na, 2 * ctx_.gvec().count(),
+                                          ctx_.augmentation_op(iat).q_pw(), veff_a, d_tmp, 1);
+
+                        d_tmp.copy<memory_t::device, memory_t::host>();
+                    }
 #endif
                     break;
                 }
@@ -145,22 +172,28 @@ inline void Potential::generate_D_operator_matrix()
 
             if (ctx_.gvec().reduced()) {
                 if (comm_.rank() == 0) {
-                    for (int i = 0; i < atom_type.num_atoms(); i++) {
-                        for (int j = 0; j < nbf * (nbf + 1) / 2; j++) {
-                            d_tmp(j, i) = 2 * d_tmp(j, i) -
-                                          veff_vec[iv]->f_pw_local(0).real() * ctx_.augmentation_op(iat).q_pw(j, 0);
+                    for (int iv = 0; iv < nv; iv++) {
+                        for (int i = 0; i < na; i++) {
+                            for (int j = 0; j < nq; j++) {
+                                d_tmp_v(j, i + na * iv) = 2 * d_tmp_v(j, i + na * iv) -
+                                    veff_vec[iv]->f_pw_local(0).real() * ctx_.augmentation_op(iat).q_pw(j, 0);
+                            }
                         }
                     }
                 } else {
-                    for (int i = 0; i < atom_type.num_atoms(); i++) {
-                        for (int j = 0; j < nbf * (nbf + 1) / 2; j++) {
-                            d_tmp(j, i) *= 2;
+                    for (int i = 0; i < na * nv; i++) {
+                        for (int j = 0; j < nq; j++) {
+                            d_tmp_v(j, i) *= 2;
                         }
                     }
                 }
             }
 
-            comm_.allreduce(d_tmp.at<CPU>(), static_cast<int>(d_tmp.size()));
+            comm_.allreduce(d_tmp_v.at<CPU>(), static_cast<int>(d_tmp_v.size()));
+        }
+
+        for (int iv = 0; iv < nv; iv++) {
+            matrix<double> d_tmp(&d_tmp_v(0, na * iv), nq, na);
 
             if (ctx_.control().print_checksum_ && ctx_.comm().rank() == 0) {
                 for (int i = 0; i < atom_type.num_atoms(); i++) {
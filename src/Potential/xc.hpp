@@ -430,6 +430,32 @@ inline void Potential::xc_mt(Density const& density__)
     }
 }
 
+inline void Potential::xc_gradient_rg(Smooth_periodic_function<double>& f__,
+                                      std::array<Smooth_periodic_function<double>*, 3> grad__,
+                                      Smooth_periodic_function<double>* lapl__)
+{
+    PROFILE("sirius::Potential::xc_gradient_rg");
+
+    #pragma omp parallel for schedule(static)
+    for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
+        int ig = ctx_.gvec().offset() + igloc;
+        auto G = ctx_.gvec().gvec_cart(ig);
+        for (int x: {0, 1, 2}) {
+            grad__[x]->f_pw_local(igloc) = f__.f_pw_local(igloc) * double_complex(0, G[x]);
+        }
+        if (lapl__) {
+            lapl__->f_pw_local(igloc) = f__.f_pw_local(igloc) * double_complex(-std::pow(G.length(), 2), 0);
+        }
+    }
+
+    std::vector<Smooth_periodic_function<double>*> f({grad__[0], grad__[1], grad__[2]});
+    if (lapl__) {
+        f.push_back(lapl__);
+    }
+    /* all components are transformed to real space at once */
+    fft_transform_batch(f);
+}
+
 template <bool add_pseudo_core__>
 inline void Potential::xc_rg_nonmagnetic(Density const& density__)
 {
@@ -439,19 +465,14 @@ inline void Potential::xc_rg_nonmagnetic(Density const& density__)
 
     int num_points = ctx_.fft().local_size();
 
-    /* we can use this comm for parallelization */
-    //auto& comm = ctx_.gvec().comm_ortho_fft();
-
-    Smooth_periodic_function<double> rho(ctx_.fft(), ctx_.gvec());
-
-    /* split real-space points between available ranks */
-    //splindex<block> spl_np(num_points, comm.size(), comm.rank());
+    auto& rho = xc_work(0);
+    std::array<Smooth_periodic_function<double>*, 3> grad_rho = {&xc_work(1), &xc_work(2), &xc_work(3)};
+    auto& lapl_rho = xc_work(4);
 
     /* check for negative values */
     double rhomin{0};
+    #pragma omp parallel for schedule(static) reduction(min:rhomin)
     for (int ir = 0; ir < num_points; ir++) {
-
-        //int ir = spl_np[irloc];
         double d = density__.rho().f_rg(ir);
         if (add_pseudo_core__) {
             d += density__.rho_pseudo_core().f_rg(ir);
@@ -471,126 +492,117 @@ inline void Potential::xc_rg_nonmagnetic(Density const& density__)
         WARNING(s);
     }
     
-    Smooth_periodic_function_gradient<double> grad_rho;
-    Smooth_periodic_function<double> lapl_rho;
-    Smooth_periodic_function<double> grad_rho_grad_rho;
-    
     if (is_gga) {
         /* use fft_transfrom of the base class (Smooth_periodic_function) */
         rho.fft_transform(-1);
 
-        /* generate pw coeffs of the gradient and laplacian */
-        grad_rho = gradient(rho);
-        lapl_rho = laplacian(rho);
-
-        /* gradient in real space */
-        for (int x: {0, 1, 2}) {
-            grad_rho[x].fft_transform(1);
-        }
-
-        /* product of gradients */
-        grad_rho_grad_rho = grad_rho * grad_rho;
-        
-        /* Laplacian in real space */
-        lapl_rho.fft_transform(1);
+        /* gradient and Laplacian in real space */
+        xc_gradient_rg(rho, grad_rho, &lapl_rho);
     }
 
-    mdarray<double, 1> exc_tmp(num_points);
-    exc_tmp.zero();
-
-    mdarray<double, 1> vxc_tmp(num_points);
-    vxc_tmp.zero();
+    auto& vsigma = *vsigma_[0];
 
-    mdarray<double, 1> vsigma_tmp;
-    if (is_gga) {
-        vsigma_tmp = mdarray<double, 1>(num_points);
-        vsigma_tmp.zero();
-    }
+    /* density below this value is treated as vacuum with zero XC energy and potential */
+    double rho_tol = ctx_.settings().xc_rho_threshold_;
 
-    /* loop over XC functionals */
-    for (auto& ixc: xc_func_) {
-        #pragma omp parallel
-        {
-            /* split local size between threads */
-            splindex<block> spl_np_t(num_points, omp_get_num_threads(), omp_get_thread_num());
+    /* number of points in a tile; all temporary arrays of a tile fit into L2 cache */
+    int const xc_tile_size{1024};
 
-            std::vector<double> exc_t(spl_np_t.local_size());
+    int num_tiles = num_points / xc_tile_size + std::min(1, num_points % xc_tile_size);
 
-            /* if this is an LDA functional */
-            if (ixc.is_lda()) {
-                std::vector<double> vxc_t(spl_np_t.local_size());
-
-                ixc.get_lda(spl_np_t.local_size(),
-                            &rho.f_rg(spl_np_t.global_offset()),
-                            &vxc_t[0],
-                            &exc_t[0]);
-
-                for (int i = 0; i < spl_np_t.local_size(); i++) {
-                    /* add Exc contribution */
-                    exc_tmp(spl_np_t[i]) += exc_t[i];
-
-                    /* directly add to Vxc */
-                    vxc_tmp(spl_np_t[i]) += vxc_t[i];
+    /* the grid is processed by tiles: density of the tile is compacted, passed through all functionals and the 
+     * result is written directly to the output arrays */
+    #pragma omp parallel
+    {
+        std::vector<int> idx(xc_tile_size);
+        std::vector<double> rho_t(xc_tile_size);
+        std::vector<double> sigma_t(xc_tile_size);
+        std::vector<double> exc_t(xc_tile_size);
+        std::vector<double> vrho_t(xc_tile_size);
+        std::vector<double> vsigma_t(xc_tile_size);
+        std::vector<double> e(xc_tile_size);
+        std::vector<double> v(xc_tile_size);
+        std::vector<double> vs(xc_tile_size);
+
+        #pragma omp for schedule(static)
+        for (int it = 0; it < num_tiles; it++) {
+            int ir0 = it * xc_tile_size;
+            int nr  = std::min(xc_tile_size, num_points - ir0);
+
+            /* select points with non-vanishing density */
+            int n{0};
+            for (int ir = ir0; ir < ir0 + nr; ir++) {
+                xc_energy_density_->f_rg(ir) = 0;
+                xc_potential_->f_rg(ir)      = 0;
+                vsigma.f_rg(ir)              = 0;
+                if (rho.f_rg(ir) > rho_tol) {
+                    idx[n]   = ir;
+                    rho_t[n] = rho.f_rg(ir);
+                    if (is_gga) {
+                        sigma_t[n] = std::pow(grad_rho[0]->f_rg(ir), 2) + std::pow(grad_rho[1]->f_rg(ir), 2) +
+                                     std::pow(grad_rho[2]->f_rg(ir), 2);
+                    }
+                    n++;
+                }
+            }
+            if (!n) {
+                continue;
+            }
+            std::fill(exc_t.begin(), exc_t.begin() + n, 0);
+            std::fill(vrho_t.begin(), vrho_t.begin() + n, 0);
+            std::fill(vsigma_t.begin(), vsigma_t.begin() + n, 0);
+
+            /* loop over XC functionals */
+            for (auto& ixc: xc_func_) {
+                if (ixc.is_lda()) {
+                    ixc.get_lda(n, &rho_t[0], &v[0], &e[0]);
+                    for (int i = 0; i < n; i++) {
+                        exc_t[i]  += e[i];
+                        vrho_t[i] += v[i];
+                    }
+                }
+                if (ixc.is_gga()) {
+                    ixc.get_gga(n, &rho_t[0], &sigma_t[0], &v[0], &vs[0], &e[0]);
+                    for (int i = 0; i < n; i++) {
+                        exc_t[i]    += e[i];
+                        vrho_t[i]   += v[i];
+                        vsigma_t[i] += vs[i];
+                    }
                 }
             }
-            if (ixc.is_gga()) {
-                std::vector<double> vrho_t(spl_np_t.local_size());
-                std::vector<double> vsigma_t(spl_np_t.local_size());
-                
-                ixc.get_gga(spl_np_t.local_size(), 
-                            &rho.f_rg(spl_np_t.global_offset()), 
-                            &grad_rho_grad_rho.f_rg(spl_np_t.global_offset()),
-                            &vrho_t[0], 
-                            &vsigma_t[0], 
-                            &exc_t[0]);
-
-
-                for (int i = 0; i < spl_np_t.local_size(); i++) {
-                    /* add Exc contribution */
-                    exc_tmp(spl_np_t[i]) += exc_t[i];
-
-                    /* directly add to Vxc available contributions */
-                    vxc_tmp(spl_np_t[i]) += (vrho_t[i] - 2 * vsigma_t[i] * lapl_rho.f_rg(spl_np_t[i]));
 
+            for (int i = 0; i < n; i++) {
+                int ir = idx[i];
+                xc_energy_density_->f_rg(ir) = exc_t[i];
+                /* directly add to Vxc available contributions */
+                xc_potential_->f_rg(ir) = vrho_t[i];
+                if (is_gga) {
+                    xc_potential_->f_rg(ir) -= 2 * vsigma_t[i] * lapl_rho.f_rg(ir);
                     /* save the sigma derivative */
-                    vsigma_tmp(spl_np_t[i]) += vsigma_t[i]; 
+                    vsigma.f_rg(ir) = vsigma_t[i];
                 }
             }
         }
     }
 
     if (is_gga) {
-        /* gather vsigma */
-        //comm.allgather(&vsigma_tmp[0], &vsigma_[0]->f_rg(0), spl_np.global_offset(), spl_np.local_size()); 
-
         /* forward transform vsigma to plane-wave domain */
-        vsigma_[0]->fft_transform(-1);
+        vsigma.fft_transform(-1);
 
-        /* gradient of vsigma in plane-wave domain */
-        auto grad_vsigma = gradient((*vsigma_[0]));
-
-        /* backward transform gradient from pw to real space */
-        for (int x: {0, 1, 2}) {
-            grad_vsigma[x].fft_transform(1);
-        }
-
-        /* compute scalar product of two gradients */
-        auto grad_vsigma_grad_rho = grad_vsigma * grad_rho;
+        /* gradient of vsigma in real space */
+        std::array<Smooth_periodic_function<double>*, 3> grad_vsigma = {&xc_work(4), &xc_work(5), &xc_work(6)};
+        xc_gradient_rg(vsigma, grad_vsigma, nullptr);
 
         /* add remaining term to Vxc */
-        //for (int irloc = 0; irloc < spl_np.local_size(); irloc++) {
+        #pragma omp parallel for schedule(static)
         for (int ir = 0; ir < num_points; ir++) {
-            //vxc_tmp(irloc) -= 2 * grad_vsigma_grad_rho.f_rg(spl_np[irloc]);
-            vxc_tmp(ir) -= 2 * grad_vsigma_grad_rho.f_rg(ir);
+            double d{0};
+            for (int x: {0, 1, 2}) {
+                d += grad_vsigma[x]->f_rg(ir) * grad_rho[x]->f_rg(ir);
+            }
+            xc_potential_->f_rg(ir) -= 2 * d;
         }
     }
-    //comm.allgather(&vxc_tmp[0], &xc_potential_->f_rg(0), spl_np.global_offset(), spl_np.local_size()); 
-    //comm.allgather(&exc_tmp[0], &xc_energy_density_->f_rg(0), spl_np.global_offset(), spl_np.local_size()); 
-
-    for (int ir = 0; ir < num_points; ir++) {
-        xc_energy_density_->f_rg(ir) = exc_tmp(ir);
-        xc_potential_->f_rg(ir) = vxc_tmp(ir);
-    }
 }
 
 template <bool add_pseudo_core__>
@@ -602,11 +614,19 @@ inline void Potential::xc_rg_magnetic(Density const& density__)
 
     int num_points = ctx_.fft().local_size();
     
-    Smooth_periodic_function<double> rho_up(ctx_.fft(), ctx_.gvec());
-    Smooth_periodic_function<double> rho_dn(ctx_.fft(), ctx_.gvec());
+    auto& rho_up = xc_work(0);
+    auto& rho_dn = xc_work(1);
+    std::array<Smooth_periodic_function<double>*, 3> grad_rho_up = {&xc_work(2), &xc_work(3), &xc_work(4)};
+    std::array<Smooth_periodic_function<double>*, 3> grad_rho_dn = {&xc_work(5), &xc_work(6), &xc_work(7)};
+    auto& lapl_rho_up = xc_work(8);
+    auto& lapl_rho_dn = xc_work(9);
+    auto& vxc_up      = xc_work(10);
+    auto& vxc_dn      = xc_work(11);
+    auto& vsigma_ud   = xc_work(12);
 
     /* compute "up" and "dn" components and also check for negative values of density */
     double rhomin{0};
+    #pragma omp parallel for schedule(static) reduction(min:rhomin)
     for (int ir = 0; ir < num_points; ir++) {
         double mag{0};
         for (int j = 0; j < ctx_.num_mag_dims(); j++) {
@@ -639,181 +659,145 @@ inline void Potential::xc_rg_magnetic(Density const& density__)
         WARNING(s);
     }
 
-    Smooth_periodic_function_gradient<double> grad_rho_up;
-    Smooth_periodic_function_gradient<double> grad_rho_dn;
-    Smooth_periodic_function<double> lapl_rho_up;
-    Smooth_periodic_function<double> lapl_rho_dn;
-    Smooth_periodic_function<double> grad_rho_up_grad_rho_up;
-    Smooth_periodic_function<double> grad_rho_up_grad_rho_dn;
-    Smooth_periodic_function<double> grad_rho_dn_grad_rho_dn;
-
     if (is_gga) {
         /* get plane-wave coefficients of densities */
         rho_up.fft_transform(-1);
         rho_dn.fft_transform(-1);
 
-        /* generate pw coeffs of the gradient and laplacian */
-        grad_rho_up = gradient(rho_up);
-        grad_rho_dn = gradient(rho_dn);
-        lapl_rho_up = laplacian(rho_up);
-        lapl_rho_dn = laplacian(rho_dn);
-
-        /* gradient in real space */
-        for (int x: {0, 1, 2}) {
-            grad_rho_up[x].fft_transform(1);
-            grad_rho_dn[x].fft_transform(1);
-        }
-
-        /* product of gradients */
-        grad_rho_up_grad_rho_up = grad_rho_up * grad_rho_up;
-        grad_rho_up_grad_rho_dn = grad_rho_up * grad_rho_dn;
-        grad_rho_dn_grad_rho_dn = grad_rho_dn * grad_rho_dn;
-        
-        /* Laplacian in real space */
-        lapl_rho_up.fft_transform(1);
-        lapl_rho_dn.fft_transform(1);
-    }
-
-    mdarray<double, 1> exc_tmp(num_points, memory_t::host, "exc_tmp");
-    exc_tmp.zero();
-
-    mdarray<double, 1> vxc_up_tmp(num_points, memory_t::host, "vxc_up_tmp");
-    vxc_up_tmp.zero();
-
-    mdarray<double, 1> vxc_dn_tmp(num_points, memory_t::host, "vxc_dn_dmp");
-    vxc_dn_tmp.zero();
-
-    mdarray<double, 1> vsigma_uu_tmp;
-    mdarray<double, 1> vsigma_ud_tmp;
-    mdarray<double, 1> vsigma_dd_tmp;
-
-    if (is_gga) {
-        vsigma_uu_tmp = mdarray<double, 1>(num_points, memory_t::host, "vsigma_uu_tmp");
-        vsigma_uu_tmp.zero();
-        
-        vsigma_ud_tmp = mdarray<double, 1>(num_points, memory_t::host, "vsigma_ud_tmp");
-        vsigma_ud_tmp.zero();
-        
-        vsigma_dd_tmp = mdarray<double, 1>(num_points, memory_t::host, "vsigma_dd_tmp");
-        vsigma_dd_tmp.zero();
+        /* gradient and Laplacian in real space */
+        xc_gradient_rg(rho_up, grad_rho_up, &lapl_rho_up);
+        xc_gradient_rg(rho_dn, grad_rho_dn, &lapl_rho_dn);
     }
 
-    /* loop over XC functionals */
-    for (auto& ixc: xc_func_) {
-        #pragma omp parallel
-        {
-            /* split local size between threads */
-            splindex<block> spl_t(num_points, omp_get_num_threads(), omp_get_thread_num());
-
-            std::vector<double> exc_t(spl_t.local_size());
-
-            /* if this is an LDA functional */
-            if (ixc.is_lda()) {
-                std::vector<double> vxc_up_t(spl_t.local_size());
-                std::vector<double> vxc_dn_t(spl_t.local_size());
+    auto& vsigma_uu = *vsigma_[0];
+    auto& vsigma_dd = *vsigma_[1];
 
+    /* density below this value is treated as vacuum with zero XC energy and potential */
+    double rho_tol = ctx_.settings().xc_rho_threshold_;
 
-                ixc.get_lda(spl_t.local_size(), 
-                            &rho_up.f_rg(spl_t.global_offset()), 
-                            &rho_dn.f_rg(spl_t.global_offset()), 
-                            &vxc_up_t[0], 
-                            &vxc_dn_t[0], 
-                            &exc_t[0]);
+    /* number of points in a tile; all temporary arrays of a tile fit into L2 cache */
+    int const xc_tile_size{1024};
 
-                for (int i = 0; i < spl_t.local_size(); i++) {
-                    /* add Exc contribution */
-                    exc_tmp(spl_t[i]) += exc_t[i];
+    int num_tiles = num_points / xc_tile_size + std::min(1, num_points % xc_tile_size);
 
-                    /* directly add to Vxc */
-                    vxc_up_tmp(spl_t[i]) += vxc_up_t[i];
-                    vxc_dn_tmp(spl_t[i]) += vxc_dn_t[i];
+    /* the grid is processed by tiles: density of the tile is compacted, passed through all functionals and the 
+     * result is written directly to the output arrays */
+    #pragma omp parallel
+    {
+        std::vector<int> idx(xc_tile_size);
+        mdarray<double, 2> in_t(xc_tile_size, 5);
+        mdarray<double, 2> out_t(xc_tile_size, 6);
+        mdarray<double, 2> tmp(xc_tile_size, 6);
+
+        #pragma omp for schedule(static)
+        for (int it = 0; it < num_tiles; it++) {
+            int ir0 = it * xc_tile_size;
+            int nr  = std::min(xc_tile_size, num_points - ir0);
+
+            /* select points with non-vanishing density */
+            int n{0};
+            for (int ir = ir0; ir < ir0 + nr; ir++) {
+                xc_energy_density_->f_rg(ir) = 0;
+                vxc_up.f_rg(ir)              = 0;
+                vxc_dn.f_rg(ir)              = 0;
+                vsigma_uu.f_rg(ir)           = 0;
+                vsigma_ud.f_rg(ir)           = 0;
+                vsigma_dd.f_rg(ir)           = 0;
+                if (rho_up.f_rg(ir) + rho_dn.f_rg(ir) > rho_tol) {
+                    idx[n]      = ir;
+                    in_t(n, 0) = rho_up.f_rg(ir);
+                    in_t(n, 1) = rho_dn.f_rg(ir);
+                    if (is_gga) {
+                        in_t(n, 2) = in_t(n, 3) = in_t(n, 4) = 0;
+                        for (int x: {0, 1, 2}) {
+                            in_t(n, 2) += grad_rho_up[x]->f_rg(ir) * grad_rho_up[x]->f_rg(ir);
+                            in_t(n, 3) += grad_rho_up[x]->f_rg(ir) * grad_rho_dn[x]->f_rg(ir);
+                            in_t(n, 4) += grad_rho_dn[x]->f_rg(ir) * grad_rho_dn[x]->f_rg(ir);
+                        }
+                    }
+                    n++;
+                }
+            }
+            if (!n) {
+                continue;
+            }
+            /* output: exc, vrho_up, vrho_dn, vsigma_uu, vsigma_ud, vsigma_dd */
+            out_t.zero();
+
+            /* loop over XC functionals */
+            for (auto& ixc: xc_func_) {
+                if (ixc.is_lda()) {
+                    ixc.get_lda(n, &in_t(0, 0), &in_t(0, 1), &tmp(0, 1), &tmp(0, 2), &tmp(0, 0));
+                    for (int j = 0; j < 3; j++) {
+                        for (int i = 0; i < n; i++) {
+                            out_t(i, j) += tmp(i, j);
+                        }
+                    }
+                }
+                if (ixc.is_gga()) {
+                    ixc.get_gga(n, &in_t(0, 0), &in_t(0, 1), &in_t(0, 2), &in_t(0, 3), &in_t(0, 4),
+                                &tmp(0, 1), &tmp(0, 2), &tmp(0, 3), &tmp(0, 4), &tmp(0, 5), &tmp(0, 0));
+                    for (int j = 0; j < 6; j++) {
+                        for (int i = 0; i < n; i++) {
+                            out_t(i, j) += tmp(i, j);
+                        }
+                    }
                 }
             }
-            if (ixc.is_gga()) {
-                std::vector<double> vrho_up_t(spl_t.local_size());
-                std::vector<double> vrho_dn_t(spl_t.local_size());
-                std::vector<double> vsigma_uu_t(spl_t.local_size());
-                std::vector<double> vsigma_ud_t(spl_t.local_size());
-                std::vector<double> vsigma_dd_t(spl_t.local_size());
-
-                ixc.get_gga(spl_t.local_size(), 
-                            &rho_up.f_rg(spl_t.global_offset()), 
-                            &rho_dn.f_rg(spl_t.global_offset()), 
-                            &grad_rho_up_grad_rho_up.f_rg(spl_t.global_offset()), 
-                            &grad_rho_up_grad_rho_dn.f_rg(spl_t.global_offset()), 
-                            &grad_rho_dn_grad_rho_dn.f_rg(spl_t.global_offset()), 
-                            &vrho_up_t[0], 
-                            &vrho_dn_t[0], 
-                            &vsigma_uu_t[0], 
-                            &vsigma_ud_t[0], 
-                            &vsigma_dd_t[0], 
-                            &exc_t[0]);
-                
-                for (int i = 0; i < spl_t.local_size(); i++) {
-                    /* add Exc contribution */
-                    exc_tmp(spl_t[i]) += exc_t[i];
-
-                    /* directly add to Vxc available contributions */
-                    vxc_up_tmp(spl_t[i]) += (vrho_up_t[i] - 2 * vsigma_uu_t[i] * lapl_rho_up.f_rg(spl_t[i]) - vsigma_ud_t[i] * lapl_rho_dn.f_rg(spl_t[i]));
-                    vxc_dn_tmp(spl_t[i]) += (vrho_dn_t[i] - 2 * vsigma_dd_t[i] * lapl_rho_dn.f_rg(spl_t[i]) - vsigma_ud_t[i] * lapl_rho_up.f_rg(spl_t[i]));
 
-                    /* save the sigma derivative */
-                    vsigma_uu_tmp(spl_t[i]) += vsigma_uu_t[i];
-                    vsigma_ud_tmp(spl_t[i]) += vsigma_ud_t[i];
-                    vsigma_dd_tmp(spl_t[i]) += vsigma_dd_t[i];
+            for (int i = 0; i < n; i++) {
+                int ir = idx[i];
+                xc_energy_density_->f_rg(ir) = out_t(i, 0);
+                /* directly add to Vxc available contributions */
+                vxc_up.f_rg(ir) = out_t(i, 1);
+                vxc_dn.f_rg(ir) = out_t(i, 2);
+                if (is_gga) {
+                    vxc_up.f_rg(ir) -= (2 * out_t(i, 3) * lapl_rho_up.f_rg(ir) + out_t(i, 4) * lapl_rho_dn.f_rg(ir));
+                    vxc_dn.f_rg(ir) -= (2 * out_t(i, 5) * lapl_rho_dn.f_rg(ir) + out_t(i, 4) * lapl_rho_up.f_rg(ir));
+                    /* save the sigma derivatives */
+                    vsigma_uu.f_rg(ir) = out_t(i, 3);
+                    vsigma_ud.f_rg(ir) = out_t(i, 4);
+                    vsigma_dd.f_rg(ir) = out_t(i, 5);
                 }
             }
         }
     }
 
     if (is_gga) {
-        /* gather vsigma */
-        Smooth_periodic_function<double> vsigma_uu(ctx_.fft(), ctx_.gvec());
-        Smooth_periodic_function<double> vsigma_ud(ctx_.fft(), ctx_.gvec());
-        Smooth_periodic_function<double> vsigma_dd(ctx_.fft(), ctx_.gvec());
-        for (int ir = 0; ir < num_points; ir++) {
-            vsigma_uu.f_rg(ir) = vsigma_uu_tmp[ir];
-            vsigma_ud.f_rg(ir) = vsigma_ud_tmp[ir];
-            vsigma_dd.f_rg(ir) = vsigma_dd_tmp[ir];
-        }
-
-        /* forward transform vsigma to plane-wave domain */
-        vsigma_uu.fft_transform(-1);
-        vsigma_ud.fft_transform(-1);
-        vsigma_dd.fft_transform(-1);
-
-        /* gradient of vsigma in plane-wave domain */
-        auto grad_vsigma_uu = gradient(vsigma_uu);
-        auto grad_vsigma_ud = gradient(vsigma_ud);
-        auto grad_vsigma_dd = gradient(vsigma_dd);
-
-        /* backward transform gradient from pw to real space */
-        for (int x: {0, 1, 2}) {
-            grad_vsigma_uu[x].fft_transform(1);
-            grad_vsigma_ud[x].fft_transform(1);
-            grad_vsigma_dd[x].fft_transform(1);
-        }
-
-        /* compute scalar product of two gradients */
-        auto grad_vsigma_uu_grad_rho_up = grad_vsigma_uu * grad_rho_up;
-        auto grad_vsigma_dd_grad_rho_dn = grad_vsigma_dd * grad_rho_dn;
-        auto grad_vsigma_ud_grad_rho_up = grad_vsigma_ud * grad_rho_up;
-        auto grad_vsigma_ud_grad_rho_dn = grad_vsigma_ud * grad_rho_dn;
-
-        /* add remaining term to Vxc */
-        for (int ir = 0; ir < num_points; ir++) {
-            vxc_up_tmp(ir) -= (2 * grad_vsigma_uu_grad_rho_up.f_rg(ir) + grad_vsigma_ud_grad_rho_dn.f_rg(ir)); 
-            vxc_dn_tmp(ir) -= (2 * grad_vsigma_dd_grad_rho_dn.f_rg(ir) + grad_vsigma_ud_grad_rho_up.f_rg(ir)); 
+        /* Laplacians are not needed anymore; their space is used for the gradients of vsigma */
+        std::array<Smooth_periodic_function<double>*, 3> grad_vsigma = {&lapl_rho_up, &lapl_rho_dn, &xc_work(13)};
+
+        /* vsigma and the weights of the (grad rho_up, grad rho_dn) products in Vxc_up and Vxc_dn */
+        std::array<Smooth_periodic_function<double>*, 3> vsigma = {&vsigma_uu, &vsigma_ud, &vsigma_dd};
+        double w[3][2][2] = {{{2, 0}, {0, 0}}, {{0, 1}, {1, 0}}, {{0, 0}, {0, 2}}};
+
+        for (int k = 0; k < 3; k++) {
+            /* gradient of vsigma in real space */
+            vsigma[k]->fft_transform(-1);
+            xc_gradient_rg(*vsigma[k], grad_vsigma, nullptr);
+
+            /* add remaining term to Vxc */
+            #pragma omp parallel for schedule(static)
+            for (int ir = 0; ir < num_points; ir++) {
+                double d_up{0};
+                double d_dn{0};
+                for (int x: {0, 1, 2}) {
+                    d_up += grad_vsigma[x]->f_rg(ir) * grad_rho_up[x]->f_rg(ir);
+                    d_dn += grad_vsigma[x]->f_rg(ir) * grad_rho_dn[x]->f_rg(ir);
+                }
+                vxc_up.f_rg(ir) -= (w[k][0][0] * d_up + w[k][0][1] * d_dn);
+                vxc_dn.f_rg(ir) -= (w[k][1][0] * d_up + w[k][1][1] * d_dn);
+            }
         }
     }
 
+    #pragma omp parallel for schedule(static)
     for (int irloc = 0; irloc < num_points; irloc++) {
-        xc_energy_density_->f_rg(irloc) = exc_tmp(irloc);
-        xc_potential_->f_rg(irloc) = 0.5 * (vxc_up_tmp(irloc) + vxc_dn_tmp(irloc));
+        xc_potential_->f_rg(irloc) = 0.5 * (vxc_up.f_rg(irloc) + vxc_dn.f_rg(irloc));
         double m = rho_up.f_rg(irloc) - rho_dn.f_rg(irloc);
 
         if (m > 1e-8) {
-            double b = 0.5 * (vxc_up_tmp(irloc) - vxc_dn_tmp(irloc));
+            double b = 0.5 * (vxc_up.f_rg(irloc) - vxc_dn.f_rg(irloc));
             for (int j = 0; j < ctx_.num_mag_dims(); j++) {
                effective_magnetic_field_[j]->f_rg(irloc) = b * density__.magnetization(j).f_rg(irloc) / m;
             }
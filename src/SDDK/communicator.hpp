@@ -29,9 +29,16 @@
 #include <cassert>
 #include <vector>
 #include <complex>
+#include <numeric>
+#include "trace.hpp"
 
 namespace sddk {
 
+/// Record the call to MPI in the timeline (see sddk::trace); number of bytes is evaluated only if recording is on.
+#define TRACE_MPI(name__, bytes__)                                                                 \
+    static const int trace_mpi_id__ = sddk::timer_labels::id(name__);                              \
+    sddk::trace_region trace_mpi__(trace_mpi_id__, sddk::trace::enabled() ? static_cast<long long>(bytes__) : 0)
+
 #define CALL_MPI(func__, args__)                                                    \
 {                                                                                   \
     if (func__ args__ != MPI_SUCCESS) {                                             \
@@ -43,7 +50,8 @@ namespace sddk {
 enum class mpi_op_t
 {
     sum,
-    max
+    max,
+    min
 };
 
 template <mpi_op_t op>
@@ -67,6 +75,15 @@ struct mpi_op_wrapper<mpi_op_t::max>
     }
 };
 
+template <>
+struct mpi_op_wrapper<mpi_op_t::min>
+{
+    static MPI_Op kind()
+    {
+        return MPI_MIN;
+    }
+};
+
 template <typename T>
 struct mpi_type_wrapper;
 
@@ -79,6 +96,15 @@ struct mpi_type_wrapper<double>
     }
 };
 
+template <>
+struct mpi_type_wrapper<float>
+{
+    static MPI_Datatype kind()
+    {
+        return MPI_FLOAT;
+    }
+};
+
 template <>
 struct mpi_type_wrapper<long double>
 {
@@ -97,6 +123,15 @@ struct mpi_type_wrapper<std::complex<double>>
     }
 };
 
+template <>
+struct mpi_type_wrapper<std::complex<float>>
+{
+    static MPI_Datatype kind()
+    {
+        return MPI_C_FLOAT_COMPLEX;
+    }
+};
+
 template <>
 struct mpi_type_wrapper<int>
 {
@@ -303,6 +338,7 @@ class Communicator
 
     inline void barrier() const
     {
+        TRACE_MPI("MPI_Barrier", 0);
         assert(mpi_comm_ != MPI_COMM_NULL);
         CALL_MPI(MPI_Barrier, (mpi_comm_));
     }
@@ -310,6 +346,7 @@ class Communicator
     template <typename T, mpi_op_t mpi_op__ = mpi_op_t::sum>
     inline void reduce(T* buffer__, int count__, int root__) const
     {
+        TRACE_MPI("MPI_Reduce", sizeof(T) * count__);
         if (root__ == rank()) {
             CALL_MPI(MPI_Reduce, (MPI_IN_PLACE, buffer__, count__, mpi_type_wrapper<T>::kind(),
                                   mpi_op_wrapper<mpi_op__>::kind(), root__, mpi_comm_));
@@ -334,6 +371,7 @@ class Communicator
     template <typename T, mpi_op_t mpi_op__ = mpi_op_t::sum>
     void reduce(T const* sendbuf__, T* recvbuf__, int count__, int root__) const
     {
+        TRACE_MPI("MPI_Reduce", sizeof(T) * count__);
         CALL_MPI(MPI_Reduce, (sendbuf__, recvbuf__, count__, mpi_type_wrapper<T>::kind(),
                               mpi_op_wrapper<mpi_op__>::kind(), root__, mpi_comm_));
     }
@@ -349,6 +387,7 @@ class Communicator
     template <typename T, mpi_op_t mpi_op__ = mpi_op_t::sum>
     inline void allreduce(T* buffer__, int count__) const
     {
+        TRACE_MPI("MPI_Allreduce", sizeof(T) * count__);
         CALL_MPI(MPI_Allreduce, (MPI_IN_PLACE, buffer__, count__, mpi_type_wrapper<T>::kind(),
                                  mpi_op_wrapper<mpi_op__>::kind(), mpi_comm_));
     }
@@ -371,6 +410,7 @@ class Communicator
     template <typename T>
     inline void bcast(T* buffer__, int count__, int root__) const
     {
+        TRACE_MPI("MPI_Bcast", sizeof(T) * count__);
         CALL_MPI(MPI_Bcast, (buffer__, count__, mpi_type_wrapper<T>::kind(), root__, mpi_comm_));
     }
 
@@ -394,6 +434,7 @@ class Communicator
     template <typename T>
     void allgather(T* buffer__, int const* recvcounts__, int const* displs__) const
     {
+        TRACE_MPI("MPI_Allgatherv", sizeof(T) * recvcounts__[rank()]);
         CALL_MPI(MPI_Allgatherv, (MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer__, recvcounts__, displs__,
                                   mpi_type_wrapper<T>::kind(), mpi_comm_));
     }
@@ -403,6 +444,7 @@ class Communicator
     void allgather(T* const sendbuf__, int sendcount__, T* recvbuf__, int const* recvcounts__,
                    int const* displs__) const
     {
+        TRACE_MPI("MPI_Allgatherv", sizeof(T) * sendcount__);
         CALL_MPI(MPI_Allgatherv, (sendbuf__, sendcount__, mpi_type_wrapper<T>::kind(), recvbuf__, recvcounts__,
                                   displs__, mpi_type_wrapper<T>::kind(), mpi_comm_));
     }
@@ -410,6 +452,7 @@ class Communicator
     template <typename T>
     void allgather(T const* sendbuf__, T* recvbuf__, int offset__, int count__) const
     {
+        TRACE_MPI("MPI_Allgatherv", sizeof(T) * count__);
         std::vector<int> v(size() * 2);
         v[2 * rank()]     = count__;
         v[2 * rank() + 1] = offset__;
@@ -458,9 +501,16 @@ class Communicator
         CALL_MPI(MPI_Isend, (buffer__, count__, mpi_type_wrapper<T>::kind(), dest__, tag__, mpi_comm_, &request));
     }
 
+    template <typename T>
+    void isend(T const* buffer__, int count__, int dest__, int tag__, MPI_Request* request__) const
+    {
+        CALL_MPI(MPI_Isend, (buffer__, count__, mpi_type_wrapper<T>::kind(), dest__, tag__, mpi_comm_, request__));
+    }
+
     template <typename T>
     void recv(T* buffer__, int count__, int source__, int tag__) const
     {
+        TRACE_MPI("MPI_Recv", sizeof(T) * count__);
         CALL_MPI(MPI_Recv, (buffer__, count__, mpi_type_wrapper<T>::kind(), source__, tag__, mpi_comm_, MPI_STATUS_IGNORE));
     }
 
@@ -473,6 +523,7 @@ class Communicator
     template <typename T>
     void gather(T const* sendbuf__, T* recvbuf__, int const* recvcounts__, int const* displs__, int root__) const
     {
+        TRACE_MPI("MPI_Gatherv", sizeof(T) * recvcounts__[rank()]);
         int sendcount = recvcounts__[rank()];
 
         CALL_MPI(MPI_Gatherv, (sendbuf__, sendcount, mpi_type_wrapper<T>::kind(), recvbuf__, recvcounts__, displs__,
@@ -482,6 +533,7 @@ class Communicator
     template <typename T>
     void scatter(T const* sendbuf__, T* recvbuf__, int const* sendcounts__, int const* displs__, int root__) const
     {
+        TRACE_MPI("MPI_Scatterv", sizeof(T) * sendcounts__[rank()]);
         int recvcount = sendcounts__[rank()];
         CALL_MPI(MPI_Scatterv, (sendbuf__, sendcounts__, displs__, mpi_type_wrapper<T>::kind(), recvbuf__, recvcount,
                                 mpi_type_wrapper<T>::kind(), root__, mpi_comm_));
@@ -490,6 +542,7 @@ class Communicator
     template <typename T>
     void alltoall(T const* sendbuf__, int sendcounts__, T* recvbuf__, int recvcounts__) const
     {
+        TRACE_MPI("MPI_Alltoall", sizeof(T) * sendcounts__ * size());
         CALL_MPI(MPI_Alltoall, (sendbuf__, sendcounts__, mpi_type_wrapper<T>::kind(), recvbuf__, recvcounts__,
                                 mpi_type_wrapper<T>::kind(), mpi_comm_));
     }
@@ -498,10 +551,21 @@ class Communicator
     void alltoall(T const* sendbuf__, int const* sendcounts__, int const* sdispls__, T* recvbuf__,
                   int const* recvcounts__, int const* rdispls__) const
     {
+        TRACE_MPI("MPI_Alltoallv", sizeof(T) * std::accumulate(sendcounts__, sendcounts__ + size(), 0LL));
         CALL_MPI(MPI_Alltoallv, (sendbuf__, sendcounts__, sdispls__, mpi_type_wrapper<T>::kind(), recvbuf__,
                                  recvcounts__, rdispls__, mpi_type_wrapper<T>::kind(), mpi_comm_));
     }
 
+    /// Non-blocking version of the all-to-all exchange with variable counts.
+    template <typename T>
+    void ialltoall(T const* sendbuf__, int const* sendcounts__, int const* sdispls__, T* recvbuf__,
+                   int const* recvcounts__, int const* rdispls__, MPI_Request* req__) const
+    {
+        TRACE_MPI("MPI_Ialltoallv", sizeof(T) * std::accumulate(sendcounts__, sendcounts__ + size(), 0LL));
+        CALL_MPI(MPI_Ialltoallv, (sendbuf__, sendcounts__, sdispls__, mpi_type_wrapper<T>::kind(), recvbuf__,
+                                  recvcounts__, rdispls__, mpi_type_wrapper<T>::kind(), mpi_comm_, req__));
+    }
+
     Communicator split(int color__) const
     {
         Communicator new_comm;
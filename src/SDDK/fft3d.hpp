@@ -52,8 +52,12 @@ namespace sddk {
  *  The following cases are handeled by the FFT driver:
  *    - transformation of a single real / complex function (serial / parallel, cpu / gpu)
  *    - transformation of two real functions (serial / parallel, cpu / gpu)
+ *    - batched transformation of several complex or pairs of real functions (serial / parallel, cpu)
  *    - input / ouput data buffer pointer (cpu / gpu). GPU input pointer works only in serial.
  *
+ *  On the CPU the xy-transformation is pruned: only the x-columns of the xy-plane which contain z-columns
+ *  of G-vectors are transformed along y, and only then the full transformation along x is performed.
+ *
  *  The transformation of two real functions is done as one transformation of complex function:
  *  \f[
  *    \Psi({\bf r}) = \psi_1({\bf r}) + i \psi_2({\bf r})
@@ -109,6 +113,21 @@ class FFT3D
         
         /// Auxiliary array in case of simultaneous transformation of two wave-functions.
         mdarray<double_complex, 1> fft_buffer_aux2_;
+
+        /// True if the z-sticks are exchanged in single precision.
+        bool a2a_single_precision_{false};
+
+        /// Single precision send and receive buffer for the all-to-all exchange of the z-sticks.
+        mdarray<std::complex<float>, 1> fft_buffer_sp_;
+
+        /// Real-space buffers for the batched transformation.
+        mdarray<double_complex, 2> fft_buffer_batch_;
+
+        /// z-sticks of the batch of functions.
+        mdarray<double_complex, 1> fft_buffer_batch_aux1_;
+
+        /// Send / receive buffer for the aggregated all-to-all of the batch.
+        mdarray<double_complex, 1> fft_buffer_batch_aux2_;
         
         /// Internal buffer for independent z-transforms.
         std::vector<double_complex*> fftw_buffer_z_;
@@ -124,6 +143,23 @@ class FFT3D
 
         std::vector<fftw_plan> plan_forward_xy_;
 
+        /// Backward transformation along x for all rows of the xy-plane.
+        std::vector<fftw_plan> plan_backward_x_;
+
+        /// Forward transformation along x for all rows of the xy-plane.
+        std::vector<fftw_plan> plan_forward_x_;
+
+        /// Backward transformation along y for each range of non-empty x-columns.
+        std::vector<std::vector<fftw_plan>> plan_backward_y_;
+
+        /// Forward transformation along y for each range of non-empty x-columns.
+        std::vector<std::vector<fftw_plan>> plan_forward_y_;
+
+        /// Contiguous ranges (first x, number of x) of the xy-plane x-columns which contain at least one z-column.
+        /** If this list is not empty, the pruned xy-transformation is executed: 1D transformations along y are done
+         *  only for non-empty x-columns and then the full transformation along x is done. */
+        std::vector<std::pair<int, int>> x_ranges_;
+
         #ifdef __GPU
         /// Handler for xy-transform cuFFT plan.
         cufftHandle cufft_plan_xy_;
@@ -155,6 +191,189 @@ class FFT3D
         /// Defines the distribution of G-vectors between the MPI ranks of FFT communicator. 
         Gvec_partition const* gvec_partition_{nullptr};
 
+        /// Transform a single z-column of one function on the CPU.
+        /** The column is stored in the auxiliary buffer in the layout required by the all-to-all: the part of the
+         *  column which belongs to the slab of rank r is located at the offset
+         *  \f$ N_{fft} z_{r} N_{col} + i_{b} n_{z,r} N_{col} + i n_{z,r} \f$, where \f$ N_{col} \f$ is the local
+         *  number of z-columns, \f$ z_{r} \f$ and \f$ n_{z,r} \f$ are the offset and size of the slab.
+         *  For a single function (num_fft__ = 1) this reduces to the standard layout of transform_z_serial(). */
+        template <int direction>
+        inline void transform_z_column(int             tid__,
+                                       int             i__,
+                                       double_complex* data__,
+                                       double_complex* fft_buffer_aux__,
+                                       int             num_fft__,
+                                       int             ib__)
+        {
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+            double norm = 1.0 / size();
+            bool is_reduced = gvec_partition_->reduced();
+
+            /* global index of column */
+            int icol = gvec_partition_->zcol_offset_fft() + i__;
+            /* offset of the PW coeffs in the input/output data buffer */
+            int data_offset = gvec_partition_->zcol_offs(icol);
+
+            switch (direction) {
+                case 1: {
+                    /* clear z buffer */
+                    std::fill(fftw_buffer_z_[tid__], fftw_buffer_z_[tid__] + grid_.size(2), 0);
+                    /* load z column  of PW coefficients into buffer */
+                    for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
+                        int z = grid().coord_by_gvec(gvec_partition_->zcol(icol).z[j], 2);
+                        fftw_buffer_z_[tid__][z] = data__[data_offset + j];
+                    }
+
+                    /* column with {x,y} = {0,0} has only non-negative z components */
+                    if (is_reduced && !icol) {
+                        /* load remaining part of {0,0,z} column */
+                        for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
+                            int z = grid().coord_by_gvec(-gvec_partition_->zcol(icol).z[j], 2);
+                            fftw_buffer_z_[tid__][z] = std::conj(data__[data_offset + j]);
+                        }
+                    }
+
+                    /* perform local FFT transform of a column */
+                    fftw_execute(plan_backward_z_[tid__]);
+                    
+                    /* redistribute z-column for a forthcoming all-to-all or just load the
+                     * full column into auxiliary buffer in serial case */
+                    for (int r = 0; r < comm_.size(); r++) {
+                        int lsz  = spl_z_.local_size(r);
+                        int offs = spl_z_.global_offset(r);
+
+                        std::copy(&fftw_buffer_z_[tid__][offs],
+                                  &fftw_buffer_z_[tid__][offs] + lsz, 
+                                  &fft_buffer_aux__[(num_fft__ * offs + ib__ * lsz) * num_zcol_local + i__ * lsz]);
+                    }
+                    break;
+
+                }
+                case -1: {
+                    /* collect full z-column or just load it from the auxiliary buffer is serial case */
+                    for (int r = 0; r < comm_.size(); r++) {
+                        int lsz  = spl_z_.local_size(r);
+                        int offs = spl_z_.global_offset(r);
+
+                        double_complex* ptr = &fft_buffer_aux__[(num_fft__ * offs + ib__ * lsz) * num_zcol_local + i__ * lsz];
+                        std::copy(ptr, ptr + lsz, &fftw_buffer_z_[tid__][offs]);
+                    }
+
+                    /* perform local FFT transform of a column */
+                    fftw_execute(plan_forward_z_[tid__]);
+
+                    /* save z column of PW coefficients */
+                    for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
+                        int z = grid().coord_by_gvec(gvec_partition_->zcol(icol).z[j], 2);
+                        data__[data_offset + j] = fftw_buffer_z_[tid__][z] * norm;
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Transform a single xy-plane of one complex or two real functions on the CPU.
+        /** z-columns of the first (and second) function are stored in the auxiliary buffers with the stride
+         *  local_size_z_, i.e. the element iz of the i-th column is located at zcols[iz + i * local_size_z_].
+         *  The xy-plane in real space is stored in (or taken from) fft_plane__. */
+        template <int direction, bool two_functions>
+        inline void transform_xy_plane(int             tid__,
+                                       int             iz__,
+                                       double_complex* zcols1__,
+                                       double_complex* zcols2__,
+                                       double_complex* fft_plane__)
+        {
+            int size_xy = grid_.size(0) * grid_.size(1);
+
+            bool is_reduced = gvec_partition_->reduced();
+
+            double_complex* buf = fftw_buffer_xy_[tid__];
+
+            switch (direction) {
+                case 1: {
+                    /* clear xy-buffer */
+                    std::fill(buf, buf + size_xy, 0);
+                    if (two_functions) {
+                        /* load first z-column into proper location */
+                        buf[z_col_pos_(0, 0)] = zcols1__[iz__] + double_complex(0, 1) * zcols2__[iz__];
+
+                        /* load remaining z-columns into proper location */
+                        for (int i = 1; i < gvec_partition_->num_zcol(); i++) {
+                            double_complex v1 = zcols1__[iz__ + i * local_size_z_];
+                            double_complex v2 = zcols2__[iz__ + i * local_size_z_];
+                            /* {x, y} part */
+                            buf[z_col_pos_(i, 0)] = v1 + double_complex(0, 1) * v2;
+                            /* {-x, -y} part */
+                            buf[z_col_pos_(i, 1)] = std::conj(v1) + double_complex(0, 1) * std::conj(v2);
+                        }
+                    } else {
+                        /* load z-columns into proper location */
+                        for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
+                            buf[z_col_pos_(i, 0)] = zcols1__[iz__ + i * local_size_z_];
+
+                            if (is_reduced && i) {
+                                buf[z_col_pos_(i, 1)] = std::conj(buf[z_col_pos_(i, 0)]);
+                            }
+                        }
+                    }
+                    
+                    /* execute local FFT transform */
+                    if (x_ranges_.size()) {
+                        /* transform non-empty x-columns along y */
+                        for (auto& p: plan_backward_y_[tid__]) {
+                            fftw_execute(p);
+                        }
+                        /* transform all rows along x */
+                        fftw_execute(plan_backward_x_[tid__]);
+                    } else {
+                        fftw_execute(plan_backward_xy_[tid__]);
+                    }
+
+                    /* copy xy plane to the main FFT buffer */
+                    std::copy(buf, buf + size_xy, fft_plane__);
+                    break;
+                }
+                case -1: {
+                    /* copy xy plane from the main FFT buffer */
+                    std::copy(fft_plane__, fft_plane__ + size_xy, buf);
+
+                    /* execute local FFT transform */
+                    if (x_ranges_.size()) {
+                        /* transform all rows along x */
+                        fftw_execute(plan_forward_x_[tid__]);
+                        /* transform along y only the x-columns from which the z-columns are taken */
+                        for (auto& p: plan_forward_y_[tid__]) {
+                            fftw_execute(p);
+                        }
+                    } else {
+                        fftw_execute(plan_forward_xy_[tid__]);
+                    }
+
+                    /* get z-columns */
+                    if (two_functions) {
+                        for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
+                            zcols1__[iz__ + i * local_size_z_] = 0.5 * 
+                                (buf[z_col_pos_(i, 0)] + std::conj(buf[z_col_pos_(i, 1)]));
+
+                            zcols2__[iz__ + i * local_size_z_] = double_complex(0, -0.5) * 
+                                (buf[z_col_pos_(i, 0)] - std::conj(buf[z_col_pos_(i, 1)]));
+                        }
+                    } else {
+                        for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
+                            zcols1__[iz__ + i * local_size_z_] = buf[z_col_pos_(i, 0)];
+                        }
+                    }
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
         /// Serial part of 1D transformation of columns.
         template <int direction, device_t data_ptr_type>
         void transform_z_serial(double_complex* data__,
@@ -163,15 +382,14 @@ class FFT3D
             PROFILE("sddk::FFT3D::transform_z_serial");
 
             int num_zcol_local = gvec_partition_->zcol_count_fft();
-            double norm = 1.0 / size();
-            
-            bool is_reduced = gvec_partition_->reduced();
 
             assert(static_cast<int>(fft_buffer_aux__.size()) >= gvec_partition_->zcol_count_fft() * grid_.size(2));
             
             /* input/output data buffer is on GPU */
             if (data_ptr_type == GPU) {
                 #ifdef __GPU
+                double norm = 1.0 / size();
+                bool is_reduced = gvec_partition_->reduced();
                 switch (direction) {
                     case 1: {
                         /* load all columns into FFT buffer */
@@ -222,77 +440,42 @@ class FFT3D
                     int tid = omp_get_thread_num();
                     #pragma omp for schedule(dynamic, 1)
                     for (int i = 0; i < num_zcol_local; i++) {
-                        /* global index of column */
-                        int icol = gvec_partition_->zcol_offset_fft() + i;
-                        /* offset of the PW coeffs in the input/output data buffer */
-                        int data_offset = gvec_partition_->zcol_offs(icol);
-
-                        switch (direction) {
-                            case 1: {
-                                /* clear z buffer */
-                                std::fill(fftw_buffer_z_[tid], fftw_buffer_z_[tid] + grid_.size(2), 0);
-                                /* load z column  of PW coefficients into buffer */
-                                for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
-                                    int z = grid().coord_by_gvec(gvec_partition_->zcol(icol).z[j], 2);
-                                    fftw_buffer_z_[tid][z] = data__[data_offset + j];
-                                }
-
-                                /* column with {x,y} = {0,0} has only non-negative z components */
-                                if (is_reduced && !icol) {
-                                    /* load remaining part of {0,0,z} column */
-                                    for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
-                                        int z = grid().coord_by_gvec(-gvec_partition_->zcol(icol).z[j], 2);
-                                        fftw_buffer_z_[tid][z] = std::conj(data__[data_offset + j]);
-                                    }
-                                }
-
-                                /* perform local FFT transform of a column */
-                                fftw_execute(plan_backward_z_[tid]);
-                                
-                                /* redistribute z-column for a forthcoming all-to-all or just load the
-                                 * full column into auxiliary buffer in serial case */
-                                for (int r = 0; r < comm_.size(); r++) {
-                                    int lsz  = spl_z_.local_size(r);
-                                    int offs = spl_z_.global_offset(r);
-
-                                    std::copy(&fftw_buffer_z_[tid][offs],
-                                              &fftw_buffer_z_[tid][offs] + lsz, 
-                                              &fft_buffer_aux__[offs * num_zcol_local + i * lsz]);
-                                }
-                                break;
-
-                            }
-                            case -1: {
-                                /* collect full z-column or just load it from the auxiliary buffer is serial case */
-                                for (int r = 0; r < comm_.size(); r++) {
-                                    int lsz  = spl_z_.local_size(r);
-                                    int offs = spl_z_.global_offset(r);
-
-                                    std::copy(&fft_buffer_aux__[offs * num_zcol_local + i * lsz],
-                                              &fft_buffer_aux__[offs * num_zcol_local + i * lsz] + lsz,
-                                              &fftw_buffer_z_[tid][offs]);
-                                }
-
-                                /* perform local FFT transform of a column */
-                                fftw_execute(plan_forward_z_[tid]);
-
-                                /* save z column of PW coefficients */
-                                for (size_t j = 0; j < gvec_partition_->zcol(icol).z.size(); j++) {
-                                    int z = grid().coord_by_gvec(gvec_partition_->zcol(icol).z[j], 2);
-                                    data__[data_offset + j] = fftw_buffer_z_[tid][z] * norm;
-                                }
-
-                                break;
-                            }
-                            default: {
-                                TERMINATE("wrong direction");
-                            }
-                        }
+                        transform_z_column<direction>(tid, i, data__, fft_buffer_aux__.at<CPU>(), 1, 0);
                     }
                 }
             }
         }
 
+        /// All-to-all exchange of the z-sticks.
+        /** If a2a_single_precision_ is set, the data is converted to single precision before the exchange, which halves
+         *  the number of bytes sent between the ranks of the FFT communicator. */
+        void alltoall_sticks(double_complex* sendbuf__, int const* sendcounts__, int const* sdispls__,
+                             double_complex* recvbuf__, int const* recvcounts__, int const* rdispls__)
+        {
+            if (!a2a_single_precision_) {
+                comm_.alltoall(sendbuf__, sendcounts__, sdispls__, recvbuf__, recvcounts__, rdispls__);
+                return;
+            }
+            int n = comm_.size() - 1;
+            size_t send_size = sdispls__[n] + sendcounts__[n];
+            size_t recv_size = rdispls__[n] + recvcounts__[n];
+            if (fft_buffer_sp_.size() < send_size + recv_size) {
+                fft_buffer_sp_ = mdarray<std::complex<float>, 1>(send_size + recv_size, host_memory_type_, "FFT3D.fft_buffer_sp_");
+            }
+            std::complex<float>* sbuf = fft_buffer_sp_.at<CPU>();
+            std::complex<float>* rbuf = fft_buffer_sp_.at<CPU>(send_size);
+
+            #pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < send_size; i++) {
+                sbuf[i] = static_cast<std::complex<float>>(sendbuf__[i]);
+            }
+            comm_.alltoall(sbuf, sendcounts__, sdispls__, rbuf, recvcounts__, rdispls__);
+            #pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < recv_size; i++) {
+                recvbuf__[i] = static_cast<double_complex>(rbuf[i]);
+            }
+        }
+
         /// Transformation of z-columns.
         template <int direction, device_t data_ptr_type>
         void transform_z(double_complex* data__,
@@ -327,7 +510,7 @@ class FFT3D
                     std::copy(&fft_buffer_aux__[0], &fft_buffer_aux__[0] + gvec_partition_->num_zcol() * local_size_z_,
                               &fft_buffer_[0]);
 
-                    comm_.alltoall(&fft_buffer_[0], &send.counts[0], &send.offsets[0], &fft_buffer_aux__[0], &recv.counts[0], &recv.offsets[0]);
+                    alltoall_sticks(&fft_buffer_[0], &send.counts[0], &send.offsets[0], &fft_buffer_aux__[0], &recv.counts[0], &recv.offsets[0]);
                 }
             
                 /* buffer is on CPU after mpi_a2a and has to be copied to GPU */
@@ -358,7 +541,7 @@ class FFT3D
                     recv.calc_offsets();
 
                     /* scatter z-columns */
-                    comm_.alltoall(&fft_buffer_aux__[0], &send.counts[0], &send.offsets[0], &fft_buffer_[0], &recv.counts[0], &recv.offsets[0]);
+                    alltoall_sticks(&fft_buffer_aux__[0], &send.counts[0], &send.offsets[0], &fft_buffer_[0], &recv.counts[0], &recv.offsets[0]);
 
                     /* copy local fractions of z-columns into auxiliary buffer */
                     std::copy(&fft_buffer_[0], &fft_buffer_[0] + gvec_partition_->num_zcol() * local_size_z_,
@@ -379,10 +562,9 @@ class FFT3D
 
             int size_xy = grid_.size(0) * grid_.size(1);
 
-            int is_reduced = gvec_partition_->reduced();
-
             #ifdef __GPU
             if (pu_ == GPU) {
+                int is_reduced = gvec_partition_->reduced();
                 /* stream #0 will be doing cuFFT */
                 switch (direction) {
                     case 1: {
@@ -425,45 +607,8 @@ class FFT3D
                     int tid = omp_get_thread_num();
                     #pragma omp for schedule(static)
                     for (int iz = 0; iz < local_size_z_; iz++) {
-                        switch (direction) {
-                            case 1: {
-                                /* clear xy-buffer */
-                                std::fill(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, 0);
-                                /* load z-columns into proper location */
-                                for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
-                                    fftw_buffer_xy_[tid][z_col_pos_(i, 0)] = fft_buffer_aux__[iz + i * local_size_z_];
-
-                                    if (is_reduced && i) {
-                                        fftw_buffer_xy_[tid][z_col_pos_(i, 1)] = std::conj(fftw_buffer_xy_[tid][z_col_pos_(i, 0)]);
-                                    }
-                                }
-                                
-                                /* execute local FFT transform */
-                                fftw_execute(plan_backward_xy_[tid]);
-
-                                /* copy xy plane to the main FFT buffer */
-                                std::copy(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, &fft_buffer_[iz * size_xy]);
-                                
-                                break;
-                            }
-                            case -1: {
-                                /* copy xy plane from the main FFT buffer */
-                                std::copy(&fft_buffer_[iz * size_xy], &fft_buffer_[iz * size_xy] + size_xy, fftw_buffer_xy_[tid]);
-
-                                /* execute local FFT transform */
-                                fftw_execute(plan_forward_xy_[tid]);
-
-                                /* get z-columns */
-                                for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
-                                    fft_buffer_aux__[iz  + i * local_size_z_] = fftw_buffer_xy_[tid][z_col_pos_(i, 0)];
-                                }
-
-                                break;
-                            }
-                            default: {
-                                TERMINATE("wrong direction");
-                            }
-                        }
+                        transform_xy_plane<direction, false>(tid, iz, fft_buffer_aux__.at<CPU>(), nullptr,
+                                                             &fft_buffer_[iz * size_xy]);
                     }
                 }
             }
@@ -527,61 +672,211 @@ class FFT3D
                     int tid = omp_get_thread_num();
                     #pragma omp for schedule(static)
                     for (int iz = 0; iz < local_size_z_; iz++) {
-                        switch (direction) {
-                            case 1: {
-                                /* clear xy-buffer */
-                                std::fill(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, 0);
-
-                                /* load first z-column into proper location */
-                                fftw_buffer_xy_[tid][z_col_pos_(0, 0)] = fft_buffer_aux1__[iz] + 
-                                    double_complex(0, 1) * fft_buffer_aux2__[iz];
-
-                                /* load remaining z-columns into proper location */
-                                for (int i = 1; i < gvec_partition_->num_zcol(); i++) {
-                                    /* {x, y} part */
-                                    fftw_buffer_xy_[tid][z_col_pos_(i, 0)] = fft_buffer_aux1__[iz + i * local_size_z_] + 
-                                        double_complex(0, 1) * fft_buffer_aux2__[iz + i * local_size_z_];
-
-                                    /* {-x, -y} part */
-                                    fftw_buffer_xy_[tid][z_col_pos_(i, 1)] = std::conj(fft_buffer_aux1__[iz + i * local_size_z_]) +
-                                        double_complex(0, 1) * std::conj(fft_buffer_aux2__[iz + i * local_size_z_]);
-                                }
-                                
-                                /* execute local FFT transform */
-                                fftw_execute(plan_backward_xy_[tid]);
-
-                                /* copy xy plane to the main FFT buffer */
-                                std::copy(fftw_buffer_xy_[tid], fftw_buffer_xy_[tid] + size_xy, &fft_buffer_[iz * size_xy]);
-                                
-                                break;
-                            }
-                            case -1: {
-                                /* copy xy plane from the main FFT buffer */
-                                std::copy(&fft_buffer_[iz * size_xy], &fft_buffer_[iz * size_xy] + size_xy, fftw_buffer_xy_[tid]);
+                        transform_xy_plane<direction, true>(tid, iz, fft_buffer_aux1__.at<CPU>(), fft_buffer_aux2__.at<CPU>(),
+                                                            &fft_buffer_[iz * size_xy]);
+                    }
+                }
+            }
+        }
 
-                                /* execute local FFT transform */
-                                fftw_execute(plan_forward_xy_[tid]);
+        /// Reorder the z-sticks of a batch of functions between the band-major and the rank-major layouts.
+        /** In the band-major layout the sticks of all functions are stored one after another:
+         *  \f$ (i_{b} N_{col} + i_{col}) n_{z} \f$ is the offset of the local part of the i_{col}-th stick of
+         *  the i_{b}-th function. In the rank-major layout the sticks are grouped by the rank which owns them
+         *  (for the all-to-all): \f$ N_{fft} n_{z} o_{r} + (i_{b} c_{r} + i) n_{z} \f$, where \f$ c_{r} \f$
+         *  and \f$ o_{r} \f$ are the number and the offset of the z-columns of rank r. */
+        template <bool to_band_major>
+        void reorder_batch_sticks(int num_fft__, double_complex const* src__, double_complex* dst__)
+        {
+            int lsz = local_size_z_;
+            int ncol = gvec_partition_->num_zcol();
+            auto& distr = gvec_partition_->zcol_distr_fft();
 
-                                /* get z-columns */
-                                for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
-                                    fft_buffer_aux1__[iz  + i * local_size_z_] = 0.5 * 
-                                        (fftw_buffer_xy_[tid][z_col_pos_(i, 0)] + std::conj(fftw_buffer_xy_[tid][z_col_pos_(i, 1)]));
+            #pragma omp parallel for schedule(static)
+            for (int ib = 0; ib < num_fft__; ib++) {
+                for (int r = 0; r < comm_.size(); r++) {
+                    size_t offs_rank = static_cast<size_t>(lsz) * (num_fft__ * distr.offsets[r] + ib * distr.counts[r]);
+                    size_t offs_band = static_cast<size_t>(lsz) * (ib * ncol + distr.offsets[r]);
+                    size_t n = static_cast<size_t>(lsz) * distr.counts[r];
+                    if (to_band_major) {
+                        std::copy(&src__[offs_rank], &src__[offs_rank] + n, &dst__[offs_band]);
+                    } else {
+                        std::copy(&src__[offs_band], &src__[offs_band] + n, &dst__[offs_rank]);
+                    }
+                }
+            }
+        }
 
-                                    fft_buffer_aux2__[iz  + i * local_size_z_] = double_complex(0, -0.5) * 
-                                        (fftw_buffer_xy_[tid][z_col_pos_(i, 0)] - std::conj(fftw_buffer_xy_[tid][z_col_pos_(i, 1)]));
-                                }
+        /// Transformation of z-columns of a batch of functions with a single aggregated all-to-all.
+        template <int direction>
+        void transform_z_batch(int num_fft__, double_complex* data__, int ld__)
+        {
+            PROFILE("sddk::FFT3D::transform_z_batch");
 
-                                break;
-                            }
-                            default: {
-                                TERMINATE("wrong direction");
-                            }
-                        }
+            int rank = comm_.rank();
+            int num_zcol_local = gvec_partition_->zcol_count_fft();
+
+            block_data_descriptor a2a_z(comm_.size());
+            block_data_descriptor a2a_xy(comm_.size());
+            if (comm_.size() > 1) {
+                for (int r = 0; r < comm_.size(); r++) {
+                    /* size of the z-stick pieces of rank r for all functions of the batch */
+                    a2a_z.counts[r]  = num_fft__ * spl_z_.local_size(r)    * gvec_partition_->zcol_distr_fft().counts[rank];
+                    /* size of the local z-stick pieces of all columns of rank r */
+                    a2a_xy.counts[r] = num_fft__ * spl_z_.local_size(rank) * gvec_partition_->zcol_distr_fft().counts[r];
+                }
+                a2a_z.calc_offsets();
+                a2a_xy.calc_offsets();
+            }
+
+            if (direction == -1 && comm_.size() > 1) {
+                sddk::timer t("sddk::FFT3D::transform_z_batch|comm");
+                reorder_batch_sticks<false>(num_fft__, fft_buffer_batch_aux1_.at<CPU>(), fft_buffer_batch_aux2_.at<CPU>());
+                alltoall_sticks(fft_buffer_batch_aux2_.at<CPU>(), &a2a_xy.counts[0], &a2a_xy.offsets[0],
+                                fft_buffer_batch_aux1_.at<CPU>(), &a2a_z.counts[0], &a2a_z.offsets[0]);
+            }
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                #pragma omp for schedule(dynamic, 1)
+                for (int k = 0; k < num_fft__ * num_zcol_local; k++) {
+                    int ib = k / num_zcol_local;
+                    int i  = k % num_zcol_local;
+                    transform_z_column<direction>(tid, i, data__ + static_cast<size_t>(ld__) * ib,
+                                                  fft_buffer_batch_aux1_.at<CPU>(), num_fft__, ib);
+                }
+            }
+
+            if (direction == 1 && comm_.size() > 1) {
+                sddk::timer t("sddk::FFT3D::transform_z_batch|comm");
+                alltoall_sticks(fft_buffer_batch_aux1_.at<CPU>(), &a2a_z.counts[0], &a2a_z.offsets[0],
+                                fft_buffer_batch_aux2_.at<CPU>(), &a2a_xy.counts[0], &a2a_xy.offsets[0]);
+                reorder_batch_sticks<true>(num_fft__, fft_buffer_batch_aux2_.at<CPU>(), fft_buffer_batch_aux1_.at<CPU>());
+            }
+        }
+
+        /// Apply 2D FFT transformation to the z-columns of a batch of functions.
+        template <int direction>
+        void transform_xy_batch(int num_fft__)
+        {
+            PROFILE("sddk::FFT3D::transform_xy_batch");
+
+            int size_xy = grid_.size(0) * grid_.size(1);
+            /* stride between the z-sticks of two functions */
+            size_t stride = static_cast<size_t>(local_size_z_) * gvec_partition_->num_zcol();
+            /* number of real-space buffers */
+            int nbuf = gvec_partition_->reduced() ? num_fft__ / 2 : num_fft__;
+
+            #pragma omp parallel
+            {
+                int tid = omp_get_thread_num();
+                #pragma omp for schedule(static)
+                for (int k = 0; k < nbuf * local_size_z_; k++) {
+                    int ib = k / local_size_z_;
+                    int iz = k % local_size_z_;
+                    if (gvec_partition_->reduced()) {
+                        transform_xy_plane<direction, true>(tid, iz, &fft_buffer_batch_aux1_[2 * ib * stride],
+                                                            &fft_buffer_batch_aux1_[(2 * ib + 1) * stride],
+                                                            &fft_buffer_batch_(iz * size_xy, ib));
+                    } else {
+                        transform_xy_plane<direction, false>(tid, iz, &fft_buffer_batch_aux1_[ib * stride], nullptr,
+                                                             &fft_buffer_batch_(iz * size_xy, ib));
                     }
                 }
             }
         }
 
+        /// Allocate buffers for the batched transformation of num_fft__ functions.
+        void allocate_batch(int num_fft__)
+        {
+            /* number of real-space buffers */
+            int nbuf = gvec_partition_->reduced() ? num_fft__ / 2 : num_fft__;
+            if (static_cast<int>(fft_buffer_batch_.size(1)) < nbuf) {
+                fft_buffer_batch_ = mdarray<double_complex, 2>(local_size(), nbuf, host_memory_type_, "FFT3D.fft_buffer_batch_");
+            }
+            /* we need this buffer size for mpi_alltoall */
+            size_t sz_max = num_fft__ * std::max(grid_.size(2) * gvec_partition_->zcol_count_fft(),
+                                                 local_size_z_ * gvec_partition_->num_zcol());
+            if (sz_max > fft_buffer_batch_aux1_.size()) {
+                fft_buffer_batch_aux1_ = mdarray<double_complex, 1>(sz_max, host_memory_type_, "FFT3D.fft_buffer_batch_aux1_");
+                if (comm_.size() > 1) {
+                    fft_buffer_batch_aux2_ = mdarray<double_complex, 1>(sz_max, host_memory_type_, "FFT3D.fft_buffer_batch_aux2_");
+                }
+            }
+        }
+
+        /// Create a plan for the 1D transformations of all rows of the xy-plane along x.
+        fftw_plan plan_many_x(double_complex* buf__, int sign__)
+        {
+            int nx = grid_.size(0);
+            return fftw_plan_many_dft(1, &nx, grid_.size(1), (fftw_complex*)buf__, NULL, 1, nx,
+                                      (fftw_complex*)buf__, NULL, 1, nx, sign__, FFTW_ESTIMATE);
+        }
+
+        /// Create a plan for the 1D transformations along y of num_x__ x-columns starting from x0__.
+        fftw_plan plan_many_y(double_complex* buf__, int x0__, int num_x__, int sign__)
+        {
+            int nx = grid_.size(0);
+            int ny = grid_.size(1);
+            return fftw_plan_many_dft(1, &ny, num_x__, (fftw_complex*)(buf__ + x0__), NULL, nx, 1,
+                                      (fftw_complex*)(buf__ + x0__), NULL, nx, 1, sign__, FFTW_ESTIMATE);
+        }
+
+        /// Find non-empty x-columns of the xy-plane and create the plans for the pruned xy-transformation.
+        void prepare_pruned_xy()
+        {
+            destroy_pruned_xy();
+
+            int nx = grid_.size(0);
+
+            std::vector<bool> is_used(nx, false);
+            for (int i = 0; i < gvec_partition_->num_zcol(); i++) {
+                is_used[z_col_pos_(i, 0) % nx] = true;
+                if (gvec_partition_->reduced()) {
+                    is_used[z_col_pos_(i, 1) % nx] = true;
+                }
+            }
+            int num_used{0};
+            for (int x = 0; x < nx; x++) {
+                if (is_used[x]) {
+                    num_used++;
+                    if (x == 0 || !is_used[x - 1]) {
+                        x_ranges_.push_back(std::make_pair(x, 0));
+                    }
+                    x_ranges_.back().second++;
+                }
+            }
+            /* nothing to prune */
+            if (num_used == nx) {
+                x_ranges_.clear();
+                return;
+            }
+
+            for (int i = 0; i < omp_get_max_threads(); i++) {
+                for (auto& r: x_ranges_) {
+                    plan_forward_y_[i].push_back(plan_many_y(fftw_buffer_xy_[i], r.first, r.second, FFTW_FORWARD));
+                    plan_backward_y_[i].push_back(plan_many_y(fftw_buffer_xy_[i], r.first, r.second, FFTW_BACKWARD));
+                }
+            }
+        }
+
+        /// Destroy the plans of the pruned xy-transformation.
+        void destroy_pruned_xy()
+        {
+            for (int i = 0; i < omp_get_max_threads(); i++) {
+                for (auto& p: plan_forward_y_[i]) {
+                    fftw_destroy_plan(p);
+                }
+                for (auto& p: plan_backward_y_[i]) {
+                    fftw_destroy_plan(p);
+                }
+                plan_forward_y_[i].clear();
+                plan_backward_y_[i].clear();
+            }
+            x_ranges_.clear();
+        }
+
     public:
         
         /// Constructor.
@@ -618,6 +913,10 @@ class FFT3D
             plan_forward_xy_  = std::vector<fftw_plan>(omp_get_max_threads());
             plan_backward_z_  = std::vector<fftw_plan>(omp_get_max_threads());
             plan_backward_xy_ = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_forward_x_   = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_backward_x_  = std::vector<fftw_plan>(omp_get_max_threads());
+            plan_forward_y_   = std::vector<std::vector<fftw_plan>>(omp_get_max_threads());
+            plan_backward_y_  = std::vector<std::vector<fftw_plan>>(omp_get_max_threads());
 
             for (int i = 0; i < omp_get_max_threads(); i++) {
                 plan_forward_z_[i] = fftw_plan_dft_1d(grid_.size(2), (fftw_complex*)fftw_buffer_z_[i], 
@@ -631,6 +930,10 @@ class FFT3D
 
                 plan_backward_xy_[i] = fftw_plan_dft_2d(grid_.size(1), grid_.size(0), (fftw_complex*)fftw_buffer_xy_[i], 
                                                         (fftw_complex*)fftw_buffer_xy_[i], FFTW_BACKWARD, FFTW_ESTIMATE);
+
+                plan_forward_x_[i] = plan_many_x(fftw_buffer_xy_[i], FFTW_FORWARD);
+
+                plan_backward_x_[i] = plan_many_x(fftw_buffer_xy_[i], FFTW_BACKWARD);
             }
             
             #ifdef __GPU
@@ -661,6 +964,8 @@ class FFT3D
                 fftw_destroy_plan(plan_forward_xy_[i]);
                 fftw_destroy_plan(plan_backward_z_[i]);
                 fftw_destroy_plan(plan_backward_xy_[i]);
+                fftw_destroy_plan(plan_forward_x_[i]);
+                fftw_destroy_plan(plan_backward_x_[i]);
             }
             #ifdef __GPU
             if (pu_ == GPU) {
@@ -800,6 +1105,9 @@ class FFT3D
                     z_col_pos_(i, 1) = x + y * grid_.size(0);
                 }
             }
+            if (pu_ == CPU) {
+                prepare_pruned_xy();
+            }
             t1.stop();
 
             #ifdef __GPU
@@ -882,6 +1190,7 @@ class FFT3D
                 map_gvec_to_fft_buffer_x0y0_.deallocate_on_device();
             }
             #endif
+            destroy_pruned_xy();
             gvec_partition_ = nullptr;
         }
         
@@ -929,6 +1238,68 @@ class FFT3D
             }
         }
         
+        /// Transform a batch of functions.
+        /** PW coefficients of the functions are stored in data__ with the leading dimension ld__. The real-space
+         *  values are stored in (or taken from) the batch buffer returned by buffer_batch(). All functions of the
+         *  batch share one all-to-all exchange of the z-sticks in each direction, which reduces the number of
+         *  messages and the latency of the parallel FFT by a factor of num_fft__.
+         *
+         *  In case of the reduced G-vector set the functions are real and are transformed in pairs; the number of
+         *  functions must be even and the i-th real-space buffer holds \f$ \psi_{2i} + i \psi_{2i+1} \f$.
+         *
+         *  Only the CPU execution is implemented. */
+        template <int direction>
+        void transform_batch(int num_fft__, double_complex* data__, int ld__)
+        {
+            PROFILE("sddk::FFT3D::transform_batch");
+
+            if (!gvec_partition_) {
+                TERMINATE("FFT3D is not ready");
+            }
+            if (pu_ != CPU) {
+                TERMINATE("batched FFT is implemented only for CPU");
+            }
+            if (gvec_partition_->reduced() && num_fft__ % 2) {
+                TERMINATE("even number of functions is required for the reduced set of G-vectors");
+            }
+
+            allocate_batch(num_fft__);
+
+            switch (direction) {
+                case 1: {
+                    transform_z_batch<direction>(num_fft__, data__, ld__);
+                    transform_xy_batch<direction>(num_fft__);
+                    break;
+                }
+                case -1: {
+                    transform_xy_batch<direction>(num_fft__);
+                    transform_z_batch<direction>(num_fft__, data__, ld__);
+                    break;
+                }
+                default: {
+                    TERMINATE("wrong direction");
+                }
+            }
+        }
+
+        /// Switch on or off the single precision exchange of the z-sticks.
+        inline void a2a_single_precision(bool a2a_single_precision__)
+        {
+            a2a_single_precision_ = a2a_single_precision__;
+        }
+
+        /// True if the z-sticks are exchanged in single precision.
+        inline bool a2a_single_precision() const
+        {
+            return a2a_single_precision_;
+        }
+
+        /// Real-space buffers of the batched transformation.
+        inline mdarray<double_complex, 2>& buffer_batch()
+        {
+            return fft_buffer_batch_;
+        }
+
         /// Transform two real functions.
         template <int direction, device_t data_ptr_type = CPU>
         void transform(double_complex* data1__, double_complex* data2__)
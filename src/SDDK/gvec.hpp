@@ -912,6 +912,93 @@ struct remap_gvec_to_shells
     }
 };
 
+/// Send rows of data given for an arbitrary list of G-vectors to the ranks which own these G-vectors.
+/** On input each rank holds a list of G-vectors (integer coordinates) and a matrix whose rows are the data of these
+ *  G-vectors. On output each rank holds the rows of its own G-vectors stored in the order of the local G-vector
+ *  index. This is used to restore data which was written with a different distribution of G-vectors (for example
+ *  on a different number of MPI ranks). The total number of G-vectors must be the same.
+ *
+ *  \param [in]  gvec  Distribution of G-vectors.
+ *  \param [in]  gv    Integer coordinates of the input G-vectors; dimensions: (3, n).
+ *  \param [in]  in    Input data; dimensions: (n, m).
+ *  \param [out] out   Output data; dimensions: (gvec.count(), m).
+ */
+template <typename T>
+inline void redistribute_by_gvec(Gvec const& gvec__, mdarray<int, 2> const& gv__, mdarray<T, 2> const& in__,
+                                 mdarray<T, 2>& out__)
+{
+    PROFILE("sddk::redistribute_by_gvec");
+
+    auto& comm = gvec__.comm();
+
+    int n = static_cast<int>(gv__.size(1));
+    int m = static_cast<int>(in__.size(1));
+
+    std::vector<int> gvec_offsets(comm.size());
+    for (int r = 0; r < comm.size(); r++) {
+        gvec_offsets[r] = gvec__.gvec_offset(r);
+    }
+
+    /* find the global index and the owner of each G-vector */
+    block_data_descriptor sd(comm.size());
+    std::vector<int> idx(n);
+    std::vector<int> dest(n);
+    for (int i = 0; i < n; i++) {
+        vector3d<int> G(&gv__(0, i));
+        idx[i] = gvec__.index_by_gvec(G);
+        if (idx[i] < 0) {
+            std::stringstream s;
+            s << "G-vector (" << G[0] << ", " << G[1] << ", " << G[2] << ") is not found";
+            TERMINATE(s);
+        }
+        dest[i] = static_cast<int>(std::upper_bound(gvec_offsets.begin(), gvec_offsets.end(), idx[i]) -
+                                   gvec_offsets.begin()) - 1;
+        sd.counts[dest[i]]++;
+    }
+    sd.calc_offsets();
+
+    /* pack global indices and rows of data by destination rank */
+    std::vector<int> send_idx(n);
+    std::vector<T> send_val(n * m);
+    std::vector<int> pos(sd.offsets);
+    for (int i = 0; i < n; i++) {
+        int j = pos[dest[i]]++;
+        send_idx[j] = idx[i];
+        for (int c = 0; c < m; c++) {
+            send_val[j * m + c] = in__(i, c);
+        }
+    }
+
+    block_data_descriptor rd(comm.size());
+    comm.alltoall(sd.counts.data(), 1, rd.counts.data(), 1);
+    rd.calc_offsets();
+    if (rd.offsets.back() + rd.counts.back() != gvec__.count()) {
+        TERMINATE("wrong number of received G-vectors");
+    }
+
+    std::vector<int> recv_idx(gvec__.count());
+    comm.alltoall(send_idx.data(), sd.counts.data(), sd.offsets.data(), recv_idx.data(), rd.counts.data(),
+                  rd.offsets.data());
+
+    /* rows of data are sent as blocks of m elements */
+    for (int r = 0; r < comm.size(); r++) {
+        sd.counts[r] *= m;
+        sd.offsets[r] *= m;
+        rd.counts[r] *= m;
+        rd.offsets[r] *= m;
+    }
+    std::vector<T> recv_val(gvec__.count() * m);
+    comm.alltoall(send_val.data(), sd.counts.data(), sd.offsets.data(), recv_val.data(), rd.counts.data(),
+                  rd.offsets.data());
+
+    for (int i = 0; i < gvec__.count(); i++) {
+        int igloc = recv_idx[i] - gvec__.offset();
+        for (int c = 0; c < m; c++) {
+            out__(igloc, c) = recv_val[i * m + c];
+        }
+    }
+}
+
 } // namespace sddk
 
 #endif //__GVEC_HPP__
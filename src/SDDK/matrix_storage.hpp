@@ -68,6 +68,88 @@ class matrix_storage<T, matrix_storage_t::slab>
     /// Column distribution in auxiliary matrix.
     splindex<block> spl_num_col_;
 
+    /// State of the pipelined remap.
+    struct remap_pipeline_t
+    {
+        block_data_descriptor const* row_distr{nullptr};
+        device_t pu{CPU};
+        int n{0};
+        int idx0{0};
+        /// Number of local columns of the extra storage in a sub-batch.
+        int batch_size{0};
+        int num_batches{0};
+        /// Send and receive dimensions of each sub-batch.
+        std::vector<std::array<block_data_descriptor, 2>> dims;
+        std::vector<MPI_Request> req;
+    };
+
+    /// State of the pipelined remap from prime to extra storage.
+    remap_pipeline_t pipe_fwd_;
+
+    /// State of the pipelined remap from extra to prime storage.
+    remap_pipeline_t pipe_bwd_;
+
+    /// Number of local columns of a given rank in the sub-batch of the pipelined remap.
+    inline int remap_batch_size(remap_pipeline_t const& pipe__, int ib__, int rank__) const
+    {
+        return std::max(0, std::min(pipe__.batch_size, spl_num_col_.local_size(rank__) - ib__ * pipe__.batch_size));
+    }
+
+    inline void remap_pipeline_begin(remap_pipeline_t&            pipe__,
+                                     device_t                     pu__,
+                                     block_data_descriptor const& row_distr__,
+                                     int                          n__,
+                                     int                          idx0__,
+                                     int                          batch_size__)
+    {
+        pipe__.row_distr  = &row_distr__;
+        pipe__.pu         = pu__;
+        pipe__.n          = n__;
+        pipe__.idx0       = idx0__;
+        pipe__.batch_size = std::max(1, batch_size__);
+        /* maximum local number of columns defines the number of sub-batches on all ranks */
+        int ncol_max = splindex_base<int>::block_size(n__, comm_col_.size());
+        pipe__.num_batches = (ncol_max + pipe__.batch_size - 1) / pipe__.batch_size;
+        pipe__.req = std::vector<MPI_Request>(pipe__.num_batches, MPI_REQUEST_NULL);
+        pipe__.dims.resize(pipe__.num_batches);
+    }
+
+    /// Start the non-blocking exchange of the sub-batch.
+    /** Columns of the prime storage are sent and received in place. Columns of the extra storage are packed in the
+     *  send-receive buffer, each sub-batch in its own region, so that several exchanges can be in flight. */
+    inline void remap_post(int ib__, bool forward__)
+    {
+        auto& pipe = (forward__) ? pipe_fwd_ : pipe_bwd_;
+        auto& row_distr = *pipe.row_distr;
+        int rank = comm_col_.rank();
+        int i0 = ib__ * pipe.batch_size;
+        int n_loc = remap_batch_size(pipe, ib__, rank);
+
+        /* dimensions of the prime (0) and extra (1) side of the exchange */
+        auto& d = pipe.dims[ib__];
+        for (int k: {0, 1}) {
+            d[k] = block_data_descriptor(comm_col_.size());
+        }
+        for (int j = 0; j < comm_col_.size(); j++) {
+            int nj = remap_batch_size(pipe, ib__, j);
+            d[0].counts[j]  = nj * row_distr.counts[rank];
+            d[0].offsets[j] = (nj) ? (spl_num_col_.global_offset(j) + i0) * num_rows_loc_ : 0;
+            d[1].counts[j]  = n_loc * row_distr.counts[j];
+            d[1].offsets[j] = n_loc * row_distr.offsets[j];
+        }
+
+        T* prime_ptr = (num_rows_loc_ == 0) ? nullptr : prime_.template at<CPU>(0, pipe.idx0);
+        T* buf = send_recv_buf_.template at<CPU>() + i0 * extra_.size(0);
+
+        if (forward__) {
+            comm_col_.ialltoall(prime_ptr, d[0].counts.data(), d[0].offsets.data(), buf, d[1].counts.data(),
+                                d[1].offsets.data(), &pipe.req[ib__]);
+        } else {
+            comm_col_.ialltoall(buf, d[1].counts.data(), d[1].offsets.data(), prime_ptr, d[0].counts.data(),
+                                d[0].offsets.data(), &pipe.req[ib__]);
+        }
+    }
+
   public:
     /// Constructor.
     matrix_storage(int num_rows_loc__, int num_cols__, Communicator const& comm_col__)
@@ -275,6 +357,140 @@ class matrix_storage<T, matrix_storage_t::slab>
         }
     }
 
+    /// Start the pipelined remap from prime to extra storage.
+    /** \param [in] pu         Target processing unit.
+     *  \param [in] row_distr  Distribution of rows of prime matrix in the extra matrix storage.
+     *  \param [in] n          Number of matrix columns to distribute.
+     *  \param [in] idx0       Starting column of the matrix.
+     *  \param [in] batch_size Number of local columns of the extra storage in a sub-batch.
+     *  \return Number of sub-batches.
+     *
+     *  The local columns of the extra storage are split into sub-batches which are exchanged with the non-blocking
+     *  all-to-all. The exchange of the first two sub-batches is started here; the exchange of the next sub-batch
+     *  is started when the current one is received in remap_forward_wait(). The number of sub-batches is the same
+     *  on all ranks of the column communicator. */
+    inline int remap_forward_begin(device_t                     pu__,
+                                   block_data_descriptor const& row_distr__,
+                                   int                          n__,
+                                   int                          idx0__,
+                                   int                          batch_size__)
+    {
+        PROFILE("sddk::matrix_storage::remap_forward_begin");
+
+        set_num_extra(pu__, row_distr__.counts.back() + row_distr__.offsets.back(), n__, idx0__);
+
+        auto& pipe = pipe_fwd_;
+        remap_pipeline_begin(pipe, pu__, row_distr__, n__, idx0__, batch_size__);
+
+        if (is_remapped()) {
+            for (int ib = 0; ib < std::min(2, pipe.num_batches); ib++) {
+                remap_post(ib, true);
+            }
+        }
+        return pipe.num_batches;
+    }
+
+    /// Wait for the sub-batch of the pipelined forward remap and unpack it to the extra storage.
+    inline void remap_forward_wait(int ib__)
+    {
+        PROFILE("sddk::matrix_storage::remap_forward_wait");
+
+        if (!is_remapped()) {
+            return;
+        }
+
+        auto& pipe = pipe_fwd_;
+        MPI_Wait(&pipe.req[ib__], MPI_STATUS_IGNORE);
+
+        /* start exchange of the next sub-batch */
+        if (ib__ + 2 < pipe.num_batches) {
+            remap_post(ib__ + 2, true);
+        }
+
+        auto& row_distr = *pipe.row_distr;
+        int i0 = ib__ * pipe.batch_size;
+        int n_loc = remap_batch_size(pipe, ib__, comm_col_.rank());
+        T* buf = send_recv_buf_.template at<CPU>() + i0 * extra_.size(0);
+
+        /* reorder recieved blocks */
+        #pragma omp parallel for
+        for (int i = 0; i < n_loc; i++) {
+            for (int j = 0; j < comm_col_.size(); j++) {
+                int offset = row_distr.offsets[j];
+                int count  = row_distr.counts[j];
+                if (count) {
+                    std::memcpy(&extra_(offset, i0 + i), &buf[offset * n_loc + count * i], count * sizeof(T));
+                }
+            }
+        }
+        /*  copy extra storage to the device if needed */
+        if (pipe.pu == GPU && n_loc) {
+            extra_.template copy<memory_t::host, memory_t::device>(i0 * extra_.size(0), n_loc * extra_.size(0));
+        }
+    }
+
+    /// Prepare the pipelined remap from extra to prime storage.
+    /** The arguments have the same meaning as in remap_forward_begin(). The extra storage must be already set. */
+    inline int remap_backward_begin(device_t                     pu__,
+                                    block_data_descriptor const& row_distr__,
+                                    int                          n__,
+                                    int                          idx0__,
+                                    int                          batch_size__)
+    {
+        assert(n__ == spl_num_col_.global_index_size());
+
+        remap_pipeline_begin(pipe_bwd_, pu__, row_distr__, n__, idx0__, batch_size__);
+        return pipe_bwd_.num_batches;
+    }
+
+    /// Start sending the sub-batch of the extra storage back to the prime storage.
+    inline void remap_backward_post(int ib__)
+    {
+        PROFILE("sddk::matrix_storage::remap_backward_post");
+
+        if (!is_remapped()) {
+            return;
+        }
+
+        auto& pipe = pipe_bwd_;
+        auto& row_distr = *pipe.row_distr;
+        int i0 = ib__ * pipe.batch_size;
+        int n_loc = remap_batch_size(pipe, ib__, comm_col_.rank());
+        T* buf = send_recv_buf_.template at<CPU>() + i0 * extra_.size(0);
+
+        /* reorder sending blocks */
+        #pragma omp parallel for
+        for (int i = 0; i < n_loc; i++) {
+            for (int j = 0; j < comm_col_.size(); j++) {
+                int offset = row_distr.offsets[j];
+                int count  = row_distr.counts[j];
+                if (count) {
+                    std::memcpy(&buf[offset * n_loc + count * i], &extra_(offset, i0 + i), count * sizeof(T));
+                }
+            }
+        }
+
+        remap_post(ib__, false);
+    }
+
+    /// Wait for all sub-batches of the pipelined backward remap.
+    inline void remap_backward_wait()
+    {
+        PROFILE("sddk::matrix_storage::remap_backward_wait");
+
+        if (!is_remapped()) {
+            return;
+        }
+
+        auto& pipe = pipe_bwd_;
+        MPI_Waitall(pipe.num_batches, pipe.req.data(), MPI_STATUSES_IGNORE);
+
+        /* move data back to device */
+        if (pipe.pu == GPU && prime_.on_device()) {
+            prime_.template copy<memory_t::host, memory_t::device>(pipe.idx0 * num_rows_loc(), pipe.n * num_rows_loc());
+        }
+    }
+
     inline void remap_from(dmatrix<T> const& mtrx__, int irow0__)
     {
         PROFILE("sddk::matrix_storage::remap_from");
@@ -36,6 +36,13 @@
 #include <initializer_list>
 #include <type_traits>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <omp.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 #ifdef __GPU
 #include "GPU/cuda.hpp"
 #endif
@@ -181,19 +188,243 @@ class mdarray_index_descriptor
     }
 };
 
+/// Counters of the host memory allocated by mdarray.
 struct mdarray_mem_count
 {
+    /// Memory currently held by the arrays.
     static std::atomic<int64_t>& allocated()
     {
         static std::atomic<int64_t> allocated_{0};
         return allocated_;
     }
 
+    /// High watermark of the memory held by the arrays.
     static std::atomic<int64_t>& allocated_max()
     {
         static std::atomic<int64_t> allocated_max_{0};
         return allocated_max_;
     }
+
+    /// Memory kept in the free lists of the pool.
+    static std::atomic<int64_t>& pool_cached()
+    {
+        static std::atomic<int64_t> pool_cached_{0};
+        return pool_cached_;
+    }
+
+    /// Number of allocations served from the free lists of the pool.
+    static std::atomic<int64_t>& pool_hits()
+    {
+        static std::atomic<int64_t> pool_hits_{0};
+        return pool_hits_;
+    }
+
+    /// Number of allocations which went to the system allocator.
+    static std::atomic<int64_t>& pool_misses()
+    {
+        static std::atomic<int64_t> pool_misses_{0};
+        return pool_misses_;
+    }
+};
+
+/// Pool of aligned host memory blocks.
+/** All host allocations of mdarray go through this class. Small blocks are aligned to the cache line (64 bytes),
+ *  blocks of 2 Mb and larger are aligned to the 2 Mb page boundary, so that they can be backed by transparent huge
+ *  pages. Released blocks are kept in free lists of size classes (four classes per power of two) and reused by the
+ *  following allocations of the same class. Behaviour is controlled by the environment variables:
+ *    - SDDK_MEM_POOL=1 : keep released blocks in the pool (default: 0)
+ *    - SDDK_MEM_POOL_LIMIT=<Mb> : maximum amount of memory cached in the free lists (default: 2048)
+ *    - SDDK_HUGE_PAGES=1 : advise the kernel to use transparent huge pages for large blocks (default: 0)
+ *    - SDDK_FIRST_TOUCH=1 : touch pages of new large blocks by all OpenMP threads (default: 0)
+ */
+class mdarray_mem_pool
+{
+  private:
+    /// Alignment of small blocks.
+    static const size_t small_align_{64};
+
+    /// Alignment (and size of the huge page) for large blocks.
+    static const size_t large_align_{1 << 21};
+
+    /// Page size used by the first-touch initialisation.
+    static const size_t page_size_{4096};
+
+    bool enabled_{false};
+
+    bool huge_pages_{false};
+
+    bool first_touch_{false};
+
+    /// Maximum amount of memory in the free lists.
+    int64_t limit_{int64_t(2048) << 20};
+
+    /// Free blocks for each size class.
+    std::map<size_t, std::vector<void*>> free_blocks_;
+
+    std::mutex mutex_;
+
+    mdarray_mem_pool()
+    {
+        auto get_env = [](const char* name__, int64_t default__)
+        {
+            const char* str = std::getenv(name__);
+            return (str == NULL) ? default__ : static_cast<int64_t>(std::atoll(str));
+        };
+        enabled_     = get_env("SDDK_MEM_POOL", 0) != 0;
+        huge_pages_  = get_env("SDDK_HUGE_PAGES", 0) != 0;
+        first_touch_ = get_env("SDDK_FIRST_TOUCH", 0) != 0;
+        limit_       = get_env("SDDK_MEM_POOL_LIMIT", 2048) << 20;
+    }
+
+    /// Round the requested size up to the size class.
+    static size_t size_class(size_t size__)
+    {
+        if (size__ <= small_align_) {
+            return small_align_;
+        }
+        /* highest power of two which is smaller than the size */
+        size_t p{small_align_};
+        while (2 * p < size__) {
+            p *= 2;
+        }
+        /* four classes in the interval (p, 2p] */
+        size_t step = p / 4;
+        return ((size__ + step - 1) / step) * step;
+    }
+
+    static size_t alignment(size_t size__)
+    {
+        if (size__ >= large_align_) {
+            return large_align_;
+        }
+        return small_align_;
+    }
+
+    /// Get a new block from the system.
+    void* allocate_new(size_t size__)
+    {
+        void* ptr{nullptr};
+        if (posix_memalign(&ptr, alignment(size__), size__)) {
+            printf("error at line %i of file %s: failed to allocate %li bytes\n", __LINE__, __FILE__, size__);
+            raise(SIGTERM);
+            exit(-13);
+        }
+        mdarray_mem_count::pool_misses()++;
+        #if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (huge_pages_ && size__ >= large_align_) {
+            madvise(ptr, size__, MADV_HUGEPAGE);
+        }
+        #endif
+        /* let each thread fault in its own part of the pages; with the static schedule this matches the
+           distribution of the work in the following OpenMP loops over the array */
+        if (first_touch_ && size__ >= large_align_ && !omp_in_parallel()) {
+            char* p = static_cast<char*>(ptr);
+            int64_t npages = size__ / page_size_;
+            #pragma omp parallel for schedule(static)
+            for (int64_t i = 0; i < npages; i++) {
+                p[i * page_size_] = 0;
+            }
+        }
+        return ptr;
+    }
+
+  public:
+    /// Return the global instance of the pool.
+    /** The pool is never destroyed, so it outlives the static arrays. */
+    static mdarray_mem_pool& instance()
+    {
+        static mdarray_mem_pool* pool_ = new mdarray_mem_pool();
+        return *pool_;
+    }
+
+    /// Allocate a block of memory.
+    void* allocate(size_t size__)
+    {
+        size_t sz = size_class(size__);
+        if (enabled_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = free_blocks_.find(sz);
+            if (it != free_blocks_.end() && !it->second.empty()) {
+                void* ptr = it->second.back();
+                it->second.pop_back();
+                mdarray_mem_count::pool_cached() -= sz;
+                mdarray_mem_count::pool_hits()++;
+                return ptr;
+            }
+        }
+        return allocate_new(sz);
+    }
+
+    /// Return a block of memory to the pool.
+    void deallocate(void* ptr__, size_t size__)
+    {
+        if (ptr__ == nullptr) {
+            return;
+        }
+        size_t sz = size_class(size__);
+        if (enabled_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (mdarray_mem_count::pool_cached().load() + static_cast<int64_t>(sz) <= limit_) {
+                free_blocks_[sz].push_back(ptr__);
+                mdarray_mem_count::pool_cached() += sz;
+                return;
+            }
+        }
+        free(ptr__);
+    }
+
+    /// Release all cached blocks to the system.
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& e: free_blocks_) {
+            for (auto ptr: e.second) {
+                free(ptr);
+            }
+            mdarray_mem_count::pool_cached() -= e.first * e.second.size();
+        }
+        free_blocks_.clear();
+    }
+
+    /// Enable or disable caching of the released blocks.
+    void enabled(bool enabled__)
+    {
+        enabled_ = enabled__;
+        if (!enabled_) {
+            release();
+        }
+    }
+
+    bool enabled() const
+    {
+        return enabled_;
+    }
+
+    void huge_pages(bool huge_pages__)
+    {
+        huge_pages_ = huge_pages__;
+    }
+
+    void first_touch(bool first_touch__)
+    {
+        first_touch_ = first_touch__;
+    }
+
+    /// Set the maximum amount of cached memory in bytes.
+    void limit(int64_t limit__)
+    {
+        limit_ = limit__;
+    }
+
+    /// Print the memory statistics.
+    void print_stat() const
+    {
+        printf("mdarray memory: allocated: %li Mb, high watermark: %li Mb\n",
+               mdarray_mem_count::allocated().load() >> 20, mdarray_mem_count::allocated_max().load() >> 20);
+        printf("memory pool   : enabled: %i, cached: %li Mb, hits: %li, misses: %li\n", enabled_,
+               mdarray_mem_count::pool_cached().load() >> 20, mdarray_mem_count::pool_hits().load(),
+               mdarray_mem_count::pool_misses().load());
+    }
 };
 
 /// Simple memory manager handler which keeps track of allocated and deallocated memory.
@@ -242,7 +473,7 @@ struct mdarray_mem_mgr
                 acc::deallocate_host(p__);
                 #endif
             } else {
-                free(p__);
+                mdarray_mem_pool::instance().deallocate(p__, size_ * sizeof(T));
             }
         }
 
@@ -463,7 +694,7 @@ class mdarray_base
                 unique_ptr_ = std::unique_ptr<T[], mdarray_mem_mgr<T>>(raw_ptr_, mdarray_mem_mgr<T>(sz, memory_t::host_pinned));
                 #endif
             } else { /* regular mameory */
-                raw_ptr_    = static_cast<T*>(malloc(sz * sizeof(T)));
+                raw_ptr_    = static_cast<T*>(mdarray_mem_pool::instance().allocate(sz * sizeof(T)));
                 unique_ptr_ = std::unique_ptr<T[], mdarray_mem_mgr<T>>(raw_ptr_, mdarray_mem_mgr<T>(sz, memory_t::host));
             }
 
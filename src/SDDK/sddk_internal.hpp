@@ -15,62 +15,397 @@
 #include <memory>
 #include <complex>
 #include <algorithm>
+#include <set>
+#include <mutex>
+#include <fstream>
 #include "communicator.hpp"
+#include "trace.hpp"
 
 namespace sddk {
 
+/// Statistics of a timer collected on a single MPI rank.
 struct timer_stats_t
 {
     double min_val{1e10};
     double max_val{0};
     double tot_val{0};
     double avg_val{0};
+    /// Time spent in the timer itself and not in the nested timers.
+    double self_val{0};
     int count{0};
 };
 
-using time_point_t = std::chrono::high_resolution_clock::time_point;
+/// Statistics of a timer reduced over MPI ranks.
+/** Minimum, average and maximum values are taken over the total time measured by each rank. */
+struct timer_rank_stats_t
+{
+    double min_val{0};
+    double avg_val{0};
+    double max_val{0};
+    /// Average over ranks of the self time.
+    double self_val{0};
+    /// Maximum number of calls over ranks.
+    int count{0};
+};
+
+/// Node of the timer call tree.
+struct timer_node_t
+{
+    /// Interned id of the timer label; root node has id -1.
+    int id{-1};
+    /// Index of the parent node.
+    int parent{-1};
+    int count{0};
+    double tot_val{0};
+    double min_val{1e10};
+    double max_val{0};
+    /// Indices of the child nodes.
+    std::vector<int> children;
+};
+
+/// Get the index of a child node with a given timer id; create the node if it doesn't exist.
+inline int timer_tree_child(std::vector<timer_node_t>& tree__, int parent__, int id__)
+{
+    for (int c: tree__[parent__].children) {
+        if (tree__[c].id == id__) {
+            return c;
+        }
+    }
+    int n = static_cast<int>(tree__.size());
+    tree__.push_back(timer_node_t());
+    tree__[n].id     = id__;
+    tree__[n].parent = parent__;
+    tree__[parent__].children.push_back(n);
+    return n;
+}
+
+/// Call tree and stack of running timers of a single thread.
+/** The data is modified only by the owning thread, so no locking is required when timers are started and stopped.
+ *  Trees of all threads are merged when the statistics is collected. */
+struct timer_thread_data_t
+{
+    /// Call tree; element 0 is the root.
+    std::vector<timer_node_t> nodes;
+    /// Indices of the nodes of running timers.
+    std::vector<int> stack;
+
+    timer_thread_data_t()
+        : nodes(1)
+    {
+    }
+};
 
 const std::string main_timer_label = "+global_timer";
 
+/// Hierarchical thread-safe timer.
+/** Timer labels are interned into integer ids. Each thread keeps its own stack of running timers and its own call
+ *  tree, so timers can be used inside OpenMP parallel regions. Timers started by the worker threads of a parallel
+ *  region are attached to the place in the call tree where the master thread has started the same timer.
+ *
+ *  Functions collecting the statistics must be called outside of parallel regions. */
 class timer
 {
   private:
 
-    std::string label_;
+    /// Interned id of the label.
+    int id_;
+
+    /// Index of the node in the call tree of the thread.
+    int node_{-1};
+
+    /// Data of the thread which started the timer.
+    timer_thread_data_t* data_{nullptr};
+
     time_point_t starting_time_;
+
     bool active_{false};
 
-    static std::vector<std::string>& stack()
+    static std::mutex& mutex()
     {
-        static std::vector<std::string> stack_;
-        return stack_;
+        static std::mutex mutex_;
+        return mutex_;
     }
 
-    static std::map<std::string, std::map<std::string, double>>& timer_values_ex()
+    /// Data of all threads that have ever started a timer.
+    static std::vector<std::unique_ptr<timer_thread_data_t>>& threads()
     {
-        static std::map<std::string, std::map<std::string, double>> timer_values_ex_;
-        return timer_values_ex_;
+        static std::vector<std::unique_ptr<timer_thread_data_t>> threads_;
+        return threads_;
     }
 
-  public:
+    static timer_thread_data_t& thread_data()
+    {
+        static thread_local timer_thread_data_t* ptr{nullptr};
+        if (!ptr) {
+            std::lock_guard<std::mutex> lock(mutex());
+            threads().push_back(std::unique_ptr<timer_thread_data_t>(new timer_thread_data_t()));
+            ptr = threads().back().get();
+        }
+        return *ptr;
+    }
 
-    timer(std::string label__)
-        : label_(label__)
+    void start()
     {
+        data_      = &thread_data();
+        int parent = data_->stack.empty() ? 0 : data_->stack.back();
+        node_      = timer_tree_child(data_->nodes, parent, id_);
+        data_->stack.push_back(node_);
+        active_        = true;
         starting_time_ = std::chrono::high_resolution_clock::now();
-        stack().push_back(label_);
-        active_ = true;
     }
 
+    static void merge_node(std::vector<timer_node_t>& tree__, int dst__, std::vector<timer_node_t> const& src__,
+                           int s__)
+    {
+        auto& d   = tree__[dst__];
+        auto& s   = src__[s__];
+        d.count   += s.count;
+        d.tot_val += s.tot_val;
+        d.min_val = std::min(d.min_val, s.min_val);
+        d.max_val = std::max(d.max_val, s.max_val);
+        for (int c: s.children) {
+            merge_node(tree__, timer_tree_child(tree__, dst__, src__[c].id), src__, c);
+        }
+    }
+
+    /// Merge call trees of all threads.
+    static std::vector<timer_node_t> merged_tree()
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+
+        std::vector<timer_node_t> tree(1);
+        for (size_t t = 0; t < threads().size(); t++) {
+            auto& src = threads()[t]->nodes;
+            for (int c: src[0].children) {
+                if (t) {
+                    /* timers, started by the worker threads of a parallel region, have no parent on the stack of
+                     * the thread; attach them to the node of the same timer started by another thread */
+                    int dst{-1};
+                    int n{0};
+                    for (int i = 1; i < static_cast<int>(tree.size()); i++) {
+                        if (tree[i].id == src[c].id) {
+                            dst = i;
+                            n++;
+                        }
+                    }
+                    if (n == 1) {
+                        merge_node(tree, dst, src, c);
+                        continue;
+                    }
+                }
+                merge_node(tree, timer_tree_child(tree, 0, src[c].id), src, c);
+            }
+        }
+        return tree;
+    }
+
+    /// Get the self time of the node.
+    static double self_time(std::vector<timer_node_t> const& tree__, int i__)
+    {
+        double te{0};
+        for (int c: tree__[i__].children) {
+            te += tree__[c].tot_val;
+        }
+        /* children started in a parallel region can accumulate more time than the parent */
+        return std::max(0.0, tree__[i__].tot_val - te);
+    }
+
+    /// Collect labels of all ranks and reduce the statistics.
+    static std::map<std::string, timer_rank_stats_t> reduce_timer_stats(std::map<std::string, timer_stats_t> const& stats__,
+                                                                        Communicator const& comm__)
+    {
+        std::vector<char> buf;
+        for (auto& e: stats__) {
+            buf.insert(buf.end(), e.first.begin(), e.first.end());
+            buf.push_back(0);
+        }
+        std::vector<int> counts(comm__.size());
+        std::vector<int> offsets(comm__.size(), 0);
+        counts[comm__.rank()] = static_cast<int>(buf.size());
+        comm__.allgather(counts.data(), comm__.rank(), 1);
+        for (int i = 1; i < comm__.size(); i++) {
+            offsets[i] = offsets[i - 1] + counts[i - 1];
+        }
+        std::vector<char> buf_all(offsets.back() + counts.back() + 1);
+        comm__.allgather(buf.data(), static_cast<int>(buf.size()), buf_all.data(), counts.data(), offsets.data());
+
+        std::set<std::string> keys;
+        for (int pos = 0; pos < offsets.back() + counts.back(); pos++) {
+            std::string s(&buf_all[pos]);
+            pos += static_cast<int>(s.size());
+            keys.insert(s);
+        }
+
+        int n = static_cast<int>(keys.size());
+        std::vector<double> vmin(n, 0);
+        std::vector<double> vmax(n, 0);
+        std::vector<double> vsum(n, 0);
+        std::vector<double> vself(n, 0);
+        std::vector<int> vcount(n, 0);
+
+        int i{0};
+        for (auto& key: keys) {
+            auto it = stats__.find(key);
+            if (it != stats__.end()) {
+                vmin[i] = vmax[i] = vsum[i] = it->second.tot_val;
+                vself[i]  = it->second.self_val;
+                vcount[i] = it->second.count;
+            }
+            i++;
+        }
+        comm__.allreduce<double, mpi_op_t::min>(vmin);
+        comm__.allreduce<double, mpi_op_t::max>(vmax);
+        comm__.allreduce<double, mpi_op_t::sum>(vsum);
+        comm__.allreduce<double, mpi_op_t::sum>(vself);
+        comm__.allreduce<int, mpi_op_t::max>(vcount);
+
+        std::map<std::string, timer_rank_stats_t> result;
+        i = 0;
+        for (auto& key: keys) {
+            auto& ts    = result[key];
+            ts.min_val  = vmin[i];
+            ts.max_val  = vmax[i];
+            ts.avg_val  = vsum[i] / comm__.size();
+            ts.self_val = vself[i] / comm__.size();
+            ts.count    = vcount[i];
+            i++;
+        }
+        return result;
+    }
+
+    /// Node of the call tree with the statistics reduced over MPI ranks.
+    struct tree_entry_t
+    {
+        std::string label;
+        timer_rank_stats_t stats;
+        std::vector<int> children;
+    };
+
+    /// Statistics of this rank in the form of the reduced statistics.
+    /** Minimum and maximum values are taken over the individual calls. */
+    static std::map<std::string, timer_rank_stats_t> local_timer_stats(std::map<std::string, timer_stats_t> const& stats__)
+    {
+        std::map<std::string, timer_rank_stats_t> result;
+        for (auto& e: stats__) {
+            auto& ts    = result[e.first];
+            ts.min_val  = e.second.count ? e.second.min_val : 0;
+            ts.avg_val  = e.second.tot_val;
+            ts.max_val  = e.second.max_val;
+            ts.self_val = e.second.self_val;
+            ts.count    = e.second.count;
+        }
+        return result;
+    }
+
+    /// Restore the call tree from the paths of the nodes.
+    static std::vector<tree_entry_t> build_tree(std::map<std::string, timer_rank_stats_t> const& paths)
+    {
+        std::vector<tree_entry_t> tree(1);
+        std::map<std::string, int> idx;
+        idx[""] = 0;
+        /* parent path is a prefix of the child path and thus goes first in the sorted map */
+        for (auto& e: paths) {
+            auto pos = e.first.rfind('\t');
+            std::string parent = (pos == std::string::npos) ? std::string("") : e.first.substr(0, pos);
+            std::string label = (pos == std::string::npos) ? e.first : e.first.substr(pos + 1);
+            int p = idx.count(parent) ? idx[parent] : 0;
+            int n = static_cast<int>(tree.size());
+            tree.push_back(tree_entry_t());
+            tree[n].label = label;
+            tree[n].stats = e.second;
+            tree[p].children.push_back(n);
+            idx[e.first] = n;
+        }
+        for (auto& e: tree) {
+            std::sort(e.children.begin(), e.children.end(), [&tree](int i1, int i2) {
+                return tree[i1].stats.avg_val > tree[i2].stats.avg_val;
+            });
+        }
+        return tree;
+    }
+
+    /// Call tree with the timer values reduced over the ranks of the communicator.
+    static std::vector<tree_entry_t> reduced_tree(Communicator const& comm__)
+    {
+        return build_tree(reduce_timer_stats(collect_tree_stats(), comm__));
+    }
+
+    static void print_tree_node(std::vector<tree_entry_t> const& tree__, int i__, int level__, double ttot__)
+    {
+        auto& ts = tree__[i__].stats;
+        if (ts.avg_val < 0.01 * ttot__) {
+            return;
+        }
+        for (int l = 0; l < level__; l++) {
+            printf("   ");
+        }
+        printf("%s%s (%10.4fs, min: %10.4fs, max: %10.4fs, %.2f %% self, %.2f %% of total)\n",
+               level__ ? "|--" : "", tree__[i__].label.c_str(), ts.avg_val, ts.min_val, ts.max_val,
+               ts.avg_val > 0 ? ts.self_val / ts.avg_val * 100 : 0, ts.avg_val / ttot__ * 100);
+        for (int c: tree__[i__].children) {
+            print_tree_node(tree__, c, level__ + 1, ttot__);
+        }
+    }
+
+    static void write_json_node(std::ostream& out__, std::vector<tree_entry_t> const& tree__, int i__, int level__)
+    {
+        std::string indent(4 * level__, ' ');
+        auto& ts = tree__[i__].stats;
+        std::string label;
+        for (char c: tree__[i__].label) {
+            if (c == '"' || c == '\\') {
+                label.push_back('\\');
+            }
+            label.push_back(c);
+        }
+        out__ << indent << "{\"label\": \"" << label << "\", \"count\": " << ts.count << ", \"avg\": " << ts.avg_val
+              << ", \"min\": " << ts.min_val << ", \"max\": " << ts.max_val << ", \"self\": " << ts.self_val
+              << ", \"children\": [";
+        auto& ch = tree__[i__].children;
+        for (size_t j = 0; j < ch.size(); j++) {
+            out__ << (j ? ",\n" : "\n");
+            write_json_node(out__, tree__, ch[j], level__ + 1);
+        }
+        if (ch.size()) {
+            out__ << "\n" << indent;
+        }
+        out__ << "]}";
+    }
+
+  public:
+
+    timer(std::string const& label__)
+        : id_(id(label__))
+    {
+        start();
+    }
+
+    /// Start the timer with the already interned label id.
+    explicit timer(int id__)
+        : id_(id__)
+    {
+        start();
+    }
+
+    timer(timer const& src__) = delete;
+
+    timer& operator=(timer const& src__) = delete;
+
     ~timer()
     {
         stop();
     }
 
-    static std::map<std::string, timer_stats_t>& timer_values()
+    /// Get the interned id of the label.
+    static int id(std::string const& label__)
+    {
+        return timer_labels::id(label__);
+    }
+
+    /// Get the label by its interned id.
+    static std::string label(int id__)
     {
-        static std::map<std::string, timer_stats_t> timer_values_;
-        return timer_values_;
+        return timer_labels::label(id__);
     }
 
     double stop()
@@ -79,123 +414,245 @@ class timer
             return 0;
         }
 
-        stack().pop_back();
-
         auto t2    = std::chrono::high_resolution_clock::now();
         auto tdiff = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - starting_time_);
         double val = tdiff.count();
 
-        auto& ts = timer_values()[label_];
+        auto& ts = data_->nodes[node_];
         ts.min_val = std::min(ts.min_val, val);
         ts.max_val = std::max(ts.max_val, val);
         ts.tot_val += val;
         ts.count++;
 
-        if (stack().size() != 0) {
-            auto parent_label = stack().back();
-            if (timer_values_ex().count(parent_label) == 0) {
-                timer_values_ex()[parent_label] = std::map<std::string, double>();
-            }
-            if (timer_values_ex()[parent_label].count(label_) == 0) {
-                timer_values_ex()[parent_label][label_] = 0;
+        trace::add(id_, starting_time_, t2);
+
+        /* timers are not necessarily stopped in the reverse order (e.g. timers started from the Fortran API) */
+        auto& s = data_->stack;
+        if (s.size() && s.back() == node_) {
+            s.pop_back();
+        } else {
+            auto it = std::find(s.rbegin(), s.rend(), node_);
+            if (it != s.rend()) {
+                s.erase(std::next(it).base());
             }
-            timer_values_ex()[parent_label][label_] += val;
         }
         active_ = false;
         return val;
     }
 
-    static void print()
+    /// Collect the statistics of this rank for each timer label.
+    /** Nested calls of the same timer are counted once. */
+    static std::map<std::string, timer_stats_t> collect_timer_stats()
     {
-        if (mpi_comm_world().rank()) {
-            return;
+        auto tree = merged_tree();
+
+        std::map<std::string, timer_stats_t> result;
+        for (int i = 1; i < static_cast<int>(tree.size()); i++) {
+            if (!tree[i].count) {
+                continue;
+            }
+            /* check if the same timer is running higher in the tree */
+            bool nested{false};
+            for (int p = tree[i].parent; p > 0; p = tree[p].parent) {
+                if (tree[p].id == tree[i].id) {
+                    nested = true;
+                }
+            }
+            auto& ts = result[label(tree[i].id)];
+            ts.self_val += self_time(tree, i);
+            if (!nested) {
+                ts.min_val = std::min(ts.min_val, tree[i].min_val);
+                ts.max_val = std::max(ts.max_val, tree[i].max_val);
+                ts.tot_val += tree[i].tot_val;
+                ts.count += tree[i].count;
+            }
+        }
+        for (auto& e: result) {
+            e.second.avg_val = e.second.tot_val / std::max(1, e.second.count);
         }
+        return result;
+    }
+
+    /// Collect the statistics of this rank for each node of the call tree.
+    /** The key is a path of the node: labels of the timers from the root are separated by a tab character. */
+    static std::map<std::string, timer_stats_t> collect_tree_stats()
+    {
+        auto tree = merged_tree();
+
+        std::vector<std::string> path(tree.size());
+        std::map<std::string, timer_stats_t> result;
+        /* parent always goes before the child */
+        for (int i = 1; i < static_cast<int>(tree.size()); i++) {
+            int p   = tree[i].parent;
+            path[i] = (p ? path[p] + "\t" : std::string("")) + label(tree[i].id);
+
+            auto& ts   = result[path[i]];
+            ts.min_val = tree[i].min_val;
+            ts.max_val = tree[i].max_val;
+            ts.tot_val = tree[i].tot_val;
+            ts.count   = tree[i].count;
+            ts.avg_val = tree[i].tot_val / std::max(1, tree[i].count);
+            ts.self_val = self_time(tree, i);
+        }
+        return result;
+    }
+
+    static std::map<std::string, timer_stats_t> timer_values()
+    {
+        return collect_timer_stats();
+    }
+
+  private:
+
+    static void print_stats(std::map<std::string, timer_rank_stats_t> const& stats__, int num_ranks__)
+    {
         for (int i = 0; i < 140; i++) {
             printf("-");
         }
         printf("\n");
-        printf("name                                                                 count      total        min        max    average    self (%%)\n");
+        if (num_ranks__ > 1) {
+            printf("timer values are taken over %i MPI ranks: total time per rank is averaged, min and max are taken over ranks\n",
+                   num_ranks__);
+        } else {
+            printf("timer values of a single rank: min and max are taken over individual calls\n");
+        }
+        printf("name                                                                 count      total        min        max   per call    self (%%)\n");
         for (int i = 0; i < 140; i++) {
             printf("-");
         }
         printf("\n");
-        for (auto& it: timer_values()) {
-
-            double te{0};
-            if (timer_values_ex().count(it.first)) {
-                for (auto& it2: timer_values_ex()[it.first]) {
-                    te += it2.second;
-                }
-            }
-            if (it.second.tot_val > 0.01) {
-                printf("%-65s : %6i %10.4f %10.4f %10.4f %10.4f     %6.2f\n", it.first.c_str(),
-                                                                              it.second.count,
-                                                                              it.second.tot_val,
-                                                                              it.second.min_val,
-                                                                              it.second.max_val,
-                                                                              it.second.tot_val / it.second.count,
-                                                                              (it.second.tot_val - te) / it.second.tot_val * 100);
+        for (auto& it: stats__) {
+            auto& ts = it.second;
+            if (ts.avg_val > 0.01) {
+                printf("%-65s : %6i %10.4f %10.4f %10.4f %10.4f     %6.2f\n", it.first.c_str(), ts.count, ts.avg_val,
+                       ts.min_val, ts.max_val, ts.avg_val / std::max(1, ts.count), ts.self_val / ts.avg_val * 100);
             }
-            //if (timer_values_ex().count(it.first)) {
-            //    for (auto& it2: timer_values_ex()[it.first]) {
-            //        printf("|-%s (%6.2f %%) \n", it2.first.c_str(), (it2.second / it.second.tot_val) * 100);
-            //    }
-            //}
-
-            //for (int i = 0; i < 140; i++) {
-            //    printf("-");
-            //}
-            //printf("\n");
         }
     }
 
-    static void print_tree()
+    static void print_call_tree(std::vector<tree_entry_t> const& tree__)
     {
-        if (!timer_values().count(main_timer_label)) {
-            return;
+        double ttot{0};
+        for (int c: tree__[0].children) {
+            ttot += tree__[c].stats.avg_val;
         }
-        if (mpi_comm_world().rank()) {
+        if (ttot <= 0) {
             return;
         }
         for (int i = 0; i < 140; i++) {
             printf("-");
         }
         printf("\n");
+        for (int c: tree__[0].children) {
+            print_tree_node(tree__, c, 0, ttot);
+        }
+    }
 
-        double ttot = timer_values()[main_timer_label].tot_val;
+  public:
 
-        for (auto& it: timer_values()) {
-            if (timer_values_ex().count(it.first)) {
-                /* collect external times */
-                double te{0};
-                for (auto& it2: timer_values_ex()[it.first]) {
-                    te += it2.second;
-                }
-                double f = it.second.tot_val / ttot;
-                if (f > 0.01) {
-                    printf("%s (%10.4fs, %.2f %% of self, %.2f %% of total)\n",
-                           it.first.c_str(), it.second.tot_val, (it.second.tot_val - te) / it.second.tot_val * 100, f * 100);
-                
-                    std::vector<std::pair<double, std::string>> tmp;
-            
-                    for (auto& it2: timer_values_ex()[it.first]) {
-                        tmp.push_back(std::pair<double, std::string>(it2.second / it.second.tot_val, it2.first));
-                    }
-                    std::sort(tmp.rbegin(), tmp.rend());
-                    for (auto& e: tmp) {
-                        printf("|--%s (%10.4fs, %.2f %%) \n", e.second.c_str(), timer_values_ex()[it.first][e.second], e.first * 100);
-                    }
-                }
-            }
+    /// Print the timer statistics of this rank.
+    /** This is a local operation; only the rank 0 of the global communicator prints. */
+    static void print()
+    {
+        if (mpi_comm_world().rank()) {
+            return;
         }
+        print_stats(local_timer_stats(collect_timer_stats()), 1);
     }
 
-    static std::map<std::string, timer_stats_t>& collect_timer_stats()
+    /// Print the timer statistics reduced over the ranks of the communicator.
+    /** This is a collective operation; the rank 0 of the communicator prints. */
+    static void print_reduced(Communicator const& comm__)
     {
-        for (auto& it: timer_values()) {
-            it.second.avg_val = it.second.tot_val / it.second.count;
+        auto stats = reduce_timer_stats(collect_timer_stats(), comm__);
+
+        if (comm__.rank()) {
+            return;
+        }
+        print_stats(stats, comm__.size());
+    }
+
+    /// Print the call tree of this rank.
+    /** This is a local operation; only the rank 0 of the global communicator prints. */
+    static void print_tree()
+    {
+        if (mpi_comm_world().rank()) {
+            return;
+        }
+        print_call_tree(build_tree(local_timer_stats(collect_tree_stats())));
+    }
+
+    /// Print the call tree with the timer values reduced over the ranks of the communicator.
+    /** This is a collective operation; the rank 0 of the communicator prints. */
+    static void print_tree_reduced(Communicator const& comm__)
+    {
+        auto tree = reduced_tree(comm__);
+
+        if (comm__.rank()) {
+            return;
+        }
+        print_call_tree(tree);
+    }
+
+    /// Write the call tree with the timer values reduced over the ranks of the communicator to a JSON file.
+    /** This is a collective operation; the file is written by the rank 0. */
+    static void write_json_tree(std::string const& fname__, Communicator const& comm__ = mpi_comm_world())
+    {
+        auto tree = reduced_tree(comm__);
+
+        if (comm__.rank()) {
+            return;
+        }
+        std::ofstream out(fname__, std::ofstream::out | std::ofstream::trunc);
+        out << "{\n    \"num_ranks\": " << comm__.size() << ",\n    \"num_threads\": " << omp_get_max_threads()
+            << ",\n    \"call_tree\": [";
+        for (size_t j = 0; j < tree[0].children.size(); j++) {
+            out << (j ? ",\n" : "\n");
+            write_json_node(out, tree, tree[0].children[j], 2);
+        }
+        out << "\n    ]\n}\n";
+    }
+
+    /// Write the recorded timeline of all ranks of the communicator in the Chrome trace-event format.
+    /** This is a collective operation; the file is written by the rank 0. Nothing is done if the recording is
+     *  switched off (see sddk::trace). Timelines of the ranks are aligned at the barrier preceding the output. */
+    static void write_trace(std::string const& fname__, Communicator const& comm__ = mpi_comm_world())
+    {
+        if (!trace::enabled()) {
+            return;
+        }
+        comm__.barrier();
+        auto t_ref = std::chrono::high_resolution_clock::now();
+
+        /* shift all ranks such that the earliest event starts at zero */
+        double span = std::chrono::duration_cast<std::chrono::duration<double>>(t_ref - trace::first_event_time(t_ref)).count();
+        comm__.allreduce<double, mpi_op_t::max>(&span, 1);
+        auto t0 = t_ref - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+                              std::chrono::duration<double>(span));
+
+        auto s = trace::serialize(comm__.rank(), t0);
+
+        std::vector<int> counts(comm__.size());
+        std::vector<int> offsets(comm__.size(), 0);
+        counts[comm__.rank()] = static_cast<int>(s.size());
+        comm__.allgather(counts.data(), comm__.rank(), 1);
+        for (int i = 1; i < comm__.size(); i++) {
+            offsets[i] = offsets[i - 1] + counts[i - 1];
+        }
+        std::vector<char> buf(comm__.rank() == 0 ? offsets.back() + counts.back() : 1);
+        comm__.gather(s.data(), buf.data(), counts.data(), offsets.data(), 0);
+
+        if (comm__.rank() == 0) {
+            std::ofstream out(fname__, std::ofstream::out | std::ofstream::trunc);
+            out << "{\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n";
+            for (int i = 0; i < comm__.size(); i++) {
+                if (i) {
+                    out << ",\n";
+                }
+                out.write(&buf[offsets[i]], counts[i]);
+            }
+            out << "\n]}\n";
         }
-        return timer_values();
     }
 };
 
@@ -479,19 +936,21 @@ class Profiler
 {
   private:
     /// Label of the profiler.
-    std::string label_;
+    char const* label_;
 
     /// Name of the function in which the profiler is created.
-    std::string function_name_;
+    char const* function_name_;
 
     /// Name of the file.
-    std::string file_;
+    char const* file_;
 
     /// Line number.
     int line_;
 
+    #if defined(__PROFILE_TIME)
     /// Profiler's timer.
-    std::unique_ptr<timer> timer_;
+    timer timer_;
+    #endif
 
 // std::string timestamp()
 //{
@@ -509,25 +968,23 @@ class Profiler
     #ifdef __PROFILE_STACK
     static std::vector<std::string>& call_stack()
     {
-        static std::vector<std::string> call_stack_;
+        static thread_local std::vector<std::string> call_stack_;
         return call_stack_;
     }
     #endif
 
   public:
-    Profiler(char const* function_name__, char const* file__, int line__, char const* label__)
-        : label_(std::string(label__))
-        , function_name_(std::string(function_name__))
-        , file_(std::string(file__))
+    /// Constructor.
+    /** Label of the timer is interned once by the PROFILE macro and the id is passed here. */
+    Profiler(char const* function_name__, char const* file__, int line__, char const* label__, int id__)
+        : label_(label__)
+        , function_name_(function_name__)
+        , file_(file__)
         , line_(line__)
-
+        #if defined(__PROFILE_TIME)
+        , timer_(id__)
+        #endif
     {
-        if (omp_get_num_threads() != 1) {
-            std::stringstream s;
-            s << "sddk::Profiler does not support threads";
-            throw std::runtime_error(s.str());
-        }
-
         #if defined(__PROFILE_STACK) || defined(__PROFILE_FUNC)
         char str[2048];
         snprintf(str, 2048, "%s at %s:%i", function_name__, file__, line__);
@@ -545,15 +1002,11 @@ class Profiler
         for (int i = 0; i < tab; i++) {
             printf(" ");
         }
-        printf("[rank%04i] + %s\n", mpi_comm_world().rank(), label_.c_str());
-        #endif
-
-        #if defined(__PROFILE_TIME)
-        timer_ = std::unique_ptr<timer>(new timer(label_));
+        printf("[rank%04i] + %s\n", mpi_comm_world().rank(), label_);
         #endif
 
         #if defined(__GPU) && defined(__GPU_NVTX)
-        acc::begin_range_marker(label_.c_str());
+        acc::begin_range_marker(label_);
         #endif
     }
 
@@ -567,7 +1020,7 @@ class Profiler
         for (int i = 0; i < tab; i++) {
             printf(" ");
         }
-        printf("[rank%04i] - %s\n", mpi_comm_world().rank(), label_.c_str());
+        printf("[rank%04i] - %s\n", mpi_comm_world().rank(), label_);
         #endif
 
         #ifdef __PROFILE_STACK
@@ -601,7 +1054,9 @@ class Profiler
 #endif
 
 #ifdef __PROFILE
-    #define PROFILE(name) sddk::Profiler profiler__(__function_name__, __FILE__, __LINE__, name);
+    #define PROFILE(name)                                                                                 \
+        static const int profiler_id__ = sddk::timer::id(name);                                           \
+        sddk::Profiler profiler__(__function_name__, __FILE__, __LINE__, name, profiler_id__);
 #else
     #define PROFILE(...)
 #endif
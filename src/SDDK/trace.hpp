@@ -0,0 +1,269 @@
+// Copyright (c) 2013-2016 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file trace.hpp
+ *
+ *  \brief Interned timer labels and recording of the timeline of timers and MPI collectives.
+ */
+
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+
+namespace sddk {
+
+using time_point_t = std::chrono::high_resolution_clock::time_point;
+
+/// Interned labels of timers and traced regions.
+class timer_labels
+{
+  private:
+    static std::mutex& mutex()
+    {
+        static std::mutex mutex_;
+        return mutex_;
+    }
+
+    static std::vector<std::string>& labels()
+    {
+        static std::vector<std::string> labels_;
+        return labels_;
+    }
+
+    static std::map<std::string, int>& label_ids()
+    {
+        static std::map<std::string, int> label_ids_;
+        return label_ids_;
+    }
+
+  public:
+    /// Get the interned id of the label.
+    /** Lookup is first done in the thread-local cache, so the global lock is taken only once per thread and label. */
+    static int id(std::string const& label__)
+    {
+        static thread_local std::map<std::string, int> cache;
+        auto it = cache.find(label__);
+        if (it != cache.end()) {
+            return it->second;
+        }
+        int i;
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            auto it1 = label_ids().find(label__);
+            if (it1 == label_ids().end()) {
+                i = static_cast<int>(labels().size());
+                labels().push_back(label__);
+                label_ids()[label__] = i;
+            } else {
+                i = it1->second;
+            }
+        }
+        cache[label__] = i;
+        return i;
+    }
+
+    /// Get the label by its interned id.
+    static std::string label(int id__)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        return labels()[id__];
+    }
+};
+
+/// Single event of the timeline.
+struct trace_event_t
+{
+    /// Interned id of the label.
+    int id;
+    time_point_t start;
+    time_point_t end;
+    /// Number of bytes sent by the MPI collective or -1 for the regular timer.
+    long long bytes;
+};
+
+/// Ring buffer of the events of a single thread.
+struct trace_buffer_t
+{
+    /// Index of the thread in the order of the first recorded event.
+    int thread_id;
+    std::vector<trace_event_t> events;
+    /// Total number of recorded events; only the last events.size() of them are kept.
+    long long num_events{0};
+};
+
+/// Recording of the timeline.
+/** Recording is switched on by the SDDK_TRACE environment variable which sets the capacity of the per-thread ring
+ *  buffer (the number of last events that are kept). Each thread writes only to its own buffer. At the end of the run
+ *  the events are written in the Chrome trace-event format (see timer::write_trace()), which can be loaded in
+ *  chrome://tracing or https://ui.perfetto.dev. Each MPI rank is shown as a separate process. */
+class trace
+{
+  private:
+    static std::mutex& mutex()
+    {
+        static std::mutex mutex_;
+        return mutex_;
+    }
+
+    static std::vector<std::unique_ptr<trace_buffer_t>>& buffers()
+    {
+        static std::vector<std::unique_ptr<trace_buffer_t>> buffers_;
+        return buffers_;
+    }
+
+    static trace_buffer_t& buffer()
+    {
+        static thread_local trace_buffer_t* ptr{nullptr};
+        if (!ptr) {
+            std::lock_guard<std::mutex> lock(mutex());
+            buffers().push_back(std::unique_ptr<trace_buffer_t>(new trace_buffer_t()));
+            ptr            = buffers().back().get();
+            ptr->thread_id = static_cast<int>(buffers().size()) - 1;
+            ptr->events.resize(capacity());
+        }
+        return *ptr;
+    }
+
+  public:
+    /// Capacity of the per-thread ring buffer; zero if recording is switched off.
+    static int capacity()
+    {
+        static const int capacity_ = []()
+        {
+            const char* str = std::getenv("SDDK_TRACE");
+            return (str == NULL) ? 0 : std::max(0, std::atoi(str));
+        }();
+        return capacity_;
+    }
+
+    static bool enabled()
+    {
+        return capacity() > 0;
+    }
+
+    /// Record an event.
+    static void add(int id__, time_point_t start__, time_point_t end__, long long bytes__ = -1)
+    {
+        if (!enabled()) {
+            return;
+        }
+        auto& b = buffer();
+        b.events[b.num_events % capacity()] = {id__, start__, end__, bytes__};
+        b.num_events++;
+    }
+
+    /// Earliest recorded event of this process.
+    /** Must be called outside of parallel regions. */
+    static time_point_t first_event_time(time_point_t t__)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        for (auto& b: buffers()) {
+            int n = static_cast<int>(std::min(b->num_events, static_cast<long long>(b->events.size())));
+            for (int i = 0; i < n; i++) {
+                t__ = std::min(t__, b->events[i].start);
+            }
+        }
+        return t__;
+    }
+
+    /// Serialize the events of this process into the list of Chrome trace-event objects.
+    /** Time stamps are given in microseconds relative to the reference time t0__. Must be called outside of
+     *  parallel regions. */
+    static std::string serialize(int pid__, time_point_t t0__)
+    {
+        auto us = [&t0__](time_point_t t)
+        {
+            return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(t - t0__).count();
+        };
+
+        std::lock_guard<std::mutex> lock(mutex());
+        std::stringstream s;
+        s.precision(3);
+        s << std::fixed;
+        s << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid__ << ", \"args\": {\"name\": \"rank "
+          << pid__ << "\"}},\n";
+        s << "{\"name\": \"process_sort_index\", \"ph\": \"M\", \"pid\": " << pid__ << ", \"args\": {\"sort_index\": "
+          << pid__ << "}}";
+        for (auto& b: buffers()) {
+            long long n  = std::min(b->num_events, static_cast<long long>(b->events.size()));
+            long long i0 = b->num_events - n;
+            if (i0) {
+                s << ",\n{\"name\": \"lost events\", \"ph\": \"i\", \"s\": \"t\", \"pid\": " << pid__
+                  << ", \"tid\": " << b->thread_id << ", \"ts\": " << us(b->events[i0 % b->events.size()].start)
+                  << ", \"args\": {\"count\": " << i0 << "}}";
+            }
+            for (long long i = i0; i < b->num_events; i++) {
+                auto& e = b->events[i % b->events.size()];
+                std::string label;
+                for (char c: timer_labels::label(e.id)) {
+                    if (c == '"' || c == '\\') {
+                        label.push_back('\\');
+                    }
+                    label.push_back(c);
+                }
+                s << ",\n{\"name\": \"" << label << "\", \"ph\": \"X\", \"pid\": " << pid__ << ", \"tid\": "
+                  << b->thread_id << ", \"ts\": " << us(e.start) << ", \"dur\": " << us(e.end) - us(e.start);
+                if (e.bytes >= 0) {
+                    s << ", \"cat\": \"mpi\", \"args\": {\"bytes\": " << e.bytes << "}";
+                }
+                s << "}";
+            }
+        }
+        return s.str();
+    }
+};
+
+/// Record the interval of a scope as a timeline event.
+class trace_region
+{
+  private:
+    int id_;
+    long long bytes_;
+    time_point_t start_;
+
+  public:
+    trace_region(int id__, long long bytes__)
+        : id_(id__)
+        , bytes_(bytes__)
+    {
+        if (trace::enabled()) {
+            start_ = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    ~trace_region()
+    {
+        if (trace::enabled()) {
+            trace::add(id_, start_, std::chrono::high_resolution_clock::now(), bytes_);
+        }
+    }
+};
+
+} // namespace sddk
+
+#endif // __TRACE_HPP__
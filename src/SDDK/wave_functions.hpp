@@ -26,6 +26,7 @@
 #define __WAVE_FUNCTIONS_HPP__
 
 #include <cstdlib>
+#include <map>
 #include "linalg.hpp"
 
 namespace sddk {
@@ -188,6 +189,18 @@ class wave_functions
         {
             return offset_mt_coeffs_[ialoc__];
         }
+
+        /// Total number of muffin-tin coefficients.
+        inline int num_mt_coeffs() const
+        {
+            return num_mt_coeffs_;
+        }
+
+        /// Distribution of muffin-tin coefficients between MPI ranks.
+        inline block_data_descriptor const& mt_coeffs_distr() const
+        {
+            return mt_coeffs_distr_;
+        }
         
         /// Copy values from another wave-function.
         /** \param [in] src Input wave-function.
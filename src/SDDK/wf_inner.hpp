@@ -1,3 +1,109 @@
+/// Depth of the pipeline of non-blocking reductions in inner() (set by SDDK_INNER_DEPTH, default 3).
+inline int inner_pipeline_depth()
+{
+    const char* str = std::getenv("SDDK_INNER_DEPTH");
+    int depth = (str == NULL) ? 3 : std::atoi(str);
+    return std::max(depth, 2);
+}
+
+/// Online selection of the block size for the pipelined reduction in inner().
+/** The first calls of inner() which are large enough to be split in at least four panels are executed with
+ *  different candidate block sizes. The cost of each call (time per element of the local gemm) is reduced with
+ *  the maximum over the communicator, so all ranks see the same numbers and take the same decision. After all
+ *  candidates are tried the cheapest one is used for the rest of the run. The state is kept separately for each
+ *  communicator. Setting SDDK_BLOCK_SIZE switches off the calibration. */
+class inner_block_size_tuner
+{
+  private:
+    /// Candidate block sizes.
+    std::vector<int> candidates_{128, 256, 512};
+
+    /// Number of calibration calls per candidate.
+    static const int num_calls_{2};
+
+    struct tuner_state_t
+    {
+        /// Index of the currently calibrated candidate.
+        int idx{0};
+        /// Number of finished calibration calls of the current candidate.
+        int ncalls{0};
+        /// Best cost of each candidate.
+        std::vector<double> cost;
+        /// Selected block size or 0 if the calibration is not finished.
+        int block_size{0};
+    };
+
+    std::map<MPI_Comm, tuner_state_t> state_;
+
+    int fixed_block_size_{0};
+
+    inner_block_size_tuner()
+    {
+        const char* str = std::getenv("SDDK_BLOCK_SIZE");
+        if (str != NULL) {
+            fixed_block_size_ = std::atoi(str);
+        }
+    }
+
+    static int num_panels(int m__, int n__, int bs__)
+    {
+        return (m__ / bs__ + std::min(1, m__ % bs__)) * (n__ / bs__ + std::min(1, n__ % bs__));
+    }
+
+  public:
+    static inner_block_size_tuner& instance()
+    {
+        static inner_block_size_tuner tuner;
+        return tuner;
+    }
+
+    /// Return the block size for the next call of inner().
+    /** If this call is a calibration call, the index of the calibrated candidate is returned in idx__, otherwise
+     *  idx__ is set to -1. */
+    int block_size(Communicator const& comm__, int m__, int n__, int& idx__)
+    {
+        idx__ = -1;
+        if (fixed_block_size_ > 0) {
+            return fixed_block_size_;
+        }
+        auto& st = state_[comm__.mpi_comm()];
+        if (st.block_size) {
+            return st.block_size;
+        }
+        if (st.cost.empty()) {
+            st.cost = std::vector<double>(candidates_.size(), std::numeric_limits<double>::max());
+        }
+        int bs = candidates_[st.idx];
+        /* too few panels to measure the overlap of computation and communication */
+        if (num_panels(m__, n__, bs) < 4) {
+            return sddk_default_block_size;
+        }
+        idx__ = st.idx;
+        return bs;
+    }
+
+    /// Record the cost of the calibration call.
+    void update(Communicator const& comm__, int idx__, double cost__)
+    {
+        auto& st = state_[comm__.mpi_comm()];
+        /* all ranks must take the same decision */
+        comm__.allreduce<double, mpi_op_t::max>(&cost__, 1);
+        st.cost[idx__] = std::min(st.cost[idx__], cost__);
+        if (++st.ncalls == num_calls_) {
+            st.ncalls = 0;
+            st.idx++;
+        }
+        if (st.idx == static_cast<int>(candidates_.size())) {
+            int i = static_cast<int>(std::min_element(st.cost.begin(), st.cost.end()) - st.cost.begin());
+            st.block_size = candidates_[i];
+            const char* pp = std::getenv("SDDK_PRINT_PERFORMANCE");
+            if (pp != NULL && std::atoi(pp) && comm__.rank() == 0) {
+                printf("inner() block size: %i\n", st.block_size);
+            }
+        }
+    }
+};
+
 /// Inner product between wave-functions.
 /** The result is always returned in the CPU pointer. In case of a single MPI rank the result is also returned in the
  *  GPU pointer */
@@ -29,9 +135,6 @@ inline void inner(wave_functions& bra__,
     const char* sddk_pp_raw = std::getenv("SDDK_PRINT_PERFORMANCE");
     int sddk_pp = (sddk_pp_raw == NULL) ? 0 : std::atoi(sddk_pp_raw);
 
-    const char* sddk_bs_raw = std::getenv("SDDK_BLOCK_SIZE");
-    int sddk_block_size = (sddk_bs_raw == NULL) ? sddk_default_block_size : std::atoi(sddk_bs_raw);
-
     double ngop{0};
     if (std::is_same<T, double>::value) {
         ngop = 2e-9;
@@ -166,9 +269,22 @@ inline void inner(wave_functions& bra__,
         return;
     }
     
-    const int BS = sddk_block_size;
+    /* panels are computed in the temporary buffers; beta__ is applied when they are added to the result */
+    beta = 0;
+
+    int calib_idx{-1};
+    const int BS = inner_block_size_tuner::instance().block_size(comm, m__, n__, calib_idx);
+    double calib_time = -omp_get_wtime();
 
-    mdarray<T, 2> c_tmp(BS * BS, 2, memory_t::host_pinned, "inner::c_tmp");
+    /* number of panels which are reduced at the same time */
+    int depth = inner_pipeline_depth();
+    #ifdef __GPU
+    if (pu == GPU) {
+        depth = std::min(depth, acc::num_streams());
+    }
+    #endif
+
+    mdarray<T, 2> c_tmp(BS * BS, depth, memory_t::host_pinned, "inner::c_tmp");
     if (pu == GPU) {
         c_tmp.allocate(memory_t::device);
     }
@@ -176,148 +292,113 @@ inline void inner(wave_functions& bra__,
     int nbr = m__ / BS + std::min(1, m__ % BS);
     int nbc = n__ / BS + std::min(1, n__ % BS);
 
-    std::array<MPI_Request, 2> req = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
-    std::array<std::array<int, 4>, 2> dims;
-
-    if (pu == GPU) {
+    /* state of the buffers:
+     * state = 0: buffer is free
+     * state = 1: buffer stores the result of local gemm which is not yet reduced
+     * state = 2: reduction of the buffer is posted */
+    std::vector<int> buf_state(depth, 0);
+    std::vector<MPI_Request> req(depth, MPI_REQUEST_NULL);
+    std::vector<std::array<int, 4>> dims(depth);
+
+    /* post the non-blocking reduction of the panel */
+    auto post_panel = [&](int s)
+    {
         #ifdef __GPU
-        /* state of the buffers:
-         * state = 0: buffer is free
-         * state = 1: buffer stores result of local zgemm */
-        int buf_state[] = {0, 0};
-         
-        omp_set_nested(1);
-        int nt = omp_get_max_threads();
-        if (nt < 2) {
-            TERMINATE("minimum two threads are required");
+        if (pu == GPU) {
+            /* wait for gemm and copyout of the panel */
+            acc::sync_stream(s);
         }
+        #endif
+        comm.iallreduce(c_tmp.template at<CPU>(0, s), dims[s][2] * dims[s][3], &req[s]);
+        buf_state[s] = 2;
+    };
 
-        #pragma omp parallel num_threads(2) shared(buf_state)
-        {
-            if (omp_get_thread_num() == 0) {
-                omp_set_num_threads(nt - 1);
-            }
+    /* wait for the reduction of the panel and add it to the result */
+    auto store_panel = [&](int s)
+    {
+        MPI_Wait(&req[s], MPI_STATUS_IGNORE);
 
-            int s{0};
-            for (int ibc = 0; ibc < nbc; ibc++) {
-                int j0 = ibc * BS;
-                int ncol = std::min(n__, (ibc + 1) * BS) - j0;
-
-                for (int ibr = 0; ibr < nbr; ibr++) {
-                    int i0 = ibr * BS;
-                    int nrow = std::min(m__, (ibr + 1) * BS) - i0;
-
-                    /* this thread will call cudaZgemm */
-                    if (omp_get_thread_num() == 1) {
-                        int state{1};
-                        /* wait for the release of the buffer */
-                        while (state) {
-                            #pragma omp atomic read
-                            state = buf_state[s % 2];
-                        }
-
-                        T* buf = (pu == CPU) ? c_tmp.template at<CPU>(0, s % 2) : c_tmp.template at<GPU>(0, s % 2);
-                        local_inner(i0__ + i0, nrow, j0__ + j0, ncol, buf, nrow, s % 2);
-
-                        #ifdef __GPU
-                        if (pu == GPU) {
-                            acc::copyout(c_tmp.template at<CPU>(0, s % 2), c_tmp.template at<GPU>(0, s % 2), nrow * ncol, s % 2);
-                        }
-                        #endif
-
-                        #pragma omp atomic write
-                        /* lock the buffer */
-                        buf_state[s % 2] = 1;
-                    } else { /* this thread will do allreduce and store */
-                        int state{0};
-                        /* wait for the lock of the buffer */
-                        while (!state) {
-                            #pragma omp atomic read
-                            state = buf_state[s % 2];
-                        }
-                        /* wait for the cuda stream */
-                        #ifdef __GPU
-                        if (pu == GPU) {
-                            acc::sync_stream(s % 2);
-                        }
-                        #endif
-                        
-                        comm.allreduce(c_tmp.template at<CPU>(0, s % 2), nrow * ncol);
-
-                        /* store panel */
-                        #pragma omp parallel for
-                        for (int jcol = 0; jcol < ncol; jcol++) {
-                            for (int irow = 0; irow < nrow; irow++) {
-                                result__.add(beta__, irow0__ + irow + i0, jcol0__ + jcol + j0,
-                                             c_tmp(irow + nrow * jcol, s % 2));
-                            }
-                        }
-
-                        #pragma omp atomic write
-                        /* release the buffer */
-                        buf_state[s % 2] = 0;
-                    }
-                    s++;
-                }
+        #pragma omp parallel for
+        for (int jcol = 0; jcol < dims[s][3]; jcol++) {
+            for (int irow = 0; irow < dims[s][2]; irow++) {
+                result__.add(beta__, irow0__ + irow +  dims[s][0], jcol0__ + jcol +  dims[s][1],
+                             c_tmp(irow + dims[s][2] * jcol, s));
             }
         }
-        omp_set_nested(0);
-        omp_set_num_threads(nt);
-        #endif
-    }
-    
-    if (pu == CPU) {
-        auto store_panel = [beta__, &req, &result__, &dims, &c_tmp, irow0__, jcol0__](int s)
-        {
-            MPI_Wait(&req[s % 2], MPI_STATUS_IGNORE);
-
-            #pragma omp parallel for
-            for (int jcol = 0; jcol < dims[s % 2][3]; jcol++) {
-                for (int irow = 0; irow < dims[s % 2][2]; irow++) {
-                    result__.add(beta__, irow0__ + irow +  dims[s % 2][0], jcol0__ + jcol +  dims[s % 2][1],
-                                 c_tmp(irow + dims[s % 2][2] * jcol, s % 2));
-                }
+        buf_state[s] = 0;
+    };
+
+    /* there is no separate communication thread; give MPI a chance to progress the posted reductions */
+    auto progress = [&]()
+    {
+        for (int s = 0; s < depth; s++) {
+            if (buf_state[s] == 2 && req[s] != MPI_REQUEST_NULL) {
+                int flag;
+                MPI_Test(&req[s], &flag, MPI_STATUS_IGNORE);
             }
-        };
+        }
+    };
 
-        int s{0};
-        for (int ibc = 0; ibc < nbc; ibc++) {
-            int j0 = ibc * BS;
-            int ncol = std::min(n__, (ibc + 1) * BS) - j0;
+    int ipanel{0};
+    for (int ibc = 0; ibc < nbc; ibc++) {
+        int j0 = ibc * BS;
+        int ncol = std::min(n__, (ibc + 1) * BS) - j0;
 
-            for (int ibr = 0; ibr < nbr; ibr++) {
-                int i0 = ibr * BS;
-                int nrow = std::min(m__, (ibr + 1) * BS) - i0;
+        for (int ibr = 0; ibr < nbr; ibr++) {
+            int i0 = ibr * BS;
+            int nrow = std::min(m__, (ibr + 1) * BS) - i0;
 
-                if (req[s % 2] != MPI_REQUEST_NULL) {
-                    store_panel(s);
-                }
+            int s = ipanel % depth;
+            if (buf_state[s] == 2) {
+                store_panel(s);
+            }
 
-                dims[s % 2][0] = i0;
-                dims[s % 2][1] = j0;
-                dims[s % 2][2] = nrow;
-                dims[s % 2][3] = ncol;
+            dims[s][0] = i0;
+            dims[s][1] = j0;
+            dims[s][2] = nrow;
+            dims[s][3] = ncol;
 
-                T* buf = (pu == CPU) ? c_tmp.template at<CPU>(0, s % 2) : c_tmp.template at<GPU>(0, s % 2);
-                local_inner(i0__ + i0, nrow, j0__ + j0, ncol, buf, nrow, -1);
+            T* buf = (pu == CPU) ? c_tmp.template at<CPU>(0, s) : c_tmp.template at<GPU>(0, s);
+            local_inner(i0__ + i0, nrow, j0__ + j0, ncol, buf, nrow, (pu == CPU) ? -1 : s);
+            buf_state[s] = 1;
 
-                #ifdef __GPU
-                if (pu == GPU) {
-                    acc::copyout(c_tmp.template at<CPU>(0, s % 2), c_tmp.template at<GPU>(0, s % 2), nrow * ncol);
+            if (pu == CPU) {
+                post_panel(s);
+            }
+            #ifdef __GPU
+            if (pu == GPU) {
+                acc::copyout(c_tmp.template at<CPU>(0, s), c_tmp.template at<GPU>(0, s), nrow * ncol, s);
+                /* GPU is busy with the current panel; post the reduction of the previous one */
+                if (ipanel > 0) {
+                    post_panel((ipanel - 1) % depth);
                 }
-                #endif
-
-                comm.iallreduce(c_tmp.template at<CPU>(0, s % 2), nrow * ncol, &req[s % 2]);
-                
-                s++;
             }
+            #endif
+            progress();
+            ipanel++;
         }
+    }
 
-        for (int s: {0, 1}) {
-            if (req[s % 2] != MPI_REQUEST_NULL) {
-                store_panel(s);
-            }
+    for (int i = 0; i < depth; i++) {
+        int s = (ipanel + i) % depth;
+        if (buf_state[s] == 1) {
+            post_panel(s);
+        }
+    }
+    for (int i = 0; i < depth; i++) {
+        int s = (ipanel + i) % depth;
+        if (buf_state[s] == 2) {
+            store_panel(s);
+        }
+    }
+
+    if (calib_idx >= 0) {
+        calib_time += omp_get_wtime();
+        int k = bra__.pw_coeffs().num_rows_loc();
+        if (bra__.has_mt()) {
+            k += bra__.mt_coeffs().num_rows_loc();
         }
+        inner_block_size_tuner::instance().update(comm, calib_idx, calib_time / m__ / n__ / std::max(k, 1));
     }
 
     if (sddk_pp) {
@@ -1,5 +1,105 @@
 #include "eigenproblem.h"
 
+/// Check if the new block is orthogonalized with a single reduction (set SDDK_ORTHO_FUSED=0 to disable).
+inline bool ortho_fused_enabled()
+{
+    const char* str = std::getenv("SDDK_ORTHO_FUSED");
+    return (str == NULL) ? true : (std::atoi(str) != 0);
+}
+
+/// Compute the overlap of the new block after the projection of the old subspace.
+/** On input o__ contains the result of the fused inner product: rows [0, N) store \f$ C = \langle \phi_{old} | S |
+ *  \phi_{new} \rangle \f$ and rows [N, N + n) store \f$ O = \langle \phi_{new} | S | \phi_{new} \rangle \f$.
+ *  Because the old functions are orthonormal, the overlap of the projected functions
+ *  \f$ |\tilde \phi_{new} \rangle = |\phi_{new} \rangle - |\phi_{old} \rangle C \f$ is
+ *  \f[
+ *    \tilde O = O - C^{H} C
+ *  \f]
+ *  and is computed locally in place of \f$ O \f$. The diagonal of the original overlap is returned; it is used
+ *  to detect the loss of accuracy in the subtraction. */
+template <typename T>
+inline mdarray<double, 1> project_overlap(int N__, int n__, dmatrix<T>& o__)
+{
+    mdarray<double, 1> o_diag(n__);
+    o_diag.zero();
+
+    if (o__.blacs_grid().comm().size() == 1) {
+        for (int i = 0; i < n__; i++) {
+            o_diag(i) = sddk_type_wrapper<T>::real(o__(N__ + i, i));
+        }
+        linalg<CPU>::gemm(2, 0, n__, n__, N__, linalg_const<T>::m_one(), o__.template at<CPU>(0, 0), o__.ld(),
+                          o__.template at<CPU>(0, 0), o__.ld(), linalg_const<T>::one(),
+                          o__.template at<CPU>(N__, 0), o__.ld());
+    } else {
+        for (int i = 0; i < n__; i++) {
+            auto r = o__.spl_row().location(N__ + i);
+            auto c = o__.spl_col().location(i);
+            if (o__.rank_row() == r.rank && o__.rank_col() == c.rank) {
+                o_diag(i) = sddk_type_wrapper<T>::real(o__(r.local_index, c.local_index));
+            }
+        }
+        o__.blacs_grid().comm().allreduce(o_diag.template at<CPU>(), n__);
+        linalg<CPU>::gemm(2, 0, n__, n__, N__, linalg_const<T>::m_one(), o__, 0, 0, o__, 0, 0,
+                          linalg_const<T>::one(), o__, N__, 0);
+    }
+    return std::move(o_diag);
+}
+
+/// Compute the inverse Cholesky factor of the projected overlap matrix.
+/** The projected overlap (rows [N, N + n) of o__) is moved to the upper-left corner, factorized and inverted.
+ *  The result is the upper triangular matrix \f$ R^{-1} \f$ in the n x n corner of o__, exactly as in the case of
+ *  the explicitly computed overlap. The function returns false if the factorization fails or if the diagonal of
+ *  the Cholesky factor shows that the new functions have lost too much of their norm in the projection; in this
+ *  case the subtraction \f$ O - C^{H} C \f$ is not accurate and the overlap must be recomputed. */
+template <typename T>
+inline bool factorize_projected_overlap(int N__, int n__, dmatrix<T>& o__, mdarray<double, 1> const& o_diag__)
+{
+    PROFILE("sddk::wave_functions::orthogonalize|fused");
+
+    /* minimum ratio between the squared norms of the function after and before the projection */
+    double const min_norm_ratio{1e-6};
+
+    mdarray<double, 1> r_diag(n__);
+
+    if (o__.blacs_grid().comm().size() == 1) {
+        for (int j = 0; j < n__; j++) {
+            std::memcpy(o__.template at<CPU>(0, j), o__.template at<CPU>(N__, j), n__ * sizeof(T));
+        }
+        if (linalg<CPU>::potrf(n__, o__.template at<CPU>(), o__.ld())) {
+            return false;
+        }
+        for (int i = 0; i < n__; i++) {
+            r_diag(i) = sddk_type_wrapper<T>::real(o__(i, i));
+        }
+    } else {
+        linalg<CPU>::tranc(n__, n__, o__, N__, 0, o__, 0, 0);
+        if (linalg<CPU>::potrf(n__, o__)) {
+            return false;
+        }
+        auto d = o__.get_diag(n__);
+        for (int i = 0; i < n__; i++) {
+            r_diag(i) = sddk_type_wrapper<T>::real(d(i));
+        }
+    }
+
+    for (int i = 0; i < n__; i++) {
+        if (r_diag(i) * r_diag(i) < min_norm_ratio * o_diag__(i)) {
+            return false;
+        }
+    }
+
+    if (o__.blacs_grid().comm().size() == 1) {
+        if (linalg<CPU>::trtri(n__, o__.template at<CPU>(), o__.ld())) {
+            return false;
+        }
+    } else {
+        if (linalg<CPU>::trtri(n__, o__)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /// Orthogonalize n new wave-functions to the N old wave-functions
 template <typename T>
 inline void orthogonalize(int N__,
@@ -14,15 +114,26 @@ inline void orthogonalize(int N__,
 
     auto pu = wfs__[0]->pu();
         
+    /* true if the inverse Cholesky factor of the new block is already computed */
+    bool factorized{false};
+
     /* project out the old subspace:
      * |\tilda phi_new> = |phi_new> - |phi_old><phi_old|phi_new> */
-    if (N__ > 0) {
+    if (N__ > 0 && N__ >= n__ && ortho_fused_enabled()) {
+        /* compute <phi_old|phi_new> and <phi_new|phi_new> with a single reduction */
+        inner(*wfs__[idx_bra__], 0, N__ + n__, *wfs__[idx_ket__], N__, n__, 0.0, o__, 0, 0);
+        auto o_diag = project_overlap(N__, n__, o__);
+        transform(pu, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
+        factorized = factorize_projected_overlap(N__, n__, o__, o_diag);
+    } else if (N__ > 0) {
         inner(*wfs__[idx_bra__], 0, N__, *wfs__[idx_ket__], N__, n__, 0.0, o__, 0, 0);
         transform(pu, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
     }
 
     /* orthogonalize new n__ x n__ block */
-    inner(*wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, 0.0, o__, 0, 0);
+    if (!factorized) {
+        inner(*wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, 0.0, o__, 0, 0);
+    }
 
     /* single MPI rank */
     if (o__.blacs_grid().comm().size() == 1) {
@@ -33,7 +144,13 @@ inline void orthogonalize(int N__,
         }
         #endif
 
-        if (use_magma) {
+        if (factorized) {
+            if (pu == GPU) {
+                #ifdef __GPU
+                acc::copyin(o__.template at<GPU>(), o__.ld(), o__.template at<CPU>(), o__.ld(), n__, n__);
+                #endif
+            }
+        } else if (use_magma) {
             #ifdef __GPU
             /* Cholesky factorization */
             if (int info = linalg<GPU>::potrf(n__, o__.template at<GPU>(), o__.ld())) {
@@ -138,19 +255,21 @@ inline void orthogonalize(int N__,
         }
         #endif
     } else { /* parallel transformation */
-        sddk::timer t1("sddk::wave_functions::orthogonalize|potrf");
-        if (int info = linalg<CPU>::potrf(n__, o__)) {
-            std::stringstream s;
-            s << "error in factorization, info = " << info;
-            TERMINATE(s);
-        }
-        t1.stop();
+        if (!factorized) {
+            sddk::timer t1("sddk::wave_functions::orthogonalize|potrf");
+            if (int info = linalg<CPU>::potrf(n__, o__)) {
+                std::stringstream s;
+                s << "error in factorization, info = " << info;
+                TERMINATE(s);
+            }
+            t1.stop();
 
-        sddk::timer t2("sddk::wave_functions::orthogonalize|trtri");
-        if (linalg<CPU>::trtri(n__, o__)) {
-            TERMINATE("error in inversion");
+            sddk::timer t2("sddk::wave_functions::orthogonalize|trtri");
+            if (linalg<CPU>::trtri(n__, o__)) {
+                TERMINATE("error in inversion");
+            }
+            t2.stop();
         }
-        t2.stop();
 
         /* o is upper triangular matrix */
         for (int i = 0; i < n__; i++) {
@@ -197,9 +316,18 @@ inline void orthogonalize(device_t                     pu__,
 {
     PROFILE("sddk::wave_functions::orthogonalize");
 
+    /* true if the inverse Cholesky factor of the new block is already computed */
+    bool factorized{false};
+
     /* project out the old subspace:
      * |\tilda phi_new> = |phi_new> - |phi_old><phi_old|phi_new> */
-    if (N__ > 0) {
+    if (N__ > 0 && N__ >= n__ && ortho_fused_enabled()) {
+        /* compute <phi_old|phi_new> and <phi_new|phi_new> with a single reduction */
+        inner(num_sc__, *wfs__[idx_bra__], 0, N__ + n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+        auto o_diag = project_overlap(N__, n__, o__);
+        transform(pu__, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
+        factorized = factorize_projected_overlap(N__, n__, o__, o_diag);
+    } else if (N__ > 0) {
         inner(num_sc__, *wfs__[idx_bra__], 0, N__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
         transform(pu__, -1.0, wfs__, 0, N__, o__, 0, 0, 1.0, wfs__, N__, n__);
     }
@@ -232,7 +360,9 @@ inline void orthogonalize(device_t                     pu__,
     //}
 
     /* orthogonalize new n__ x n__ block */
-    inner(num_sc__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+    if (!factorized) {
+        inner(num_sc__, *wfs__[idx_bra__], N__, n__, *wfs__[idx_ket__], N__, n__, o__, 0, 0);
+    }
 
     /* single MPI rank */
     if (o__.blacs_grid().comm().size() == 1) {
@@ -243,7 +373,13 @@ inline void orthogonalize(device_t                     pu__,
         }
         #endif
 
-        if (use_magma) {
+        if (factorized) {
+            if (pu__ == GPU) {
+                #ifdef __GPU
+                acc::copyin(o__.template at<GPU>(), o__.ld(), o__.template at<CPU>(), o__.ld(), n__, n__);
+                #endif
+            }
+        } else if (use_magma) {
             #ifdef __GPU
             /* Cholesky factorization */
             if (int info = linalg<GPU>::potrf(n__, o__.template at<GPU>(), o__.ld())) {
@@ -353,19 +489,21 @@ inline void orthogonalize(device_t                     pu__,
             #endif
         }
     } else { /* parallel transformation */
-        sddk::timer t1("sddk::wave_functions::orthogonalize|potrf");
-        if (int info = linalg<CPU>::potrf(n__, o__)) {
-            std::stringstream s;
-            s << "error in factorization, info = " << info;
-            TERMINATE(s);
-        }
-        t1.stop();
+        if (!factorized) {
+            sddk::timer t1("sddk::wave_functions::orthogonalize|potrf");
+            if (int info = linalg<CPU>::potrf(n__, o__)) {
+                std::stringstream s;
+                s << "error in factorization, info = " << info;
+                TERMINATE(s);
+            }
+            t1.stop();
 
-        sddk::timer t2("sddk::wave_functions::orthogonalize|trtri");
-        if (linalg<CPU>::trtri(n__, o__)) {
-            TERMINATE("error in inversion");
+            sddk::timer t2("sddk::wave_functions::orthogonalize|trtri");
+            if (linalg<CPU>::trtri(n__, o__)) {
+                TERMINATE("error in inversion");
+            }
+            t2.stop();
         }
-        t2.stop();
 
         /* o is upper triangular matrix */
         for (int i = 0; i < n__; i++) {
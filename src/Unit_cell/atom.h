@@ -494,44 +494,44 @@ class Atom
      */
     template <spin_block_t sblock>
     inline double_complex
-    radial_integrals_sum_L3(int idxrf1__, int idxrf2__, std::vector<gaunt_L3<double_complex>> const& gnt__) const
+    radial_integrals_sum_L3(int idxrf1__, int idxrf2__, gaunt_L3_range<double_complex> const& gnt__) const
     {
-        double_complex zsum(0, 0);
+        int n = static_cast<int>(gnt__.size());
+        int const* lm3 = gnt__.lm3();
+        double_complex const* coef = gnt__.coef();
 
-        for (size_t i = 0; i < gnt__.size(); i++) {
-            switch (sblock) {
-                case spin_block_t::nm: {
-                    /* just the Hamiltonian */
-                    zsum += gnt__[i].coef * h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__);
-                    break;
-                }
-                case spin_block_t::uu: {
-                    /* h + Bz */
-                    zsum += gnt__[i].coef * (h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__) +
-                                             b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 0));
-                    break;
-                }
-                case spin_block_t::dd: {
-                    /* h - Bz */
-                    zsum += gnt__[i].coef * (h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__) -
-                                             b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 0));
-                    break;
-                }
-                case spin_block_t::ud: {
-                    /* Bx - i By */
-                    zsum += gnt__[i].coef * double_complex(b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 1),
-                                                           -b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 2));
-                    break;
-                }
-                case spin_block_t::du: {
-                    /* Bx + i By */
-                    zsum += gnt__[i].coef * double_complex(b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 1),
-                                                           b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 2));
-                    break;
-                }
+        double const* h = &h_radial_integrals_(0, idxrf1__, idxrf2__);
+
+        /* the sums are linear in the radial integrals; each term is a vectorized contraction */
+        switch (sblock) {
+            case spin_block_t::nm: {
+                /* just the Hamiltonian */
+                return sum_L3(n, lm3, coef, h);
+            }
+            case spin_block_t::uu: {
+                /* h + Bz */
+                double const* bz = &b_radial_integrals_(0, idxrf1__, idxrf2__, 0);
+                return sum_L3(n, lm3, coef, h) + sum_L3(n, lm3, coef, bz);
+            }
+            case spin_block_t::dd: {
+                /* h - Bz */
+                double const* bz = &b_radial_integrals_(0, idxrf1__, idxrf2__, 0);
+                return sum_L3(n, lm3, coef, h) - sum_L3(n, lm3, coef, bz);
+            }
+            case spin_block_t::ud: {
+                /* Bx - i By */
+                double const* bx = &b_radial_integrals_(0, idxrf1__, idxrf2__, 1);
+                double const* by = &b_radial_integrals_(0, idxrf1__, idxrf2__, 2);
+                return sum_L3(n, lm3, coef, bx) - double_complex(0, 1) * sum_L3(n, lm3, coef, by);
+            }
+            case spin_block_t::du: {
+                /* Bx + i By */
+                double const* bx = &b_radial_integrals_(0, idxrf1__, idxrf2__, 1);
+                double const* by = &b_radial_integrals_(0, idxrf1__, idxrf2__, 2);
+                return sum_L3(n, lm3, coef, bx) + double_complex(0, 1) * sum_L3(n, lm3, coef, by);
             }
         }
-        return zsum;
+        return 0;
     }
 
     inline int num_mt_points() const
@@ -29,6 +29,12 @@
 
 namespace sirius {
 
+/// Augmentation operator Q_{xi,xi'}(G) of an atom type.
+/** By default the plane-wave coefficients are stored for all local G-vectors. If the control parameter
+ *  aug_block_size is set, only the coefficients of the leading local G-vectors are kept (at least one block and as
+ *  many blocks as fit into aug_cache_memory) and the rest is generated on the fly, block by block, from the radial
+ *  integrals and the spherical harmonics of G-vectors. The consumers access the coefficients through q_pw_block().
+ *  Streaming is used only on the CPU; on the GPU the full table is always stored. */
 class Augmentation_operator
 {
     private:
@@ -39,17 +45,33 @@ class Augmentation_operator
 
         Atom_type const& atom_type_;
 
+        /// Radial integrals of the augmentation operator.
+        Radial_integrals_aug<false> const* ri_{nullptr};
+
         mdarray<double, 2> q_mtrx_;
 
+        /// Plane-wave coefficients of the first num_gvec_cached_ local G-vectors.
         mdarray<double, 2> q_pw_;
 
         mdarray<double, 1> sym_weight_;
 
-        void generate_pw_coeffs(double omega__, Gvec const& gvec__, Radial_integrals_aug<false> const& radial_integrals__)
+        /// Real spherical harmonics of the local G-vectors.
+        mdarray<double, 2> gvec_rlm_;
+
+        /// Gaunt coefficients of three real spherical harmonics.
+        std::unique_ptr<Gaunt_coefficients<double>> gaunt_coefs_;
+
+        /// Number of G-vectors in a block of coefficients generated on the fly.
+        int block_size_{0};
+
+        /// Number of leading local G-vectors for which the coefficients are stored.
+        int num_gvec_cached_{0};
+
+        /// Compute coefficients for the local G-vectors [igloc0__, igloc0__ + ngv__).
+        /** The result is stored as q__(idx12, 2 * (igloc - igloc0__) + {0, 1}) for real and imaginary parts. */
+        void generate_pw_coeffs(int igloc0__, int ngv__, double* q__, int ld__) const
         {
-            PROFILE("sirius::Augmentation_operator::generate_pw_coeffs");
-        
-            double fourpi_omega = fourpi / omega__;
+            double fourpi_omega = fourpi / ctx_.unit_cell().omega();
 
             /* maximum l of beta-projectors */
             int lmax_beta = atom_type_.indexr().lmax();
@@ -64,35 +86,18 @@ class Augmentation_operator
                 }
             }
 
-            /* Gaunt coefficients of three real spherical harmonics */
-            Gaunt_coefficients<double> gaunt_coefs(lmax_beta, 2 * lmax_beta, lmax_beta, SHT::gaunt_rlm);
-            
-            /* split G-vectors between ranks */
-            int gvec_count = gvec__.count();
-            int gvec_offset = gvec__.offset();
-            
-            /* array of real spherical harmonics for each G-vector */
-            mdarray<double, 2> gvec_rlm(Utils::lmmax(2 * lmax_beta), gvec_count);
-            #pragma omp parallel for schedule(static)
-            for (int igloc = 0; igloc < gvec_count; igloc++) {
-                int ig = gvec_offset + igloc;
-                auto rtp = SHT::spherical_coordinates(gvec__.gvec_cart(ig));
-                SHT::spherical_harmonics(2 * lmax_beta, rtp[1], rtp[2], &gvec_rlm(0, igloc));
-            }
-        
             /* number of beta-projectors */
             int nbf = atom_type_.mt_basis_size();
             
-            /* array of plane-wave coefficients */
-            q_pw_ = mdarray<double, 2>(nbf * (nbf + 1) / 2, 2 * gvec_count, memory_t::host_pinned, "q_pw_");
             #pragma omp parallel for schedule(static)
-            for (int igloc = 0; igloc < gvec_count; igloc++) {
-                int ig = gvec_offset + igloc;
-                double g = gvec__.gvec_len(ig);
+            for (int i = 0; i < ngv__; i++) {
+                int igloc = igloc0__ + i;
+                int ig = ctx_.gvec().offset() + igloc;
+                double g = ctx_.gvec().gvec_len(ig);
                 
                 std::vector<double_complex> v(lmmax);
                 
-                auto ri = radial_integrals__.values(atom_type_.id(), g);
+                auto ri = ri_->values(atom_type_.id(), g);
 
                 for (int xi2 = 0; xi2 < nbf; xi2++) {
                     int lm2 = atom_type_.indexb(xi2).lm;
@@ -108,17 +113,62 @@ class Augmentation_operator
                         int idxrf12 = idxrf2 * (idxrf2 + 1) / 2 + idxrf1;
                         
                         for (int lm3 = 0; lm3 < lmmax; lm3++) {
-                            v[lm3] = std::conj(zilm[lm3]) * gvec_rlm(lm3, igloc) * ri(idxrf12, l_by_lm[lm3]);
+                            v[lm3] = std::conj(zilm[lm3]) * gvec_rlm_(lm3, igloc) * ri(idxrf12, l_by_lm[lm3]);
                         }
 
-                        double_complex z = fourpi_omega * gaunt_coefs.sum_L3_gaunt(lm2, lm1, &v[0]);
-                        q_pw_(idx12, 2 * igloc)     = z.real();
-                        q_pw_(idx12, 2 * igloc + 1) = z.imag();
+                        double_complex z = fourpi_omega * gaunt_coefs_->sum_L3_gaunt(lm2, lm1, &v[0]);
+                        q__[idx12 + ld__ * 2 * i]       = z.real();
+                        q__[idx12 + ld__ * (2 * i + 1)] = z.imag();
                     }
                 }
             }
+        }
 
-            sym_weight_ = mdarray<double, 1>(nbf * (nbf + 1) / 2, memory_t::host_pinned, "sym_weight_");
+        void generate_pw_coeffs(double omega__, Gvec const& gvec__)
+        {
+            PROFILE("sirius::Augmentation_operator::generate_pw_coeffs");
+        
+            /* maximum l of beta-projectors */
+            int lmax_beta = atom_type_.indexr().lmax();
+
+            gaunt_coefs_ = std::unique_ptr<Gaunt_coefficients<double>>(
+                new Gaunt_coefficients<double>(lmax_beta, 2 * lmax_beta, lmax_beta, SHT::gaunt_rlm));
+            
+            /* split G-vectors between ranks */
+            int gvec_count = gvec__.count();
+            int gvec_offset = gvec__.offset();
+            
+            /* array of real spherical harmonics for each G-vector */
+            gvec_rlm_ = mdarray<double, 2>(Utils::lmmax(2 * lmax_beta), gvec_count);
+            #pragma omp parallel for schedule(static)
+            for (int igloc = 0; igloc < gvec_count; igloc++) {
+                int ig = gvec_offset + igloc;
+                auto rtp = SHT::spherical_coordinates(gvec__.gvec_cart(ig));
+                SHT::spherical_harmonics(2 * lmax_beta, rtp[1], rtp[2], &gvec_rlm_(0, igloc));
+            }
+        
+            /* number of beta-projectors */
+            int nbf = atom_type_.mt_basis_size();
+            int nq = nbf * (nbf + 1) / 2;
+
+            block_size_ = ctx_.control().aug_block_size_;
+            if (block_size_ <= 0 || ctx_.processing_unit() == GPU) {
+                /* store the full table; consumers still walk through it in blocks to keep their temporary
+                 * arrays of phase factors small */
+                block_size_ = std::max(1, std::min(gvec_count, 1024));
+                num_gvec_cached_ = gvec_count;
+            } else {
+                /* memory of one block in Mb */
+                double mb = 16.0 * nq * block_size_ / (1 << 20);
+                int nblk = std::max(1, static_cast<int>(ctx_.control().aug_cache_memory_ / mb));
+                num_gvec_cached_ = std::min(gvec_count, nblk * block_size_);
+            }
+            
+            /* array of plane-wave coefficients */
+            q_pw_ = mdarray<double, 2>(nq, 2 * num_gvec_cached_, memory_t::host_pinned, "q_pw_");
+            generate_pw_coeffs(0, num_gvec_cached_, q_pw_.at<CPU>(), nq);
+
+            sym_weight_ = mdarray<double, 1>(nq, memory_t::host_pinned, "sym_weight_");
             for (int xi2 = 0; xi2 < nbf; xi2++) {
                 for (int xi1 = 0; xi1 <= xi2; xi1++) {
                     /* packed orbital index */
@@ -143,7 +193,12 @@ class Augmentation_operator
             comm_.bcast(&q_mtrx_(0, 0), nbf * nbf , 0);
 
             if (ctx_.control().print_checksum_) {
-                double cs = q_pw_.checksum();
+                double cs{0};
+                mdarray<double, 2> buf;
+                for (int ig0 = 0; ig0 < gvec_count; ig0 += block_size_) {
+                    int ng = std::min(block_size_, gvec_count - ig0);
+                    cs += mdarray<double, 1>(const_cast<double*>(q_pw_block(ig0, ng, buf)), 2 * nq * ng).checksum();
+                }
                 comm_.allreduce(&cs, 1);
                 if (comm_.rank() == 0) {
                     print_checksum("q_pw", cs);
@@ -159,9 +214,10 @@ class Augmentation_operator
             : ctx_(ctx__)
             , comm_(ctx__.comm())
             , atom_type_(ctx__.unit_cell().atom_type(iat__))
+            , ri_(&ri__)
         {
             if (atom_type_.pp_desc().augment) {
-                generate_pw_coeffs(ctx__.unit_cell().omega(), ctx__.gvec(), ri__);
+                generate_pw_coeffs(ctx__.unit_cell().omega(), ctx__.gvec());
             }
         }
 
@@ -188,8 +244,13 @@ class Augmentation_operator
             #endif
         }
 
+        /// Full table of plane-wave coefficients.
+        /** Available only if the coefficients of all local G-vectors are stored. */
         mdarray<double, 2> const& q_pw() const
         {
+            if (num_gvec_cached_ != ctx_.gvec().count()) {
+                TERMINATE("full table of Q(G) is not stored");
+            }
             return q_pw_;
         }
 
@@ -198,6 +259,28 @@ class Augmentation_operator
             return q_pw_(i__, ig__);
         }
 
+        /// Number of G-vectors in a block of coefficients returned by q_pw_block().
+        inline int block_size() const
+        {
+            return block_size_;
+        }
+
+        /// Return coefficients for the local G-vectors [igloc0__, igloc0__ + ngv__).
+        /** The returned array has the leading dimension nbf * (nbf + 1) / 2 and stores the real and imaginary parts
+         *  of each G-vector in two consecutive columns. If the block is not cached, it is generated in buf__. */
+        double const* q_pw_block(int igloc0__, int ngv__, mdarray<double, 2>& buf__) const
+        {
+            if (igloc0__ + ngv__ <= num_gvec_cached_) {
+                return q_pw_.at<CPU>(0, 2 * igloc0__);
+            }
+            int nq = static_cast<int>(q_pw_.size(0));
+            if (buf__.size() < static_cast<size_t>(2 * nq * ngv__)) {
+                buf__ = mdarray<double, 2>(nq, 2 * ngv__, memory_t::host, "q_pw_block");
+            }
+            generate_pw_coeffs(igloc0__, ngv__, buf__.at<CPU>(), nq);
+            return buf__.at<CPU>();
+        }
+
         double const& q_mtrx(int xi1__, int xi2__) const
         {
             return q_mtrx_(xi1__, xi2__);
@@ -216,6 +299,256 @@ class Augmentation_operator
         }
 };
 
+/// Augmentation functions of the atoms on the regular real-space grid.
+/** For each atom the local points of the fine FFT grid inside the sphere, where the radial functions of the
+ *  augmentation operator are non-zero, are stored together with the values
+ *  \f[
+ *    Q_{\xi \xi'}({\bf r}) = \sum_{\ell_3 m_3} \langle R_{\ell_1 m_1} | R_{\ell_3 m_3} | R_{\ell_2 m_2} \rangle
+ *      \frac{Q_{\ell_1 \ell_2}^{\ell_3}(r)}{r^2} R_{\ell_3 m_3}(\hat {\bf r})
+ *  \f]
+ *  where \f$ {\bf r} \f$ is taken relative to the atom position. This gives the augmentation charge and the
+ *  D-operator matrix with the cost proportional to the number of atoms. */
+class Augmentation_operator_rg
+{
+    private:
+
+        Simulation_context_base const& ctx_;
+
+        /// Local indices of the real-space points inside the augmentation sphere of each atom.
+        std::vector<std::vector<int>> box_points_;
+
+        /// Values of Q_{xi,xi'}(r) (packed orbital index, point) at the box points of each atom.
+        std::vector<mdarray<double, 2>> q_rg_;
+
+        /// Radius of the sphere outside of which all radial functions of the augmentation operator vanish.
+        static double augmentation_radius(Atom_type const& atom_type__)
+        {
+            int nbrf = atom_type__.mt_radial_basis_size();
+            int lmax_beta = atom_type__.indexr().lmax();
+            int nr = atom_type__.num_mt_points();
+
+            int ir_max{0};
+            for (int l = 0; l <= 2 * lmax_beta; l++) {
+                for (int idx = 0; idx < nbrf * (nbrf + 1) / 2; idx++) {
+                    for (int ir = nr - 1; ir > ir_max; ir--) {
+                        if (std::abs(atom_type__.q_rf(idx, l)[ir]) > 1e-12) {
+                            ir_max = ir;
+                            break;
+                        }
+                    }
+                }
+            }
+            /* spline can be evaluated only between the first and the last point */
+            return atom_type__.radial_grid(std::min(ir_max + 1, nr - 2));
+        }
+
+        void generate_box(int ia__, Gaunt_coefficients<double> const& gaunt__, double R__)
+        {
+            auto& fft = ctx_.fft();
+            auto& uc = ctx_.unit_cell();
+            auto& atom_type = uc.atom(ia__).type();
+            auto pos = uc.atom(ia__).position();
+
+            int nbf = atom_type.mt_basis_size();
+            int nbrf = atom_type.mt_radial_basis_size();
+            int lmax_beta = atom_type.indexr().lmax();
+            int lmmax = Utils::lmmax(2 * lmax_beta);
+
+            /* extent of the sphere in fractional coordinates along each lattice vector */
+            vector3d<double> ext;
+            for (int x: {0, 1, 2}) {
+                double s{0};
+                for (int y: {0, 1, 2}) {
+                    s += std::pow(uc.inverse_lattice_vectors()(x, y), 2);
+                }
+                ext[x] = R__ * std::sqrt(s);
+            }
+
+            std::vector<int> lo(3), hi(3);
+            for (int x: {0, 1, 2}) {
+                lo[x] = static_cast<int>(std::ceil((pos[x] - ext[x]) * fft.grid().size(x)));
+                hi[x] = static_cast<int>(std::floor((pos[x] + ext[x]) * fft.grid().size(x)));
+            }
+
+            auto mod = [](int i, int n)
+            {
+                return ((i % n) + n) % n;
+            };
+
+            /* find the local points inside the sphere; periodic images of the atom are included by
+             * running over the unwrapped grid indices */
+            std::vector<int> points;
+            std::vector<vector3d<double>> rvec;
+            for (int j2 = lo[2]; j2 <= hi[2]; j2++) {
+                int jz = mod(j2, fft.grid().size(2)) - fft.offset_z();
+                if (jz < 0 || jz >= fft.local_size_z()) {
+                    continue;
+                }
+                for (int j1 = lo[1]; j1 <= hi[1]; j1++) {
+                    for (int j0 = lo[0]; j0 <= hi[0]; j0++) {
+                        vector3d<double> f(double(j0) / fft.grid().size(0) - pos[0],
+                                           double(j1) / fft.grid().size(1) - pos[1],
+                                           double(j2) / fft.grid().size(2) - pos[2]);
+                        auto r = uc.get_cartesian_coordinates(f);
+                        if (r.length() < R__) {
+                            points.push_back(fft.grid().index_by_coord(mod(j0, fft.grid().size(0)),
+                                                                       mod(j1, fft.grid().size(1)), jz));
+                            rvec.push_back(r);
+                        }
+                    }
+                }
+            }
+
+            int npt = static_cast<int>(points.size());
+            q_rg_[ia__] = mdarray<double, 2>(nbf * (nbf + 1) / 2, npt);
+
+            std::vector<double> rlm(lmmax);
+            mdarray<double, 2> qrf(nbrf * (nbrf + 1) / 2, 2 * lmax_beta + 1);
+
+            for (int ipt = 0; ipt < npt; ipt++) {
+                auto rtp = SHT::spherical_coordinates(rvec[ipt]);
+                SHT::spherical_harmonics(2 * lmax_beta, rtp[1], rtp[2], &rlm[0]);
+
+                /* radial functions are stored multiplied by r^2 */
+                double r = std::max(rtp[0], atom_type.radial_grid(0));
+                int ir = atom_type.radial_grid().index_of(r);
+                double dr = r - atom_type.radial_grid(ir);
+                for (int l = 0; l <= 2 * lmax_beta; l++) {
+                    for (int idx = 0; idx < nbrf * (nbrf + 1) / 2; idx++) {
+                        qrf(idx, l) = atom_type.q_rf(idx, l)(ir, dr) / r / r;
+                    }
+                }
+
+                for (int xi2 = 0; xi2 < nbf; xi2++) {
+                    int lm2 = atom_type.indexb(xi2).lm;
+                    int idxrf2 = atom_type.indexb(xi2).idxrf;
+                    for (int xi1 = 0; xi1 <= xi2; xi1++) {
+                        int lm1 = atom_type.indexb(xi1).lm;
+                        int idxrf1 = atom_type.indexb(xi1).idxrf;
+                        /* packed radial-function index */
+                        int idxrf12 = idxrf2 * (idxrf2 + 1) / 2 + idxrf1;
+
+                        double q{0};
+                        for (auto& g: gaunt__.gaunt_vector(lm2, lm1)) {
+                            q += g.coef * qrf(idxrf12, g.l3) * rlm[g.lm3];
+                        }
+                        q_rg_[ia__](xi2 * (xi2 + 1) / 2 + xi1, ipt) = q;
+                    }
+                }
+            }
+            box_points_[ia__] = std::move(points);
+        }
+
+    public:
+
+        Augmentation_operator_rg(Simulation_context_base const& ctx__)
+            : ctx_(ctx__)
+        {
+            PROFILE("sirius::Augmentation_operator_rg");
+
+            auto& uc = ctx_.unit_cell();
+
+            box_points_ = std::vector<std::vector<int>>(uc.num_atoms());
+            q_rg_ = std::vector<mdarray<double, 2>>(uc.num_atoms());
+
+            for (int iat = 0; iat < uc.num_atom_types(); iat++) {
+                auto& atom_type = uc.atom_type(iat);
+                if (!atom_type.pp_desc().augment) {
+                    continue;
+                }
+                int lmax_beta = atom_type.indexr().lmax();
+                /* Gaunt coefficients of three real spherical harmonics */
+                Gaunt_coefficients<double> gaunt_coefs(lmax_beta, 2 * lmax_beta, lmax_beta, SHT::gaunt_rlm);
+
+                double R = augmentation_radius(atom_type);
+
+                #pragma omp parallel for schedule(dynamic)
+                for (int i = 0; i < atom_type.num_atoms(); i++) {
+                    generate_box(atom_type.atom_id(i), gaunt_coefs, R);
+                }
+            }
+
+            if (ctx_.control().verbosity_ > 0) {
+                unsigned long long npt{0};
+                for (auto& e: box_points_) {
+                    npt += e.size();
+                }
+                ctx_.fft().comm().allreduce(&npt, 1);
+                if (ctx_.comm().rank() == 0) {
+                    printf("number of points in the real-space augmentation boxes: %llu\n", npt);
+                }
+            }
+        }
+
+        /// Add the augmentation charge of the atoms of a given type to the real-space functions.
+        /** The auxiliary density matrix dm__ has the layout (packed orbital index, atom of type, component) and
+         *  f_rg__ has one local real-space array for each component. */
+        void add_charge(int iat__, mdarray<double, 3> const& dm__, std::vector<double*> f_rg__) const
+        {
+            PROFILE("sirius::Augmentation_operator_rg::add_charge");
+
+            auto& atom_type = ctx_.unit_cell().atom_type(iat__);
+            int nbf = atom_type.mt_basis_size();
+            int nq = nbf * (nbf + 1) / 2;
+            int nv = static_cast<int>(f_rg__.size());
+
+            matrix<double> w(nq, nv);
+            for (int i = 0; i < atom_type.num_atoms(); i++) {
+                int ia = atom_type.atom_id(i);
+                int npt = static_cast<int>(box_points_[ia].size());
+                if (!npt) {
+                    continue;
+                }
+                for (int iv = 0; iv < nv; iv++) {
+                    for (int xi2 = 0; xi2 < nbf; xi2++) {
+                        for (int xi1 = 0; xi1 <= xi2; xi1++) {
+                            int idx12 = xi2 * (xi2 + 1) / 2 + xi1;
+                            w(idx12, iv) = dm__(idx12, i, iv) * ((xi1 == xi2) ? 1 : 2);
+                        }
+                    }
+                }
+                matrix<double> rho(npt, nv);
+                linalg<CPU>::gemm(1, 0, npt, nv, nq, q_rg_[ia], w, rho);
+
+                /* the box of a small cell can contain the same point more than once, so the points are added
+                 * sequentially */
+                for (int iv = 0; iv < nv; iv++) {
+                    for (int ipt = 0; ipt < npt; ipt++) {
+                        f_rg__[iv][box_points_[ia][ipt]] += rho(ipt, iv);
+                    }
+                }
+            }
+        }
+
+        /// Integrate a real-space function with Q_{xi,xi'}(r) of the atoms of a given type.
+        /** The sum over the grid points is divided by the total number of points, i.e. the result is the integral
+         *  divided by the unit cell volume, which is the normalization of the G-space sum in
+         *  Potential::generate_D_operator_matrix(). The result (packed orbital index, atom of type) is reduced
+         *  over the FFT communicator. */
+        void integrate(int iat__, double const* f_rg__, matrix<double>& result__) const
+        {
+            PROFILE("sirius::Augmentation_operator_rg::integrate");
+
+            auto& atom_type = ctx_.unit_cell().atom_type(iat__);
+            int nbf = atom_type.mt_basis_size();
+            int nq = nbf * (nbf + 1) / 2;
+            double norm = 1.0 / ctx_.fft().size();
+
+            result__.zero();
+            #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < atom_type.num_atoms(); i++) {
+                int ia = atom_type.atom_id(i);
+                for (int ipt = 0; ipt < static_cast<int>(box_points_[ia].size()); ipt++) {
+                    double f = f_rg__[box_points_[ia][ipt]] * norm;
+                    for (int idx = 0; idx < nq; idx++) {
+                        result__(idx, i) += q_rg_[ia](idx, ipt) * f;
+                    }
+                }
+            }
+            ctx_.fft().comm().allreduce(result__.at<CPU>(), static_cast<int>(result__.size()));
+        }
+};
+
 class Augmentation_operator_gvec_deriv
 {
     private:
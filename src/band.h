@@ -98,6 +98,16 @@ class Band
         void apply_uj_correction(mdarray<double_complex, 2>& fv_states, mdarray<double_complex, 3>& hpsi);
 
         /// Add interstitial contribution to apw-apw block of Hamiltonian and overlap
+        /** The matrix is processed by square tiles. For each tile the table of \f$ {\bf G} - {\bf G}' \f$ indices
+         *  is built first and then the Fourier coefficients are gathered. If the matrix is not distributed, only the
+         *  tiles of the upper half are computed and the lower half is restored from the hermiticity:
+         *  \f[
+         *      H_{{\bf G}'{\bf G}}^{IT} = \Big( H_{{\bf G}{\bf G}'}^{IT} \Big)^{*}
+         *  \f]
+         *  which holds because the potential, the step function and the inverse relativistic mass are real.
+         *
+         *  The iterative LAPW solver doesn't use the interstitial matrix: it applies the Hamiltonian to the
+         *  trial wave-functions with the FFT (see Band::apply_fv_h_o()). */
         inline void set_fv_h_o_it(K_point* kp__,
                                   Potential const& potential__, 
                                   matrix<double_complex>& h__,
@@ -153,7 +163,7 @@ class Band
                                                   Q_operator<T>& q_op__) const;
         /// RMM-DIIS diagonalization.
         template <typename T>
-        inline void diag_pseudo_potential_rmm_diis(K_point* kp__,
+        inline int diag_pseudo_potential_rmm_diis(K_point* kp__,
                                                    int ispn__,
                                                    D_operator<T>& d_op__,
                                                    Q_operator<T>& q_op__) const;
@@ -393,12 +403,16 @@ class Band
             } else if (itso.type_ == "davidson") {
                 niter = diag_pseudo_potential_davidson(kp__, d_op, q_op);
             } else if (itso.type_ == "rmm-diis") {
-                if (ctx_.num_mag_dims() != 3) {
+                /* RMM-DIIS is not robust far from the ground state (it can converge to the wrong eigen-pair), so
+                 * Davidson solver is used in the beginning of the SCF cycle; non-collinear and GPU cases are not
+                 * implemented in RMM-DIIS solver */
+                if (ctx_.iterative_solver_tolerance() > itso.rmm_diis_tolerance_ || ctx_.num_mag_dims() == 3 ||
+                    ctx_.processing_unit() == GPU) {
+                    niter = diag_pseudo_potential_davidson(kp__, d_op, q_op);
+                } else {
                     for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-                        diag_pseudo_potential_rmm_diis(kp__, ispn, d_op, q_op);
+                        niter = std::max(niter, diag_pseudo_potential_rmm_diis(kp__, ispn, d_op, q_op));
                     }
-                } else {
-                    STOP();
                 }
             } else if (itso.type_ == "chebyshev") {
                 P_operator<T> p_op(ctx_, kp__->beta_projectors(), kp__->p_mtrx());
@@ -549,18 +563,37 @@ class Band
 
             // TODO: this is k-independent and can in principle be precomputed together with radial integrals if memory is available
             // TODO: for spin-collinear case hmt is Hermitian; compute upper triangular part and use zhemm
-            mdarray<double_complex, 2> hmt(type.mt_aw_basis_size(), type.mt_aw_basis_size());
+            int naw = type.mt_aw_basis_size();
+            mdarray<double_complex, 2> hmt(naw, naw);
             /* compute the muffin-tin Hamiltonian */
-            for (int j2 = 0; j2 < type.mt_aw_basis_size(); j2++) {
-                int lm2    = type.indexb(j2).lm;
-                int idxrf2 = type.indexb(j2).idxrf;
-                for (int j1 = 0; j1 < type.mt_aw_basis_size(); j1++) {
-                    int lm1    = type.indexb(j1).lm;
-                    int idxrf1 = type.indexb(j1).idxrf;
-                    hmt(j1, j2) = atom__.radial_integrals_sum_L3<sblock>(idxrf1, idxrf2, gaunt_coefs_->gaunt_vector(lm1, lm2));
+            if (sblock == spin_block_t::nm) {
+                /* contract all (lm1, lm2) pairs with the radial integrals in one batch */
+                std::vector<int> lm1(naw * naw);
+                std::vector<int> lm2(naw * naw);
+                std::vector<int> offs(naw * naw);
+                for (int j2 = 0; j2 < naw; j2++) {
+                    for (int j1 = 0; j1 < naw; j1++) {
+                        int j = j1 + naw * j2;
+                        lm1[j]  = type.indexb(j1).lm;
+                        lm2[j]  = type.indexb(j2).lm;
+                        offs[j] = static_cast<int>(atom__.h_radial_integrals(type.indexb(j1).idxrf, type.indexb(j2).idxrf) -
+                                                   atom__.h_radial_integrals(0, 0));
+                    }
+                }
+                gaunt_coefs_->sum_L3_gaunt(naw * naw, lm1.data(), lm2.data(), atom__.h_radial_integrals(0, 0),
+                                           offs.data(), hmt.at<CPU>());
+            } else {
+                for (int j2 = 0; j2 < naw; j2++) {
+                    int lm2    = type.indexb(j2).lm;
+                    int idxrf2 = type.indexb(j2).idxrf;
+                    for (int j1 = 0; j1 < naw; j1++) {
+                        int lm1    = type.indexb(j1).lm;
+                        int idxrf1 = type.indexb(j1).idxrf;
+                        hmt(j1, j2) = atom__.radial_integrals_sum_L3<sblock>(idxrf1, idxrf2, gaunt_coefs_->gaunt_vector(lm1, lm2));
+                    }
                 }
             }
-            linalg<CPU>::gemm(0, 1, num_gkvec__, type.mt_aw_basis_size(), type.mt_aw_basis_size(), alm__, hmt, halm__);
+            linalg<CPU>::gemm(0, 1, num_gkvec__, naw, naw, alm__, hmt, halm__);
         }
 
         void apply_o1mt_to_apw(Atom const&                 atom__,
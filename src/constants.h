@@ -54,5 +54,10 @@ const double ha2ev = 27.21138505;
 
 const char* const storage_file_name = "sirius.h5";
 
+/// Version of the layout of the storage file.
+/** Version 2: plane-wave coefficients are stored as {2, num_gvec} arrays, written by slabs of G-vectors. Files
+ *  without the "storage_format" attribute have the old layout of flat {2 * num_gvec} arrays. */
+const int storage_file_format = 2;
+
 #endif // __CONSTANTS_H__
 
@@ -54,6 +54,12 @@ extern "C" void update_density_rg_1_gpu(int size__,
                                         double wt__, 
                                         double* density_rg__);
 
+extern "C" void update_density_rg_1_pair_gpu(int size__,
+                                             double_complex const* psi_rg__,
+                                             double wt1__,
+                                             double wt2__,
+                                             double* density_rg__);
+
 extern "C" void update_density_rg_2_gpu(int size__, 
                                         double_complex const* psi_rg_up__, 
                                         double_complex const* psi_rg_dn__, 
@@ -589,14 +595,18 @@ class Density
             
             mdarray<double_complex, 2> rho_aug(ctx_.gvec().count(), ctx_.num_mag_dims() + 1, ctx_.dual_memory_t());
 
-            switch (ctx_.processing_unit()) {
-                case CPU: {
-                    generate_rho_aug<CPU>(rho_aug);
-                    break;
-                }
-                case GPU: {
-                    generate_rho_aug<GPU>(rho_aug);
-                    break;
+            if (ctx_.control().augment_real_space_) {
+                generate_rho_aug_rg(rho_aug);
+            } else {
+                switch (ctx_.processing_unit()) {
+                    case CPU: {
+                        generate_rho_aug<CPU>(rho_aug);
+                        break;
+                    }
+                    case GPU: {
+                        generate_rho_aug<GPU>(rho_aug);
+                        break;
+                    }
                 }
             }
 
@@ -611,6 +621,9 @@ class Density
         template <device_t pu>
         inline void generate_rho_aug(mdarray<double_complex, 2>& rho_aug__);
 
+        /// Generate augmentation charge on the real-space grid and transform it to plane-wave coefficients.
+        inline void generate_rho_aug_rg(mdarray<double_complex, 2>& rho_aug__);
+
         /// Check density at MT boundary
         void check_density_continuity_at_mt();
 
@@ -632,20 +645,12 @@ class Density
 
         void load()
         {
-            HDF5_tree fin(storage_file_name, false);
-
-            int ngv;
-            fin.read("/parameters/num_gvec", &ngv, 1);
-            if (ngv != ctx_.gvec().num_gvec()) {
-                TERMINATE("wrong number of G-vectors");
-            }
-            mdarray<int, 2> gv(3, ngv);
-            fin.read("/parameters/gvec", gv);
-
-            rho_->hdf5_read(fin["density"], gv);
+            rho_->hdf5_read(storage_file_name, "density");
             rho_->fft_transform(1);
             for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                magnetization_[j]->hdf5_read(fin["magnetization"][j], gv);
+                std::stringstream s;
+                s << "magnetization/" << j;
+                magnetization_[j]->hdf5_read(storage_file_name, s.str());
                 magnetization_[j]->fft_transform(1);
             }
         }
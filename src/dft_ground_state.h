@@ -374,7 +374,7 @@ class DFT_ground_state
 
             auto& remap_gvec = ctx_.remap_gvec();
 
-            unit_cell_.symmetry().symmetrize_function(&f__->f_pw_local(0), remap_gvec, ctx_.sym_phase_factors());
+            unit_cell_.symmetry().symmetrize_function(&f__->f_pw_local(0), remap_gvec, ctx_.sym_gvec_map());
 
             /* symmetrize PW components */
             //auto v = f__->gather_f_pw();
@@ -385,7 +385,7 @@ class DFT_ground_state
                     //auto vz = gz__->gather_f_pw();
                     //unit_cell_.symmetry().symmetrize_vector_function(&vz[0], ctx_.gvec(), comm);
                     //gz__->scatter_f_pw(vz);
-                    unit_cell_.symmetry().symmetrize_vector_function(&gz__->f_pw_local(0), remap_gvec);
+                    unit_cell_.symmetry().symmetrize_vector_function(&gz__->f_pw_local(0), remap_gvec, ctx_.sym_gvec_map());
                     break;
                 }
                 case 3: {
@@ -396,7 +396,8 @@ class DFT_ground_state
                     //gx__->scatter_f_pw(vx);
                     //gy__->scatter_f_pw(vy);
                     //gz__->scatter_f_pw(vz);
-                    unit_cell_.symmetry().symmetrize_vector_function(&gx__->f_pw_local(0), &gy__->f_pw_local(0), &gz__->f_pw_local(0), remap_gvec);
+                    unit_cell_.symmetry().symmetrize_vector_function(&gx__->f_pw_local(0), &gy__->f_pw_local(0),
+                                                                     &gz__->f_pw_local(0), remap_gvec, ctx_.sym_gvec_map());
                     break;
                 }
             }
@@ -562,6 +563,10 @@ inline int DFT_ground_state::find(double potential_tol, double energy_tol, int n
             printf("+------------------------------+\n");
         }
 
+        /* move k-points between MPI ranks using the timings of the previous iteration */
+        if (iter > 0 && ctx_.control().rebalance_kpoints_) {
+            kset_.rebalance();
+        }
         /* find new wave-functions */
         band_.solve_for_kset(kset_, potential_, true);
         /* find band occupancies */
@@ -656,6 +661,9 @@ inline int DFT_ground_state::find(double potential_tol, double energy_tol, int n
         ctx_.create_storage_file();
         potential_.save();
         density_.save();
+        if (ctx_.control().save_wave_functions_) {
+            kset_.save();
+        }
     }
 
     return result;
@@ -48,6 +48,118 @@ struct gaunt_L1_L2
     T coef;
 };
 
+/// Non-zero Gaunt coefficients of a given combination of lm1 and lm2.
+/** This is a view of one row of the compressed storage of Gaunt_coefficients. Besides the {lm3, l3, coef} records
+ *  it exposes the flat arrays of lm3 indices and coefficients for the contraction kernels. */
+template <typename T>
+class gaunt_L3_range
+{
+    private:
+
+        gaunt_L3<T> const* gaunt_{nullptr};
+
+        int const* lm3_{nullptr};
+
+        T const* coef_{nullptr};
+
+        int size_{0};
+
+    public:
+
+        gaunt_L3_range(gaunt_L3<T> const* gaunt__, int const* lm3__, T const* coef__, int size__)
+            : gaunt_(gaunt__)
+            , lm3_(lm3__)
+            , coef_(coef__)
+            , size_(size__)
+        {
+        }
+
+        inline size_t size() const
+        {
+            return static_cast<size_t>(size_);
+        }
+
+        inline gaunt_L3<T> const& operator[](int i__) const
+        {
+            return gaunt_[i__];
+        }
+
+        inline gaunt_L3<T> const* begin() const
+        {
+            return gaunt_;
+        }
+
+        inline gaunt_L3<T> const* end() const
+        {
+            return gaunt_ + size_;
+        }
+
+        /// Flat array of lm3 indices.
+        inline int const* lm3() const
+        {
+            return lm3_;
+        }
+
+        /// Flat array of coefficients.
+        inline T const* coef() const
+        {
+            return coef_;
+        }
+};
+
+/// Contraction of Gaunt coefficients with a vector indexed by lm3: \f$ \sum_{k} c_k v_{L_3(k)} \f$.
+/** The real and imaginary parts are accumulated separately in double precision and complex arrays are accessed as
+ *  arrays of (re, im) pairs, such that the loops are vectorized by the compiler. */
+inline double sum_L3(int n__, int const* lm3__, double const* coef__, double const* v__)
+{
+    double sum{0};
+    #pragma omp simd reduction(+:sum)
+    for (int k = 0; k < n__; k++) {
+        sum += coef__[k] * v__[lm3__[k]];
+    }
+    return sum;
+}
+
+inline double_complex sum_L3(int n__, int const* lm3__, double const* coef__, double_complex const* v__)
+{
+    double const* v = reinterpret_cast<double const*>(v__);
+    double re{0}, im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        re += coef__[k] * v[2 * lm3__[k]];
+        im += coef__[k] * v[2 * lm3__[k] + 1];
+    }
+    return double_complex(re, im);
+}
+
+inline double_complex sum_L3(int n__, int const* lm3__, double_complex const* coef__, double const* v__)
+{
+    double const* c = reinterpret_cast<double const*>(coef__);
+    double re{0}, im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        double v = v__[lm3__[k]];
+        re += c[2 * k] * v;
+        im += c[2 * k + 1] * v;
+    }
+    return double_complex(re, im);
+}
+
+inline double_complex sum_L3(int n__, int const* lm3__, double_complex const* coef__, double_complex const* v__)
+{
+    double const* c = reinterpret_cast<double const*>(coef__);
+    double const* v = reinterpret_cast<double const*>(v__);
+    double re{0}, im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        double v_re = v[2 * lm3__[k]];
+        double v_im = v[2 * lm3__[k] + 1];
+        re += c[2 * k] * v_re - c[2 * k + 1] * v_im;
+        im += c[2 * k] * v_im + c[2 * k + 1] * v_re;
+    }
+    return double_complex(re, im);
+}
+
 /// Compact storage of non-zero Gaunt coefficients \f$ \langle \ell_1 m_1 | \ell_3 m_3 | \ell_2 m_2 \rangle \f$.
 /** Very important! The following notation is adopted and used everywhere: lm1 and lm2 represent 'bra' and 'ket' 
  *  spherical harmonics of the Gaunt integral and lm3 represent the inner spherical harmonic. 
@@ -75,8 +187,22 @@ class Gaunt_coefficients
         /// List of non-zero Gaunt coefficients for each lm3.
         mdarray<std::vector<gaunt_L1_L2<T>>, 1> gaunt_packed_L1_L2_;
 
-        /// List of non-zero Gaunt coefficients for each combination of lm1, lm2.
-        mdarray<std::vector<gaunt_L3<T>>, 2> gaunt_packed_L3_;
+        /// Offsets of the rows of non-zero Gaunt coefficients for each combination of lm1, lm2.
+        /** Coefficients of (lm1, lm2) are stored in [row_L3_(lm1, lm2), row_L3_(lm1, lm2) + num_gaunt(lm1, lm2)) of
+         *  the flat arrays below; rows are ordered with lm2 running fastest. */
+        mdarray<int, 2> row_L3_;
+
+        /// Number of non-zero Gaunt coefficients for each combination of lm1, lm2.
+        mdarray<int, 2> num_L3_;
+
+        /// Flat list of non-zero Gaunt coefficients {lm3, l3, coef} in the compressed-row order.
+        std::vector<gaunt_L3<T>> gaunt_L3_;
+
+        /// Flat array of lm3 indices in the compressed-row order.
+        std::vector<int> lm3_L3_;
+
+        /// Flat array of coefficients in the compressed-row order.
+        std::vector<T> coef_L3_;
 
     public:
         
@@ -96,13 +222,15 @@ class Gaunt_coefficients
             gaunt_packed_L1_L2_ = mdarray<std::vector<gaunt_L1_L2<T>>, 1>(lmmax3_);
             gaunt_L1_L2<T> g12;
             
-            gaunt_packed_L3_ = mdarray<std::vector<gaunt_L3<T>>, 2>(lmmax1_, lmmax2_);
+            row_L3_ = mdarray<int, 2>(lmmax1_, lmmax2_);
+            num_L3_ = mdarray<int, 2>(lmmax1_, lmmax2_);
             gaunt_L3<T> g3;
 
             for (int l1 = 0, lm1 = 0; l1 <= lmax1_; l1++) {
                 for (int m1 = -l1; m1 <= l1; m1++, lm1++) {
                     for (int l2 = 0, lm2 = 0; l2 <= lmax2_; l2++) {
                         for (int m2 = -l2; m2 <= l2; m2++, lm2++) {
+                            row_L3_(lm1, lm2) = static_cast<int>(gaunt_L3_.size());
                             for (int l3 = 0, lm3 = 0; l3 <= lmax3_; l3++) {
                                 for (int m3 = -l3; m3 <= l3; m3++, lm3++) {
                                     
@@ -116,10 +244,13 @@ class Gaunt_coefficients
                                         g3.lm3 = lm3;
                                         g3.l3 = l3;
                                         g3.coef = gc;
-                                        gaunt_packed_L3_(lm1, lm2).push_back(g3);
+                                        gaunt_L3_.push_back(g3);
+                                        lm3_L3_.push_back(lm3);
+                                        coef_L3_.push_back(gc);
                                     }
                                 }
                             }
+                            num_L3_(lm1, lm2) = static_cast<int>(gaunt_L3_.size()) - row_L3_(lm1, lm2);
                         }
                     }
                 }
@@ -158,13 +289,14 @@ class Gaunt_coefficients
         /// Return number of non-zero Gaunt coefficients for a combination of lm1 and lm2.
         inline int num_gaunt(int lm1, int lm2) const
         {
-            return static_cast<int>(gaunt_packed_L3_(lm1, lm2).size());
+            return num_L3_(lm1, lm2);
         }
         
         /// Return a structure containing {lm3, coef} for a given lm1, lm2 and index
         inline gaunt_L3<T> const& gaunt(int lm1, int lm2, int idx) const
         {
-            return gaunt_packed_L3_(lm1, lm2)[idx];
+            assert(idx >= 0 && idx < num_L3_(lm1, lm2));
+            return gaunt_L3_[row_L3_(lm1, lm2) + idx];
         }
 
         /// Return a sum over L3 (lm3) index of Gaunt coefficients and a complex vector.
@@ -176,11 +308,8 @@ class Gaunt_coefficients
          */
         inline double_complex sum_L3_gaunt(int lm1, int lm2, double_complex const* v) const
         {
-            double_complex zsum(0, 0);
-            for (int k = 0; k < (int)gaunt_packed_L3_(lm1, lm2).size(); k++) {
-                zsum += gaunt_packed_L3_(lm1, lm2)[k].coef * v[gaunt_packed_L3_(lm1, lm2)[k].lm3];
-            }
-            return zsum;
+            int k0 = row_L3_(lm1, lm2);
+            return sum_L3(num_L3_(lm1, lm2), &lm3_L3_[k0], &coef_L3_[k0], v);
         }
         
         /// Return a sum over L3 (lm3) index of Gaunt coefficients and a real vector.
@@ -192,17 +321,35 @@ class Gaunt_coefficients
          */
         inline T sum_L3_gaunt(int lm1, int lm2, double const* v) const
         {
-            T sum = 0;
-            for (int k = 0; k < (int)gaunt_packed_L3_(lm1, lm2).size(); k++) {
-                sum += gaunt_packed_L3_(lm1, lm2)[k].coef * v[gaunt_packed_L3_(lm1, lm2)[k].lm3];
+            int k0 = row_L3_(lm1, lm2);
+            return sum_L3(num_L3_(lm1, lm2), &lm3_L3_[k0], &coef_L3_[k0], v);
+        }
+
+        /// Compute sums over L3 for a batch of (lm1, lm2) pairs.
+        /** For each i in [0, n__) the following operation is performed:
+         *  \f[
+         *      r_i = \sum_{\ell_3 m_3} \langle \ell_1 m_1 | \ell_3 m_3 | \ell_2 m_2 \rangle v_{\ell_3 m_3}^{(i)}
+         *  \f]
+         *  where lm1 = lm1__[i], lm2 = lm2__[i] and \f$ v^{(i)} \f$ starts at v__ + v_offset__[i]. Each sum is
+         *  computed by the vectorized sum_L3() kernel; the loop over pairs is serial because it is called from the
+         *  threaded loops over atoms.
+         */
+        template <typename F, typename R>
+        inline void sum_L3_gaunt(int n__, int const* lm1__, int const* lm2__, F const* v__, int const* v_offset__,
+                                 R* result__) const
+        {
+            for (int i = 0; i < n__; i++) {
+                int k0 = row_L3_(lm1__[i], lm2__[i]);
+                result__[i] = sum_L3(num_L3_(lm1__[i], lm2__[i]), &lm3_L3_[k0], &coef_L3_[k0], v__ + v_offset__[i]);
             }
-            return sum;
         }
-    
-        /// Return vector of non-zero Gaunt coefficients for a given combination of lm1 and lm2
-        inline std::vector<gaunt_L3<T>> const& gaunt_vector(int lm1, int lm2) const
+
+        /// Return non-zero Gaunt coefficients for a given combination of lm1 and lm2
+        inline gaunt_L3_range<T> gaunt_vector(int lm1, int lm2) const
         {
-            return gaunt_packed_L3_(lm1, lm2);
+            int k0 = row_L3_(lm1, lm2);
+            return gaunt_L3_range<T>(gaunt_L3_.data() + k0, lm3_L3_.data() + k0, coef_L3_.data() + k0,
+                                     num_L3_(lm1, lm2));
         }
 };
 
@@ -163,17 +163,67 @@ class HDF5_tree
     /// HDF5 file handler
     hid_t file_id_{-1};
 
+    /// Data transfer property list (collective transfer in case of parallel file access).
+    hid_t xfer_plist_id_{H5P_DEFAULT};
+
     /// True if this is a root node
     bool root_node_{true};
 
     /// Constructor to create branches of the HDF5 tree.
-    HDF5_tree(hid_t file_id__, const std::string& path__)
+    HDF5_tree(hid_t file_id__, hid_t xfer_plist_id__, const std::string& path__)
         : path_(path__)
         , file_id_(file_id__)
+        , xfer_plist_id_(xfer_plist_id__)
         , root_node_(false)
     {
     }
 
+    /// Select a hyperslab of the dataset and access it with the given HDF5 function.
+    /** Offsets and counts follow the same fastest-index-first order as the dimensions of the dataset. */
+    template <typename T, typename F>
+    void access_slab(const std::string& name, T* data, const std::vector<int>& offset, const std::vector<int>& count,
+                     F&& h5_access__, const char* label__)
+    {
+        HDF5_group group(file_id_, path_);
+
+        HDF5_dataset dataset(group.id(), name);
+
+        int ndims = static_cast<int>(count.size());
+
+        std::vector<hsize_t> file_offset(ndims);
+        std::vector<hsize_t> file_count(ndims);
+        std::vector<int> mem_dims(ndims);
+        size_t size{1};
+        for (int i = 0; i < ndims; i++) {
+            file_offset[ndims - i - 1] = offset[i];
+            file_count[ndims - i - 1]  = count[i];
+            mem_dims[i] = std::max(count[i], 1);
+            size *= count[i];
+        }
+
+        hid_t file_space = H5Dget_space(dataset.id());
+        if (file_space < 0) {
+            TERMINATE("error in H5Dget_space()");
+        }
+        HDF5_dataspace mem_space(mem_dims);
+        /* empty slab: all ranks still take part in the (possibly collective) transfer */
+        if (size == 0) {
+            H5Sselect_none(file_space);
+            H5Sselect_none(mem_space.id());
+        } else {
+            if (H5Sselect_hyperslab(file_space, H5S_SELECT_SET, &file_offset[0], NULL, &file_count[0], NULL) < 0) {
+                TERMINATE("error in H5Sselect_hyperslab()");
+            }
+        }
+        if (h5_access__(dataset.id(), type_wrapper<typename std::remove_const<T>::type>::hdf5_type_id(),
+                        mem_space.id(), file_space, xfer_plist_id_, data) < 0) {
+            std::stringstream s;
+            s << "error in " << label__ << std::endl << "name : " << name;
+            TERMINATE(s);
+        }
+        H5Sclose(file_space);
+    }
+
     /// Write a multidimensional array.
     template <typename T>
     void write(const std::string& name, T const* data, const std::vector<int>& dims)
@@ -244,10 +294,51 @@ class HDF5_tree
         path_ = "/";
     }
 
+    /// Open the existing file for the parallel access by all ranks of the communicator.
+    /** Requires the HDF5 library with MPI-IO support; use HDF5_tree::parallel_io() to check this. */
+    HDF5_tree(const std::string& file_name__, Communicator const& comm__)
+        : file_name_(file_name__)
+    {
+#ifdef H5_HAVE_PARALLEL
+        if (H5open() < 0) {
+            TERMINATE("error in H5open()");
+        }
+
+        hid_t plist_id = H5Pcreate(H5P_FILE_ACCESS);
+        H5Pset_fapl_mpio(plist_id, comm__.mpi_comm(), MPI_INFO_NULL);
+        file_id_ = H5Fopen(file_name_.c_str(), H5F_ACC_RDWR, plist_id);
+        H5Pclose(plist_id);
+        if (file_id_ < 0) {
+            TERMINATE("H5Fopen() failed");
+        }
+
+        xfer_plist_id_ = H5Pcreate(H5P_DATASET_XFER);
+        H5Pset_dxpl_mpio(xfer_plist_id_, H5FD_MPIO_COLLECTIVE);
+
+        path_ = "/";
+#else
+        (void)comm__;
+        TERMINATE("HDF5 library is compiled without MPI-IO support");
+#endif
+    }
+
+    /// Return true if the HDF5 library supports parallel file access.
+    static bool parallel_io()
+    {
+#ifdef H5_HAVE_PARALLEL
+        return true;
+#else
+        return false;
+#endif
+    }
+
     /// Destructor.
     ~HDF5_tree()
     {
         if (root_node_) {
+            if (xfer_plist_id_ != H5P_DEFAULT) {
+                H5Pclose(xfer_plist_id_);
+            }
             if (H5Fclose(file_id_) < 0) {
                 TERMINATE("error in H5Fclose()");
             }
@@ -275,6 +366,13 @@ class HDF5_tree
         return (*this)[name];
     }
 
+    /// Return true if the object with the given name exists at the current location.
+    bool exists(const std::string& name)
+    {
+        HDF5_group group(file_id_, path_);
+        return (H5Lexists(group.id(), name.c_str(), H5P_DEFAULT) > 0);
+    }
+
     template <int N>
     void write(const std::string& name, mdarray<double_complex, N> const& data)
     {
@@ -338,6 +436,72 @@ class HDF5_tree
         write(name, &vec[0], (int)vec.size());
     }
 
+    /// Attach a scalar attribute to the group at the current location.
+    template <typename T>
+    void write_attribute(const std::string& name, T value)
+    {
+        HDF5_group group(file_id_, path_);
+
+        HDF5_dataspace dataspace({1});
+
+        hid_t attr_id = H5Acreate(group.id(), name.c_str(), type_wrapper<T>::hdf5_type_id(), dataspace.id(),
+                                  H5P_DEFAULT, H5P_DEFAULT);
+        if (attr_id < 0) {
+            TERMINATE("error in H5Acreate()");
+        }
+        if (H5Awrite(attr_id, type_wrapper<T>::hdf5_type_id(), &value) < 0) {
+            TERMINATE("error in H5Awrite()");
+        }
+        H5Aclose(attr_id);
+    }
+
+    /// Read a scalar attribute of the group at the current location.
+    /** Return false if the attribute does not exist. */
+    template <typename T>
+    bool read_attribute(const std::string& name, T& value)
+    {
+        HDF5_group group(file_id_, path_);
+
+        if (H5Aexists(group.id(), name.c_str()) <= 0) {
+            return false;
+        }
+        hid_t attr_id = H5Aopen(group.id(), name.c_str(), H5P_DEFAULT);
+        if (attr_id < 0) {
+            TERMINATE("error in H5Aopen()");
+        }
+        if (H5Aread(attr_id, type_wrapper<T>::hdf5_type_id(), &value) < 0) {
+            TERMINATE("error in H5Aread()");
+        }
+        H5Aclose(attr_id);
+        return true;
+    }
+
+    /// Create an empty dataset which is later filled by write_slab().
+    template <typename T>
+    void create_dataset(const std::string& name, const std::vector<int>& dims)
+    {
+        HDF5_group group(file_id_, path_);
+
+        HDF5_dataspace dataspace(dims);
+
+        HDF5_dataset dataset(group, dataspace, name, type_wrapper<T>::hdf5_type_id());
+    }
+
+    /// Write a contiguous block of data into the hyperslab of the existing dataset.
+    template <typename T>
+    void write_slab(const std::string& name, T const* data, const std::vector<int>& offset,
+                    const std::vector<int>& count)
+    {
+        access_slab(name, data, offset, count, H5Dwrite, "H5Dwrite()");
+    }
+
+    /// Read a hyperslab of the dataset into a contiguous block of data.
+    template <typename T>
+    void read_slab(const std::string& name, T* data, const std::vector<int>& offset, const std::vector<int>& count)
+    {
+        access_slab(name, data, offset, count, H5Dread, "H5Dread()");
+    }
+
     template <int N>
     void read(const std::string& name, mdarray<double_complex, N>& data)
     {
@@ -391,7 +555,7 @@ class HDF5_tree
     HDF5_tree operator[](const std::string& path__)
     {
         std::string new_path = path_ + path__ + "/";
-        return HDF5_tree(file_id_, new_path);
+        return HDF5_tree(file_id_, xfer_plist_id_, new_path);
     }
 
     HDF5_tree operator[](int idx)
@@ -399,10 +563,32 @@ class HDF5_tree
         std::stringstream s;
         s << idx;
         std::string new_path = path_ + s.str() + "/";
-        return HDF5_tree(file_id_, new_path);
+        return HDF5_tree(file_id_, xfer_plist_id_, new_path);
     }
 };
 
+/// Give each rank of the communicator access to the existing HDF5 file.
+/** If the HDF5 library supports MPI-IO, the file is opened by all ranks at once and the functor is executed
+ *  concurrently. Otherwise the ranks open the file one after another. In both cases the functor must touch only
+ *  the local slab of the data with HDF5_tree::write_slab() or HDF5_tree::read_slab() and must call them the same
+ *  number of times on each rank. No collective communication is allowed inside the functor. */
+template <typename F>
+inline void hdf5_distributed_access(std::string const& file_name__, Communicator const& comm__, F&& f__)
+{
+    if (HDF5_tree::parallel_io()) {
+        HDF5_tree h5f(file_name__, comm__);
+        f__(h5f);
+    } else {
+        for (int r = 0; r < comm__.size(); r++) {
+            if (r == comm__.rank()) {
+                HDF5_tree h5f(file_name__, false);
+                f__(h5f);
+            }
+            comm__.barrier();
+        }
+    }
+}
+
 }; // namespace sirius
 
 #endif // __HDF5_TREE_H__
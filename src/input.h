@@ -227,6 +227,7 @@ struct Iterative_solver_input
     int num_steps_{20};
 
     /// Size of the variational subspace is this number times the number of bands.
+    /** In case of RMM-DIIS solver this is the length of the DIIS history of each band. */
     int subspace_size_{4};
 
     /// Tolerance for the eigen-energy difference \f$ |\epsilon_i^{old} - \epsilon_i^{new} | \f$.
@@ -259,6 +260,12 @@ struct Iterative_solver_input
      *  as they are and solve generalized eigen-value problem. */
     bool orthogonalize_{true};
 
+    /// Iterative solver tolerance above which the Davidson solver is used in place of RMM-DIIS.
+    /** RMM-DIIS is not robust far from the ground state: it can converge to the wrong eigen-pair. Davidson solver is
+     *  used in the beginning of the SCF cycle, until the tolerance (which is reduced in the course of SCF) drops
+     *  below this value. Default is 1e-4. */
+    double rmm_diis_tolerance_{1e-4};
+
     /// Tell how to initialize the subspace.
     /** It can be either "lcao", i.e. start from the linear combination of atomic orbitals or "random" –- start from
      *  the randomized wave functions. */
@@ -280,6 +287,7 @@ struct Iterative_solver_input
             mask_alpha_         = parser["iterative_solver"].value("mask_alpha", mask_alpha_);
             num_singular_       = parser["iterative_solver"].value("num_singular", num_singular_);
             orthogonalize_      = parser["iterative_solver"].value("orthogonalize", orthogonalize_);
+            rmm_diis_tolerance_ = parser["iterative_solver"].value("rmm_diis_tolerance", rmm_diis_tolerance_);
             init_subspace_      = parser["iterative_solver"].value("init_subspace", init_subspace_);
             std::transform(init_subspace_.begin(), init_subspace_.end(), init_subspace_.begin(), ::tolower);
         }
@@ -298,6 +306,18 @@ struct Iterative_solver_input
  *      "electronic_structure_method" : (string) electronic structure method
  *      "processing_unit" : (string) primary processing unit
  *      "fft_mode" : (string) serial or parallel FFT
+ *      "fft_batch_size" : (int) number of wave-functions transformed together by the coarse-grid FFT in H|psi> and density
+ *      "fft_remap_batch_size" : (int) number of local wave-functions in a sub-batch of the pipelined remap in H|psi>
+ *      "fft_a2a_single_precision" : (bool) exchange z-sticks of the coarse-grid FFT in single precision in H|psi>
+ *      "fft_a2a_single_precision_tol" : (double) iterative solver tolerance below which double precision is used
+ *      "save_wave_functions" : (bool) write wave-functions to the storage file for the restart
+ *      "rebalance_kpoints" : (bool) re-distribute k-points between MPI ranks using the timings of the band solver
+ *      "beta_chunk_memory" : (double) memory (in Mb) of the plane-wave coefficients of a chunk of beta-projectors
+ *      "beta_cache_memory" : (double) memory (in Mb) to keep the generated beta-projectors between the SCF iterations
+ *      "xc_backend" : (string) "libxc", "native" (built-in LDA, PBE and PBEsol kernels) or "validate" (check them against libxc)
+ *      "augment_real_space" : (bool) compute augmentation charge and D-operator on the real-space grid around each atom
+ *      "aug_block_size" : (int) number of G-vectors in a block of the augmentation operator Q(G) generated on the fly
+ *      "aug_cache_memory" : (double) memory (in Mb) to keep the leading blocks of Q(G) of each atom type
  *    }
  *  \endcode
  */
@@ -309,6 +329,17 @@ struct Control_input
     std::string std_evp_solver_name_{""};
     std::string gen_evp_solver_name_{""};
     std::string fft_mode_{"serial"};
+    /// Number of wave-functions in a batch of the coarse-grid FFT in Local_operator::apply_h() and Density.
+    /** Value of 1 switches off the batched transformation. */
+    int fft_batch_size_{1};
+    /// Number of local wave-functions in a sub-batch of the pipelined remap in Local_operator::apply_h().
+    /** The all-to-all remap of the next sub-batch is overlapped with the FFTs of the current one.
+     *  Value of 0 switches off the pipelining. */
+    int fft_remap_batch_size_{0};
+    /// Use single precision all-to-all of the coarse-grid FFT in Local_operator::apply_h().
+    bool fft_a2a_single_precision_{false};
+    /// Mixed precision is switched off when the iterative solver tolerance drops below this value.
+    double fft_a2a_single_precision_tol_{1e-6};
     std::string processing_unit_{""};
     double rmt_max_{2.2};
     double spglib_tolerance_{1e-4};
@@ -328,6 +359,28 @@ struct Control_input
     bool print_stress_{false};
     bool print_forces_{false};
     bool print_timers_{true};
+    /// Write wave-functions to the storage file together with the density and potential.
+    bool save_wave_functions_{false};
+    /// Re-distribute k-points between MPI ranks between the SCF iterations according to their cost.
+    bool rebalance_kpoints_{false};
+    /// Memory budget (in Mb) per MPI rank for the plane-wave coefficients of a chunk of beta-projectors.
+    double beta_chunk_memory_{512};
+    /// Memory limit (in Mb) per MPI rank for the cache of the plane-wave coefficients of beta-projectors.
+    /** Value of 0 switches off the cache. */
+    double beta_cache_memory_{0};
+    /// Compute the augmentation charge and the D-operator matrix on the real-space grid around each atom.
+    /** The cost scales linearly with the number of atoms instead of \f$ N_{atoms} \times N_{G} \f$. The
+     *  augmentation functions are not filtered by the plane-wave cutoff, so the result differs slightly from
+     *  the G-space version, which stays the default. */
+    bool augment_real_space_{false};
+    /// Number of G-vectors in a block of the augmentation operator Q(G) generated on the fly.
+    /** Value of 0 keeps the full table of Q(G) for all local G-vectors. Ignored on GPU. */
+    int aug_block_size_{0};
+    /// Memory limit (in Mb) per atom type for the stored blocks of Q(G) when aug_block_size is set.
+    /** The first block is always stored. */
+    double aug_cache_memory_{0};
+    /// Backend for the evaluation of XC functionals.
+    std::string xc_backend_{"libxc"};
 
     void read(json const& parser)
     {
@@ -338,6 +391,10 @@ struct Control_input
             gen_evp_solver_name_ = parser["control"].value("gen_evp_solver_type", gen_evp_solver_name_);
             processing_unit_     = parser["control"].value("processing_unit", processing_unit_);
             fft_mode_            = parser["control"].value("fft_mode", fft_mode_);
+            fft_batch_size_      = parser["control"].value("fft_batch_size", fft_batch_size_);
+            fft_remap_batch_size_ = parser["control"].value("fft_remap_batch_size", fft_remap_batch_size_);
+            fft_a2a_single_precision_ = parser["control"].value("fft_a2a_single_precision", fft_a2a_single_precision_);
+            fft_a2a_single_precision_tol_ = parser["control"].value("fft_a2a_single_precision_tol", fft_a2a_single_precision_tol_);
             reduce_gvec_         = parser["control"].value("reduce_gvec", reduce_gvec_);
             rmt_max_             = parser["control"].value("rmt_max", rmt_max_);
             spglib_tolerance_    = parser["control"].value("spglib_tolerance", spglib_tolerance_);
@@ -351,8 +408,16 @@ struct Control_input
             print_stress_        = parser["control"].value("print_stress", print_stress_);
             print_forces_        = parser["control"].value("print_forces", print_forces_);
             print_timers_        = parser["control"].value("print_timers", print_timers_);
-
-            auto strings = {&std_evp_solver_name_, &gen_evp_solver_name_, &fft_mode_, &processing_unit_};
+            save_wave_functions_ = parser["control"].value("save_wave_functions", save_wave_functions_);
+            rebalance_kpoints_   = parser["control"].value("rebalance_kpoints", rebalance_kpoints_);
+            beta_chunk_memory_   = parser["control"].value("beta_chunk_memory", beta_chunk_memory_);
+            beta_cache_memory_   = parser["control"].value("beta_cache_memory", beta_cache_memory_);
+            xc_backend_          = parser["control"].value("xc_backend", xc_backend_);
+            augment_real_space_  = parser["control"].value("augment_real_space", augment_real_space_);
+            aug_block_size_      = parser["control"].value("aug_block_size", aug_block_size_);
+            aug_cache_memory_    = parser["control"].value("aug_cache_memory", aug_cache_memory_);
+
+            auto strings = {&std_evp_solver_name_, &gen_evp_solver_name_, &fft_mode_, &processing_unit_, &xc_backend_};
             for (auto s : strings) {
                 std::transform(s->begin(), s->end(), s->begin(), ::tolower);
             }
@@ -480,6 +545,8 @@ struct Settings_input
     int nprii_rho_core_{20};
     bool always_update_wf_{true};
     double mixer_rss_min_{1e-12};
+    /// Points of the regular grid with the density below this value are skipped in the XC potential.
+    double xc_rho_threshold_{1e-14};
 
     void read(json const& parser)
     {
@@ -490,6 +557,7 @@ struct Settings_input
             nprii_rho_core_   = parser["settings"].value("nprii_rho_core", nprii_rho_core_);
             always_update_wf_ = parser["settings"].value("always_update_wf", always_update_wf_);
             mixer_rss_min_    = parser["settings"].value("mixer_rss_min", mixer_rss_min_);
+            xc_rho_threshold_ = parser["settings"].value("xc_rho_threshold", xc_rho_threshold_);
         }
     }
 };
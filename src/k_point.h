@@ -87,6 +87,9 @@ class K_point
         /// Band energies.
         std::vector<double> band_energies_; 
 
+        /// True if the wave-functions were loaded from the storage file.
+        bool wave_functions_restored_{false};
+
         std::unique_ptr<Matching_coefficients> alm_coeffs_row_{nullptr};
 
         std::unique_ptr<Matching_coefficients> alm_coeffs_col_{nullptr};
@@ -237,13 +240,61 @@ class K_point
 
         //Periodic_function<double_complex>* spinor_wave_function_component(int lmax, int ispn, int j);
 
-        void save(int id);
+        /// Save wave-functions, band energies and band occupancies to the storage file.
+        /** Each rank of the k-point communicator writes its own slab of G+k vectors and plane-wave coefficients
+         *  and its own block of muffin-tin coefficients. */
+        inline void save(std::string const& name__, int id__);
+
+        /// Load wave-functions, band energies and band occupancies from the storage file.
+        /** Returns false if the stored k-point has a different number of G+k vectors. */
+        inline bool load(std::string const& name__, int id__);
 
-        void load(HDF5_tree h5in, int id);
+        /// Return true if the wave-functions were loaded from the storage file.
+        inline bool wave_functions_restored() const
+        {
+            return wave_functions_restored_;
+        }
 
-        //== void save_wave_functions(int id);
+        /// Return the local arrays of wave-functions which are kept between the SCF iterations.
+        /** These arrays are sent to the new owner when the k-point is moved to a different MPI rank. Their size
+         *  depends only on the distribution of G+k vectors inside the k-point communicator. */
+        inline std::vector<mdarray<double_complex, 2>*> persistent_wave_functions()
+        {
+            std::vector<mdarray<double_complex, 2>*> result;
+            auto add = [&result](wave_functions& wf)
+            {
+                result.push_back(&wf.pw_coeffs().prime());
+                if (wf.has_mt() && wf.mt_coeffs().num_rows_loc()) {
+                    result.push_back(&wf.mt_coeffs().prime());
+                }
+            };
+            for (int ispn = 0; ispn < spinor_wave_functions_->num_components(); ispn++) {
+                add(spinor_wave_functions_->component(ispn));
+            }
+            if (fv_eigen_vectors_slab_) {
+                add(*fv_eigen_vectors_slab_);
+            }
+            if (singular_components_) {
+                add(*singular_components_);
+            }
+            return std::move(result);
+        }
 
-        //== void load_wave_functions(int id);
+        /// Release the memory of a k-point which is no longer handled by this MPI rank.
+        inline void release()
+        {
+            fv_eigen_vectors_ = dmatrix<double_complex>();
+            fv_eigen_vectors_slab_.reset();
+            singular_components_.reset();
+            sv_eigen_vectors_[0] = dmatrix<double_complex>();
+            sv_eigen_vectors_[1] = dmatrix<double_complex>();
+            fv_states_.reset();
+            spinor_wave_functions_.reset();
+            alm_coeffs_row_.reset();
+            alm_coeffs_col_.reset();
+            alm_coeffs_loc_.reset();
+            beta_projectors_.reset();
+        }
 
         void get_fv_eigen_vectors(mdarray<double_complex, 2>& fv_evec);
         
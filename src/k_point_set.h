@@ -50,6 +50,9 @@ class K_point_set
 
         splindex<chunk> spl_num_kpoints_;
 
+        /// Time spent by the band solver on each k-point during the last SCF iteration.
+        std::vector<double> solve_time_;
+
         double energy_fermi_{0};
 
         double band_gap_{0};
@@ -176,6 +179,7 @@ class K_point_set
             } else {
                 spl_num_kpoints_ = splindex<chunk>(num_kpoints(), comm_k_.size(), comm_k_.rank(), counts);
             }
+            solve_time_ = std::vector<double>(num_kpoints(), 0);
 
             for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
                 kpoints_[spl_num_kpoints_[ikloc]]->initialize();
@@ -211,6 +215,9 @@ class K_point_set
         void print_info();
 
         void sync_band_energies();
+
+        /// Re-distribute k-points between the ranks of the k-communicator according to their cost.
+        void rebalance();
         
         void save();
 
@@ -263,6 +270,12 @@ class K_point_set
             return spl_num_kpoints_[ikloc];
         }
 
+        /// Time spent by the band solver on the k-point.
+        inline double& solve_time(int ik__)
+        {
+            return solve_time_[ik__];
+        }
+
         void set_band_occupancies(int ik, double* band_occupancies)
         {
             kpoints_[ik]->set_band_occupancies(band_occupancies);
@@ -339,6 +352,142 @@ inline void K_point_set::sync_band_energies()
     }
 }
 
+inline void K_point_set::rebalance()
+{
+    PROFILE("sirius::K_point_set::rebalance");
+
+    int nk = num_kpoints();
+    int nr = comm_k_.size();
+
+    if (nr == 1) {
+        return;
+    }
+
+    /* cost of each k-point is the time spent by the band solver in the previous SCF iteration; if it is not
+     * available, the cost is estimated from the size of the basis */
+    std::vector<double> cost(2 * nk, 0);
+    for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+        int ik = spl_num_kpoints_[ikloc];
+        cost[ik]      = solve_time_[ik];
+        cost[nk + ik] = static_cast<double>(kpoints_[ik]->num_gkvec()) * ctx_.num_bands();
+    }
+    /* all ranks must end up with the same partitioning */
+    ctx_.comm().allreduce<double, mpi_op_t::max>(cost.data(), 2 * nk);
+    if (!std::all_of(cost.begin(), cost.begin() + nk, [](double t){return t > 0;})) {
+        std::copy(cost.begin() + nk, cost.end(), cost.begin());
+    }
+    cost.resize(nk);
+
+    /* split k-points into contiguous chunks with the load not exceeding max_load */
+    auto split = [&](double max_load__, std::vector<int>& counts__)
+    {
+        counts__ = std::vector<int>(nr, 0);
+        int ik{0};
+        for (int r = 0; r < nr; r++) {
+            /* leave at least one k-point for each of the remaining ranks */
+            int nleft = (nk >= nr) ? nr - r - 1 : 0;
+            double load{0};
+            while (ik < nk - nleft && (counts__[r] == 0 || load + cost[ik] <= max_load__)) {
+                load += cost[ik];
+                counts__[r]++;
+                ik++;
+            }
+        }
+        return (ik == nk);
+    };
+
+    /* find the smallest maximum load by bisection */
+    double lo = *std::max_element(cost.begin(), cost.end());
+    double hi = std::accumulate(cost.begin(), cost.end(), 0.0);
+    std::vector<int> counts;
+    for (int i = 0; i < 50 && hi - lo > 1e-3 * lo; i++) {
+        double m = 0.5 * (lo + hi);
+        if (split(m, counts)) {
+            hi = m;
+        } else {
+            lo = m;
+        }
+    }
+    split(hi, counts);
+
+    std::vector<double> load_old(nr, 0);
+    std::vector<double> load_new(nr, 0);
+    for (int r = 0, ik = 0; r < nr; r++) {
+        for (int i = 0; i < counts[r]; i++, ik++) {
+            load_new[r] += cost[ik];
+        }
+    }
+    for (int ik = 0; ik < nk; ik++) {
+        load_old[spl_num_kpoints_.local_rank(ik)] += cost[ik];
+    }
+    double max_load_old = *std::max_element(load_old.begin(), load_old.end());
+    double max_load_new = *std::max_element(load_new.begin(), load_new.end());
+
+    if (ctx_.control().verbosity_ >= 1 && ctx_.comm().rank() == 0) {
+        printf("k-point distribution: maximum load %12.6f, balanced maximum load %12.6f\n", max_load_old, max_load_new);
+    }
+
+    /* moving k-points is not free; don't do it for a small gain */
+    if (max_load_new > 0.95 * max_load_old) {
+        return;
+    }
+
+    splindex<chunk> spl_new(nk, nr, comm_k_.rank(), counts);
+
+    int rank = comm_k_.rank();
+
+    /* initialize k-points which are moved to this rank */
+    std::vector<int> moved_in;
+    for (int ik = 0; ik < nk; ik++) {
+        if (spl_new.local_rank(ik) == rank && spl_num_kpoints_.local_rank(ik) != rank) {
+            kpoints_[ik]->initialize();
+            moved_in.push_back(ik);
+        }
+    }
+
+    /* move wave-functions; ranks of the k-communicator have the same position in the band communicator, so the
+     * source and destination k-points have identical distribution of G+k vectors */
+    std::vector<MPI_Request> req;
+    std::vector<int> moved_out;
+    for (int ik = 0; ik < nk; ik++) {
+        int src = spl_num_kpoints_.local_rank(ik);
+        int dst = spl_new.local_rank(ik);
+        if (src == dst || (rank != src && rank != dst)) {
+            continue;
+        }
+        for (auto wf: kpoints_[ik]->persistent_wave_functions()) {
+            req.push_back(MPI_Request());
+            if (rank == src) {
+                comm_k_.isend(wf->at<CPU>(), static_cast<int>(wf->size()), dst, ik, &req.back());
+            } else {
+                comm_k_.irecv(wf->at<CPU>(), static_cast<int>(wf->size()), src, ik, &req.back());
+            }
+        }
+        if (rank == src) {
+            moved_out.push_back(ik);
+        }
+    }
+    MPI_Waitall(static_cast<int>(req.size()), req.data(), MPI_STATUSES_IGNORE);
+
+    for (int ik: moved_out) {
+        kpoints_[ik]->release();
+    }
+
+    spl_num_kpoints_ = spl_new;
+
+    if (ctx_.processing_unit() == GPU && keep_wf_on_gpu) {
+        for (int ik: moved_in) {
+            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+                auto& psi = kpoints_[ik]->spinor_wave_functions(ispn);
+                psi.pw_coeffs().prime().copy<memory_t::host, memory_t::device>();
+                if (ctx_.full_potential()) {
+                    psi.mt_coeffs().prime().copy<memory_t::host, memory_t::device>();
+                }
+            }
+        }
+    }
+}
+
 inline void K_point_set::find_band_occupancies()
 {
     PROFILE("sirius::K_point_set::find_band_occupancies");
@@ -472,64 +621,96 @@ inline void K_point_set::print_info()
 
 inline void K_point_set::save()
 {
-    TERMINATE("fix me");
-    STOP();
-
-    //==if (comm_.rank() == 0)
-    //=={
-    //==    HDF5_tree fout(storage_file_name, false);
-    //==    fout.create_node("K_point_set");
-    //==    fout["K_point_set"].write("num_kpoints", num_kpoints());
-    //==}
-    //==comm_.barrier();
-    //==
-    //==if (ctx_.mpi_grid().side(1 << _dim_k_ | 1 << _dim_col_))
-    //=={
-    //==    for (int ik = 0; ik < num_kpoints(); ik++)
-    //==    {
-    //==        int rank = spl_num_kpoints_.local_rank(ik);
-    //==        
-    //==        if (ctx_.mpi_grid().coordinate(_dim_k_) == rank) kpoints_[ik]->save(ik);
-    //==        
-    //==        ctx_.mpi_grid().barrier(1 << _dim_k_ | 1 << _dim_col_);
-    //==    }
-    //==}
+    PROFILE("sirius::K_point_set::save");
+
+    if (ctx_.comm().rank() == 0) {
+        HDF5_tree fout(storage_file_name, false);
+        fout.create_node("K_point_set");
+        fout["K_point_set"].write("num_kpoints", num_kpoints());
+    }
+    ctx_.comm().barrier();
+
+    /* groups of k-points access the file one after another */
+    for (int r = 0; r < comm_k_.size(); r++) {
+        if (comm_k_.rank() == r) {
+            for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+                int ik = spl_num_kpoints_[ikloc];
+                kpoints_[ik]->save(storage_file_name, ik);
+            }
+        }
+        ctx_.comm().barrier();
+    }
 }
 
-/// \todo check parameters of saved data in a separate function
+/// Load wave-functions of the k-points which are found in the storage file.
+/** The stored set of k-points may differ from the current one; k-points are matched by their coordinates.
+ *  Wave-functions of the restored k-points are used by Band::initialize_subspace() as the initial guess. */
 inline void K_point_set::load()
 {
-    STOP();
-
-    //== HDF5_tree fin(storage_file_name, false);
-
-    //== int num_kpoints_in;
-    //== fin["K_point_set"].read("num_kpoints", &num_kpoints_in);
-
-    //== std::vector<int> ikidx(num_kpoints(), -1); 
-    //== // read available k-points
-    //== double vk_in[3];
-    //== for (int jk = 0; jk < num_kpoints_in; jk++)
-    //== {
-    //==     fin["K_point_set"][jk].read("coordinates", vk_in, 3);
-    //==     for (int ik = 0; ik < num_kpoints(); ik++)
-    //==     {
-    //==         vector3d<double> dvk; 
-    //==         for (int x = 0; x < 3; x++) dvk[x] = vk_in[x] - kpoints_[ik]->vk(x);
-    //==         if (dvk.length() < 1e-12)
-    //==         {
-    //==             ikidx[ik] = jk;
-    //==             break;
-    //==         }
-    //==     }
-    //== }
-
-    //== for (int ik = 0; ik < num_kpoints(); ik++)
-    //== {
-    //==     int rank = spl_num_kpoints_.local_rank(ik);
-    //==     
-    //==     if (comm_.rank() == rank) kpoints_[ik]->load(fin["K_point_set"], ikidx[ik]);
-    //== }
+    PROFILE("sirius::K_point_set::load");
+
+    int num_kpoints_in{0};
+    mdarray<double, 2> vk_in;
+
+    if (ctx_.comm().rank() == 0) {
+        HDF5_tree fin(storage_file_name, false);
+        if (fin.exists("K_point_set")) {
+            int num_bands, num_spins;
+            fin["parameters"].read("num_bands", &num_bands, 1);
+            fin["parameters"].read("num_spins", &num_spins, 1);
+            if (num_bands == ctx_.num_bands() && num_spins == ctx_.num_spins()) {
+                fin["K_point_set"].read("num_kpoints", &num_kpoints_in, 1);
+                vk_in = mdarray<double, 2>(3, num_kpoints_in);
+                for (int jk = 0; jk < num_kpoints_in; jk++) {
+                    fin["K_point_set"][jk].read("vk", &vk_in(0, jk), 3);
+                }
+            } else {
+                WARNING("wrong number of bands or spins in the storage file; wave-functions are not loaded");
+            }
+        }
+    }
+    ctx_.comm().bcast(&num_kpoints_in, 1, 0);
+    if (num_kpoints_in == 0) {
+        return;
+    }
+    if (ctx_.comm().rank() != 0) {
+        vk_in = mdarray<double, 2>(3, num_kpoints_in);
+    }
+    ctx_.comm().bcast(vk_in.at<CPU>(), 3 * num_kpoints_in, 0);
+
+    /* index of the current k-points in the storage file */
+    std::vector<int> ikidx(num_kpoints(), -1);
+    for (int ik = 0; ik < num_kpoints(); ik++) {
+        for (int jk = 0; jk < num_kpoints_in; jk++) {
+            auto dvk = vector3d<double>(&vk_in(0, jk)) - kpoints_[ik]->vk();
+            if (dvk.length() < 1e-10) {
+                ikidx[ik] = jk;
+                break;
+            }
+        }
+    }
+
+    /* groups of k-points access the file one after another */
+    int num_restored{0};
+    for (int r = 0; r < comm_k_.size(); r++) {
+        if (comm_k_.rank() == r) {
+            for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+                int ik = spl_num_kpoints_[ikloc];
+                if (ikidx[ik] >= 0 && kpoints_[ik]->load(storage_file_name, ikidx[ik])) {
+                    num_restored++;
+                }
+            }
+        }
+        ctx_.comm().barrier();
+    }
+    comm_k_.allreduce(&num_restored, 1);
+
+    sync_band_energies();
+
+    if (ctx_.comm().rank() == 0 && ctx_.control().verbosity_ >= 1) {
+        printf("wave-functions of %i out of %i k-points are loaded from the storage file\n", num_restored,
+               num_kpoints());
+    }
 }
 
 //== void K_point_set::save_wave_functions()
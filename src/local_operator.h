@@ -68,6 +68,9 @@ class Local_operator
 
         /// Second temporary array to store [V*phi](G)
         mdarray<double_complex, 1> vphi2_;
+
+        /// Temporary array to store [V*phi](G) for a batch of wave-functions.
+        mdarray<double_complex, 2> vphi_batch_;
         
         /// LAPW unit step function on a coarse FFT grid.
         mdarray<double, 1> theta_;
@@ -322,6 +325,11 @@ class Local_operator
                 vphi2_ = mdarray<double_complex, 1>(ngv_fft, memory_t::host, "Local_operator::vphi2");
             }
 
+            int nb = fft_batch_size(gkvec__.reduced());
+            if (nb > 1 && (static_cast<int>(vphi_batch_.size(0)) < ngv_fft || static_cast<int>(vphi_batch_.size(1)) < nb)) {
+                vphi_batch_ = mdarray<double_complex, 2>(ngv_fft, nb, memory_t::host, "Local_operator::vphi_batch");
+            }
+
             if (fft_coarse_.pu() == GPU) {
                 pw_ekin_.allocate(memory_t::device);
                 pw_ekin_.copy<memory_t::host, memory_t::device>();
@@ -332,6 +340,36 @@ class Local_operator
             }
         }
 
+        /// Number of wave-functions in a batch of coarse-grid FFTs.
+        /** In case of reduced G-vectors the wave-functions are transformed in pairs and the batch size is rounded up
+         *  to an even number. Batched transformation is used only on CPU and for the spin-collinear case. */
+        inline int fft_batch_size(bool reduced__) const
+        {
+            int nb = param_->control().fft_batch_size_;
+            if (fft_coarse_.pu() != CPU || param_->num_mag_dims() == 3 || nb <= 1) {
+                return 1;
+            }
+            if (reduced__) {
+                nb += nb % 2;
+            }
+            return nb;
+        }
+
+        /// Number of local wave-functions in a sub-batch of the pipelined remap in apply_h().
+        /** Returns 0 if the wave-functions are not remapped or the pipelining is switched off. In case of reduced
+         *  G-vectors the sub-batch size is rounded up to an even number to keep the pairs of wave-functions. */
+        inline int remap_batch_size(bool is_remapped__, bool reduced__) const
+        {
+            int bs = param_->control().fft_remap_batch_size_;
+            if (!is_remapped__ || bs <= 0) {
+                return 0;
+            }
+            if (reduced__) {
+                bs += bs % 2;
+            }
+            return bs;
+        }
+
         inline void dismiss()
         {
             #ifdef __GPU
@@ -350,12 +388,31 @@ class Local_operator
 
             auto& gkp = phi__.gkvec().partition();
 
+            /* early SCF iterations don't require double precision H|psi>: exchange z-sticks in single precision;
+               FFTs and the multiplication by the local potential are still done in double precision */
+            fft_coarse_.a2a_single_precision(param_->control().fft_a2a_single_precision_ &&
+                                             param_->iterative_solver_tolerance() > param_->control().fft_a2a_single_precision_tol_);
+
+            /* number of local wave-functions in a sub-batch of the pipelined remap */
+            int remap_bs = remap_batch_size(phi__.component(0).pw_coeffs().is_remapped(), gkp.reduced());
+            /* number of sub-batches */
+            int num_remap_batches{1};
+
             for (int ispn = 0; ispn < phi__.num_components(); ispn++) {
 
-                phi__.component(ispn).pw_coeffs().remap_forward(fft_coarse_.pu(), gkp.gvec_fft_slab(), n__, idx0__);
+                if (remap_bs) {
+                    num_remap_batches = phi__.component(ispn).pw_coeffs().remap_forward_begin(fft_coarse_.pu(),
+                                            gkp.gvec_fft_slab(), n__, idx0__, remap_bs);
+                } else {
+                    phi__.component(ispn).pw_coeffs().remap_forward(fft_coarse_.pu(), gkp.gvec_fft_slab(), n__, idx0__);
+                }
 
                 hphi__.component(ispn).pw_coeffs().set_num_extra(CPU, gkp.gvec_count_fft(), n__, idx0__);
                 hphi__.component(ispn).pw_coeffs().extra().zero<memory_t::host | memory_t::device>();
+                if (remap_bs) {
+                    hphi__.component(ispn).pw_coeffs().remap_backward_begin(param_->processing_unit(),
+                                                                            gkp.gvec_fft_slab(), n__, idx0__, remap_bs);
+                }
             }
             
             /* transform one or two wave-functions to real space; the result of
@@ -512,152 +569,225 @@ class Local_operator
                 }
             };
 
-            int first{0};
-            /* if G-vectors are reduced, wave-functions are real and we can transform two of them at once */
-            /* non-collinear case is not treated here because nc wave-functions are complex */
-            if (gkp.reduced()) {
-                int npairs = phi__.component(0).pw_coeffs().spl_num_col().local_size() / 2;
-                /* Gamma-point case can only be non-magnetic or spin-collinear */
-                for (int i = 0; i < npairs; i++) {
-                    /* phi(G) -> phi(r) */
-                    phi_to_r(i, 0, true);
-                    /* multiply by effective potential */
-                    mul_by_veff(fft_coarse_.buffer(), ispn__);
-                    /* V(r)phi(r) -> [V*phi](G) */
-                    vphi_to_G(true);
-                    /* add kinetic energy */
-                    add_to_hphi(i, 0, true);
-                }
-                /* check if we have to do last wave-function which had no pair */
-                first = (phi__.component(0).pw_coeffs().spl_num_col().local_size() % 2) ? phi__.component(0).pw_coeffs().spl_num_col().local_size() - 1
-                                                                                        : phi__.component(0).pw_coeffs().spl_num_col().local_size();
+            /* number of local wave-functions */
+            int nwf = phi__.component(0).pw_coeffs().spl_num_col().local_size();
+
+            int nb = fft_batch_size(gkp.reduced());
+            if (nb > 1 && (static_cast<int>(vphi_batch_.size(0)) < gkp.gvec_count_fft() || static_cast<int>(vphi_batch_.size(1)) < nb)) {
+                vphi_batch_ = mdarray<double_complex, 2>(gkp.gvec_count_fft(), nb, memory_t::host, "Local_operator::vphi_batch");
             }
-            
-            /* if we don't have G-vector reductions, first = 0 and we start a normal loop */
-            for (int i = first; i < phi__.component(0).pw_coeffs().spl_num_col().local_size(); i++) {
-                
-                /* non-collinear case */
-                /* 2x2 Hamiltonian in applied to spinor wave-functions
-                 * .--------.--------.   .-----.   .------.
-                 * |        |        |   |     |   |      |
-                 * | H_{uu} | H_{ud} |   |phi_u|   |hphi_u|
-                 * |        |        |   |     |   |      |
-                 * .--------.--------. x .-----. = .------.
-                 * |        |        |   |     |   |      |
-                 * | H_{du} | H_{dd} |   |phi_d|   |hphi_d|
-                 * |        |        |   |     |   |      |
-                 * .--------.--------.   .-----.   .------.
-                 *
-                 * hphi_u = H_{uu} phi_u + H_{ud} phi_d
-                 * hphi_d = H_{du} phi_u + H_{dd} phi_d
-                 *
-                 * The following indexing scheme will be used for spin-blocks
-                 * .---.---.
-                 * | 0 | 2 |
-                 * .---.---.
-                 * | 3 | 1 |
-                 * .---.---.
-                 */        
-                if (param_->num_mag_dims() == 3) {
-                    /* phi_u(G) -> phi_u(r) */
-                    phi_to_r(i, 0);
-                    /* save phi_u(r) */
-                    switch (fft_coarse_.pu()) {
-                        case CPU: {
-                            fft_coarse_.output(buf_rg_.at<CPU>());
-                            break;
+
+            /* apply Hamiltonian to the local wave-functions in the range [i_begin, i_end) */
+            auto apply_range = [&](int i_begin, int i_end)
+            {
+                int first{i_begin};
+                /* batched transformation of wave-functions; in case of reduced G-vectors the last wave-function
+                 * without a pair is treated separately */
+                if (nb > 1) {
+                    int nwf_batch = gkp.reduced() ? i_end - (i_end - i_begin) % 2 : i_end;
+                    auto& phi_extra  = phi__.component(0).pw_coeffs().extra();
+                    auto& hphi_extra = hphi__.component(0).pw_coeffs().extra();
+                    auto& fft_buf    = fft_coarse_.buffer_batch();
+                    for (int i0 = i_begin; i0 < nwf_batch; i0 += nb) {
+                        int n = std::min(nb, nwf_batch - i0);
+                        /* number of real-space buffers */
+                        int nbuf = gkp.reduced() ? n / 2 : n;
+                        /* phi(G) -> phi(r) */
+                        fft_coarse_.transform_batch<1>(n, phi_extra.at<CPU>(0, i0), phi_extra.ld());
+                        /* multiply all functions of the batch by effective potential */
+                        #pragma omp parallel
+                        {
+                            sddk::timer t1("sirius::Local_operator::apply_h|veff");
+                            #pragma omp for schedule(static)
+                            for (int ir = 0; ir < fft_coarse_.local_size(); ir++) {
+                                double v = veff_vec_(ir, ispn__);
+                                for (int j = 0; j < nbuf; j++) {
+                                    fft_buf(ir, j) *= v;
+                                }
+                            }
                         }
-                        case GPU: {
-                            #ifdef __GPU
-                            acc::copy(buf_rg_.at<GPU>(), fft_coarse_.buffer().at<GPU>(), fft_coarse_.local_size());
-                            #endif
-                            break;
+                        /* V(r)phi(r) -> [V*phi](G) */
+                        fft_coarse_.transform_batch<-1>(n, vphi_batch_.at<CPU>(), vphi_batch_.ld());
+                        /* add kinetic energy */
+                        #pragma omp parallel
+                        {
+                            sddk::timer t1("sirius::Local_operator::apply_h|ekin");
+                            #pragma omp for schedule(static)
+                            for (int ig = 0; ig < gkp.gvec_count_fft(); ig++) {
+                                for (int j = 0; j < n; j++) {
+                                    hphi_extra(ig, i0 + j) += (phi_extra(ig, i0 + j) * pw_ekin_[ig] + vphi_batch_(ig, j));
+                                }
+                            }
                         }
                     }
-                    /* multiply phi_u(r) by effective potential */
-                    mul_by_veff(fft_coarse_.buffer(), 0);
-                    /* V_{uu}(r)phi_{u}(r) -> [V*phi]_{u}(G) */
-                    vphi_to_G();
-                    /* add kinetic energy */
-                    add_to_hphi(i, 0);
-                    /* multiply phi_{u} by V_{du} */
-                    mul_by_veff(buf_rg_, 3);
-                    /* copy to FFT buffer */
-                    switch (fft_coarse_.pu()) {
-                        case CPU: {
-                            fft_coarse_.input(buf_rg_.at<CPU>());
-                            break;
-                        }
-                        case GPU: {
-                            #ifdef __GPU
-                            acc::copy(fft_coarse_.buffer().at<GPU>(), buf_rg_.at<GPU>(), fft_coarse_.local_size());
-                            #endif
-                            break;
-                        }
+                    first = nwf_batch;
+                } else if (gkp.reduced()) {
+                    /* if G-vectors are reduced, wave-functions are real and we can transform two of them at once */
+                    /* non-collinear case is not treated here because nc wave-functions are complex */
+                    /* Gamma-point case can only be non-magnetic or spin-collinear */
+                    for (int i = i_begin / 2; i < i_end / 2; i++) {
+                        /* phi(G) -> phi(r) */
+                        phi_to_r(i, 0, true);
+                        /* multiply by effective potential */
+                        mul_by_veff(fft_coarse_.buffer(), ispn__);
+                        /* V(r)phi(r) -> [V*phi](G) */
+                        vphi_to_G(true);
+                        /* add kinetic energy */
+                        add_to_hphi(i, 0, true);
                     }
-                    /* V_{du}(r)phi_{u}(r) -> [V*phi]_{d}(G) */
-                    vphi_to_G();
-                    /* add to hphi_{d} */
-                    add_to_hphi(i, 3);
-
-                    /* for the second spin */
-
-                    /* phi_d(G) -> phi_d(r) */
-                    phi_to_r(i, 1);
-                    /* save phi_d(r) */
-                    switch (fft_coarse_.pu()) {
-                        case CPU: {
-                            fft_coarse_.output(buf_rg_.at<CPU>());
-                            break;
+                    /* check if we have to do last wave-function which had no pair */
+                    first = ((i_end - i_begin) % 2) ? i_end - 1 : i_end;
+                }
+            
+                /* if we don't have G-vector reductions, first = i_begin and we start a normal loop */
+                for (int i = first; i < i_end; i++) {
+                
+                    /* non-collinear case */
+                    /* 2x2 Hamiltonian in applied to spinor wave-functions
+                     * .--------.--------.   .-----.   .------.
+                     * |        |        |   |     |   |      |
+                     * | H_{uu} | H_{ud} |   |phi_u|   |hphi_u|
+                     * |        |        |   |     |   |      |
+                     * .--------.--------. x .-----. = .------.
+                     * |        |        |   |     |   |      |
+                     * | H_{du} | H_{dd} |   |phi_d|   |hphi_d|
+                     * |        |        |   |     |   |      |
+                     * .--------.--------.   .-----.   .------.
+                     *
+                     * hphi_u = H_{uu} phi_u + H_{ud} phi_d
+                     * hphi_d = H_{du} phi_u + H_{dd} phi_d
+                     *
+                     * The following indexing scheme will be used for spin-blocks
+                     * .---.---.
+                     * | 0 | 2 |
+                     * .---.---.
+                     * | 3 | 1 |
+                     * .---.---.
+                     */        
+                    if (param_->num_mag_dims() == 3) {
+                        /* phi_u(G) -> phi_u(r) */
+                        phi_to_r(i, 0);
+                        /* save phi_u(r) */
+                        switch (fft_coarse_.pu()) {
+                            case CPU: {
+                                fft_coarse_.output(buf_rg_.at<CPU>());
+                                break;
+                            }
+                            case GPU: {
+                                #ifdef __GPU
+                                acc::copy(buf_rg_.at<GPU>(), fft_coarse_.buffer().at<GPU>(), fft_coarse_.local_size());
+                                #endif
+                                break;
+                            }
                         }
-                        case GPU: {
-                            #ifdef __GPU
-                            acc::copy(buf_rg_.at<GPU>(), fft_coarse_.buffer().at<GPU>(), fft_coarse_.local_size());
-                            #endif
-                            break;
+                        /* multiply phi_u(r) by effective potential */
+                        mul_by_veff(fft_coarse_.buffer(), 0);
+                        /* V_{uu}(r)phi_{u}(r) -> [V*phi]_{u}(G) */
+                        vphi_to_G();
+                        /* add kinetic energy */
+                        add_to_hphi(i, 0);
+                        /* multiply phi_{u} by V_{du} */
+                        mul_by_veff(buf_rg_, 3);
+                        /* copy to FFT buffer */
+                        switch (fft_coarse_.pu()) {
+                            case CPU: {
+                                fft_coarse_.input(buf_rg_.at<CPU>());
+                                break;
+                            }
+                            case GPU: {
+                                #ifdef __GPU
+                                acc::copy(fft_coarse_.buffer().at<GPU>(), buf_rg_.at<GPU>(), fft_coarse_.local_size());
+                                #endif
+                                break;
+                            }
                         }
-                    }
-                    /* multiply phi_d(r) by effective potential */
-                    mul_by_veff(fft_coarse_.buffer(), 1);
-                    /* V_{dd}(r)phi_{d}(r) -> [V*phi]_{d}(G) */
-                    vphi_to_G();
-                    /* add kinetic energy */
-                    add_to_hphi(i, 1);
-                    /* multiply phi_{d} by V_{ud} */
-                    mul_by_veff(buf_rg_, 2);
-                    /* copy to FFT buffer */
-                    switch (fft_coarse_.pu()) {
-                        case CPU: {
-                            fft_coarse_.input(buf_rg_.at<CPU>());
-                            break;
+                        /* V_{du}(r)phi_{u}(r) -> [V*phi]_{d}(G) */
+                        vphi_to_G();
+                        /* add to hphi_{d} */
+                        add_to_hphi(i, 3);
+
+                        /* for the second spin */
+
+                        /* phi_d(G) -> phi_d(r) */
+                        phi_to_r(i, 1);
+                        /* save phi_d(r) */
+                        switch (fft_coarse_.pu()) {
+                            case CPU: {
+                                fft_coarse_.output(buf_rg_.at<CPU>());
+                                break;
+                            }
+                            case GPU: {
+                                #ifdef __GPU
+                                acc::copy(buf_rg_.at<GPU>(), fft_coarse_.buffer().at<GPU>(), fft_coarse_.local_size());
+                                #endif
+                                break;
+                            }
                         }
-                        case GPU: {
-                            #ifdef __GPU
-                            acc::copy(fft_coarse_.buffer().at<GPU>(), buf_rg_.at<GPU>(), fft_coarse_.local_size());
-                            #endif
-                            break;
+                        /* multiply phi_d(r) by effective potential */
+                        mul_by_veff(fft_coarse_.buffer(), 1);
+                        /* V_{dd}(r)phi_{d}(r) -> [V*phi]_{d}(G) */
+                        vphi_to_G();
+                        /* add kinetic energy */
+                        add_to_hphi(i, 1);
+                        /* multiply phi_{d} by V_{ud} */
+                        mul_by_veff(buf_rg_, 2);
+                        /* copy to FFT buffer */
+                        switch (fft_coarse_.pu()) {
+                            case CPU: {
+                                fft_coarse_.input(buf_rg_.at<CPU>());
+                                break;
+                            }
+                            case GPU: {
+                                #ifdef __GPU
+                                acc::copy(fft_coarse_.buffer().at<GPU>(), buf_rg_.at<GPU>(), fft_coarse_.local_size());
+                                #endif
+                                break;
+                            }
                         }
+                        /* V_{ud}(r)phi_{d}(r) -> [V*phi]_{u}(G) */
+                        vphi_to_G();
+                        /* add to hphi_{u} */
+                        add_to_hphi(i, 2);
+
+                    } else { /* spin-collinear case */
+                        /* phi(G) -> phi(r) */
+                        phi_to_r(i, 0);
+                        /* multiply by effective potential */
+                        mul_by_veff(fft_coarse_.buffer(), ispn__);
+                        /* V(r)phi(r) -> [V*phi](G) */
+                        vphi_to_G();
+                        /* add kinetic energy */
+                        add_to_hphi(i, 0);
                     }
-                    /* V_{ud}(r)phi_{d}(r) -> [V*phi]_{u}(G) */
-                    vphi_to_G();
-                    /* add to hphi_{u} */
-                    add_to_hphi(i, 2);
+                }
+            };
 
-                } else { /* spin-collinear case */
-                    /* phi(G) -> phi(r) */
-                    phi_to_r(i, 0);
-                    /* multiply by effective potential */
-                    mul_by_veff(fft_coarse_.buffer(), ispn__);
-                    /* V(r)phi(r) -> [V*phi](G) */
-                    vphi_to_G();
-                    /* add kinetic energy */
-                    add_to_hphi(i, 0);
+            for (int ib = 0; ib < num_remap_batches; ib++) {
+                int i_begin = (remap_bs) ? std::min(nwf, ib * remap_bs) : 0;
+                int i_end   = (remap_bs) ? std::min(nwf, (ib + 1) * remap_bs) : nwf;
+                if (remap_bs) {
+                    for (int ispn = 0; ispn < phi__.num_components(); ispn++) {
+                        phi__.component(ispn).pw_coeffs().remap_forward_wait(ib);
+                    }
+                }
+                apply_range(i_begin, i_end);
+                /* send the finished sub-batch back while the next one is transformed */
+                if (remap_bs) {
+                    for (int ispn = 0; ispn < hphi__.num_components(); ispn++) {
+                        hphi__.component(ispn).pw_coeffs().remap_backward_post(ib);
+                    }
                 }
             }
 
             for (int ispn = 0; ispn < hphi__.num_components(); ispn++) {
-                hphi__.component(ispn).pw_coeffs().remap_backward(param_->processing_unit(), gkp.gvec_fft_slab(), n__, idx0__);
+                if (remap_bs) {
+                    hphi__.component(ispn).pw_coeffs().remap_backward_wait();
+                } else {
+                    hphi__.component(ispn).pw_coeffs().remap_backward(param_->processing_unit(), gkp.gvec_fft_slab(), n__, idx0__);
+                }
             }
+
+            fft_coarse_.a2a_single_precision(false);
         }
 
         void apply_h_o(Gvec_partition const& gkvec_par__,
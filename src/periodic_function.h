@@ -250,40 +250,121 @@ class Periodic_function: public Smooth_periodic_function<T>
             }
         }
         
-        /** \todo write and read distributed functions */
+        /// Write the function to the HDF5 storage file.
+        /** Each rank writes its own slab of plane-wave coefficients and its own muffin-tin functions. The
+         *  datasets are created by the root rank and filled with HDF5_tree::write_slab() by all ranks, so no
+         *  gather of the global array is necessary. */
         void hdf5_write(std::string storage_file_name__, std::string path__)
         {
-            //STOP();
-            //if (ctx_.full_potential()) {
-            //    h5f.write("f_mt", f_mt_);
-            //}
-            auto v = this->gather_f_pw();
-            if (ctx_.comm().rank() == 0) {
-                HDF5_tree fout(storage_file_name, false);
-                fout[path__].write("f_pw", reinterpret_cast<double*>(v.data()), static_cast<int>(v.size() * 2));
+            PROFILE("sirius::Periodic_function::hdf5_write");
+
+            int ngv  = gvec_.num_gvec();
+            int nmtp = unit_cell_.max_num_mt_points();
+            int na   = unit_cell_.num_atoms();
+
+            if (comm_.rank() == 0) {
+                HDF5_tree fout(storage_file_name__, false);
+                fout[path__].create_dataset<double>("f_pw", {2, ngv});
+                if (ctx_.full_potential()) {
+                    fout[path__].create_dataset<T>("f_mt", {angular_domain_size_, nmtp, na});
+                }
             }
+            comm_.barrier();
+
+            int nloc = unit_cell_.spl_num_atoms().local_size();
+            int ia0  = (nloc) ? unit_cell_.spl_num_atoms().global_offset() : 0;
+
+            /* pack local muffin-tin functions into a contiguous buffer */
+            mdarray<T, 3> f_mt_buf;
+            if (ctx_.full_potential()) {
+                f_mt_buf = mdarray<T, 3>(angular_domain_size_, nmtp, nloc);
+                f_mt_buf.zero();
+                for (int ialoc = 0; ialoc < nloc; ialoc++) {
+                    int ia = unit_cell_.spl_num_atoms(ialoc);
+                    for (int ir = 0; ir < unit_cell_.atom(ia).num_mt_points(); ir++) {
+                        for (int lm = 0; lm < angular_domain_size_; lm++) {
+                            f_mt_buf(lm, ir, ialoc) = f_mt_local_(ialoc)(lm, ir);
+                        }
+                    }
+                }
+            }
+
+            hdf5_distributed_access(storage_file_name__, comm_, [&](HDF5_tree& fout)
+            {
+                fout[path__].write_slab("f_pw", reinterpret_cast<double const*>(this->f_pw_local_.template at<CPU>()),
+                                        {0, gvec_.offset()}, {2, gvec_.count()});
+                if (ctx_.full_potential()) {
+                    fout[path__].write_slab("f_mt", f_mt_buf.template at<CPU>(),
+                                            {0, 0, ia0}, {angular_domain_size_, nmtp, nloc});
+                }
+            });
         }
 
-        void hdf5_read(HDF5_tree h5f__, mdarray<int, 2>& gvec__)
+        /// Read the function from the HDF5 storage file.
+        /** Each rank reads the slab of stored G-vectors and plane-wave coefficients with the same offset and size
+         *  as its local slab of G-vectors. The G-vector order of the stored run may differ (e.g. when it was
+         *  executed on a different number of ranks), so the stored coefficients are sent to the ranks owning
+         *  the corresponding G-vectors with redistribute_by_gvec(). */
+        void hdf5_read(std::string storage_file_name__, std::string path__)
         {
-            //if (ctx_.full_potential()) {
-            //    h5f.read("f_mt", f_mt_);
-            //}
-            std::vector<double_complex> v(gvec_.num_gvec());
-            h5f__.read("f_pw", reinterpret_cast<double*>(v.data()), static_cast<int>(v.size() * 2));
-
-            std::map<vector3d<int>, int> local_gvec_mapping;
-
-            for (int igloc = 0; igloc < gvec_.count(); igloc++) {
-                int ig = gvec_.offset() + igloc;
-                auto G = gvec_.gvec(ig);
-                local_gvec_mapping[G] = igloc;
+            PROFILE("sirius::Periodic_function::hdf5_read");
+
+            int ngv  = gvec_.num_gvec();
+            int nmtp = unit_cell_.max_num_mt_points();
+
+            mdarray<int, 2> gv(3, gvec_.count());
+            mdarray<double_complex, 2> v(gvec_.count(), 1);
+            int nloc = unit_cell_.spl_num_atoms().local_size();
+            int ia0  = (nloc) ? unit_cell_.spl_num_atoms().global_offset() : 0;
+
+            mdarray<T, 3> f_mt_buf;
+            if (ctx_.full_potential()) {
+                f_mt_buf = mdarray<T, 3>(angular_domain_size_, nmtp, nloc);
             }
 
-            for (int ig = 0; ig < gvec_.num_gvec(); ig++) {
-                vector3d<int> G(&gvec__(0, ig));
-                if (local_gvec_mapping.count(G) != 0) {
-                    this->f_pw_local_[local_gvec_mapping[G]] = v[ig];
+            int format{1};
+            int ngv_stored{-1};
+            hdf5_distributed_access(storage_file_name__, comm_, [&](HDF5_tree& fin)
+            {
+                fin.read_attribute("storage_format", format);
+                if (format != storage_file_format) {
+                    return;
+                }
+                fin["parameters"].read("num_gvec", &ngv_stored, 1);
+                if (ngv_stored != ngv) {
+                    return;
+                }
+                fin["parameters"].read_slab("gvec", gv.at<CPU>(), {0, gvec_.offset()}, {3, gvec_.count()});
+                fin[path__].read_slab("f_pw", reinterpret_cast<double*>(v.at<CPU>()), {0, gvec_.offset()},
+                                      {2, gvec_.count()});
+                if (ctx_.full_potential()) {
+                    fin[path__].read_slab("f_mt", f_mt_buf.template at<CPU>(),
+                                          {0, 0, ia0}, {angular_domain_size_, nmtp, nloc});
+                }
+            });
+            if (format != storage_file_format) {
+                std::stringstream s;
+                s << "storage file " << storage_file_name__ << " has format version " << format
+                  << ", but version " << storage_file_format << " is expected" << std::endl
+                  << "files written by older versions of the code can't be used for restart";
+                TERMINATE(s);
+            }
+            if (ngv_stored != ngv) {
+                TERMINATE("wrong number of G-vectors");
+            }
+
+            /* send the stored coefficients to the ranks owning the G-vectors */
+            mdarray<double_complex, 2> f_pw(this->f_pw_local_.template at<CPU>(), gvec_.count(), 1);
+            redistribute_by_gvec(gvec_, gv, v, f_pw);
+
+            if (ctx_.full_potential()) {
+                for (int ialoc = 0; ialoc < nloc; ialoc++) {
+                    int ia = unit_cell_.spl_num_atoms(ialoc);
+                    for (int ir = 0; ir < unit_cell_.atom(ia).num_mt_points(); ir++) {
+                        for (int lm = 0; lm < angular_domain_size_; lm++) {
+                            f_mt_local_(ialoc)(lm, ir) = f_mt_buf(lm, ir, ialoc);
+                        }
+                    }
                 }
             }
         }
@@ -72,6 +72,11 @@ class Potential
          */
         std::array<std::unique_ptr<Smooth_periodic_function<double>>, 2> vsigma_;
 
+        /// Work functions of the XC potential on the regular grid.
+        /** The functions are kept between the calls to avoid the allocation of the fine-grid arrays on each
+         *  SCF iteration. */
+        std::vector<std::unique_ptr<Smooth_periodic_function<double>>> xc_work_;
+
         std::unique_ptr<Smooth_periodic_function<double>> dveff_;
 
         mdarray<double, 3> sbessel_mom_;
@@ -314,6 +319,22 @@ class Potential
         /// Generate XC potential in the muffin-tins.
         inline void xc_mt(Density const& density__);
     
+        /// Return the i-th work function of the XC potential; the function is allocated on the first access.
+        inline Smooth_periodic_function<double>& xc_work(int i__)
+        {
+            while (static_cast<int>(xc_work_.size()) <= i__) {
+                xc_work_.push_back(std::unique_ptr<Smooth_periodic_function<double>>(
+                    new Smooth_periodic_function<double>(ctx_.fft(), ctx_.gvec())));
+            }
+            return *xc_work_[i__];
+        }
+
+        /// Compute gradient and, optionally, Laplacian of a function in real space.
+        /** Plane-wave coefficients of the function must be available. */
+        inline void xc_gradient_rg(Smooth_periodic_function<double>& f__,
+                                   std::array<Smooth_periodic_function<double>*, 3> grad__,
+                                   Smooth_periodic_function<double>* lapl__);
+
         /// Generate non-magnetic XC potential on the regular real-space grid.
         template <bool add_pseudo_core__>
         inline void xc_rg_nonmagnetic(Density const& density__);
@@ -375,13 +396,13 @@ class Potential
 
                 generate_local_potential();
 
-                for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-                    vsigma_[ispn] = std::unique_ptr<Smooth_periodic_function<double>>(new Smooth_periodic_function<double>(ctx_.fft(), ctx_.gvec()));
-                }
-
                 dveff_ = std::unique_ptr<Smooth_periodic_function<double>>(new Smooth_periodic_function<double>(ctx_.fft(), ctx_.gvec()));
             }
 
+            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+                vsigma_[ispn] = std::unique_ptr<Smooth_periodic_function<double>>(new Smooth_periodic_function<double>(ctx_.fft(), ctx_.gvec()));
+            }
+
             vh_el_ = mdarray<double, 1>(unit_cell_.num_atoms());
 
             if (ctx_.full_potential()) {
@@ -412,7 +433,7 @@ class Potential
 
             /* create list of XC functionals */
             for (auto& xc_label: ctx_.xc_functionals()) {
-                xc_func_.push_back(std::move(XC_functional(xc_label, ctx_.num_spins())));
+                xc_func_.push_back(std::move(XC_functional(xc_label, ctx_.num_spins(), ctx_.control().xc_backend_)));
             }
 
             /* in case of PAW */
@@ -849,20 +870,12 @@ class Potential
         
         inline void load()
         {
-            HDF5_tree fin(storage_file_name, false);
-
-            int ngv;
-            fin.read("/parameters/num_gvec", &ngv, 1);
-            if (ngv != ctx_.gvec().num_gvec()) {
-                TERMINATE("wrong number of G-vectors");
-            }
-            mdarray<int, 2> gv(3, ngv);
-            fin.read("/parameters/gvec", gv);
-
-            effective_potential_->hdf5_read(fin["effective_potential"], gv);
+            effective_potential_->hdf5_read(storage_file_name, "effective_potential");
 
             for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                effective_magnetic_field_[j]->hdf5_read(fin["effective_magnetic_field"][j], gv);
+                std::stringstream s;
+                s << "effective_magnetic_field/" << j;
+                effective_magnetic_field_[j]->hdf5_read(storage_file_name, s.str());
             }
             
             if (ctx_.full_potential()) {
@@ -55,6 +55,9 @@ class Simulation_context: public Simulation_context_base
 
         std::vector<Augmentation_operator> augmentation_op_;
 
+        /// Augmentation operator on the real-space grid around each atom.
+        std::unique_ptr<Augmentation_operator_rg> augmentation_op_rg_;
+
         std::unique_ptr<Beta_projector_chunks> beta_projector_chunks_;
 
         /* copy constructor is forbidden */
@@ -102,10 +105,19 @@ class Simulation_context: public Simulation_context_base
                         MEMORY_USAGE_INFO();
                     }
                 }
+                if (control().augment_real_space_) {
+                    augmentation_op_rg_ = std::unique_ptr<Augmentation_operator_rg>(new Augmentation_operator_rg(*this));
+                }
+
+                /* estimate the local number of G+k vectors; G+k vectors of a k-point are distributed over the band
+                 * communicator */
+                double ngk = fourpi * std::pow(gk_cutoff(), 3) * unit_cell().omega() / 3 / std::pow(twopi, 3);
+                int ngk_loc = static_cast<int>(ngk / comm_band().size()) + 1;
 
-                beta_projector_chunks_ = std::unique_ptr<Beta_projector_chunks>(new Beta_projector_chunks(unit_cell()));
-                if (control().verbosity_ > 1 && comm().rank() == 0) {
-                    beta_projector_chunks_->print_info();
+                beta_projector_chunks_ = std::unique_ptr<Beta_projector_chunks>(
+                    new Beta_projector_chunks(unit_cell(), ngk_loc, control().beta_chunk_memory_));
+                if (control().verbosity_ > 0 && comm().rank() == 0) {
+                    beta_projector_chunks_->print_info(control().verbosity_);
                 }
             }
 
@@ -124,6 +136,11 @@ class Simulation_context: public Simulation_context_base
             return augmentation_op_[iat__];
         }
 
+        inline Augmentation_operator_rg const& augmentation_op_rg() const
+        {
+            return *augmentation_op_rg_;
+        }
+
         inline Beta_projector_chunks const& beta_projector_chunks() const
         {
             return *beta_projector_chunks_;
@@ -85,6 +85,9 @@ class Simulation_context_base: public Simulation_parameters
         mdarray<double_complex, 3> phase_factors_;
 
         mdarray<double_complex, 3> sym_phase_factors_;
+
+        /// Precomputed action of the symmetry operations on the G-vectors of the shell distribution.
+        std::unique_ptr<symmetry_gvec_map> sym_gvec_map_;
         
         mdarray<int, 2> gvec_coord_;
 
@@ -232,6 +235,7 @@ class Simulation_context_base: public Simulation_parameters
             if (comm_.rank() == 0) {
                 /* create new hdf5 file */
                 HDF5_tree fout(storage_file_name, true);
+                fout.write_attribute("storage_format", storage_file_format);
                 fout.create_node("parameters");
                 fout.create_node("effective_potential");
                 fout.create_node("effective_magnetic_field");
@@ -247,17 +251,23 @@ class Simulation_context_base: public Simulation_parameters
                 fout["parameters"].write("num_mag_dims", num_mag_dims());
                 fout["parameters"].write("num_bands", num_bands());
 
-                mdarray<int, 2> gv(3, gvec_.num_gvec());
-                for (int ig = 0; ig < gvec_.num_gvec(); ig++) {
-                    auto G = gvec_.gvec(ig);
-                    for (int x: {0, 1, 2}) {
-                        gv(x, ig) = G[x];
-                    }
-                }
                 fout["parameters"].write("num_gvec", gvec_.num_gvec());
-                fout["parameters"].write("gvec", gv);
+                fout["parameters"].create_dataset<int>("gvec", {3, gvec_.num_gvec()});
             }
             comm_.barrier();
+
+            /* each rank stores its own slab of G-vectors */
+            mdarray<int, 2> gv(3, gvec_.count());
+            for (int igloc = 0; igloc < gvec_.count(); igloc++) {
+                auto G = gvec_.gvec(gvec_.offset() + igloc);
+                for (int x: {0, 1, 2}) {
+                    gv(x, igloc) = G[x];
+                }
+            }
+            hdf5_distributed_access(storage_file_name, comm_, [&](HDF5_tree& fout)
+            {
+                fout["parameters"].write_slab("gvec", gv.at<CPU>(), {0, gvec_.offset()}, {3, gvec_.count()});
+            });
         }
 
         inline std::string const& start_time_tag() const
@@ -329,6 +339,23 @@ class Simulation_context_base: public Simulation_parameters
             }
         }
 
+        /// Generate phase factors \f$ e^{i {\bf G} {\bf r}_{\alpha}} \f$ for all atoms of a given type and a block of local G-vectors.
+        /** Phase factors are stored as phase_factors__(igloc - igloc0__, i), where i is the index of atom inside
+         *  the type. This is a host-only version. */
+        inline void generate_phase_factors(int iat__, int igloc0__, int ngv__, mdarray<double_complex, 2>& phase_factors__) const
+        {
+            int na = unit_cell_.atom_type(iat__).num_atoms();
+            #pragma omp parallel for schedule(static)
+            for (int j = 0; j < ngv__; j++) {
+                auto G = gvec_.gvec(gvec_.offset() + igloc0__ + j);
+                for (int i = 0; i < na; i++) {
+                    int ia = unit_cell_.atom_type(iat__).atom_id(i);
+                    phase_factors__(j, i) = phase_factors_(0, G[0], ia) * phase_factors_(1, G[1], ia) *
+                                            phase_factors_(2, G[2], ia);
+                }
+            }
+        }
+
         /// Make periodic function out of form factors.
         /** Return vector of plane-wave coefficients */
         template <index_domain_t index_domain>
@@ -419,6 +446,11 @@ class Simulation_context_base: public Simulation_parameters
         {
             return sym_phase_factors_;
         }
+
+        symmetry_gvec_map const& sym_gvec_map() const
+        {
+            return *sym_gvec_map_;
+        }
 };
 
 inline void Simulation_context_base::init_fft()
@@ -584,6 +616,9 @@ inline void Simulation_context_base::initialize()
                 }
             }
         }
+
+        sym_gvec_map_ = std::unique_ptr<symmetry_gvec_map>(new symmetry_gvec_map(unit_cell().symmetry(), remap_gvec(),
+                                                                                 sym_phase_factors_));
     }
     
     /* take 10% of empty non-magnetic states */
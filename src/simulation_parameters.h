@@ -234,6 +234,21 @@ class Simulation_parameters
             control_input_.verbosity_ = level__;
         }
 
+        inline void set_augment_real_space(bool augment_real_space__)
+        {
+            control_input_.augment_real_space_ = augment_real_space__;
+        }
+
+        inline void set_aug_block_size(int aug_block_size__)
+        {
+            control_input_.aug_block_size_ = aug_block_size__;
+        }
+
+        inline void set_aug_cache_memory(double aug_cache_memory__)
+        {
+            control_input_.aug_cache_memory_ = aug_cache_memory__;
+        }
+
         inline int lmax_apw() const
         {
             return parameters_input_.lmax_apw_;
@@ -474,6 +489,11 @@ class Simulation_parameters
             iterative_solver_input_.energy_tolerance_ = tolerance__;
         }
 
+        inline void set_iterative_solver_type(std::string type__)
+        {
+            iterative_solver_input_.type_ = type__;
+        }
+
         inline Control_input const& control() const
         {
             return control_input_;
@@ -107,6 +107,13 @@ namespace sirius {
         fftw_cleanup();
         sddk::stop_global_timer();
         sddk::timer::print_tree();
+        sddk::timer::write_trace("sirius_trace.json");
+        if (sddk::mdarray_mem_pool::instance().enabled()) {
+            if (mpi_comm_world().rank() == 0) {
+                sddk::mdarray_mem_pool::instance().print_stat();
+            }
+            sddk::mdarray_mem_pool::instance().release();
+        }
         if (call_mpi_fin__) {
             Communicator::finalize();
         }
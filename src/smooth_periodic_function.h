@@ -60,6 +60,8 @@ class Smooth_periodic_function
         /// Distribution of G-vectors inside FFT slab.
         block_data_descriptor gvec_fft_slab_;
 
+    public:
+
         /// Gather plane-wave coefficients for the subsequent FFT call.
         inline void gather_f_pw_fft()
         {
@@ -72,8 +74,6 @@ class Smooth_periodic_function
                                               gvec_fft_slab_.offsets.data());
         }
 
-    public:
-
         /// Default constructor.
         Smooth_periodic_function() 
         {
@@ -327,6 +327,71 @@ inline Smooth_periodic_function<double> laplacian(Smooth_periodic_function<doubl
     return std::move(g);
 }
 
+/// Backward transform of a set of real functions with a single batched FFT.
+/** The functions are packed in pairs into complex functions \f$ f_{2i} + i f_{2i+1} \f$ such that a half of
+ *  the transformations is saved; all pairs share one all-to-all exchange of the z-sticks. For the GPU FFT driver
+ *  the functions are transformed one by one. */
+inline void fft_transform_batch(std::vector<Smooth_periodic_function<double>*> const& f__)
+{
+    PROFILE("sirius::fft_transform_batch");
+
+    if (f__.empty()) {
+        return;
+    }
+
+    auto& fft  = f__[0]->fft();
+    auto& gvec = f__[0]->gvec();
+
+    if (fft.pu() != CPU) {
+        for (auto f: f__) {
+            f->fft_transform(1);
+        }
+        return;
+    }
+
+    int n   = static_cast<int>(f__.size());
+    int np  = (n + 1) / 2;
+    int ngv = gvec.partition().gvec_count_fft();
+
+    for (auto f: f__) {
+        f->gather_f_pw_fft();
+    }
+
+    if (gvec.reduced()) {
+        /* FFT driver packs the pairs of real functions itself */
+        mdarray<double_complex, 2> f_pw(ngv, 2 * np);
+        f_pw.zero();
+        for (int i = 0; i < n; i++) {
+            std::memcpy(&f_pw(0, i), &f__[i]->f_pw_fft(0), ngv * sizeof(double_complex));
+        }
+        fft.transform_batch<1>(2 * np, f_pw.at<CPU>(), f_pw.ld());
+    } else {
+        /* Fourier transform of f_{2i} + i f_{2i+1} */
+        mdarray<double_complex, 2> f_pw(ngv, np);
+        #pragma omp parallel for schedule(static)
+        for (int ig = 0; ig < ngv; ig++) {
+            for (int i = 0; i < np; i++) {
+                f_pw(ig, i) = f__[2 * i]->f_pw_fft(ig);
+                if (2 * i + 1 < n) {
+                    f_pw(ig, i) += double_complex(0, 1) * f__[2 * i + 1]->f_pw_fft(ig);
+                }
+            }
+        }
+        fft.transform_batch<1>(np, f_pw.at<CPU>(), f_pw.ld());
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int ir = 0; ir < fft.local_size(); ir++) {
+        for (int i = 0; i < np; i++) {
+            auto z = fft.buffer_batch()(ir, i);
+            f__[2 * i]->f_rg(ir) = z.real();
+            if (2 * i + 1 < n) {
+                f__[2 * i + 1]->f_rg(ir) = z.imag();
+            }
+        }
+    }
+}
+
 template <typename T>
 Smooth_periodic_function<T> operator*(Smooth_periodic_function_gradient<T>& grad_f__, 
                                       Smooth_periodic_function_gradient<T>& grad_g__)
@@ -72,6 +72,8 @@ struct magnetic_group_symmetry_descriptor
     matrix3d<double> spin_rotation;
 };
 
+struct symmetry_gvec_map;
+
 class Symmetry
 {
     private:
@@ -292,19 +294,21 @@ class Symmetry
          */
         void symmetrize_function(double_complex* f_pw__, 
                                  remap_gvec_to_shells const& remap_gvec__,
-                                 mdarray<double_complex, 3> const& sym_phase_factors__) const;
+                                 symmetry_gvec_map const& sym_gvec__) const;
         
         //void symmetrize_function(double_complex* f_pw__,
         //                         Gvec const& gvec__,
         //                         Communicator const& comm__) const;
 
         void symmetrize_vector_function(double_complex* fz_pw__,
-                                        remap_gvec_to_shells const& remap_gvec__) const;
+                                        remap_gvec_to_shells const& remap_gvec__,
+                                        symmetry_gvec_map const& sym_gvec__) const;
 
         void symmetrize_vector_function(double_complex* fx_pw__,
                                         double_complex* fy_pw__,
                                         double_complex* fz_pw__,
-                                        remap_gvec_to_shells const& remap_gvec__) const;
+                                        remap_gvec_to_shells const& remap_gvec__,
+                                        symmetry_gvec_map const& sym_gvec__) const;
 
         //void symmetrize_function(double_complex* f_pw__,
         //                         Gvec const& gvec__,
@@ -347,6 +351,223 @@ class Symmetry
         }
 };
 
+
+/// Precomputed action of the magnetic group symmetry operations on the local G-vectors of the shell distribution.
+/** Rotated G-vector belongs to the same shell and thus to the same MPI rank of the remap_gvec_to_shells
+ *  distribution. Indices of the rotated G-vectors and the phase factors \f$ e^{i{\bf G t}} \f$ are computed once
+ *  for a given set of G-vectors and reused by all calls to the plane-wave symmetrization. Local G-vectors are also
+ *  sorted by shells, such that the shells can be split between OpenMP threads in contiguous ranges of a similar
+ *  number of G-vectors; each thread then updates only the G-vectors of its own shells. */
+struct symmetry_gvec_map
+{
+    /// Local G-vector indices sorted by shells.
+    std::vector<int> gvec_by_shell;
+
+    /// Offsets of the local shells in the gvec_by_shell list.
+    std::vector<int> shell_offsets;
+
+    /// Index of the rotated G-vector for each symmetry operation and local G-vector.
+    /** If only the inverse of the rotated G-vector is stored (reduced G-vectors), the index is encoded as -(ig + 1)
+     *  and the complex conjugate of the rotated coefficient has to be taken. */
+    mdarray<int, 2> idx_rot;
+
+    /// Column of the phase_factors array for each symmetry operation or -1 if fractional translation is zero.
+    std::vector<int> phase_idx;
+
+    /// Phase factors for the symmetry operations with non-zero fractional translation.
+    mdarray<double_complex, 2> phase_factors;
+
+    symmetry_gvec_map(Symmetry const& sym__,
+                      remap_gvec_to_shells const& remap_gvec__,
+                      mdarray<double_complex, 3> const& sym_phase_factors__)
+    {
+        PROFILE("sirius::symmetry_gvec_map");
+
+        int ngv  = remap_gvec__.a2a_recv.size();
+        int nsym = sym__.num_mag_sym();
+
+        /* sort local G-vectors by shells */
+        std::vector<std::pair<int, int>> tmp(ngv);
+        for (int igloc = 0; igloc < ngv; igloc++) {
+            tmp[igloc] = std::pair<int, int>(remap_gvec__.gvec_shell_remapped(igloc), igloc);
+        }
+        std::sort(tmp.begin(), tmp.end());
+        gvec_by_shell = std::vector<int>(ngv);
+        shell_offsets.clear();
+        for (int i = 0; i < ngv; i++) {
+            gvec_by_shell[i] = tmp[i].second;
+            if (i == 0 || tmp[i].first != tmp[i - 1].first) {
+                shell_offsets.push_back(i);
+            }
+        }
+        shell_offsets.push_back(ngv);
+
+        phase_idx = std::vector<int>(nsym, -1);
+        int nph{0};
+        for (int isym = 0; isym < nsym; isym++) {
+            auto t = sym__.magnetic_group_symmetry(isym).spg_op.t;
+            if (std::abs(t[0]) + std::abs(t[1]) + std::abs(t[2]) > 1e-10) {
+                phase_idx[isym] = nph++;
+            }
+        }
+
+        idx_rot       = mdarray<int, 2>(nsym, ngv, memory_t::host, "symmetry_gvec_map::idx_rot");
+        phase_factors = mdarray<double_complex, 2>(std::max(nph, 1), ngv, memory_t::host,
+                                                   "symmetry_gvec_map::phase_factors");
+
+        #pragma omp parallel for schedule(static)
+        for (int igloc = 0; igloc < ngv; igloc++) {
+            vector3d<int> G(&remap_gvec__.gvec_remapped_(0, igloc));
+            for (int isym = 0; isym < nsym; isym++) {
+                /* apply symmetry operation to the G-vector;
+                 * remember that we move R from acting on x to acting on G: G(Rx) = (GR)x;
+                 * GR is a vector-matrix multiplication [G][.....]
+                 *                                         [..R..]
+                 *                                         [.....]
+                 * which can also be written as matrix^{T}-vector operation
+                 */
+                auto R      = sym__.magnetic_group_symmetry(isym).spg_op.R;
+                auto gv_rot = transpose(R) * G;
+                /* index of a rotated G-vector */
+                int ig_rot = remap_gvec__.index_by_gvec(gv_rot);
+                if (ig_rot == -1) {
+                    gv_rot = gv_rot * (-1);
+                    ig_rot = remap_gvec__.index_by_gvec(gv_rot);
+                    if (ig_rot < 0 || ig_rot >= ngv) {
+                        TERMINATE("rotated G-vector is not found");
+                    }
+                    idx_rot(isym, igloc) = -ig_rot - 1;
+                } else {
+                    idx_rot(isym, igloc) = ig_rot;
+                }
+                if (phase_idx[isym] >= 0) {
+                    phase_factors(phase_idx[isym], igloc) = sym_phase_factors__(0, G[0], isym) *
+                                                            sym_phase_factors__(1, G[1], isym) *
+                                                            sym_phase_factors__(2, G[2], isym);
+                }
+            }
+        }
+    }
+
+    /// Number of local G-vector shells.
+    inline int num_shells() const
+    {
+        return static_cast<int>(shell_offsets.size()) - 1;
+    }
+
+    /// First local shell of the thread; shells [first_shell(tid), first_shell(tid + 1)) are handled by the thread.
+    inline int first_shell(int tid__, int num_threads__) const
+    {
+        if (tid__ >= num_threads__) {
+            return num_shells();
+        }
+        /* split the G-vectors evenly and align the boundary to the beginning of the shell */
+        int ng = static_cast<int>(gvec_by_shell.size());
+        int n  = static_cast<int>((static_cast<long long>(ng) * tid__) / num_threads__);
+        auto it = std::lower_bound(shell_offsets.begin(), shell_offsets.end() - 1, n);
+        return static_cast<int>(it - shell_offsets.begin());
+    }
+
+    /// Phase factor of the symmetry operation for the local G-vector.
+    inline double_complex phase(int isym__, int igloc__) const
+    {
+        return (phase_idx[isym__] < 0) ? double_complex(1, 0) : phase_factors(phase_idx[isym__], igloc__);
+    }
+};
+
+
+/// Spatial hash of the atomic positions in fractional coordinates.
+/** Unit cell is split into a regular grid of boxes with the size not smaller than the tolerance, such that an atom
+ *  within the tolerance of a given point is located in the same box or in one of the neighbouring boxes, taking into
+ *  account the periodic boundary conditions. This makes the search of the equivalent atom independent of the
+ *  number of atoms. */
+class atom_position_grid
+{
+  private:
+    /// Positions of atoms in fractional coordinates.
+    mdarray<double, 2> const& positions_;
+
+    double tolerance_;
+
+    /// Number of boxes along each lattice vector.
+    int n_;
+
+    /// Offsets of the boxes in the atoms_ list.
+    std::vector<int> box_offsets_;
+
+    /// List of atoms sorted by boxes.
+    std::vector<int> atoms_;
+
+    /// Index of the box along one dimension for the reduced fractional coordinate.
+    inline int box_coord(double x__) const
+    {
+        x__ -= std::floor(x__);
+        return std::min(n_ - 1, static_cast<int>(x__ * n_));
+    }
+
+    inline int box_index(int i0__, int i1__, int i2__) const
+    {
+        return (i0__ * n_ + i1__) * n_ + i2__;
+    }
+
+  public:
+    atom_position_grid(mdarray<double, 2> const& positions__, int num_atoms__, double tolerance__)
+        : positions_(positions__)
+        , tolerance_(tolerance__)
+    {
+        /* box size must be larger than the tolerance; on average one atom in a box */
+        int nmax = static_cast<int>(1.0 / std::max(tolerance__, 1e-6));
+        n_ = std::max(1, std::min(nmax, static_cast<int>(std::ceil(std::pow(num_atoms__, 1.0 / 3)))));
+
+        std::vector<int> box(num_atoms__);
+        box_offsets_ = std::vector<int>(n_ * n_ * n_ + 1, 0);
+        for (int ia = 0; ia < num_atoms__; ia++) {
+            box[ia] = box_index(box_coord(positions_(0, ia)), box_coord(positions_(1, ia)),
+                                box_coord(positions_(2, ia)));
+            box_offsets_[box[ia] + 1]++;
+        }
+        for (int i = 0; i < n_ * n_ * n_; i++) {
+            box_offsets_[i + 1] += box_offsets_[i];
+        }
+        atoms_ = std::vector<int>(num_atoms__);
+        std::vector<int> counts(n_ * n_ * n_, 0);
+        for (int ia = 0; ia < num_atoms__; ia++) {
+            atoms_[box_offsets_[box[ia]] + counts[box[ia]]++] = ia;
+        }
+    }
+
+    /// Find the atom located within the tolerance of a given point in fractional coordinates.
+    /** Returns -1 if there is no such atom. */
+    int find(vector3d<double> v__) const
+    {
+        int i0[] = {box_coord(v__[0]), box_coord(v__[1]), box_coord(v__[2])};
+        /* in case of less than three boxes the neighbours are repeated */
+        int nd = std::min(n_, 3);
+        int d[] = {0, -1, 1};
+        for (int d0 = 0; d0 < nd; d0++) {
+            for (int d1 = 0; d1 < nd; d1++) {
+                for (int d2 = 0; d2 < nd; d2++) {
+                    int b = box_index((i0[0] + d[d0] + n_) % n_, (i0[1] + d[d1] + n_) % n_,
+                                      (i0[2] + d[d2] + n_) % n_);
+                    for (int i = box_offsets_[b]; i < box_offsets_[b + 1]; i++) {
+                        int ia = atoms_[i];
+                        /* minimum image distance in fractional coordinates */
+                        vector3d<double> dr;
+                        for (int x: {0, 1, 2}) {
+                            dr[x] = v__[x] - positions_(x, ia);
+                            dr[x] -= std::round(dr[x]);
+                        }
+                        if (dr.length() < tolerance_) {
+                            return ia;
+                        }
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+};
+
 inline Symmetry::Symmetry(matrix3d<double>& lattice_vectors__,  
                           int num_atoms__,
                           mdarray<double, 2>& positions__,
@@ -433,45 +654,44 @@ inline Symmetry::Symmetry(matrix3d<double>& lattice_vectors__,
     t2.stop();
 
     sddk::timer t3("sirius::Symmetry::Symmetry|sym2");
+    atom_position_grid pos_grid(positions_, num_atoms_, tolerance_);
     sym_table_ = mdarray<int, 2>(num_atoms_, num_spg_sym());
+    int num_not_found{0};
     /* loop over spatial symmetries */
+    #pragma omp parallel for schedule(static) reduction(+:num_not_found)
     for (int isym = 0; isym < num_spg_sym(); isym++) {
+        auto R = space_group_symmetry(isym).R;
+        auto t = space_group_symmetry(isym).t;
         for (int ia = 0; ia < num_atoms_; ia++) {
-            auto R = space_group_symmetry(isym).R;
-            auto t = space_group_symmetry(isym).t;
             /* spatial transform */
-            vector3d<double> pos(positions__(0, ia), positions__(1, ia), positions__(2, ia));
-            auto v = reduce_coordinates(R * pos + t);
-
-            int ja = -1;
+            vector3d<double> pos(positions_(0, ia), positions_(1, ia), positions_(2, ia));
             /* check for equivalent atom */
-            for (int k = 0; k < num_atoms_; k++) {
-                vector3d<double> pos1(positions__(0, k), positions__(1, k), positions__(2, k));
-                if ((v.first - pos1).length() < tolerance_) {
-                    ja = k;
-                    break;
-                }
-            }
-
+            int ja = pos_grid.find(R * pos + t);
             if (ja == -1) {
-                TERMINATE("equivalent atom was not found");
+                num_not_found++;
             }
             sym_table_(ia, isym) = ja;
         }
     }
+    if (num_not_found) {
+        TERMINATE("equivalent atom was not found");
+    }
     t3.stop();
     
     sddk::timer t4("sirius::Symmetry::Symmetry|sym3");
+    /* index of the first spin symmetry under which all atoms transform for each spatial symmetry */
+    std::vector<int> spin_sym(num_spg_sym(), -1);
     /* loop over spatial symmetries */
+    #pragma omp parallel for schedule(dynamic)
     for (int isym = 0; isym < num_spg_sym(); isym++) {
         /* loop over spin symmetries */
         for (int jsym = 0; jsym < num_spg_sym(); jsym++) {
             /* take proper part of rotation matrix */
             auto Rspin = space_group_symmetry(jsym).rotation;
             
-            int n{0};
+            bool ok{true};
             /* check if all atoms transfrom under spatial and spin symmetries */
-            for (int ia = 0; ia < num_atoms_; ia++) {
+            for (int ia = 0; ia < num_atoms_ && ok; ia++) {
                 int ja = sym_table_(ia, isym);
 
                 /* now check tha vector filed transforms from atom ia to atom ja */
@@ -479,21 +699,24 @@ inline Symmetry::Symmetry(matrix3d<double>& lattice_vectors__,
                 auto vd = Rspin * vector3d<double>(spins__(0, ia), spins__(1, ia), spins__(2, ia)) -
                                   vector3d<double>(spins__(0, ja), spins__(1, ja), spins__(2, ja));
 
-                if (vd.length() < 1e-10) {
-                    n++;
-                }
+                ok = (vd.length() < 1e-10);
             }
-            /* if all atoms transform under spin rotaion, add it to a list */
-            if (n == num_atoms_) {
-                magnetic_group_symmetry_descriptor mag_op;
-                mag_op.spg_op        = space_group_symmetry(isym);
-                mag_op.isym          = isym;
-                mag_op.spin_rotation = Rspin;
-                magnetic_group_symmetry_.push_back(mag_op);
+            if (ok) {
+                spin_sym[isym] = jsym;
                 break;
             }
         }
     }
+    /* if all atoms transform under spin rotaion, add it to a list */
+    for (int isym = 0; isym < num_spg_sym(); isym++) {
+        if (spin_sym[isym] >= 0) {
+            magnetic_group_symmetry_descriptor mag_op;
+            mag_op.spg_op        = space_group_symmetry(isym);
+            mag_op.isym          = isym;
+            mag_op.spin_rotation = space_group_symmetry(spin_sym[isym]).rotation;
+            magnetic_group_symmetry_.push_back(mag_op);
+        }
+    }
     t4.stop();
 }
 
@@ -682,7 +905,7 @@ inline void Symmetry::check_gvec_symmetry(Gvec const& gvec__, Communicator const
 
 inline void Symmetry::symmetrize_function(double_complex* f_pw__,
                                           remap_gvec_to_shells const& remap_gvec__,
-                                          mdarray<double_complex, 3> const& sym_phase_factors__) const
+                                          symmetry_gvec_map const& sym_gvec__) const
 {
     PROFILE("sirius::Symmetry::symmetrize_function_pw");
 
@@ -693,45 +916,22 @@ inline void Symmetry::symmetrize_function(double_complex* f_pw__,
     sddk::timer t1("sirius::Symmetry::symmetrize_function_pw|local");
     #pragma omp parallel
     {
-        int nt = omp_get_max_threads();
+        /* per-thread time shows the imbalance of the distribution of G-shells between threads */
+        sddk::timer t2("sirius::Symmetry::symmetrize_function_pw|thread");
+        int nt = omp_get_num_threads();
         int tid = omp_get_thread_num();
 
-        for (int igloc = 0; igloc < remap_gvec__.a2a_recv.size(); igloc++) {
-            vector3d<int> G(&remap_gvec__.gvec_remapped_(0, igloc));
-
-            int igsh = remap_gvec__.gvec_shell_remapped(igloc);
-
-            if (igsh % nt == tid) {
-
-                for (int i = 0; i < num_mag_sym(); i++) {
+        /* rotated G-vector stays in the same shell, so each thread updates only the G-vectors of its own shells */
+        for (int igsh = sym_gvec__.first_shell(tid, nt); igsh < sym_gvec__.first_shell(tid + 1, nt); igsh++) {
+            for (int i = sym_gvec__.shell_offsets[igsh]; i < sym_gvec__.shell_offsets[igsh + 1]; i++) {
+                int igloc = sym_gvec__.gvec_by_shell[i];
+                for (int isym = 0; isym < num_mag_sym(); isym++) {
                     /* full space-group symmetry operation is {R|t} */
-                    auto R = magnetic_group_symmetry(i).spg_op.R;
-                    //auto t = magnetic_group_symmetry(i).spg_op.t;
-                
-                    //double_complex z = v[igloc] * std::exp(double_complex(0, twopi * (G * t)));
-                    double_complex z = v[igloc] * sym_phase_factors__(0, G[0], i) *
-                                                  sym_phase_factors__(1, G[1], i) *
-                                                  sym_phase_factors__(2, G[2], i);
-
-                    /* apply symmetry operation to the G-vector;
-                     * remember that we move R from acting on x to acting on G: G(Rx) = (GR)x;
-                     * GR is a vector-matrix multiplication [G][.....]
-                     *                                         [..R..]
-                     *                                         [.....]
-                     * which can also be written as matrix^{T}-vector operation
-                     */
-                    auto gv_rot = transpose(R) * G;
-
-                    /* index of a rotated G-vector */
-                    int ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-
-                    if (ig_rot == -1) {
-                        gv_rot = gv_rot * (-1);
-                        ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-                        assert(ig_rot >=0 && ig_rot < (int)v.size());
-                        sym_f_pw[ig_rot] += std::conj(z);
+                    double_complex z = v[igloc] * sym_gvec__.phase(isym, igloc);
+                    int ig_rot = sym_gvec__.idx_rot(isym, igloc);
+                    if (ig_rot < 0) {
+                        sym_f_pw[-ig_rot - 1] += std::conj(z);
                     } else {
-                        assert(ig_rot >=0 && ig_rot < (int)v.size());
                         sym_f_pw[ig_rot] += z;
                     }
                 }
@@ -989,51 +1189,34 @@ inline void Symmetry::symmetrize_function(double_complex* f_pw__,
 //    }
 //}
 inline void Symmetry::symmetrize_vector_function(double_complex* fz_pw__,
-                                                 remap_gvec_to_shells const& remap_gvec__) const
+                                                 remap_gvec_to_shells const& remap_gvec__,
+                                                 symmetry_gvec_map const& sym_gvec__) const
 {
     PROFILE("sirius::Symmetry::symmetrize_vector_function_pw");
     
     auto v = remap_gvec__.remap_forward(fz_pw__);
 
     std::vector<double_complex> sym_f_pw(v.size(), 0);
-    
-    double* ptr = (double*)&sym_f_pw[0];
-
-    #pragma omp parallel for
-    for (int i = 0; i < num_mag_sym(); i++) {
-        /* full space-group symmetry operation is {R|t} */
-        auto R = magnetic_group_symmetry(i).spg_op.R;
-        auto t = magnetic_group_symmetry(i).spg_op.t;
-        auto S = magnetic_group_symmetry(i).spin_rotation;
-
-        for (int igloc = 0; igloc < remap_gvec__.a2a_recv.size(); igloc++) {
-            vector3d<int> G(&remap_gvec__.gvec_remapped_(0, igloc));
-
-            double_complex z = v[igloc] * std::exp(double_complex(0, twopi * (G * t))) * S(2, 2);
-
-            auto gv_rot = transpose(R) * G;
-
-            /* index of a rotated G-vector */
-            int ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-            
-            if (ig_rot == -1) {
-                gv_rot = gv_rot * (-1);
-                ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-                assert(ig_rot >=0 && ig_rot < (int)v.size());
 
-                #pragma omp atomic update
-                ptr[2 * ig_rot] += z.real();
-
-                #pragma omp atomic update
-                ptr[2 * ig_rot + 1] -= z.imag();
-            } else {
-                assert(ig_rot >=0 && ig_rot < (int)v.size());
+    #pragma omp parallel
+    {
+        int nt = omp_get_num_threads();
+        int tid = omp_get_thread_num();
 
-                #pragma omp atomic update
-                ptr[2 * ig_rot] += z.real();
+        for (int igsh = sym_gvec__.first_shell(tid, nt); igsh < sym_gvec__.first_shell(tid + 1, nt); igsh++) {
+            for (int i = sym_gvec__.shell_offsets[igsh]; i < sym_gvec__.shell_offsets[igsh + 1]; i++) {
+                int igloc = sym_gvec__.gvec_by_shell[i];
+                for (int isym = 0; isym < num_mag_sym(); isym++) {
+                    auto S = magnetic_group_symmetry(isym).spin_rotation;
 
-                #pragma omp atomic update
-                ptr[2 * ig_rot + 1] += z.imag();
+                    double_complex z = v[igloc] * sym_gvec__.phase(isym, igloc) * S(2, 2);
+                    int ig_rot = sym_gvec__.idx_rot(isym, igloc);
+                    if (ig_rot < 0) {
+                        sym_f_pw[-ig_rot - 1] += std::conj(z);
+                    } else {
+                        sym_f_pw[ig_rot] += z;
+                    }
+                }
             }
         }
     }
@@ -1151,7 +1334,8 @@ inline void Symmetry::symmetrize_vector_function(double_complex* fz_pw__,
 inline void Symmetry::symmetrize_vector_function(double_complex* fx_pw__,
                                                  double_complex* fy_pw__,
                                                  double_complex* fz_pw__,
-                                                 remap_gvec_to_shells const& remap_gvec__) const
+                                                 remap_gvec_to_shells const& remap_gvec__,
+                                                 symmetry_gvec_map const& sym_gvec__) const
 {
     PROFILE("sirius::Symmetry::symmetrize_vector_function_pw");
 
@@ -1162,80 +1346,34 @@ inline void Symmetry::symmetrize_vector_function(double_complex* fx_pw__,
     std::vector<double_complex> sym_fx_pw(vx.size(), 0);
     std::vector<double_complex> sym_fy_pw(vx.size(), 0);
     std::vector<double_complex> sym_fz_pw(vx.size(), 0);
-    
-    double* ptr_x = (double*)&sym_fx_pw[0];
-    double* ptr_y = (double*)&sym_fy_pw[0];
-    double* ptr_z = (double*)&sym_fz_pw[0];
-
-    //std::vector<double_complex*> v_pw_in({fx_pw__, fy_pw__, fz_pw__});
-
-    #pragma omp parallel for
-    for (int i = 0; i < num_mag_sym(); i++) {
-        /* full space-group symmetry operation is {R|t} */
-        auto R = magnetic_group_symmetry(i).spg_op.R;
-        auto t = magnetic_group_symmetry(i).spg_op.t;
-        auto S = magnetic_group_symmetry(i).spin_rotation;
-
-        for (int igloc = 0; igloc < remap_gvec__.a2a_recv.size(); igloc++) {
-            vector3d<int> G(&remap_gvec__.gvec_remapped_(0, igloc));
-
-            //auto gv_rot = transpose(R) * gvec__.gvec(ig);
-
-            /* index of a rotated G-vector */
-            //int ig_rot = gvec__.index_by_gvec(gv_rot);
-
-            double_complex phase = std::exp(double_complex(0, twopi * (G * t)));
-            vector3d<double_complex> v_rot;
-            for (int j: {0, 1, 2}) {
-                v_rot[j] = phase * (S(j, 0) * vx[igloc] + S(j, 1) * vy[igloc] + S(j, 2) * vz[igloc]);
-            }
-
-            auto gv_rot = transpose(R) * G;
-            /* index of a rotated G-vector */
-            int ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-
-            if (ig_rot == -1) {
-                gv_rot = gv_rot * (-1);
-                ig_rot = remap_gvec__.index_by_gvec(gv_rot);
-                assert(ig_rot >=0 && ig_rot < (int)vx.size());
 
-                #pragma omp atomic update
-                ptr_x[2 * ig_rot] += v_rot[0].real();
-
-                #pragma omp atomic update
-                ptr_y[2 * ig_rot] += v_rot[1].real();
-
-                #pragma omp atomic update
-                ptr_z[2 * ig_rot] += v_rot[2].real();
-
-                #pragma omp atomic update
-                ptr_x[2 * ig_rot + 1] -= v_rot[0].imag();
-                
-                #pragma omp atomic update
-                ptr_y[2 * ig_rot + 1] -= v_rot[1].imag();
-
-                #pragma omp atomic update
-                ptr_z[2 * ig_rot + 1] -= v_rot[2].imag();
-            } else {
-                assert(ig_rot >=0 && ig_rot < (int)vx.size());
-
-                #pragma omp atomic update
-                ptr_x[2 * ig_rot] += v_rot[0].real();
-
-                #pragma omp atomic update
-                ptr_y[2 * ig_rot] += v_rot[1].real();
-
-                #pragma omp atomic update
-                ptr_z[2 * ig_rot] += v_rot[2].real();
+    #pragma omp parallel
+    {
+        int nt = omp_get_num_threads();
+        int tid = omp_get_thread_num();
 
-                #pragma omp atomic update
-                ptr_x[2 * ig_rot + 1] += v_rot[0].imag();
-                
-                #pragma omp atomic update
-                ptr_y[2 * ig_rot + 1] += v_rot[1].imag();
+        for (int igsh = sym_gvec__.first_shell(tid, nt); igsh < sym_gvec__.first_shell(tid + 1, nt); igsh++) {
+            for (int i = sym_gvec__.shell_offsets[igsh]; i < sym_gvec__.shell_offsets[igsh + 1]; i++) {
+                int igloc = sym_gvec__.gvec_by_shell[i];
+                for (int isym = 0; isym < num_mag_sym(); isym++) {
+                    auto S = magnetic_group_symmetry(isym).spin_rotation;
 
-                #pragma omp atomic update
-                ptr_z[2 * ig_rot + 1] += v_rot[2].imag();
+                    double_complex phase = sym_gvec__.phase(isym, igloc);
+                    vector3d<double_complex> v_rot;
+                    for (int j: {0, 1, 2}) {
+                        v_rot[j] = phase * (S(j, 0) * vx[igloc] + S(j, 1) * vy[igloc] + S(j, 2) * vz[igloc]);
+                    }
+                    int ig_rot = sym_gvec__.idx_rot(isym, igloc);
+                    if (ig_rot < 0) {
+                        sym_fx_pw[-ig_rot - 1] += std::conj(v_rot[0]);
+                        sym_fy_pw[-ig_rot - 1] += std::conj(v_rot[1]);
+                        sym_fz_pw[-ig_rot - 1] += std::conj(v_rot[2]);
+                    } else {
+                        sym_fx_pw[ig_rot] += v_rot[0];
+                        sym_fy_pw[ig_rot] += v_rot[1];
+                        sym_fz_pw[ig_rot] += v_rot[2];
+                    }
+                }
             }
         }
     }
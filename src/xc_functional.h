@@ -28,6 +28,7 @@
 #include <xc.h>
 #include <string.h>
 #include "utils.h"
+#include "xc_functional_native.h"
 
 namespace sirius {
 
@@ -396,6 +397,17 @@ const std::map<std::string, int> libxc_functionals = {
     {"XC_HYB_MGGA_XC_WB97M_V", XC_HYB_MGGA_XC_WB97M_V} /* Mardirossian and Head-Gordon */
 };
 
+/// Backend for the evaluation of XC functionals.
+enum class xc_backend_t
+{
+    /// Always use libxc.
+    libxc,
+    /// Use built-in implementation when available and libxc otherwise.
+    native,
+    /// Use libxc and check the built-in implementation against it.
+    validate
+};
+
 /// Interface class to Libxc.
 class XC_functional
 {
@@ -407,6 +419,48 @@ class XC_functional
         
         xc_func_type handler_;
 
+        /// Type of the built-in implementation of this functional.
+        xc_native_t native_{xc_native_t::none};
+
+        /// Backend used to evaluate the functional.
+        xc_backend_t backend_{xc_backend_t::libxc};
+
+        /// True if the built-in implementation has already been reported to differ from libxc.
+        bool validation_failed_{false};
+
+        /// True if built-in implementation is used.
+        inline bool use_native() const
+        {
+            return native_ != xc_native_t::none && backend_ != xc_backend_t::libxc;
+        }
+
+        /// Compare the result of the built-in implementation with libxc.
+        void validate(std::string label__, int size__, double const* native__, double const* libxc__)
+        {
+            /* relative tolerance */
+            const double tol{1e-8};
+
+            double diff{0};
+            int idx{0};
+            for (int i = 0; i < size__; i++) {
+                double d = std::abs(native__[i] - libxc__[i]) / (1 + std::abs(libxc__[i]));
+                if (d > diff) {
+                    diff = d;
+                    idx  = i;
+                }
+            }
+            if (diff > tol) {
+                #pragma omp critical
+                if (!validation_failed_) {
+                    validation_failed_ = true;
+                    std::stringstream s;
+                    s << "built-in implementation of " << libxc_name_ << " differs from libxc" << std::endl
+                      << "  " << label__ << " : " << native__[idx] << " (built-in) " << libxc__[idx] << " (libxc)";
+                    WARNING(s);
+                }
+            }
+        }
+
         /* forbid copy constructor */
         XC_functional(const XC_functional& src) = delete;
 
@@ -417,10 +471,25 @@ class XC_functional
 
     public:
 
-        XC_functional(const std::string libxc_name__, int num_spins__)
+        /// Constructor.
+        /** \param [in] libxc_name Name of the functional in libxc.
+         *  \param [in] num_spins  Number of spin components.
+         *  \param [in] backend    One of "libxc", "native" or "validate". */
+        XC_functional(const std::string libxc_name__, int num_spins__, std::string backend__ = "libxc")
             : libxc_name_(libxc_name__),
               num_spins_(num_spins__)
         {
+            std::map<std::string, xc_backend_t> const backends = {{"libxc",    xc_backend_t::libxc},
+                                                                  {"native",   xc_backend_t::native},
+                                                                  {"validate", xc_backend_t::validate}};
+            if (backends.count(backend__) == 0) {
+                std::stringstream s;
+                s << "wrong XC backend: " << backend__;
+                TERMINATE(s);
+            }
+            backend_ = backends.at(backend__);
+            native_  = get_xc_native_t(libxc_name_);
+
             /* check if functional name is in list */
             if (libxc_functionals.count(libxc_name_) == 0) {
                 std::stringstream s;
@@ -432,6 +501,10 @@ class XC_functional
             if (xc_func_init(&handler_, libxc_functionals.at(libxc_name_), num_spins_) != 0) {
                 TERMINATE("xc_func_init() failed");
             }
+            /* libxc and the built-in implementation treat the same low densities as zero */
+            if (native_ != xc_native_t::none) {
+                xc_func_set_dens_threshold(&handler_, xc_native::rho_min);
+            }
 
             initialized_ = true;
         }
@@ -441,6 +514,8 @@ class XC_functional
             this->libxc_name_  = src__.libxc_name_;
             this->num_spins_   = src__.num_spins_;
             this->handler_     = src__.handler_;
+            this->native_      = src__.native_;
+            this->backend_     = src__.backend_;
             this->initialized_ = true;
             src__.initialized_ = false;
         }
@@ -512,6 +587,10 @@ class XC_functional
         void set_relativistic(bool enabled__)
         {
             if (is_exchange()) {
+                /* built-in Slater exchange is non-relativistic */
+                if (enabled__ && native_ == xc_native_t::lda_x) {
+                    native_ = xc_native_t::none;
+                }
                 if (enabled__) {
                     xc_lda_x_set_params(&handler_, 4.0/3.0, XC_RELATIVISTIC, 0.0);
                 } else {
@@ -539,6 +618,20 @@ class XC_functional
                 }
             }
 
+            if (use_native()) {
+                if (backend_ == xc_backend_t::validate) {
+                    std::vector<double> v_n(size);
+                    std::vector<double> e_n(size);
+                    xc_native::lda(native_, size, rho, v_n.data(), e_n.data());
+                    xc_lda_exc_vxc(&handler_, size, rho, e, v);
+                    validate("vxc", size, v_n.data(), v);
+                    validate("exc", size, e_n.data(), e);
+                } else {
+                    xc_native::lda(native_, size, rho, v, e);
+                }
+                return;
+            }
+
             xc_lda_exc_vxc(&handler_, size, rho, e, v);
         }
 
@@ -554,8 +647,7 @@ class XC_functional
                 TERMINATE("wrong XC");
             }
 
-            std::vector<double> rho_ud(size * 2);
-            /* check and rearrange density */
+            /* check density */
             for (int i = 0; i < size; i++) {
                 if (rho_up[i] < 0 || rho_dn[i] < 0) {
                     std::stringstream s;
@@ -563,7 +655,16 @@ class XC_functional
                       << " " << Utils::double_to_string(rho_dn[i]);
                     TERMINATE(s);
                 }
-                
+            }
+
+            if (backend_ == xc_backend_t::native && use_native()) {
+                xc_native::lda(native_, size, rho_up, rho_dn, v_up, v_dn, e);
+                return;
+            }
+
+            std::vector<double> rho_ud(size * 2);
+            /* rearrange density */
+            for (int i = 0; i < size; i++) {
                 rho_ud[2 * i]     = rho_up[i];
                 rho_ud[2 * i + 1] = rho_dn[i];
             }
@@ -577,6 +678,16 @@ class XC_functional
                 v_up[i] = v_ud[2 * i];
                 v_dn[i] = v_ud[2 * i + 1];
             }
+
+            if (backend_ == xc_backend_t::validate && use_native()) {
+                std::vector<double> v_up_n(size);
+                std::vector<double> v_dn_n(size);
+                std::vector<double> e_n(size);
+                xc_native::lda(native_, size, rho_up, rho_dn, v_up_n.data(), v_dn_n.data(), e_n.data());
+                validate("vxc_up", size, v_up_n.data(), v_up);
+                validate("vxc_dn", size, v_dn_n.data(), v_dn);
+                validate("exc", size, e_n.data(), e);
+            }
         }
 
         void add_lda(const int size,
@@ -586,33 +697,15 @@ class XC_functional
                      double* v_dn,
                      double* e)
         {
-            if (family() != XC_FAMILY_LDA) {
-                TERMINATE("wrong XC");
-            }
-
-            std::vector<double> rho_ud(size * 2);
-            /* check and rearrange density */
-            for (int i = 0; i < size; i++) {
-                if (rho_up[i] < 0 || rho_dn[i] < 0) {
-                    std::stringstream s;
-                    s << "rho is negative : " << Utils::double_to_string(rho_up[i]) 
-                      << " " << Utils::double_to_string(rho_dn[i]);
-                    TERMINATE(s);
-                }
-                
-                rho_ud[2 * i]     = rho_up[i];
-                rho_ud[2 * i + 1] = rho_dn[i];
-            }
-            
-            std::vector<double> v_ud(size * 2);
+            std::vector<double> v_up_tmp(size);
+            std::vector<double> v_dn_tmp(size);
             std::vector<double> e_tmp(size);
 
-            xc_lda_exc_vxc(&handler_, size, &rho_ud[0], &e_tmp[0], &v_ud[0]);
-            
-            /* extract potential */
+            get_lda(size, rho_up, rho_dn, v_up_tmp.data(), v_dn_tmp.data(), e_tmp.data());
+
             for (int i = 0; i < size; i++) {
-                v_up[i] += v_ud[2 * i];
-                v_dn[i] += v_ud[2 * i + 1];
+                v_up[i] += v_up_tmp[i];
+                v_dn[i] += v_dn_tmp[i];
                 e[i]    += e_tmp[i];
             }
         }
@@ -638,6 +731,22 @@ class XC_functional
                 }
             }
 
+            if (use_native()) {
+                if (backend_ == xc_backend_t::validate) {
+                    std::vector<double> vrho_n(size);
+                    std::vector<double> vsigma_n(size);
+                    std::vector<double> e_n(size);
+                    xc_native::gga(native_, size, rho, sigma, vrho_n.data(), vsigma_n.data(), e_n.data());
+                    xc_gga_exc_vxc(&handler_, size, rho, sigma, e, vrho, vsigma);
+                    validate("vrho", size, vrho_n.data(), vrho);
+                    validate("vsigma", size, vsigma_n.data(), vsigma);
+                    validate("exc", size, e_n.data(), e);
+                } else {
+                    xc_native::gga(native_, size, rho, sigma, vrho, vsigma, e);
+                }
+                return;
+            }
+
             xc_gga_exc_vxc(&handler_, size, rho, sigma, e, vrho, vsigma);
         }
 
@@ -657,10 +766,7 @@ class XC_functional
         {
             if (family() != XC_FAMILY_GGA) TERMINATE("wrong XC");
 
-            std::vector<double> rho(2 * size);
-            std::vector<double> sigma(3 * size);
-            /* check and rearrange density */
-            /* rearrange sigma as well */
+            /* check density */
             for (int i = 0; i < size; i++)
             {
                 if (rho_up[i] < 0 || rho_dn[i] < 0)
@@ -670,7 +776,20 @@ class XC_functional
                       << " " << Utils::double_to_string(rho_dn[i]);
                     TERMINATE(s);
                 }
-                
+            }
+
+            if (backend_ == xc_backend_t::native && use_native()) {
+                xc_native::gga(native_, size, rho_up, rho_dn, sigma_uu, sigma_ud, sigma_dd, vrho_up, vrho_dn,
+                               vsigma_uu, vsigma_ud, vsigma_dd, e);
+                return;
+            }
+
+            std::vector<double> rho(2 * size);
+            std::vector<double> sigma(3 * size);
+            /* rearrange density */
+            /* rearrange sigma as well */
+            for (int i = 0; i < size; i++)
+            {
                 rho[2 * i] = rho_up[i];
                 rho[2 * i + 1] = rho_dn[i];
 
@@ -694,6 +813,18 @@ class XC_functional
                 vsigma_ud[i] = vsigma[3 * i + 1];
                 vsigma_dd[i] = vsigma[3 * i + 2];
             }
+
+            if (backend_ == xc_backend_t::validate && use_native()) {
+                mdarray<double, 2> v_n(size, 6);
+                xc_native::gga(native_, size, rho_up, rho_dn, sigma_uu, sigma_ud, sigma_dd, &v_n(0, 0), &v_n(0, 1),
+                               &v_n(0, 2), &v_n(0, 3), &v_n(0, 4), &v_n(0, 5));
+                validate("vrho_up", size, &v_n(0, 0), vrho_up);
+                validate("vrho_dn", size, &v_n(0, 1), vrho_dn);
+                validate("vsigma_uu", size, &v_n(0, 2), vsigma_uu);
+                validate("vsigma_ud", size, &v_n(0, 3), vsigma_ud);
+                validate("vsigma_dd", size, &v_n(0, 4), vsigma_dd);
+                validate("exc", size, &v_n(0, 5), e);
+            }
         }
 };
 
@@ -0,0 +1,682 @@
+// Copyright (c) 2013-2017 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file xc_functional_native.h
+ *
+ *  \brief Built-in implementation of the most common LDA and GGA functionals.
+ *
+ *  The functionals are evaluated with the same parameters as in libxc. The loops over points contain neither
+ *  branches nor floating-point comparisons nor calls to the libm functions: the thresholds are applied with
+ *  bit masks and the elementary functions are evaluated by the inline routines below, which use only
+ *  arithmetic and integer bit operations. This way the loops are vectorized already with the basic
+ *  "-O3" flags (no "-ffast-math", no vector math library); "make xc_native_vec" in apps/unit_tests checks
+ *  this with GCC.
+ */
+
+#ifndef __XC_FUNCTIONAL_NATIVE_H__
+#define __XC_FUNCTIONAL_NATIVE_H__
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace sirius {
+
+/// Functionals with the built-in implementation.
+enum class xc_native_t
+{
+    /// No built-in implementation.
+    none,
+    /// Slater exchange.
+    lda_x,
+    /// Perdew-Zunger correlation.
+    lda_c_pz,
+    /// Perdew-Wang correlation.
+    lda_c_pw,
+    /// Perdew-Wang correlation with the modified parameters.
+    lda_c_pw_mod,
+    /// PBE exchange.
+    gga_x_pbe,
+    /// PBEsol exchange.
+    gga_x_pbe_sol,
+    /// PBE correlation.
+    gga_c_pbe,
+    /// PBEsol correlation.
+    gga_c_pbe_sol
+};
+
+/// Get the type of the built-in functional by the libxc name.
+inline xc_native_t get_xc_native_t(std::string name__)
+{
+    std::map<std::string, xc_native_t> const m = {
+        {"XC_LDA_X",         xc_native_t::lda_x},
+        {"XC_LDA_C_PZ",      xc_native_t::lda_c_pz},
+        {"XC_LDA_C_PW",      xc_native_t::lda_c_pw},
+        {"XC_LDA_C_PW_MOD",  xc_native_t::lda_c_pw_mod},
+        {"XC_GGA_X_PBE",     xc_native_t::gga_x_pbe},
+        {"XC_GGA_X_PBE_SOL", xc_native_t::gga_x_pbe_sol},
+        {"XC_GGA_C_PBE",     xc_native_t::gga_c_pbe},
+        {"XC_GGA_C_PBE_SOL", xc_native_t::gga_c_pbe_sol}
+    };
+    if (m.count(name__)) {
+        return m.at(name__);
+    }
+    return xc_native_t::none;
+}
+
+namespace xc_native {
+
+/* The point functions must be inlined into the loops, otherwise the loops are not vectorized. */
+#if defined(__GNUC__)
+#define XC_NATIVE_INLINE inline __attribute__((always_inline))
+#else
+#define XC_NATIVE_INLINE inline
+#endif
+
+/// Density below this value is treated as zero; XC_functional sets the same threshold in libxc.
+const double rho_min = 1e-15;
+
+/// Maximum value of the relative spin polarization.
+const double zeta_max = 1 - 1e-12;
+
+/// Prefactor of the Slater exchange energy: \f$ \frac{3}{4} (\frac{3}{\pi})^{1/3} \f$.
+const double cx = 0.7385587663820224;
+
+/// \f$ (3\pi^2)^{1/3} \f$
+const double c_kf = 3.0936677262801355;
+
+/// \f$ (\frac{3}{4\pi})^{1/3} \f$
+const double c_rs = 0.6203504908994001;
+
+/// \f$ 2^{4/3} - 2 \f$
+const double c_fz = 0.5198420997897464;
+
+/// \f$ \gamma = (1 - \ln 2) / \pi^2 \f$ of the PBE correlation.
+const double pbe_gamma = 0.031090690869654895;
+
+/// \f$ \kappa \f$ of the PBE exchange.
+const double pbe_kappa = 0.804;
+
+/// Reinterpret the bits of a double as an unsigned integer.
+XC_NATIVE_INLINE uint64_t as_uint(double x__)
+{
+    uint64_t u;
+    std::memcpy(&u, &x__, sizeof(double));
+    return u;
+}
+
+/// Reinterpret the bits of an unsigned integer as a double.
+XC_NATIVE_INLINE double as_double(uint64_t u__)
+{
+    double x;
+    std::memcpy(&x, &u__, sizeof(double));
+    return x;
+}
+
+/// Mask with all bits set if a >= b and with no bits set otherwise.
+/** The sign bit of a - b is used instead of the floating-point comparison, which the compiler doesn't
+ *  vectorize without "-fno-trapping-math". */
+XC_NATIVE_INLINE uint64_t mask_ge(double a__, double b__)
+{
+    return (as_uint(a__ - b__) >> 63) - 1;
+}
+
+/// Select a where the mask is set and b otherwise.
+XC_NATIVE_INLINE double select(uint64_t mask__, double a__, double b__)
+{
+    return as_double((as_uint(a__) & mask__) | (as_uint(b__) & ~mask__));
+}
+
+/// Keep x where the mask is set and return zero otherwise.
+XC_NATIVE_INLINE double keep(uint64_t mask__, double x__)
+{
+    return as_double(as_uint(x__) & mask__);
+}
+
+/// Maximum of two numbers.
+XC_NATIVE_INLINE double simd_max(double a__, double b__)
+{
+    return select(mask_ge(a__, b__), a__, b__);
+}
+
+/// Minimum of two numbers.
+XC_NATIVE_INLINE double simd_min(double a__, double b__)
+{
+    return select(mask_ge(a__, b__), b__, a__);
+}
+
+/// 2^52 + 2^51; adding and subtracting it rounds a double of magnitude below 2^51 to the nearest integer.
+const double round_shift = 6755399441055744.0;
+
+/// Round to the nearest integer.
+XC_NATIVE_INLINE double round_int(double x__)
+{
+    return (x__ + round_shift) - round_shift;
+}
+
+/// 2^n for the integer n in [-1022, 1023] stored as a double.
+XC_NATIVE_INLINE double pow2(double n__)
+{
+    /* the lowest bits of the mantissa of n + round_shift hold n in two's complement */
+    return as_double((as_uint(n__ + round_shift) + 1023) << 52);
+}
+
+/// Split a positive normal number into x = 2^k m with 1 <= m < 2; k is returned as a double.
+XC_NATIVE_INLINE double split_exp(double x__, double& m__)
+{
+    uint64_t u = as_uint(x__);
+    m__ = as_double((u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    /* the biased exponent is converted to double by placing it in the mantissa of 2^52 */
+    return as_double((u >> 52) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023);
+}
+
+/// Square root of a non-negative number; zero and subnormal numbers give zero.
+XC_NATIVE_INLINE double simd_sqrt(double x__)
+{
+    double m;
+    double k = split_exp(x__, m);
+    /* x = 2^(2q) w with 1 <= w < 4 */
+    double q = round_int(0.5 * (k - 0.5));
+    double w = m * (1 + (k - 2 * q));
+    /* initial approximation with relative error of 1% followed by the Newton iterations */
+    double y = 0.54293186 + w * (0.50215794 - 0.03475006 * w);
+    y = 0.5 * (y + w / y);
+    y = 0.5 * (y + w / y);
+    y = 0.5 * (y + w / y);
+    return keep(mask_ge(x__, 2.2250738585072014e-308), pow2(q) * y);
+}
+
+/// Cubic root of a non-negative number; zero and subnormal numbers give zero.
+XC_NATIVE_INLINE double simd_cbrt(double x__)
+{
+    double m;
+    double k = split_exp(x__, m);
+    /* x = 2^(3q) w with 1/2 <= w < 4 */
+    double q = round_int(k / 3);
+    double r = k - 3 * q;
+    double w = m * (1 + r * (0.75 + 0.25 * r));
+    /* initial approximation with relative error of 4% followed by the Halley iterations */
+    double y = 0.64590932 + w * (0.37502650 - 0.03542681 * w);
+    double y3 = y * y * y;
+    y *= (y3 + 2 * w) / (2 * y3 + w);
+    y3 = y * y * y;
+    y *= (y3 + 2 * w) / (2 * y3 + w);
+    y3 = y * y * y;
+    y *= (y3 + 2 * w) / (2 * y3 + w);
+    return keep(mask_ge(x__, 2.2250738585072014e-308), pow2(q) * y);
+}
+
+/// Natural logarithm of a positive normal number.
+/** Same reduction and polynomial as in the FreeBSD / musl implementation of log(). */
+XC_NATIVE_INLINE double simd_log(double x__)
+{
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    /* x = 2^k m with sqrt(2)/2 <= m < sqrt(2) */
+    uint64_t u = as_uint(x__) + (0x3ff0000000000000ULL - 0x3fe6a09e667f3bcdULL);
+    double k = as_double((u >> 52) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023);
+    double f = as_double((u & 0x000fffffffffffffULL) + 0x3fe6a09e667f3bcdULL) - 1;
+
+    double hfsq = 0.5 * f * f;
+    double s    = f / (2 + f);
+    double z    = s * s;
+    double w    = z * z;
+    double t1   = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 + w * 1.531383769920937332e-01));
+    double t2   = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 + w * (1.818357216161805012e-01 +
+                  w * 1.479819860511658591e-01)));
+    return s * (hfsq + t1 + t2) + k * ln2_lo - hfsq + f + k * ln2_hi;
+}
+
+/// exp(x) - 1 for |x| < 700, accurate also for small |x|.
+XC_NATIVE_INLINE double simd_expm1(double x__)
+{
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    /* x = n ln(2) + r with |r| <= ln(2) / 2 */
+    double n = round_int(x__ * 1.44269504088896338700e+00);
+    double r = (x__ - n * ln2_hi) - n * ln2_lo;
+    /* exp(r) - 1 by the Taylor series; the truncation error is below 1e-17 */
+    double p = 1.0 / 479001600;
+    p = 1.0 / 39916800 + r * p;
+    p = 1.0 / 3628800 + r * p;
+    p = 1.0 / 362880 + r * p;
+    p = 1.0 / 40320 + r * p;
+    p = 1.0 / 5040 + r * p;
+    p = 1.0 / 720 + r * p;
+    p = 1.0 / 120 + r * p;
+    p = 1.0 / 24 + r * p;
+    p = 1.0 / 6 + r * p;
+    p = 0.5 + r * p;
+    p = r + r * r * p;
+    /* exp(x) - 1 = 2^n (exp(r) - 1) + 2^n - 1 */
+    double t = pow2(n);
+    return t * p + (t - 1);
+}
+
+/// Parameters of the Perdew-Wang interpolation of correlation energy.
+struct pw_param_t
+{
+    double A[3];
+    double alpha1[3];
+    double beta1[3];
+    double beta2[3];
+    double beta3[3];
+    double beta4[3];
+    /// Second derivative of the spin-interpolation function at zero polarization.
+    double fz20;
+};
+
+/// Parameters for the paramagnetic, ferromagnetic and spin-stiffness fits.
+inline pw_param_t const& pw_param(bool mod__)
+{
+    static pw_param_t const p = {{0.031091,  0.015545,   0.016887 },
+                                 {0.21370,   0.20548,    0.11125  },
+                                 {7.5957,    14.1189,    10.357   },
+                                 {3.5876,    6.1977,     3.6231   },
+                                 {1.6382,    3.3662,     0.88026  },
+                                 {0.49294,   0.62517,    0.49671  },
+                                 1.709921};
+    static pw_param_t const p_mod = {{0.0310907, 0.01554535, 0.0168869},
+                                     {0.21370,   0.20548,    0.11125  },
+                                     {7.5957,    14.1189,    10.357   },
+                                     {3.5876,    6.1977,     3.6231   },
+                                     {1.6382,    3.3662,     0.88026  },
+                                     {0.49294,   0.62517,    0.49671  },
+                                     1.709920934161365617563962776245};
+    return (mod__) ? p_mod : p;
+}
+
+/// Perdew-Wang fit G(rs) and its derivative with respect to rs.
+XC_NATIVE_INLINE void pw_g(pw_param_t const& p__, int i__, double rs__, double& g__, double& dg__)
+{
+    double sr = simd_sqrt(rs__);
+    double A  = p__.A[i__];
+    double q0 = -2 * A * (1 + p__.alpha1[i__] * rs__);
+    double q1 = 2 * A * sr * (p__.beta1[i__] + sr * (p__.beta2[i__] + sr * (p__.beta3[i__] + sr * p__.beta4[i__])));
+    double dq1 = A * (p__.beta1[i__] / sr + 2 * p__.beta2[i__] + 3 * p__.beta3[i__] * sr + 4 * p__.beta4[i__] * rs__);
+    double l = simd_log(1 + 1 / q1);
+
+    g__  = q0 * l;
+    dg__ = -2 * A * p__.alpha1[i__] * l - q0 * dq1 / (q1 * q1 + q1);
+}
+
+/// Spin-interpolation function f(zeta) and its derivative.
+XC_NATIVE_INLINE void spin_f(double z__, double& f__, double& df__)
+{
+    double a = simd_cbrt(1 + z__);
+    double b = simd_cbrt(1 - z__);
+    f__  = (a * (1 + z__) + b * (1 - z__) - 2) / c_fz;
+    df__ = 4.0 * (a - b) / 3 / c_fz;
+}
+
+/// Perdew-Wang correlation energy and its derivatives with respect to rs and zeta.
+XC_NATIVE_INLINE void pw_point(pw_param_t const& p__, double rs__, double z__, double& ec__, double& ec_rs__, double& ec_z__)
+{
+    double ec0, ec0_rs, ec1, ec1_rs, ga, ga_rs;
+    pw_g(p__, 0, rs__, ec0, ec0_rs);
+    pw_g(p__, 1, rs__, ec1, ec1_rs);
+    /* fit of the negative spin stiffness */
+    pw_g(p__, 2, rs__, ga, ga_rs);
+
+    double f, df;
+    spin_f(z__, f, df);
+    double z3 = z__ * z__ * z__;
+    double z4 = z3 * z__;
+
+    ec__    = ec0 - ga * f * (1 - z4) / p__.fz20 + (ec1 - ec0) * f * z4;
+    ec_rs__ = ec0_rs - ga_rs * f * (1 - z4) / p__.fz20 + (ec1_rs - ec0_rs) * f * z4;
+    ec_z__  = -ga * (df * (1 - z4) - 4 * z3 * f) / p__.fz20 + (ec1 - ec0) * (df * z4 + 4 * z3 * f);
+}
+
+/// Perdew-Zunger fit of the correlation energy and its derivative with respect to rs.
+XC_NATIVE_INLINE void pz_ec(int i__, double rs__, double& ec__, double& ec_rs__)
+{
+    const double gamma[] = {-0.1423, -0.0843};
+    const double beta1[] = {1.0529, 1.3981};
+    const double beta2[] = {0.3334, 0.2611};
+    const double a[]     = {0.0311, 0.01555};
+    const double b[]     = {-0.048, -0.0269};
+    const double c[]     = {0.0020, 0.0007};
+    const double d[]     = {-0.0116, -0.0048};
+
+    double sr  = simd_sqrt(rs__);
+    double den = 1 + beta1[i__] * sr + beta2[i__] * rs__;
+    double lrs = simd_log(rs__);
+
+    /* low density */
+    double ec1    = gamma[i__] / den;
+    double ec1_rs = -gamma[i__] * (0.5 * beta1[i__] / sr + beta2[i__]) / (den * den);
+    /* high density */
+    double ec2    = a[i__] * lrs + b[i__] + c[i__] * rs__ * lrs + d[i__] * rs__;
+    double ec2_rs = a[i__] / rs__ + c[i__] * (lrs + 1) + d[i__];
+
+    auto low = mask_ge(rs__, 1);
+    ec__    = select(low, ec1, ec2);
+    ec_rs__ = select(low, ec1_rs, ec2_rs);
+}
+
+/// Perdew-Zunger correlation energy and its derivatives with respect to rs and zeta.
+XC_NATIVE_INLINE void pz_point(double rs__, double z__, double& ec__, double& ec_rs__, double& ec_z__)
+{
+    double ec0, ec0_rs, ec1, ec1_rs;
+    pz_ec(0, rs__, ec0, ec0_rs);
+    pz_ec(1, rs__, ec1, ec1_rs);
+
+    double f, df;
+    spin_f(z__, f, df);
+
+    ec__    = ec0 + f * (ec1 - ec0);
+    ec_rs__ = ec0_rs + f * (ec1_rs - ec0_rs);
+    ec_z__  = df * (ec1 - ec0);
+}
+
+/// PBE exchange of the spin-unpolarized density.
+XC_NATIVE_INLINE void pbe_x_point(double mu__, double rho__, double sigma__, double& e__, double& vrho__, double& vsigma__)
+{
+    double rho13 = simd_cbrt(rho__);
+    double ex    = -cx * rho13;
+    /* 1 / (4 k_F^2 rho^2) */
+    double c     = 1.0 / (4 * (c_kf * rho13 * rho__) * (c_kf * rho13 * rho__));
+    double s2    = sigma__ * c;
+    double d     = 1 + mu__ * s2 / pbe_kappa;
+    double fx    = 1 + pbe_kappa - pbe_kappa / d;
+    double dfx   = mu__ / (d * d);
+
+    e__      = ex * fx;
+    vrho__   = ex * (4 * fx - 8 * s2 * dfx) / 3;
+    vsigma__ = rho__ * ex * dfx * c;
+}
+
+/// PBE correlation.
+/** Input is the total density, spin polarization, total sigma and the LDA correlation energy with its
+ *  derivatives. */
+XC_NATIVE_INLINE void pbe_c_point(double beta__, double rho__, double z__, double sigma__, double rs__, double ec__,
+                        double ec_rs__, double ec_z__, double& e__, double& vrho_up__, double& vrho_dn__,
+                        double& vsigma__)
+{
+    double a     = simd_cbrt(1 + z__);
+    double b     = simd_cbrt(1 - z__);
+    double phi   = 0.5 * (a * a + b * b);
+    double phi_z = (1 / a - 1 / b) / 3;
+    double phi3  = phi * phi * phi;
+
+    double kf  = c_kf * simd_cbrt(rho__);
+    /* 1 / (4 phi^2 k_s^2 rho^2) */
+    double c   = 1.0 / (4 * phi * phi * (4 * kf / pi) * rho__ * rho__);
+    double t2  = sigma__ * c;
+
+    double bg  = beta__ / pbe_gamma;
+    double em1 = simd_expm1(-ec__ / (pbe_gamma * phi3));
+    double A   = bg / em1;
+    double E   = em1 + 1;
+
+    double At  = A * t2;
+    double num = 1 + At;
+    double den = 1 + At + At * At;
+    double y   = bg * t2 * num / den;
+    double y_t2 = bg * (num / den + t2 * (A * den - num * (A + 2 * A * At)) / (den * den));
+    double y_A  = bg * t2 * t2 * (den - num * (1 + 2 * At)) / (den * den);
+
+    double H    = pbe_gamma * phi3 * simd_log(1 + y);
+    double g    = pbe_gamma * phi3 / (1 + y);
+    double A_ec = A * A * E / (beta__ * phi3);
+    double A_phi = -3 * A * A * E * ec__ / (beta__ * phi3 * phi);
+
+    double H_t2  = g * y_t2;
+    double H_ec  = g * y_A * A_ec;
+    double H_phi = 3 * H / phi + g * y_A * A_phi;
+
+    /* rho * d/drho at fixed zeta */
+    double rho_ec_rho = -rs__ * ec_rs__ / 3;
+    double rho_H_rho  = H_ec * rho_ec_rho - 7 * H_t2 * t2 / 3;
+    /* d/dzeta at fixed rho */
+    double H_z = H_ec * ec_z__ + H_phi * phi_z - 2 * H_t2 * t2 * phi_z / phi;
+
+    e__       = ec__ + H;
+    double v0 = ec__ + H + rho_ec_rho + rho_H_rho;
+    vrho_up__ = v0 + (1 - z__) * (ec_z__ + H_z);
+    vrho_dn__ = v0 - (1 + z__) * (ec_z__ + H_z);
+    vsigma__  = rho__ * H_t2 * c;
+}
+
+/// Spin-unpolarized LDA.
+inline void lda(xc_native_t type__, int size__, double const* rho__, double* v__, double* e__)
+{
+    bool pw_mod = (type__ == xc_native_t::lda_c_pw_mod);
+
+    switch (type__) {
+        case xc_native_t::lda_x: {
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                double ex = -cx * simd_cbrt(rho__[i]);
+                e__[i] = ex;
+                v__[i] = 4 * ex / 3;
+            }
+            break;
+        }
+        case xc_native_t::lda_c_pz: {
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                auto m = mask_ge(rho__[i], rho_min);
+                double rs = c_rs / simd_cbrt(select(m, rho__[i], rho_min));
+                double ec, ec_rs;
+                pz_ec(0, rs, ec, ec_rs);
+                e__[i] = keep(m, ec);
+                v__[i] = keep(m, ec - rs * ec_rs / 3);
+            }
+            break;
+        }
+        case xc_native_t::lda_c_pw:
+        case xc_native_t::lda_c_pw_mod: {
+            auto p = pw_param(pw_mod);
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                auto m = mask_ge(rho__[i], rho_min);
+                double rs = c_rs / simd_cbrt(select(m, rho__[i], rho_min));
+                double ec, ec_rs;
+                pw_g(p, 0, rs, ec, ec_rs);
+                e__[i] = keep(m, ec);
+                v__[i] = keep(m, ec - rs * ec_rs / 3);
+            }
+            break;
+        }
+        default: {
+            TERMINATE("not a built-in LDA functional");
+        }
+    }
+}
+
+/// Spin-polarized LDA.
+inline void lda(xc_native_t type__, int size__, double const* rho_up__, double const* rho_dn__, double* v_up__,
+                double* v_dn__, double* e__)
+{
+    bool pw_mod = (type__ == xc_native_t::lda_c_pw_mod);
+
+    switch (type__) {
+        case xc_native_t::lda_x: {
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                /* spin scaling: E_x[rho_up, rho_dn] = (E_x[2 rho_up] + E_x[2 rho_dn]) / 2 */
+                double ex_up = -cx * simd_cbrt(2 * rho_up__[i]);
+                double ex_dn = -cx * simd_cbrt(2 * rho_dn__[i]);
+                double r = simd_max(rho_up__[i] + rho_dn__[i], rho_min);
+                e__[i]    = (rho_up__[i] * ex_up + rho_dn__[i] * ex_dn) / r;
+                v_up__[i] = 4 * ex_up / 3;
+                v_dn__[i] = 4 * ex_dn / 3;
+            }
+            break;
+        }
+        case xc_native_t::lda_c_pz: {
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                double rho = rho_up__[i] + rho_dn__[i];
+                auto m = mask_ge(rho, rho_min);
+                double r = select(m, rho, rho_min);
+                double z = simd_max(simd_min((rho_up__[i] - rho_dn__[i]) / r, zeta_max), -zeta_max);
+                double rs = c_rs / simd_cbrt(r);
+                double ec, ec_rs, ec_z;
+                pz_point(rs, z, ec, ec_rs, ec_z);
+                double v = ec - rs * ec_rs / 3;
+                e__[i]    = keep(m, ec);
+                v_up__[i] = keep(m, v + (1 - z) * ec_z);
+                v_dn__[i] = keep(m, v - (1 + z) * ec_z);
+            }
+            break;
+        }
+        case xc_native_t::lda_c_pw:
+        case xc_native_t::lda_c_pw_mod: {
+            auto p = pw_param(pw_mod);
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                double rho = rho_up__[i] + rho_dn__[i];
+                auto m = mask_ge(rho, rho_min);
+                double r = select(m, rho, rho_min);
+                double z = simd_max(simd_min((rho_up__[i] - rho_dn__[i]) / r, zeta_max), -zeta_max);
+                double rs = c_rs / simd_cbrt(r);
+                double ec, ec_rs, ec_z;
+                pw_point(p, rs, z, ec, ec_rs, ec_z);
+                double v = ec - rs * ec_rs / 3;
+                e__[i]    = keep(m, ec);
+                v_up__[i] = keep(m, v + (1 - z) * ec_z);
+                v_dn__[i] = keep(m, v - (1 + z) * ec_z);
+            }
+            break;
+        }
+        default: {
+            TERMINATE("not a built-in LDA functional");
+        }
+    }
+}
+
+/// Spin-unpolarized GGA.
+inline void gga(xc_native_t type__, int size__, double const* rho__, double const* sigma__, double* vrho__,
+                double* vsigma__, double* e__)
+{
+    switch (type__) {
+        case xc_native_t::gga_x_pbe:
+        case xc_native_t::gga_x_pbe_sol: {
+            double mu = (type__ == xc_native_t::gga_x_pbe) ? 0.2195149727645171 : 10.0 / 81;
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                auto m = mask_ge(rho__[i], rho_min);
+                double e, vrho, vsigma;
+                pbe_x_point(mu, select(m, rho__[i], rho_min), sigma__[i], e, vrho, vsigma);
+                e__[i]      = keep(m, e);
+                vrho__[i]   = keep(m, vrho);
+                vsigma__[i] = keep(m, vsigma);
+            }
+            break;
+        }
+        case xc_native_t::gga_c_pbe:
+        case xc_native_t::gga_c_pbe_sol: {
+            double beta = (type__ == xc_native_t::gga_c_pbe) ? 0.06672455060314922 : 0.046;
+            /* PBE correlation is built on top of the modified Perdew-Wang LDA */
+            auto p = pw_param(true);
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                auto m = mask_ge(rho__[i], rho_min);
+                double r = select(m, rho__[i], rho_min);
+                double rs = c_rs / simd_cbrt(r);
+                double ec, ec_rs;
+                pw_g(p, 0, rs, ec, ec_rs);
+                double e, vrho, vrho1, vsigma;
+                pbe_c_point(beta, r, 0, sigma__[i], rs, ec, ec_rs, 0, e, vrho, vrho1, vsigma);
+                e__[i]      = keep(m, e);
+                vrho__[i]   = keep(m, vrho);
+                vsigma__[i] = keep(m, vsigma);
+            }
+            break;
+        }
+        default: {
+            TERMINATE("not a built-in GGA functional");
+        }
+    }
+}
+
+/// Spin-polarized GGA.
+inline void gga(xc_native_t type__, int size__, double const* rho_up__, double const* rho_dn__,
+                double const* sigma_uu__, double const* sigma_ud__, double const* sigma_dd__, double* vrho_up__,
+                double* vrho_dn__, double* vsigma_uu__, double* vsigma_ud__, double* vsigma_dd__, double* e__)
+{
+    switch (type__) {
+        case xc_native_t::gga_x_pbe:
+        case xc_native_t::gga_x_pbe_sol: {
+            double mu = (type__ == xc_native_t::gga_x_pbe) ? 0.2195149727645171 : 10.0 / 81;
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                /* spin scaling: E_x[rho_up, rho_dn] = (E_x[2 rho_up] + E_x[2 rho_dn]) / 2 */
+                auto up = mask_ge(2 * rho_up__[i], rho_min);
+                auto dn = mask_ge(2 * rho_dn__[i], rho_min);
+                double e_up, vrho_up, vsigma_up, e_dn, vrho_dn, vsigma_dn;
+                pbe_x_point(mu, select(up, 2 * rho_up__[i], rho_min), 4 * sigma_uu__[i], e_up, vrho_up, vsigma_up);
+                pbe_x_point(mu, select(dn, 2 * rho_dn__[i], rho_min), 4 * sigma_dd__[i], e_dn, vrho_dn, vsigma_dn);
+
+                double rho = rho_up__[i] + rho_dn__[i];
+                auto m = mask_ge(rho, rho_min);
+                e__[i] = keep(m, (keep(up, rho_up__[i] * e_up) + keep(dn, rho_dn__[i] * e_dn)) /
+                                 select(m, rho, rho_min));
+                vrho_up__[i]   = keep(up, vrho_up);
+                vrho_dn__[i]   = keep(dn, vrho_dn);
+                vsigma_uu__[i] = keep(up, 2 * vsigma_up);
+                vsigma_ud__[i] = 0;
+                vsigma_dd__[i] = keep(dn, 2 * vsigma_dn);
+            }
+            break;
+        }
+        case xc_native_t::gga_c_pbe:
+        case xc_native_t::gga_c_pbe_sol: {
+            double beta = (type__ == xc_native_t::gga_c_pbe) ? 0.06672455060314922 : 0.046;
+            /* PBE correlation is built on top of the modified Perdew-Wang LDA */
+            auto p = pw_param(true);
+            #pragma omp simd
+            for (int i = 0; i < size__; i++) {
+                double rho = rho_up__[i] + rho_dn__[i];
+                auto m = mask_ge(rho, rho_min);
+                double r = select(m, rho, rho_min);
+                double z = simd_max(simd_min((rho_up__[i] - rho_dn__[i]) / r, zeta_max), -zeta_max);
+                double rs = c_rs / simd_cbrt(r);
+                double ec, ec_rs, ec_z;
+                pw_point(p, rs, z, ec, ec_rs, ec_z);
+                double sigma = sigma_uu__[i] + 2 * sigma_ud__[i] + sigma_dd__[i];
+                double e, vrho_up, vrho_dn, vsigma;
+                pbe_c_point(beta, r, z, sigma, rs, ec, ec_rs, ec_z, e, vrho_up, vrho_dn, vsigma);
+                e__[i]         = keep(m, e);
+                vrho_up__[i]   = keep(m, vrho_up);
+                vrho_dn__[i]   = keep(m, vrho_dn);
+                vsigma_uu__[i] = keep(m, vsigma);
+                vsigma_ud__[i] = keep(m, 2 * vsigma);
+                vsigma_dd__[i] = keep(m, vsigma);
+            }
+            break;
+        }
+        default: {
+            TERMINATE("not a built-in GGA functional");
+        }
+    }
+}
+
+} // namespace xc_native
+
+#undef XC_NATIVE_INLINE
+
+} // namespace sirius
+
+#endif // __XC_FUNCTIONAL_NATIVE_H__